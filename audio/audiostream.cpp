@@ -21,13 +21,14 @@
  */
 
 #include "common/debug.h"
-#include "common/file.h"
+#include "common/archive.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
 #include "common/queue.h"
 #include "common/util.h"
 
 #include "audio/audiostream.h"
+#include "audio/decodeahead.h"
 #include "audio/decoders/flac.h"
 #include "audio/decoders/mp3.h"
 #include "audio/decoders/quicktime.h"
@@ -65,21 +66,22 @@ static const StreamFileFormat STREAM_FILEFORMATS[] = {
 
 SeekableAudioStream *SeekableAudioStream::openStreamFile(const Common::String &basename) {
 	SeekableAudioStream *stream = NULL;
-	Common::File *fileHandle = new Common::File();
 
 	for (int i = 0; i < ARRAYSIZE(STREAM_FILEFORMATS); ++i) {
 		Common::String filename = basename + STREAM_FILEFORMATS[i].fileExtension;
-		fileHandle->open(filename);
-		if (fileHandle->isOpen()) {
-			// Create the stream object
+		Common::ArchiveMemberPtr member = SearchMan.getMember(filename);
+		Common::SeekableReadStream *fileHandle = member ? member->createReadStream() : 0;
+		if (fileHandle) {
+			// Create the stream object. Only a file of its own may be
+			// decoded on another thread; members of an archive like a ZIP
+			// file may share its handle.
 			stream = STREAM_FILEFORMATS[i].openStreamFile(fileHandle, DisposeAfterUse::YES);
-			fileHandle = 0;
+			if (member->createsPrivateStreams())
+				stream = makeDecodeAheadStream(stream);
 			break;
 		}
 	}
 
-	delete fileHandle;
-
 	if (stream == NULL)
 		debug(1, "SeekableAudioStream::openStreamFile: Could not open compressed AudioFile %s", basename.c_str());
 
@@ -160,6 +160,10 @@ public:
 	 * In case of an error, the file handle will be closed, but deleting
 	 * it is still the responsibility of the caller.
 	 *
+	 * Long streams are decoded ahead on a background thread, see
+	 * makeDecodeAheadStream(), unless the file is a member of an archive
+	 * whose handle its streams share.
+	 *
 	 * @param basename a filename without an extension
 	 * @return  an SeekableAudioStream ready to use in case of success;
 	 *          NULL in case of an error (e.g. invalid/nonexisting file)
@@ -0,0 +1,254 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/decodeahead.h"
+
+#include "common/atomic.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/mutex.h"
+#include "common/system.h"
+#include "common/threadpool.h"
+#include "common/util.h"
+
+namespace Audio {
+
+enum {
+	/**
+	 * Samples decoded at once. Compressed formats decode whole frames of
+	 * about a thousand samples anyway, and this keeps the time seeking or
+	 * an underrun waits for a running decode step short.
+	 */
+	kDecodeChunk = 4096,
+	/** Smallest buffer, a few callbacks' worth of samples. */
+	kMinBufferSize = 4 * kDecodeChunk
+};
+
+/**
+ * Decodes a stream into a ring buffer on the thread pool. It owns both, so
+ * that the BufferedDecodeAheadStream reading the buffer can go away while
+ * the task is still running.
+ */
+class DecodeAheadTask : public Common::ThreadTask {
+public:
+	DecodeAheadTask(SeekableAudioStream *parent, DisposeAfterUse::Flag disposeAfterUse, bool threaded, uint32 size);
+	~DecodeAheadTask();
+
+	/** Fill the buffer up. */
+	virtual void run();
+
+	/** Decode one chunk into the buffer. The decoder lock must be held. */
+	int decodeChunk();
+
+	/** Number of decoded samples not read yet. */
+	uint32 getBuffered() const;
+
+	void lockDecoder();
+	void unlockDecoder();
+
+	SeekableAudioStream *const _parent;
+	const DisposeAfterUse::Flag _disposeAfterUse;
+
+	/** Guards _parent and writing the buffer. Only needed with threads. */
+	Common::Mutex *_decoderMutex;
+
+	int16 *_buffer;
+	/** Size of the buffer in samples, a power of two. */
+	const uint32 _size;
+	/** Total number of samples read and written, the buffer index is this modulo _size. */
+	volatile uint32 _readPos, _writePos;
+	/** Set once the wrapped stream ran out of data. */
+	volatile uint32 _decodedToEnd;
+	/** Asks a running task to stop early. */
+	volatile uint32 _quit;
+};
+
+DecodeAheadTask::DecodeAheadTask(SeekableAudioStream *parent, DisposeAfterUse::Flag disposeAfterUse, bool threaded, uint32 size)
+	: _parent(parent), _disposeAfterUse(disposeAfterUse), _decoderMutex(0), _size(size),
+	  _readPos(0), _writePos(0), _decodedToEnd(0), _quit(0) {
+	if (threaded)
+		_decoderMutex = new Common::Mutex();
+	_buffer = new int16[_size];
+}
+
+DecodeAheadTask::~DecodeAheadTask() {
+	delete[] _buffer;
+	delete _decoderMutex;
+
+	if (_disposeAfterUse == DisposeAfterUse::YES)
+		delete _parent;
+}
+
+void DecodeAheadTask::lockDecoder() {
+	if (_decoderMutex)
+		_decoderMutex->lock();
+}
+
+void DecodeAheadTask::unlockDecoder() {
+	if (_decoderMutex)
+		_decoderMutex->unlock();
+}
+
+uint32 DecodeAheadTask::getBuffered() const {
+	return Common::atomicLoad(&_writePos) - Common::atomicLoad(&_readPos);
+}
+
+int DecodeAheadTask::decodeChunk() {
+	const uint32 writePos = _writePos;
+	const uint32 index = writePos & (_size - 1);
+
+	// Stay within the free space and before the end of the ring. Both are
+	// multiples of the chunk size, so stereo samples never get split.
+	const uint32 count = MIN<uint32>(MIN<uint32>(_size - getBuffered(), _size - index), kDecodeChunk);
+	if (count == 0)
+		return 0;
+
+	const int decoded = _parent->readBuffer(_buffer + index, count);
+	if (decoded > 0)
+		Common::atomicStore(&_writePos, writePos + decoded);
+
+	if (decoded <= 0 || _parent->endOfData())
+		Common::atomicStore(&_decodedToEnd, (uint32)1);
+
+	return decoded;
+}
+
+void DecodeAheadTask::run() {
+	while (!Common::atomicLoad(&_quit)) {
+		lockDecoder();
+		const bool done = Common::atomicLoad(&_decodedToEnd) || getBuffered() + kDecodeChunk > _size;
+		if (!done)
+			decodeChunk();
+		unlockDecoder();
+
+		if (done)
+			break;
+	}
+}
+
+BufferedDecodeAheadStream::BufferedDecodeAheadStream(SeekableAudioStream *stream, DisposeAfterUse::Flag disposeAfterUse, Common::ThreadPool *pool, uint aheadMillis)
+	: _parent(stream), _isStereo(stream->isStereo()), _rate(stream->getRate()), _pool(pool), _task(0), _underruns(0) {
+	assert(stream);
+	assert(pool);
+
+	const uint32 wanted = aheadMillis * (uint32)_rate / 1000 * (_isStereo ? 2 : 1);
+	uint32 size = kMinBufferSize;
+	while (size < wanted)
+		size *= 2;
+
+	// Without threads, all decoding happens on the calling thread
+	_task = new DecodeAheadTask(stream, disposeAfterUse, pool->getThreadCount() > 0, size);
+
+	// Not in the audio callback yet, so this may wait for the pool
+	_pool->submit(_task);
+}
+
+BufferedDecodeAheadStream::~BufferedDecodeAheadStream() {
+	if (_underruns)
+		debug(2, "BufferedDecodeAheadStream: Decoding fell behind %u times", _underruns);
+
+	// This may happen in the audio callback, so don't wait for a running
+	// decode step. The pool deletes the task when it is done.
+	Common::atomicStore(&_task->_quit, (uint32)1);
+	_pool->detach(_task);
+}
+
+void BufferedDecodeAheadStream::startDecoding() {
+	if (Common::atomicLoad(&_task->_decodedToEnd) || _task->getBuffered() > _task->_size / 2)
+		return;
+
+	// Should the task still be running, or the pool be in use, the next
+	// read tries again. There is half a buffer of time left for that.
+	_pool->trySubmit(_task);
+}
+
+int BufferedDecodeAheadStream::readBuffer(int16 *buffer, const int numSamples) {
+	const uint32 size = _task->_size;
+	int samples = 0;
+
+	while (samples < numSamples) {
+		const uint32 buffered = _task->getBuffered();
+
+		if (buffered == 0) {
+			if (Common::atomicLoad(&_task->_decodedToEnd))
+				break;
+
+			// Decoding fell behind, do it here like an unwrapped stream would.
+			// This waits for a running decode step, which most likely filled
+			// the buffer by the time we get the lock.
+			_underruns++;
+			_task->lockDecoder();
+			if (_task->getBuffered() == 0)
+				_task->decodeChunk();
+			_task->unlockDecoder();
+			continue;
+		}
+
+		const uint32 readPos = _task->_readPos;
+		const uint32 index = readPos & (size - 1);
+		const uint32 count = MIN<uint32>(MIN<uint32>(buffered, size - index), numSamples - samples);
+		memcpy(buffer + samples, _task->_buffer + index, count * sizeof(int16));
+		samples += count;
+		Common::atomicStore(&_task->_readPos, readPos + count);
+	}
+
+	startDecoding();
+	return samples;
+}
+
+bool BufferedDecodeAheadStream::endOfData() const {
+	return Common::atomicLoad(&_task->_decodedToEnd) && _task->getBuffered() == 0;
+}
+
+bool BufferedDecodeAheadStream::seek(const Timestamp &where) {
+	_task->lockDecoder();
+
+	// Drop everything decoded so far, a running task starts over at the
+	// new position once it gets the lock
+	Common::atomicStore(&_task->_readPos, (uint32)0);
+	Common::atomicStore(&_task->_writePos, (uint32)0);
+	const bool result = _parent->seek(where);
+	Common::atomicStore(&_task->_decodedToEnd, (uint32)(_parent->endOfData() ? 1 : 0));
+
+	_task->unlockDecoder();
+
+	startDecoding();
+	return result;
+}
+
+SeekableAudioStream *makeDecodeAheadStream(SeekableAudioStream *stream, DisposeAfterUse::Flag disposeAfterUse) {
+	if (!stream)
+		return 0;
+
+	const int aheadMillis = ConfMan.getInt("audio_decode_ahead");
+	Common::ThreadPool *pool = g_system->getThreadPool();
+	if (aheadMillis <= 0 || pool->getThreadCount() == 0)
+		return stream;
+
+	// Short sounds are decoded in no time, and the buffer would hold all of them
+	if (stream->getLength().msecs() < aheadMillis * 2)
+		return stream;
+
+	return new BufferedDecodeAheadStream(stream, disposeAfterUse, pool, aheadMillis);
+}
+
+} // End of namespace Audio
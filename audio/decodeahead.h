@@ -0,0 +1,112 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_DECODEAHEAD_H
+#define AUDIO_DECODEAHEAD_H
+
+#include "common/scummsys.h"
+#include "common/types.h"
+
+#include "audio/audiostream.h"
+
+namespace Common {
+class ThreadPool;
+}
+
+namespace Audio {
+
+class DecodeAheadTask;
+
+/**
+ * A stream decoding another one on a background thread, so that slow
+ * compressed frames don't hold up the audio callback.
+ *
+ * The decoded samples are kept in a ring buffer, which a task of the thread
+ * pool refills whenever it is half empty. Should the buffer ever run dry,
+ * readBuffer() decodes on the calling thread, as if it wasn't wrapped.
+ *
+ * The wrapped stream, and the stream it reads its data from, are accessed
+ * from the pool's threads. They must not be used by anyone else while
+ * wrapped, which rules out sub streams of a shared archive file (see
+ * ArchiveMember::createsPrivateStreams()).
+ *
+ * Like everything else, seeking is only allowed from the thread reading
+ * the stream; it waits for a running decode step and drops the buffer.
+ *
+ * Neither reading nor deleting the stream waits for the pool, unless the
+ * buffer ran dry, so both are fine in the audio callback.
+ */
+class BufferedDecodeAheadStream : public SeekableAudioStream {
+public:
+	/**
+	 * @param stream          the stream to decode ahead
+	 * @param disposeAfterUse whether to delete the stream along with this one
+	 * @param pool            the pool to decode on
+	 * @param aheadMillis     how far to decode ahead, in milliseconds
+	 */
+	BufferedDecodeAheadStream(SeekableAudioStream *stream, DisposeAfterUse::Flag disposeAfterUse, Common::ThreadPool *pool, uint aheadMillis);
+	/** Stops decoding, the pool deletes the wrapped stream once the task ended. */
+	~BufferedDecodeAheadStream();
+
+	int readBuffer(int16 *buffer, const int numSamples);
+	bool endOfData() const;
+
+	bool isStereo() const { return _isStereo; }
+	int getRate() const { return _rate; }
+
+	bool seek(const Timestamp &where);
+	Timestamp getLength() const { return _parent->getLength(); }
+
+	/** Number of times the buffer ran dry, forcing readBuffer() to decode itself. */
+	uint getUnderruns() const { return _underruns; }
+
+private:
+	/**
+	 * Queue the task to refill the buffer, unless it is queued or running
+	 * already, or there is no need.
+	 */
+	void startDecoding();
+
+	SeekableAudioStream *_parent;
+	const bool _isStereo;
+	const int _rate;
+
+	Common::ThreadPool *_pool;
+	/** Decodes into the buffer, and owns it along with the wrapped stream. */
+	DecodeAheadTask *_task;
+
+	uint _underruns;
+};
+
+/**
+ * Wrap a stream into a BufferedDecodeAheadStream, as far ahead as the
+ * "audio_decode_ahead" setting asks for. Returns the stream itself if that
+ * is 0, the system has no threads to decode on, or the stream is too short
+ * to benefit.
+ *
+ * The stream has to be private as described for BufferedDecodeAheadStream.
+ */
+SeekableAudioStream *makeDecodeAheadStream(SeekableAudioStream *stream, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES);
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,62 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/mixbus.h"
+
+#include "common/util.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Audio {
+
+void clampMixBus(const st_mix_t *in, st_sample_t *out, uint count) {
+	uint i = 0;
+
+#if defined(__SSE2__)
+	// Packing with signed saturation is exactly the clamp we need
+	for (; i + 8 <= count; i += 8) {
+		const __m128i lo = _mm_loadu_si128((const __m128i *)(in + i));
+		const __m128i hi = _mm_loadu_si128((const __m128i *)(in + i + 4));
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(lo, hi));
+	}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	for (; i + 8 <= count; i += 8) {
+		const int16x4_t lo = vqmovn_s32(vld1q_s32((const int32_t *)(in + i)));
+		const int16x4_t hi = vqmovn_s32(vld1q_s32((const int32_t *)(in + i + 4)));
+		vst1q_s16((int16_t *)(out + i), vcombine_s16(lo, hi));
+	}
+#endif
+
+	for (; i < count; i++)
+		out[i] = CLIP<st_mix_t>(in[i], ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	for (i = 0; i < count; i++)
+		out[i] ^= 0x8000;
+#endif
+}
+
+} // End of namespace Audio
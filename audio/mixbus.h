@@ -0,0 +1,43 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_MIXBUS_H
+#define AUDIO_MIXBUS_H
+
+#include "common/scummsys.h"
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * Clamp the samples of a mixing bus into 16 bit output samples. Uses SSE2
+ * or NEON, if the compiler targets them.
+ *
+ * @param in	the mixing bus, as filled by RateConverter::flowMix()
+ * @param out	the output buffer
+ * @param count	number of samples (not sample pairs) to convert
+ */
+void clampMixBus(const st_mix_t *in, st_sample_t *out, uint count);
+
+} // End of namespace Audio
+
+#endif
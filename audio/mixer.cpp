@@ -23,10 +23,14 @@
 #include "gui/EventRecorder.h"
 
 #include "common/util.h"
+#include "common/atomic.h"
+#include "common/config-manager.h"
+#include "common/profiler.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 
 #include "audio/mixer_intern.h"
+#include "audio/mixbus.h"
 #include "audio/rate.h"
 #include "audio/audiostream.h"
 #include "audio/timestamp.h"
@@ -50,13 +54,13 @@ public:
 	/**
 	 * Mixes the channel's samples into the given buffer.
 	 *
-	 * @param data buffer where to mix the data
+	 * @param data mixing bus where to mix the data
 	 * @param len  number of sample *pairs*. So a value of
 	 *             10 means that the buffer contains twice 10 sample, each
-	 *             16 bits, for a total of 40 bytes.
+	 *             32 bits, for a total of 80 bytes.
 	 * @return number of sample pairs processed (which can still be silence!)
 	 */
-	int mix(int16 *data, uint len);
+	int mix(st_mix_t *data, uint len);
 
 	/**
 	 * Queries whether the channel is still playing or not.
@@ -123,9 +127,13 @@ public:
 	void notifyGlobalVolChange() { updateChannelVolumes(); }
 
 	/**
-	 * Queries how long the channel has been playing.
+	 * Queries the timing information needed to tell how long the channel
+	 * has been playing, see MixerImpl::getElapsedTime().
 	 */
-	Timestamp getElapsedTime();
+	uint32 getSamplesConsumed() const { return _samplesConsumed; }
+	uint32 getMixerTimeStamp() const { return _mixerTimeStamp; }
+	uint32 getPauseStartTime() const { return _pauseStartTime; }
+	uint32 getPauseTime() const { return _pauseTime; }
 
 	/**
 	 * Queries the channel's sound type.
@@ -175,12 +183,17 @@ private:
 
 // TODO: parameter "system" is unused
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _sampleRate(sampleRate), _resampler(ConfMan.get("audio_resampler") == "sinc" ? kSincResampler : kLinearResampler),
+	  _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	_mixBus.resize(2 * MIX_BUS_FRAMES);
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = 0;
+		memset(&_status[i], 0, sizeof(_status[i]));
+	}
 }
 
 MixerImpl::~MixerImpl() {
@@ -196,6 +209,10 @@ uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
 
+RateConverter *MixerImpl::makeRateConverter(uint inrate, bool stereo, bool reverseStereo) {
+	return Audio::makeRateConverter(inrate, _sampleRate, stereo, reverseStereo, _resampler);
+}
+
 void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	int index = -1;
 	for (int i = 0; i != NUM_CHANNELS; i++) {
@@ -216,11 +233,100 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
 
 	chan->setHandle(chanHandle);
+	publishChannel(index);
 	_handleSeed++;
 	if (handle)
 		*handle = chanHandle;
 }
 
+void MixerImpl::deleteChannel(int index) {
+	Common::atomicStore(&_status[index].active, (uint32)0);
+
+	delete _channels[index];
+	_channels[index] = 0;
+}
+
+void MixerImpl::publishChannel(int index) {
+	ChannelStatus &status = _status[index];
+	Channel *chan = _channels[index];
+
+	Common::atomicStore(&status.handle, chan->getHandle()._val);
+	Common::atomicStore(&status.id, (int32)chan->getId());
+	Common::atomicStore(&status.type, (int32)chan->getType());
+	Common::atomicStore(&status.volume, (int32)chan->getVolume());
+	Common::atomicStore(&status.balance, (int32)chan->getBalance());
+	publishTiming(index);
+
+	Common::atomicStore(&status.active, (uint32)1);
+}
+
+void MixerImpl::publishTiming(int index) {
+	ChannelStatus &status = _status[index];
+	const Channel *chan = _channels[index];
+
+	// There is only one writer at a time, readers retry if the sequence
+	// changed while they read the timing
+	const uint32 sequence = status.sequence;
+	Common::atomicStore(&status.sequence, sequence + 1);
+	Common::atomicStore(&status.samplesConsumed, chan->getSamplesConsumed());
+	Common::atomicStore(&status.mixerTimeStamp, chan->getMixerTimeStamp());
+	Common::atomicStore(&status.pauseStartTime, chan->getPauseStartTime());
+	Common::atomicStore(&status.pauseTime, chan->getPauseTime());
+	Common::atomicStore(&status.paused, (uint32)chan->isPaused());
+	Common::atomicStore(&status.sequence, sequence + 2);
+}
+
+bool MixerImpl::isActive(SoundHandle handle) const {
+	const ChannelStatus &status = _status[handle._val % NUM_CHANNELS];
+	return Common::atomicLoad(&status.active) && Common::atomicLoad(&status.handle) == handle._val;
+}
+
+void MixerImpl::queueCommand(const Command &command) {
+	Common::StackLock lock(_commandMutex);
+	pushCommand(command);
+}
+
+void MixerImpl::pushCommand(const Command &command) {
+	if (_commands.push(command))
+		return;
+
+	// The mixer does not run, or is far behind. Apply everything here then,
+	// which keeps the commands in order.
+	Common::StackLock mixLock(_mutex);
+	processCommands();
+	applyCommand(command);
+}
+
+void MixerImpl::processCommands() {
+	Command command;
+	while (_commands.pop(command))
+		applyCommand(command);
+}
+
+void MixerImpl::applyCommand(const Command &command) {
+	switch (command.type) {
+	case Command::kSetVolume:
+	case Command::kSetBalance: {
+		Channel *chan = _channels[command.handle % NUM_CHANNELS];
+		if (!chan || chan->getHandle()._val != command.handle)
+			return;
+
+		if (command.type == Command::kSetVolume)
+			chan->setVolume(command.value);
+		else
+			chan->setBalance(command.value);
+		break;
+	}
+
+	case Command::kUpdateVolumes:
+		for (int i = 0; i != NUM_CHANNELS; ++i) {
+			if (_channels[i] && _channels[i]->getType() == command.value)
+				_channels[i]->notifyGlobalVolChange();
+		}
+		break;
+	}
+}
+
 void MixerImpl::playStream(
 			SoundType type,
 			SoundHandle *handle,
@@ -229,7 +335,11 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
+	// The status of the new channel must not be mixed up with a volume or
+	// balance set for the channel which had its slot before
+	Common::StackLock commandLock(_commandMutex);
 	Common::StackLock lock(_mutex);
+	processCommands();
 
 	if (stream == 0) {
 		warning("stream is 0");
@@ -267,6 +377,8 @@ void MixerImpl::playStream(
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
+	PROFILE_SCOPE("audio.mix");
+
 	assert(samples);
 
 	Common::StackLock lock(_mutex);
@@ -279,67 +391,78 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
-	//  zero the buf
-	memset(buf, 0, 2 * len * sizeof(int16));
+	processCommands();
 
-	// mix all channels
-	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i]) {
-			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
-
-				if (tmp > res)
-					res = tmp;
+	// Mix into a bus with more headroom than the output, so that loud
+	// channels are only clamped once, after everything is added up
+	st_mix_t *bus = _mixBus.begin();
+	int res = 0;
+
+	while (len > 0) {
+		const uint frames = MIN<uint>(len, MIX_BUS_FRAMES);
+		memset(bus, 0, 2 * frames * sizeof(st_mix_t));
+
+		// mix all channels
+		int mixed = 0, tmp;
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			if (_channels[i]) {
+				if (_channels[i]->isFinished()) {
+					deleteChannel(i);
+				} else if (!_channels[i]->isPaused()) {
+					tmp = _channels[i]->mix(bus, frames);
+					publishTiming(i);
+
+					if (tmp > mixed)
+						mixed = tmp;
+				}
 			}
-		}
+
+		clampMixBus(bus, buf, 2 * frames);
+
+		res += mixed;
+		buf += 2 * frames;
+		len -= frames;
+	}
 
 	return res;
 }
 
 void MixerImpl::stopAll() {
 	Common::StackLock lock(_mutex);
+	processCommands();
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+		if (_channels[i] != 0 && !_channels[i]->isPermanent())
+			deleteChannel(i);
 	}
 }
 
 void MixerImpl::stopID(int id) {
 	Common::StackLock lock(_mutex);
+	processCommands();
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+		if (_channels[i] != 0 && _channels[i]->getId() == id)
+			deleteChannel(i);
 	}
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
+	processCommands();
 
 	// Simply ignore stop requests for handles of sounds that already terminated
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
 
-	delete _channels[index];
-	_channels[index] = 0;
+	deleteChannel(index);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
 	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	Command command = { Command::kUpdateVolumes, 0, type };
+	queueCommand(command);
 }
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
@@ -348,39 +471,40 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
-
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	// No new channel can take the slot while the lock is held
+	Common::StackLock lock(_commandMutex);
+	if (!isActive(handle))
 		return;
 
-	_channels[index]->setVolume(volume);
+	Common::atomicStore(&_status[handle._val % NUM_CHANNELS].volume, (int32)volume);
+
+	Command command = { Command::kSetVolume, handle._val, volume };
+	pushCommand(command);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (!isActive(handle))
 		return 0;
 
-	return _channels[index]->getVolume();
+	return Common::atomicLoad(&_status[handle._val % NUM_CHANNELS].volume);
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
-
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_commandMutex);
+	if (!isActive(handle))
 		return;
 
-	_channels[index]->setBalance(balance);
+	Common::atomicStore(&_status[handle._val % NUM_CHANNELS].balance, (int32)balance);
+
+	Command command = { Command::kSetBalance, handle._val, balance };
+	pushCommand(command);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (!isActive(handle))
 		return 0;
 
-	return _channels[index]->getBalance();
+	return Common::atomicLoad(&_status[handle._val % NUM_CHANNELS].balance);
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -388,29 +512,68 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 }
 
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	const ChannelStatus &status = _status[handle._val % NUM_CHANNELS];
+	Timestamp ts(0, _sampleRate);
+
+	uint32 samplesConsumed, mixerTimeStamp, pauseStartTime, pauseTime, paused;
+	for (;;) {
+		const uint32 sequence = Common::atomicLoad(&status.sequence);
+		if (!isActive(handle))
+			return ts;
+		if (sequence & 1)
+			continue;
+
+		samplesConsumed = Common::atomicLoad(&status.samplesConsumed);
+		mixerTimeStamp = Common::atomicLoad(&status.mixerTimeStamp);
+		pauseStartTime = Common::atomicLoad(&status.pauseStartTime);
+		pauseTime = Common::atomicLoad(&status.pauseTime);
+		paused = Common::atomicLoad(&status.paused);
+
+		if (Common::atomicLoad(&status.sequence) == sequence)
+			break;
+	}
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return Timestamp(0, _sampleRate);
+	if (mixerTimeStamp == 0)
+		return ts;
+
+	uint32 delta;
+	if (paused)
+		delta = pauseStartTime - mixerTimeStamp;
+	else
+		delta = g_system->getMillis(true) - mixerTimeStamp - pauseTime;
 
-	return _channels[index]->getElapsedTime();
+	// Convert the number of samples into a time duration.
+
+	ts = ts.addFrames(samplesConsumed);
+	ts = ts.addMsecs(delta);
+
+	// In theory it would seem like a good idea to limit the approximation
+	// so that it never exceeds the theoretical upper bound set by
+	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
+	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
+	// isn't invoked at the regular intervals that I first imagined.
+
+	return ts;
 }
 
 void MixerImpl::pauseAll(bool paused) {
 	Common::StackLock lock(_mutex);
+	processCommands();
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != 0) {
 			_channels[i]->pause(paused);
+			publishTiming(i);
 		}
 	}
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
 	Common::StackLock lock(_mutex);
+	processCommands();
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != 0 && _channels[i]->getId() == id) {
 			_channels[i]->pause(paused);
+			publishTiming(i);
 			return;
 		}
 	}
@@ -418,6 +581,7 @@ void MixerImpl::pauseID(int id, bool paused) {
 
 void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 	Common::StackLock lock(_mutex);
+	processCommands();
 
 	// Simply ignore (un)pause requests for sounds that already terminated
 	const int index = handle._val % NUM_CHANNELS;
@@ -425,44 +589,41 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 		return;
 
 	_channels[index]->pause(paused);
+	publishTiming(index);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+		if (Common::atomicLoad(&_status[i].active) && Common::atomicLoad(&_status[i].id) == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
-	return 0;
+	if (!isActive(handle))
+		return 0;
+
+	const int id = Common::atomicLoad(&_status[handle._val % NUM_CHANNELS].id);
+
+	// The channel might have been replaced in the meantime
+	return isActive(handle) ? id : 0;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	return isActive(handle);
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
-	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+		if (Common::atomicLoad(&_status[i].active) && Common::atomicLoad(&_status[i].type) == (int32)type)
 			return true;
 	return false;
 }
@@ -479,13 +640,10 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
-	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	Command command = { Command::kUpdateVolumes, 0, type };
+	queueCommand(command);
 }
 
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
@@ -509,7 +667,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = mixer->makeRateConverter(_stream->getRate(), _stream->isStereo(), reverseStereo);
 }
 
 Channel::~Channel() {
@@ -579,35 +737,7 @@ void Channel::pause(bool paused) {
 	}
 }
 
-Timestamp Channel::getElapsedTime() {
-	const uint32 rate = _mixer->getOutputRate();
-	uint32 delta = 0;
-
-	Audio::Timestamp ts(0, rate);
-
-	if (_mixerTimeStamp == 0)
-		return ts;
-
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
-	else
-		delta = g_system->getMillis(true) - _mixerTimeStamp - _pauseTime;
-
-	// Convert the number of samples into a time duration.
-
-	ts = ts.addFrames(_samplesConsumed);
-	ts = ts.addMsecs(delta);
-
-	// In theory it would seem like a good idea to limit the approximation
-	// so that it never exceeds the theoretical upper bound set by
-	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
-	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
-	// isn't invoked at the regular intervals that I first imagined.
-
-	return ts;
-}
-
-int Channel::mix(int16 *data, uint len) {
+int Channel::mix(st_mix_t *data, uint len) {
 	assert(_stream);
 
 	int res = 0;
@@ -618,7 +748,7 @@ int Channel::mix(int16 *data, uint len) {
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis(true);
 		_pauseTime = 0;
-		res = _converter->flow(*_stream, data, len, _volL, _volR);
+		res = _converter->flowMix(*_stream, data, len, _volL, _volR);
 		_samplesDecoded += res;
 	}
 
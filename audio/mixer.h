@@ -30,6 +30,7 @@ namespace Audio {
 
 class AudioStream;
 class Channel;
+class RateConverter;
 class Timestamp;
 
 /**
@@ -277,6 +278,17 @@ public:
 	 * @return the output sample rate in Hz
 	 */
 	virtual uint getOutputRate() const = 0;
+
+	/**
+	 * Create a rate converter from the given rate to the output rate, with
+	 * the resampler the user chose.
+	 *
+	 * @param inrate		the sample rate of the input
+	 * @param stereo		whether the input is stereo
+	 * @param reverseStereo	whether to swap the left and right channels
+	 * @return the new converter, which the caller has to delete
+	 */
+	virtual RateConverter *makeRateConverter(uint inrate, bool stereo, bool reverseStereo = false) = 0;
 };
 
 
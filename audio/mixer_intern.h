@@ -24,8 +24,11 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/mutex.h"
+#include "common/spscqueue.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
@@ -51,12 +54,16 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 16
+		NUM_CHANNELS = 16,
+		/** Frames mixed at once, larger buffers are mixed in several parts. */
+		MIX_BUS_FRAMES = 8192
 	};
 
 	Common::Mutex _mutex;
 
 	const uint _sampleRate;
+	/** The "audio_resampler" setting, read once on the main thread. */
+	const Resampler _resampler;
 	bool _mixerReady;
 	uint32 _handleSeed;
 
@@ -70,6 +77,62 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * All channels are added up in here, and clamped once at the end. It
+	 * is allocated up front, so that the audio callback never allocates.
+	 */
+	Common::Array<st_mix_t> _mixBus;
+
+	/**
+	 * A change to the channels, which the mixer applies before mixing the
+	 * next buffer. This way, the calls engines make all the time do not
+	 * have to wait for the mixer to finish a buffer.
+	 */
+	struct Command {
+		enum Type {
+			kSetVolume,
+			kSetBalance,
+			kUpdateVolumes
+		};
+
+		Type type;
+		/** The handle of the channel, for kSetVolume and kSetBalance. */
+		uint32 handle;
+		/** The new volume or balance, or the sound type for kUpdateVolumes. */
+		int value;
+	};
+
+	/**
+	 * What the control calls need to know about a channel, so that they
+	 * can answer without locking. Written under _mutex, except for the
+	 * volume and balance, which only engine threads write, under
+	 * _commandMutex. Read without any lock through Common::atomicLoad().
+	 */
+	struct ChannelStatus {
+		volatile uint32 active;
+		volatile uint32 handle;
+		volatile int32 id;
+		volatile int32 type;
+		volatile int32 volume;
+		volatile int32 balance;
+
+		/** Odd while the timing below is updated. */
+		volatile uint32 sequence;
+		volatile uint32 samplesConsumed;
+		volatile uint32 mixerTimeStamp;
+		volatile uint32 pauseStartTime;
+		volatile uint32 pauseTime;
+		volatile uint32 paused;
+	};
+
+	/**
+	 * Serializes the threads queuing commands or changing the status of a
+	 * channel. Never taken by the mixer, and taken before _mutex.
+	 */
+	Common::Mutex _commandMutex;
+	Common::SPSCQueue<Command, 256> _commands;
+	ChannelStatus _status[NUM_CHANNELS];
+
 
 public:
 
@@ -118,9 +181,36 @@ public:
 
 	virtual uint getOutputRate() const;
 
+	virtual RateConverter *makeRateConverter(uint inrate, bool stereo, bool reverseStereo = false);
+
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+private:
+	/** Delete a channel and mark its slot as free. Needs _mutex. */
+	void deleteChannel(int index);
+
+	/** Update the status of a new channel. Needs _commandMutex and _mutex. */
+	void publishChannel(int index);
+
+	/** Update the timing in the status of a channel. Needs _mutex. */
+	void publishTiming(int index);
+
+	/** Check whether a handle refers to a playing channel, without locking. */
+	bool isActive(SoundHandle handle) const;
+
+	/** Hand a command to the mixer. Does not block unless the queue is full. */
+	void queueCommand(const Command &command);
+
+	/** Like queueCommand(), for callers which hold _commandMutex already. */
+	void pushCommand(const Command &command);
+
+	/** Apply all queued commands. Needs _mutex. */
+	void processCommands();
+
+	/** Apply a single command. Needs _mutex. */
+	void applyCommand(const Command &command);
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
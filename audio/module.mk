@@ -2,6 +2,7 @@ MODULE := audio
 
 MODULE_OBJS := \
 	audiostream.o \
+	decodeahead.o \
 	fmopl.o \
 	mididrv.o \
 	midiparser_qt.o \
@@ -9,10 +10,13 @@ MODULE_OBJS := \
 	midiparser_xmidi.o \
 	midiparser.o \
 	midiplayer.o \
+	mixbus.o \
 	mixer.o \
 	mpu401.o \
 	musicplugin.o \
 	null.o \
+	rate_sinc.o \
+	soundcache.o \
 	timestamp.o \
 	decoders/aac.o \
 	decoders/adpcm.o \
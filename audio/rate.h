@@ -30,6 +30,8 @@ namespace Audio {
 class AudioStream;
 
 typedef int16 st_sample_t;
+/** Samples of a mixing bus, with enough headroom to add up many channels. */
+typedef int32 st_mix_t;
 typedef uint16 st_volume_t;
 typedef uint32 st_size_t;
 typedef uint32 st_rate_t;
@@ -65,6 +67,16 @@ static inline void clampedAdd(int16& a, int b) {
 #endif
 }
 
+/** Add a sample to a 16 bit output buffer, clamping the result. */
+static inline void addSample(st_sample_t &a, int b) {
+	clampedAdd(a, b);
+}
+
+/** Add a sample to a mixing bus, which is clamped later on. */
+static inline void addSample(st_mix_t &a, int b) {
+	a += b;
+}
+
 class RateConverter {
 public:
 	RateConverter() {}
@@ -75,10 +87,62 @@ public:
 	 */
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
+	/**
+	 * Like flow(), but adds the samples to a mixing bus without clamping.
+	 * The bus is clamped once after all channels are mixed into it, see
+	 * MixerImpl::mixCallback().
+	 *
+	 * The default implementation mixes into a temporary 16 bit buffer
+	 * through flow(), converters should provide a direct one.
+	 *
+	 * @return Number of sample pairs written into the buffer.
+	 */
+	virtual int flowMix(AudioStream &input, st_mix_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		const st_size_t kBufferPairs = 256;
+		st_sample_t buffer[kBufferPairs * 2];
+		st_size_t done = 0;
+
+		while (done < osamp) {
+			const st_size_t len = (osamp - done < kBufferPairs) ? osamp - done : kBufferPairs;
+			memset(buffer, 0, sizeof(buffer));
+
+			const int res = flow(input, buffer, len, vol_l, vol_r);
+			for (int i = 0; i < res * 2; i++)
+				obuf[done * 2 + i] += buffer[i];
+
+			done += res;
+			if ((st_size_t)res < len)
+				break;
+		}
+
+		return done;
+	}
+
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+/** The ways of converting between different rates. */
+enum Resampler {
+	/** Linear interpolation, the default. */
+	kLinearResampler,
+	/** A windowed sinc filter, see makeSincRateConverter(). */
+	kSincResampler
+};
+
+/**
+ * Create a rate converter for the given rates, which uses the resampler if
+ * the rates differ.
+ *
+ * @see Mixer::makeRateConverter() for the resampler the user chose
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, Resampler resampler = kLinearResampler);
+
+/**
+ * Create a rate converter with a polyphase windowed sinc filter. It costs
+ * considerably more CPU time than linear interpolation, but does not add
+ * audible aliasing when upsampling low rate sounds.
+ */
+RateConverter *makeSincRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
 
 } // End of namespace Audio
 
@@ -96,6 +96,7 @@ protected:
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int flowMix(AudioStream &input, st_mix_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
 	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return (ST_SUCCESS);
 	}
@@ -131,6 +132,9 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
 #define ARM_SimpleRate_M _ARM_SimpleRate_M
 #define ARM_SimpleRate_S _ARM_SimpleRate_S
 #define ARM_SimpleRate_R _ARM_SimpleRate_R
+#define ARM_SimpleRateMix_M _ARM_SimpleRateMix_M
+#define ARM_SimpleRateMix_S _ARM_SimpleRateMix_S
+#define ARM_SimpleRateMix_R _ARM_SimpleRateMix_R
 #endif
 
 extern "C" st_sample_t *ARM_SimpleRate_M(
@@ -160,6 +164,33 @@ extern "C" st_sample_t *ARM_SimpleRate_R(
 								st_volume_t vol_l,
 								st_volume_t vol_r);
 
+extern "C" st_mix_t *ARM_SimpleRateMix_M(
+								AudioStream &input,
+								int (*fn)(Audio::AudioStream&,int16*,int),
+								SimpleRateDetails *sr,
+								st_mix_t *obuf,
+								st_size_t osamp,
+								st_volume_t vol_l,
+								st_volume_t vol_r);
+
+extern "C" st_mix_t *ARM_SimpleRateMix_S(
+								AudioStream &input,
+								int (*fn)(Audio::AudioStream&,int16*,int),
+								SimpleRateDetails *sr,
+								st_mix_t *obuf,
+								st_size_t osamp,
+								st_volume_t vol_l,
+								st_volume_t vol_r);
+
+extern "C" st_mix_t *ARM_SimpleRateMix_R(
+								AudioStream &input,
+								int (*fn)(Audio::AudioStream&,int16*,int),
+								SimpleRateDetails *sr,
+								st_mix_t *obuf,
+								st_size_t osamp,
+								st_volume_t vol_l,
+								st_volume_t vol_r);
+
 extern "C" int SimpleRate_readFudge(Audio::AudioStream &input, int16 *a, int b)
 {
 #ifdef DEBUG_RATECONV
@@ -196,6 +227,30 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	return (obuf - ostart) / 2;
 }
 
+template<bool stereo, bool reverseStereo>
+int SimpleRateConverter<stereo, reverseStereo>::flowMix(AudioStream &input, st_mix_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_mix_t *ostart = obuf;
+
+	if (!stereo) {
+		obuf = ARM_SimpleRateMix_M(input,
+								&SimpleRate_readFudge,
+								&sr,
+								obuf, osamp, vol_l, vol_r);
+	} else if (reverseStereo) {
+		obuf = ARM_SimpleRateMix_R(input,
+								&SimpleRate_readFudge,
+								&sr,
+								obuf, osamp, vol_l, vol_r);
+	} else {
+		obuf = ARM_SimpleRateMix_S(input,
+								&SimpleRate_readFudge,
+								&sr,
+								obuf, osamp, vol_l, vol_r);
+	}
+
+	return (obuf - ostart) / 2;
+}
+
 /**
  * Audio rate converter based on simple linear Interpolation.
  *
@@ -232,6 +287,9 @@ extern "C" {
 #define ARM_LinearRate_M _ARM_LinearRate_M
 #define ARM_LinearRate_S _ARM_LinearRate_S
 #define ARM_LinearRate_R _ARM_LinearRate_R
+#define ARM_LinearRateMix_M _ARM_LinearRateMix_M
+#define ARM_LinearRateMix_S _ARM_LinearRateMix_S
+#define ARM_LinearRateMix_R _ARM_LinearRateMix_R
 #endif
 }
 
@@ -262,6 +320,33 @@ extern "C" st_sample_t *ARM_LinearRate_R(
 								st_volume_t vol_l,
 								st_volume_t vol_r);
 
+extern "C" st_mix_t *ARM_LinearRateMix_M(
+								AudioStream &input,
+								int (*fn)(Audio::AudioStream&,int16*,int),
+								LinearRateDetails *lr,
+								st_mix_t *obuf,
+								st_size_t osamp,
+								st_volume_t vol_l,
+								st_volume_t vol_r);
+
+extern "C" st_mix_t *ARM_LinearRateMix_S(
+								AudioStream &input,
+								int (*fn)(Audio::AudioStream&,int16*,int),
+								LinearRateDetails *lr,
+								st_mix_t *obuf,
+								st_size_t osamp,
+								st_volume_t vol_l,
+								st_volume_t vol_r);
+
+extern "C" st_mix_t *ARM_LinearRateMix_R(
+								AudioStream &input,
+								int (*fn)(Audio::AudioStream&,int16*,int),
+								LinearRateDetails *lr,
+								st_mix_t *obuf,
+								st_size_t osamp,
+								st_volume_t vol_l,
+								st_volume_t vol_r);
+
 template<bool stereo, bool reverseStereo>
 class LinearRateConverter : public RateConverter {
 protected:
@@ -270,6 +355,7 @@ protected:
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+	int flowMix(AudioStream &input, st_mix_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
 	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return (ST_SUCCESS);
 	}
@@ -341,6 +427,35 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 	return (obuf - ostart) / 2;
 }
 
+template<bool stereo, bool reverseStereo>
+int LinearRateConverter<stereo, reverseStereo>::flowMix(AudioStream &input, st_mix_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_mix_t *ostart = obuf;
+
+	if (vol_l > 0xff)
+		vol_l = 0xff;
+
+	if (vol_r > 0xff)
+		vol_r = 0xff;
+
+	if (!stereo) {
+		obuf = ARM_LinearRateMix_M(input,
+								&SimpleRate_readFudge,
+								&lr,
+								obuf, osamp, vol_l, vol_r);
+	} else if (reverseStereo) {
+		obuf = ARM_LinearRateMix_R(input,
+								&SimpleRate_readFudge,
+								&lr,
+								obuf, osamp, vol_l, vol_r);
+	} else {
+		obuf = ARM_LinearRateMix_S(input,
+								&SimpleRate_readFudge,
+								&lr,
+								obuf, osamp, vol_l, vol_r);
+	}
+	return (obuf - ostart) / 2;
+}
+
 
 #pragma mark -
 
@@ -353,6 +468,9 @@ extern "C" {
 #define ARM_CopyRate_M _ARM_CopyRate_M
 #define ARM_CopyRate_S _ARM_CopyRate_S
 #define ARM_CopyRate_R _ARM_CopyRate_R
+#define ARM_CopyRateMix_M _ARM_CopyRateMix_M
+#define ARM_CopyRateMix_S _ARM_CopyRateMix_S
+#define ARM_CopyRateMix_R _ARM_CopyRateMix_R
 #endif
 }
 
@@ -377,12 +495,49 @@ extern "C" st_sample_t *ARM_CopyRate_R(
 								st_volume_t vol_r,
 								st_sample_t *_buffer);
 
+extern "C" st_mix_t *ARM_CopyRateMix_M(
+								st_size_t len,
+								st_mix_t *obuf,
+								st_volume_t vol_l,
+								st_volume_t vol_r,
+								st_sample_t *_buffer);
+
+extern "C" st_mix_t *ARM_CopyRateMix_S(
+								st_size_t len,
+								st_mix_t *obuf,
+								st_volume_t vol_l,
+								st_volume_t vol_r,
+								st_sample_t *_buffer);
+
+extern "C" st_mix_t *ARM_CopyRateMix_R(
+								st_size_t len,
+								st_mix_t *obuf,
+								st_volume_t vol_l,
+								st_volume_t vol_r,
+								st_sample_t *_buffer);
+
 
 template<bool stereo, bool reverseStereo>
 class CopyRateConverter : public RateConverter {
 	st_sample_t *_buffer;
 	st_size_t _bufferSize;
 
+	/** Reads up to osamp sample pairs into the temporary buffer. */
+	st_size_t readInput(AudioStream &input, st_size_t osamp) {
+		if (stereo)
+			osamp *= 2;
+
+		// Reallocate temp buffer, if necessary
+		if (osamp > _bufferSize) {
+			free(_buffer);
+			_buffer = (st_sample_t *)malloc(osamp * 2);
+			_bufferSize = osamp;
+		}
+
+		// Read up to 'osamp' samples into our temporary buffer
+		return input.readBuffer(_buffer, osamp);
+	}
+
 public:
 	CopyRateConverter() : _buffer(0), _bufferSize(0) {}
 	~CopyRateConverter() {
@@ -395,21 +550,9 @@ public:
 #ifdef DEBUG_RATECONV
 		debug("Copy st=%d rev=%d", stereo, reverseStereo);
 #endif
-		st_size_t len;
 		st_sample_t *ostart = obuf;
 
-		if (stereo)
-			osamp *= 2;
-
-		// Reallocate temp buffer, if necessary
-		if (osamp > _bufferSize) {
-			free(_buffer);
-			_buffer = (st_sample_t *)malloc(osamp * 2);
-			_bufferSize = osamp;
-		}
-
-		// Read up to 'osamp' samples into our temporary buffer
-		len = input.readBuffer(_buffer, osamp);
+		const st_size_t len = readInput(input, osamp);
 		if (len <= 0)
 			return 0;
 
@@ -424,6 +567,26 @@ public:
 		return (obuf - ostart) / 2;
 	}
 
+	virtual int flowMix(AudioStream &input, st_mix_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		assert(input.isStereo() == stereo);
+
+		st_mix_t *ostart = obuf;
+
+		const st_size_t len = readInput(input, osamp);
+		if (len <= 0)
+			return 0;
+
+		// Mix the data into the output buffer
+		if (stereo && reverseStereo)
+			obuf = ARM_CopyRateMix_R(len, obuf, vol_l, vol_r, _buffer);
+		else if (stereo)
+			obuf = ARM_CopyRateMix_S(len, obuf, vol_l, vol_r, _buffer);
+		else
+			obuf = ARM_CopyRateMix_M(len, obuf, vol_l, vol_r, _buffer);
+
+		return (obuf - ostart) / 2;
+	}
+
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
 		return (ST_SUCCESS);
 	}
@@ -436,7 +599,10 @@ public:
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, Resampler resampler) {
+	if (inrate != outrate && resampler == kSincResampler)
+		return makeSincRateConverter(inrate, outrate, stereo, reverseStereo);
+
 	if (inrate != outrate) {
 		if ((inrate % outrate) == 0) {
 			if (stereo) {
@@ -0,0 +1,361 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * A polyphase resampler: every output sample is computed from kTaps input
+ * samples around its position, weighted by a Kaiser windowed sinc. The
+ * weights only depend on the fractional part of the position, so they are
+ * computed once per rate ratio and phase and shared by all converters.
+ */
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "audio/mixer.h"
+#include "common/algorithm.h"
+#include "common/atomic.h"
+#include "common/math.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Audio {
+
+enum {
+	/** Number of input samples each output sample is computed from. */
+	kTaps = 32,
+	/** Fixed point precision of the filter coefficients. */
+	kCoeffBits = 14,
+	/**
+	 * Maximum number of precomputed phases. Ratios needing more use the
+	 * nearest lower phase, which is off by less than 1/1024 of a sample.
+	 */
+	kMaxPhases = 1024,
+	/** Number of input frames read from the stream at once. */
+	kInputFrames = 512,
+	/**
+	 * Maximum number of filters kept for later converters. At most 64 KB
+	 * each, and games only use a few rates.
+	 */
+	kMaxSincFilters = 16
+};
+
+/** Shape of the Kaiser window, giving about 80 dB stop band attenuation. */
+static const double kKaiserBeta = 8.0;
+
+/** The zeroth order modified Bessel function of the first kind. */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 64 && term > sum * 1e-12; k++) {
+		const double t = x / (2 * k);
+		term *= t * t;
+		sum += term;
+	}
+	return sum;
+}
+
+/**
+ * The filter coefficients for one ratio of rates.
+ */
+struct SincFilter {
+	/** Input frames per outStep output frames, both reduced by their gcd. */
+	uint inStep, outStep;
+	/** Number of rows in coeffs. */
+	uint phases;
+	/** kTaps coefficients for each phase, scaled by 1 << kCoeffBits. */
+	int16 *coeffs;
+	/** The next filter in the cache. */
+	SincFilter *next;
+
+	SincFilter(uint in, uint out);
+	~SincFilter() { delete[] coeffs; }
+
+	/** Return the coefficients for an output at phase / outStep after an input frame. */
+	const int16 *getCoeffs(uint phase) const {
+		if (phases != outStep)
+			phase = phase * phases / outStep;
+		return coeffs + phase * kTaps;
+	}
+};
+
+SincFilter::SincFilter(uint in, uint out) : inStep(in), outStep(out), next(0) {
+	phases = MIN<uint>(outStep, kMaxPhases);
+	coeffs = new int16[phases * kTaps];
+
+	// When downsampling, cut off below the Nyquist frequency of the output
+	const double cutoff = (outStep < inStep) ? (double)outStep / inStep : 1.0;
+	const double windowScale = 1.0 / besselI0(kKaiserBeta);
+
+	for (uint p = 0; p < phases; p++) {
+		double taps[kTaps];
+		double sum = 0.0;
+
+		for (uint k = 0; k < kTaps; k++) {
+			// Distance of the input sample from the output position, which
+			// lies between the taps kTaps / 2 - 1 and kTaps / 2
+			const double x = (double)k - (kTaps / 2 - 1) - (double)p / phases;
+			const double t = x / (kTaps / 2);
+			const double window = (t > -1.0 && t < 1.0) ? besselI0(kKaiserBeta * sqrt(1.0 - t * t)) * windowScale : 0.0;
+			const double arg = M_PI * cutoff * x;
+			const double sinc = (fabs(arg) < 1e-9) ? 1.0 : sin(arg) / arg;
+
+			taps[k] = sinc * window;
+			sum += taps[k];
+		}
+
+		// Normalize every phase to unity gain, so constant signals stay so
+		for (uint k = 0; k < kTaps; k++)
+			coeffs[p * kTaps + k] = (int16)floor(taps[k] / sum * (1 << kCoeffBits) + 0.5);
+	}
+}
+
+/**
+ * The filters kept for later converters. The list only grows, so it can be
+ * searched without locking, which matters as converters are created on the
+ * audio and timer threads as well. It is never freed, as converters may
+ * still be in use on those threads while the program exits.
+ */
+static SincFilter *volatile s_sincFilters = 0;
+
+/** Number of filters in s_sincFilters, or reserved to be added to it. */
+static volatile int32 s_sincFilterCount = 0;
+
+static const SincFilter *findSincFilter(const SincFilter *filter, const SincFilter *end, uint inStep, uint outStep) {
+	for (; filter != end; filter = filter->next) {
+		if (filter->inStep == inStep && filter->outStep == outStep)
+			return filter;
+	}
+	return 0;
+}
+
+/**
+ * Return the filter for a ratio. When the list of filters is full, the
+ * filter is not added to it, and returned in owned as well, to be deleted
+ * by the caller.
+ */
+static const SincFilter *getSincFilter(uint inStep, uint outStep, SincFilter *&owned) {
+	owned = 0;
+
+	SincFilter *head = Common::atomicLoad(&s_sincFilters);
+	const SincFilter *found = findSincFilter(head, 0, inStep, outStep);
+	if (found)
+		return found;
+
+	SincFilter *filter = new SincFilter(inStep, outStep);
+	if (Common::atomicAdd(&s_sincFilterCount, 1) > kMaxSincFilters) {
+		Common::atomicAdd(&s_sincFilterCount, -1);
+		owned = filter;
+		return filter;
+	}
+
+	for (;;) {
+		filter->next = head;
+		if (Common::atomicCompareExchange(&s_sincFilters, head, filter))
+			return filter;
+
+		// Another thread added filters meanwhile, possibly this very one
+		SincFilter *newHead = Common::atomicLoad(&s_sincFilters);
+		found = findSincFilter(newHead, head, inStep, outStep);
+		if (found) {
+			Common::atomicAdd(&s_sincFilterCount, -1);
+			delete filter;
+			return found;
+		}
+		head = newHead;
+	}
+}
+
+/** Apply the filter to kTaps samples, returning the result scaled by 1 << kCoeffBits. */
+static inline int32 dotProduct(const int16 *samples, const int16 *coeffs) {
+#if defined(__SSE2__)
+	__m128i sum = _mm_setzero_si128();
+	for (uint i = 0; i < kTaps; i += 8)
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(samples + i)), _mm_loadu_si128((const __m128i *)(coeffs + i))));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	int32x4_t sum = vdupq_n_s32(0);
+	for (uint i = 0; i < kTaps; i += 4)
+		sum = vmlal_s16(sum, vld1_s16((const int16_t *)(samples + i)), vld1_s16((const int16_t *)(coeffs + i)));
+	const int32x2_t pair = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+	return vget_lane_s32(vpadd_s32(pair, pair), 0);
+#else
+	int32 sum = 0;
+	for (uint i = 0; i < kTaps; i++)
+		sum += samples[i] * coeffs[i];
+	return sum;
+#endif
+}
+
+static inline int filterSample(const int16 *samples, const int16 *coeffs) {
+	const int32 sum = (dotProduct(samples, coeffs) + (1 << (kCoeffBits - 1))) >> kCoeffBits;
+	return CLIP<int32>(sum, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+}
+
+/**
+ * Audio rate converter based on a polyphase windowed sinc filter.
+ *
+ * The filter delays the output by kTaps / 2 input frames, which are not
+ * flushed when the input stream ends.
+ */
+template<bool stereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+protected:
+	const SincFilter *_filter;
+	/** The filter, if it is not kept in the list of filters. */
+	SincFilter *_ownedFilter;
+
+	/** Input samples of each channel, starting with the oldest one still needed. */
+	int16 _samples[stereo ? 2 : 1][kInputFrames + kTaps];
+	/** Number of frames in _samples. */
+	uint _avail;
+	/** First frame of the window for the next output frame. */
+	uint _pos;
+	/** Position of the next output frame after _pos + kTaps / 2 - 1, in 1 / outStep units. */
+	uint _phase;
+
+	st_sample_t _readBuffer[kInputFrames * (stereo ? 2 : 1)];
+
+	bool refill(AudioStream &input);
+
+	template<class T>
+	int flowImpl(AudioStream &input, T *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+
+public:
+	SincRateConverter(st_rate_t inrate, st_rate_t outrate);
+	~SincRateConverter() { delete _ownedFilter; }
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return flowImpl(input, obuf, osamp, vol_l, vol_r);
+	}
+	int flowMix(AudioStream &input, st_mix_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return flowImpl(input, obuf, osamp, vol_l, vol_r);
+	}
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+		return ST_SUCCESS;
+	}
+};
+
+template<bool stereo, bool reverseStereo>
+SincRateConverter<stereo, reverseStereo>::SincRateConverter(st_rate_t inrate, st_rate_t outrate) {
+	if (inrate == 0 || outrate == 0)
+		error("SincRateConverter: Invalid rate conversion %d -> %d", inrate, outrate);
+
+	const st_rate_t divisor = Common::gcd(inrate, outrate);
+	_filter = getSincFilter(inrate / divisor, outrate / divisor, _ownedFilter);
+
+	// Start with silence before the first input frame
+	memset(_samples, 0, sizeof(_samples));
+	_avail = kTaps / 2 - 1;
+	_pos = 0;
+	_phase = 0;
+}
+
+template<bool stereo, bool reverseStereo>
+bool SincRateConverter<stereo, reverseStereo>::refill(AudioStream &input) {
+	// Move the frames the window still needs to the front. When
+	// downsampling, the window may already lie beyond the buffered frames.
+	if (_pos >= _avail) {
+		_pos -= _avail;
+		_avail = 0;
+	} else if (_pos > 0) {
+		_avail -= _pos;
+		for (int c = 0; c < (stereo ? 2 : 1); c++)
+			memmove(_samples[c], _samples[c] + _pos, _avail * sizeof(int16));
+		_pos = 0;
+	}
+
+	const uint frames = MIN<uint>(kInputFrames, kInputFrames + kTaps - _avail);
+	const int read = input.readBuffer(_readBuffer, frames * (stereo ? 2 : 1));
+	if (read <= 0)
+		return false;
+
+	if (stereo) {
+		for (int i = 0; i < read / 2; i++) {
+			_samples[0][_avail + i] = _readBuffer[i * 2];
+			_samples[stereo ? 1 : 0][_avail + i] = _readBuffer[i * 2 + 1];
+		}
+		_avail += read / 2;
+	} else {
+		memcpy(_samples[0] + _avail, _readBuffer, read * sizeof(int16));
+		_avail += read;
+	}
+	return true;
+}
+
+/*
+ * Process input samples to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+template<class T>
+int SincRateConverter<stereo, reverseStereo>::flowImpl(AudioStream &input, T *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	assert(input.isStereo() == stereo);
+
+	const uint inStep = _filter->inStep;
+	const uint outStep = _filter->outStep;
+	T *ostart = obuf;
+	T *oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+		while (_pos + kTaps > _avail) {
+			if (!refill(input))
+				return (obuf - ostart) / 2;
+		}
+
+		const int16 *coeffs = _filter->getCoeffs(_phase);
+		const int out0 = filterSample(_samples[0] + _pos, coeffs);
+		const int out1 = stereo ? filterSample(_samples[stereo ? 1 : 0] + _pos, coeffs) : out0;
+
+		// output left channel
+		addSample(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		addSample(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+
+		// Advance by inStep / outStep input frames
+		_phase += inStep;
+		if (_phase >= outStep) {
+			_pos += _phase / outStep;
+			_phase %= outStep;
+		}
+	}
+	return (obuf - ostart) / 2;
+}
+
+RateConverter *makeSincRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+	if (stereo) {
+		if (reverseStereo)
+			return new SincRateConverter<true, true>(inrate, outrate);
+		else
+			return new SincRateConverter<true, false>(inrate, outrate);
+	} else
+		return new SincRateConverter<false, false>(inrate, outrate);
+}
+
+} // End of namespace Audio
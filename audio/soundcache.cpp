@@ -0,0 +1,212 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/soundcache.h"
+
+#include "audio/audiostream.h"
+#include "audio/decoders/raw.h"
+
+#include "common/array.h"
+#include "common/atomic.h"
+#include "common/memstream.h"
+
+namespace Common {
+DECLARE_SINGLETON(Audio::DecodedSoundCache);
+}
+
+namespace Audio {
+
+struct DecodedSoundCache::CachedSound {
+	DecodedSoundKey key;
+	/** The decoded samples, in native endianness. */
+	byte *data;
+	uint32 size;
+	int rate;
+	bool stereo;
+	/** One reference is held by the cache, one by each stream playing it. */
+	volatile int32 refCount;
+
+	CachedSound(const DecodedSoundKey &k, byte *d, uint32 s, int r, bool st) : key(k), data(d), size(s), rate(r), stereo(st), refCount(1) {}
+
+	void addRef() {
+		Common::atomicAdd(&refCount, 1);
+	}
+
+	void release() {
+		if (Common::atomicAdd(&refCount, -1) == 0) {
+			free(data);
+			delete this;
+		}
+	}
+};
+
+/**
+ * A read stream over the samples of a cached sound, which keeps them alive.
+ */
+class CachedSoundReadStream : public Common::MemoryReadStream {
+public:
+	CachedSoundReadStream(DecodedSoundCache::CachedSound *sound) : Common::MemoryReadStream(sound->data, sound->size), _sound(sound) {
+		_sound->addRef();
+	}
+
+	~CachedSoundReadStream() {
+		_sound->release();
+	}
+
+private:
+	DecodedSoundCache::CachedSound *_sound;
+};
+
+static SeekableAudioStream *makeCachedSoundStream(DecodedSoundCache::CachedSound *sound) {
+	byte flags = FLAG_16BITS;
+#ifdef SCUMM_LITTLE_ENDIAN
+	flags |= FLAG_LITTLE_ENDIAN;
+#endif
+	if (sound->stereo)
+		flags |= FLAG_STEREO;
+
+	return makeRawStream(new CachedSoundReadStream(sound), sound->rate, flags, DisposeAfterUse::YES);
+}
+
+DecodedSoundCache::DecodedSoundCache() : _maxSoundSize(kDefaultMaxSoundSize), _memoryLimit(kDefaultMemoryLimit) {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+DecodedSoundCache::~DecodedSoundCache() {
+	clear();
+}
+
+SeekableAudioStream *DecodedSoundCache::find(const DecodedSoundKey &key) {
+	SoundMap::iterator entry = _index.find(key);
+	if (entry == _index.end())
+		return 0;
+
+	_stats.hits++;
+
+	// Move the sound to the front of the list
+	CachedSound *sound = *entry->_value;
+	_sounds.erase(entry->_value);
+	_sounds.push_front(sound);
+	entry->_value = _sounds.begin();
+
+	return makeCachedSoundStream(sound);
+}
+
+RewindableAudioStream *DecodedSoundCache::decode(const DecodedSoundKey &key, RewindableAudioStream *stream) {
+	if (!stream)
+		return 0;
+
+	if (_tooLarge.contains(key)) {
+		_stats.tooLarge++;
+		return stream;
+	}
+
+	Common::Array<int16> samples;
+	const uint32 maxSamples = MIN(_maxSoundSize, _memoryLimit) / 2;
+	const uint32 kChunk = 4096;
+
+	while (!stream->endOfData()) {
+		const uint32 used = samples.size();
+		if (used >= maxSamples) {
+			// Too long, play it as it is
+			_tooLarge[key] = true;
+			_stats.tooLarge++;
+			stream->rewind();
+			return stream;
+		}
+
+		samples.resize(used + kChunk);
+		const int read = stream->readBuffer(&samples[used], kChunk);
+		samples.resize(used + MAX(read, 0));
+		if (read <= 0)
+			break;
+	}
+
+	_stats.misses++;
+
+	const uint32 size = samples.size() * 2;
+	byte *data = (byte *)malloc(MAX<uint32>(size, 1));
+	if (size)
+		memcpy(data, samples.begin(), size);
+
+	CachedSound *sound = new CachedSound(key, data, size, stream->getRate(), stream->isStereo());
+	delete stream;
+
+	// Replace an older copy, in case the caller didn't check for one
+	SoundMap::iterator entry = _index.find(key);
+	if (entry != _index.end()) {
+		_stats.memory -= (*entry->_value)->size;
+		(*entry->_value)->release();
+		_sounds.erase(entry->_value);
+		_index.erase(entry);
+	}
+
+	makeRoom(size);
+	_sounds.push_front(sound);
+	_index[key] = _sounds.begin();
+	_stats.memory += size;
+
+	return makeCachedSoundStream(sound);
+}
+
+void DecodedSoundCache::makeRoom(uint32 size) {
+	while (!_sounds.empty() && _stats.memory + size > _memoryLimit) {
+		CachedSound *sound = _sounds.back();
+		_sounds.pop_back();
+		_index.erase(sound->key);
+		_stats.memory -= sound->size;
+		_stats.evictions++;
+		sound->release();
+	}
+}
+
+void DecodedSoundCache::setLimits(uint32 maxSoundSize, uint32 memoryLimit) {
+	_maxSoundSize = maxSoundSize;
+	_memoryLimit = memoryLimit;
+	_tooLarge.clear();
+	makeRoom(0);
+}
+
+void DecodedSoundCache::clear() {
+	for (SoundList::iterator i = _sounds.begin(); i != _sounds.end(); ++i)
+		(*i)->release();
+
+	_sounds.clear();
+	_index.clear();
+	_tooLarge.clear();
+	_stats.memory = 0;
+}
+
+DecodedSoundCache::Stats DecodedSoundCache::getStats() const {
+	Stats stats = _stats;
+	stats.sounds = _sounds.size();
+	stats.memoryLimit = _memoryLimit;
+	return stats;
+}
+
+void DecodedSoundCache::resetStats() {
+	const uint32 memory = _stats.memory;
+	memset(&_stats, 0, sizeof(_stats));
+	_stats.memory = memory;
+}
+
+} // End of namespace Audio
@@ -0,0 +1,156 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_SOUNDCACHE_H
+#define AUDIO_SOUNDCACHE_H
+
+#include "common/scummsys.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+namespace Audio {
+
+class RewindableAudioStream;
+class SeekableAudioStream;
+
+/**
+ * Identifies a compressed sound: the resource it is stored in, usually a
+ * file name, and its byte range in there.
+ */
+struct DecodedSoundKey {
+	Common::String source;
+	uint32 offset;
+	uint32 size;
+
+	DecodedSoundKey() : offset(0), size(0) {}
+	DecodedSoundKey(const Common::String &s, uint32 o, uint32 sz) : source(s), offset(o), size(sz) {}
+
+	bool operator==(const DecodedSoundKey &other) const {
+		return offset == other.offset && size == other.size && source == other.source;
+	}
+};
+
+struct DecodedSoundKeyHash {
+	uint operator()(const DecodedSoundKey &key) const {
+		return Common::hashit(key.source.c_str()) ^ (key.offset * 2654435761U) ^ key.size;
+	}
+};
+
+/**
+ * A cache of fully decoded short sounds, for effects which engines decode
+ * from the same compressed data every time they are played.
+ *
+ * Usage:
+ * @code
+ * Audio::DecodedSoundKey key(fileName, offset, size);
+ * Audio::RewindableAudioStream *stream = SoundCache.find(key);
+ * if (!stream)
+ *     stream = SoundCache.decode(key, Audio::makeVorbisStream(data, DisposeAfterUse::YES));
+ * @endcode
+ *
+ * The streams handed out share the decoded samples. They may be used on
+ * any thread, and keep their samples alive when the sound is evicted from
+ * the cache. The cache itself is not thread safe; it is meant to be used
+ * from the engine thread.
+ */
+class DecodedSoundCache : public Common::Singleton<DecodedSoundCache> {
+public:
+	struct Stats {
+		uint32 hits;
+		/** Sounds which were decoded and cached. */
+		uint32 misses;
+		/** Sounds which were too long to be cached, these aren't misses. */
+		uint32 tooLarge;
+		uint32 evictions;
+		/** Number of cached sounds. */
+		uint32 sounds;
+		/** Bytes used by cached sounds. */
+		uint32 memory;
+		uint32 memoryLimit;
+	};
+
+	enum {
+		/** Largest decoded sound kept, about three seconds of stereo 44.1 kHz. */
+		kDefaultMaxSoundSize = 512 * 1024,
+		/** Total size of the decoded sounds kept. */
+		kDefaultMemoryLimit = 8 * 1024 * 1024
+	};
+
+	/** Use the SoundCache instance, other instances are only useful for testing. */
+	DecodedSoundCache();
+	~DecodedSoundCache();
+
+	/**
+	 * Return a new stream playing the cached sound for the given key, or 0
+	 * if it isn't cached.
+	 */
+	SeekableAudioStream *find(const DecodedSoundKey &key);
+
+	/**
+	 * Decode a stream completely and cache the result under the given key.
+	 *
+	 * @param key		the key to cache the sound under
+	 * @param stream	the stream to decode, which is deleted
+	 * @return a new stream playing the cached sound, or the rewound stream
+	 *         itself if it is too long to be cached
+	 */
+	RewindableAudioStream *decode(const DecodedSoundKey &key, RewindableAudioStream *stream);
+
+	/** Change the size limits, evicting sounds as needed. */
+	void setLimits(uint32 maxSoundSize, uint32 memoryLimit);
+
+	/** Drop all sounds. Streams still playing keep theirs. */
+	void clear();
+
+	Stats getStats() const;
+	void resetStats();
+
+	struct CachedSound;
+
+private:
+	typedef Common::List<CachedSound *> SoundList;
+	typedef Common::HashMap<DecodedSoundKey, SoundList::iterator, DecodedSoundKeyHash> SoundMap;
+	typedef Common::HashMap<DecodedSoundKey, bool, DecodedSoundKeyHash> KeySet;
+
+	/** Evict the least recently used sounds until there is room for the given number of bytes. */
+	void makeRoom(uint32 size);
+
+	/** The sounds, the most recently used one first. */
+	SoundList _sounds;
+	SoundMap _index;
+	/** Keys of sounds known to exceed _maxSoundSize, which aren't decoded again. */
+	KeySet _tooLarge;
+
+	uint32 _maxSoundSize;
+	uint32 _memoryLimit;
+	Stats _stats;
+};
+
+} // End of namespace Audio
+
+/** Shortcut for accessing the decoded sound cache. */
+#define SoundCache Audio::DecodedSoundCache::instance()
+
+#endif
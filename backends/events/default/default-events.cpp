@@ -91,6 +91,10 @@ bool DefaultEventManager::pollEvent(Common::Event &event) {
 	bool result = false;
 
 	_dispatcher.dispatch();
+
+	// Write config changes which were deferred to batch them up
+	ConfMan.processPendingFlush();
+
 	if (!_eventQueue.empty()) {
 		event = _eventQueue.pop();
 		result = true;
@@ -159,6 +159,17 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and the time of the last modification of the file
+	 * referred by this node, without opening it.
+	 *
+	 * The modification time is only meant to be compared against earlier
+	 * values for the same file; its unit and epoch depend on the backend.
+	 *
+	 * @return bool true if both values could be determined, false otherwise
+	 *         (e.g. if the backend does not support it).
+	 */
+	virtual bool getFileInfo(uint32 &size, uint32 &modificationTime) const { return false; }
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
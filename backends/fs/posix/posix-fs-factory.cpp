@@ -32,6 +32,10 @@
 #include "backends/fs/posix/posix-fs-factory.h"
 #include "backends/fs/posix/posix-fs.h"
 
+void POSIXFilesystemFactory::setMemoryMapFiles(bool enable) {
+	POSIXFilesystemNode::setMemoryMapFiles(enable);
+}
+
 AbstractFSNode *POSIXFilesystemFactory::makeRootFileNode() const {
 	return new POSIXFilesystemNode("/");
 }
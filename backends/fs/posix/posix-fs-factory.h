@@ -31,6 +31,14 @@
  * Parts of this class are documented in the base interface class, FilesystemFactory.
  */
 class POSIXFilesystemFactory : public FilesystemFactory {
+public:
+	/**
+	 * Set whether files are memory mapped instead of read through stdio,
+	 * see the "mmap_files" config key. Backends call this once the config
+	 * is loaded, instead of every file opened querying ConfMan.
+	 */
+	static void setMemoryMapFiles(bool enable);
+
 protected:
 	virtual AbstractFSNode *makeRootFileNode() const;
 	virtual AbstractFSNode *makeCurrentDirectoryFileNode() const;
@@ -34,6 +34,10 @@
 #include "backends/fs/stdiostream.h"
 #include "common/algorithm.h"
 
+#ifdef POSIX
+#include "backends/fs/posix/posix-mmapstream.h"
+#endif
+
 #include <sys/param.h>
 #include <sys/stat.h>
 #include <dirent.h>
@@ -45,6 +49,8 @@
 #endif
 
 
+bool POSIXFilesystemNode::_memoryMapFiles = false;
+
 void POSIXFilesystemNode::setFlags() {
 	struct stat st;
 
@@ -243,7 +249,27 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 	return makeNode(Common::String(start, end));
 }
 
+bool POSIXFilesystemNode::getFileInfo(uint32 &size, uint32 &modificationTime) const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || S_ISDIR(st.st_mode))
+		return false;
+
+	size = (uint32)st.st_size;
+	modificationTime = (uint32)st.st_mtime;
+	return true;
+}
+
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
+#ifdef POSIX
+	// Memory mapping the files is opt-in. If it fails, we fall back to stdio.
+	if (_memoryMapFiles) {
+		Common::SeekableReadStream *stream = PosixMmapStream::makeFromPath(getPath());
+		if (stream)
+			return stream;
+	}
+#endif
+
 	return StdioStream::makeFromPath(getPath(), false);
 }
 
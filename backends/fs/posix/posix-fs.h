@@ -66,6 +66,7 @@ public:
 	virtual bool isDirectory() const { return _isDirectory; }
 	virtual bool isReadable() const { return access(_path.c_str(), R_OK) == 0; }
 	virtual bool isWritable() const { return access(_path.c_str(), W_OK) == 0; }
+	virtual bool getFileInfo(uint32 &size, uint32 &modificationTime) const;
 
 	virtual AbstractFSNode *getChild(const Common::String &n) const;
 	virtual bool getChildren(AbstractFSList &list, ListMode mode, bool hidden) const;
@@ -74,7 +75,12 @@ public:
 	virtual Common::SeekableReadStream *createReadStream();
 	virtual Common::WriteStream *createWriteStream();
 
+	/** Set whether createReadStream() memory maps files. */
+	static void setMemoryMapFiles(bool enable) { _memoryMapFiles = enable; }
+
 private:
+	static bool _memoryMapFiles;
+
 	/**
 	 * Tests and sets the _isValid and _isDirectory flags, using the stat() function.
 	 */
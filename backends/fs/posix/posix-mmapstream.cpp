@@ -0,0 +1,105 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#if defined(POSIX)
+
+// Re-enable some forbidden symbols to avoid clashes with stat.h and unistd.h.
+// Also with clock() in sys/time.h in some Mac OS X SDKs.
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_mkdir
+#define FORBIDDEN_SYMBOL_EXCEPTION_exit		//Needed for IRIX's unistd.h
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+PosixMmapStream::Mapping::Mapping(void *d, uint32 s) : data(d), size(s) {
+}
+
+PosixMmapStream::Mapping::~Mapping() {
+	munmap(data, size);
+}
+
+PosixMmapStream::PosixMmapStream(const MappingPtr &mapping, const byte *data, uint32 size) :
+	Common::MemoryReadStream(data, size), _mapping(mapping), _data(data) {
+}
+
+PosixMmapStream *PosixMmapStream::makeFromPath(const Common::String &path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	// Small files are read faster than they are mapped
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size < kMinMapSize) || (st.st_size > 0x7FFFFFFF)) {
+		close(fd);
+		return 0;
+	}
+
+	void *data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		close(fd);
+		return 0;
+	}
+
+	// Pages past the end of the file raise SIGBUS when touched, so don't use
+	// the mapping if the file was truncated in the meantime
+	struct stat mapped;
+	if ((fstat(fd, &mapped) != 0) || (mapped.st_size != st.st_size)) {
+		munmap(data, st.st_size);
+		close(fd);
+		return 0;
+	}
+
+	// The mapping stays valid after closing the file descriptor
+	close(fd);
+
+	MappingPtr mapping(new Mapping(data, st.st_size));
+
+	return new PosixMmapStream(mapping, (const byte *)data, st.st_size);
+}
+
+Common::SeekableReadStream *PosixMmapStream::readStream(uint32 dataSize) {
+	const uint32 offset = pos();
+	const uint32 left   = size() - offset;
+
+	const bool shortRead = dataSize > left;
+	if (shortRead)
+		dataSize = left;
+
+	// Advance our position as if the data was read
+	seek(dataSize, SEEK_CUR);
+
+	if (shortRead) {
+		// Let the base class set the eos flag, as it would on a short read
+		byte dummy;
+		read(&dummy, 1);
+	}
+
+	return new PosixMmapStream(_mapping, _data + offset, dataSize);
+}
+
+#endif
@@ -0,0 +1,80 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_MMAPSTREAM_H
+#define BACKENDS_FS_POSIX_MMAPSTREAM_H
+
+#include "common/scummsys.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/str.h"
+
+/**
+ * A read-only view onto a memory mapped file.
+ *
+ * The mapping is shared between the stream and all sub views created with
+ * readStream(), which hand out parts of the file without copying them. It is
+ * unmapped once the last of those is destroyed.
+ *
+ * Reading a part of a file which was truncated while it is mapped raises
+ * SIGBUS. Files changing their size while they are mapped aren't used, but
+ * nothing protects against truncating them later, which is the reason
+ * memory mapping is opt-in.
+ */
+class PosixMmapStream : public Common::MemoryReadStream {
+public:
+	/**
+	 * Given a path, maps the whole file into memory and wraps it in a
+	 * PosixMmapStream instance. Returns 0 if the file can't be mapped.
+	 */
+	static PosixMmapStream *makeFromPath(const Common::String &path);
+
+	/**
+	 * Return a view of the next dataSize bytes, sharing the mapping
+	 * instead of copying the data into a new buffer.
+	 */
+	virtual Common::SeekableReadStream *readStream(uint32 dataSize);
+
+private:
+	enum {
+		/** Smaller files are left to stdio. */
+		kMinMapSize = 64 * 1024
+	};
+
+	/** A memory mapped file, unmapped on destruction. */
+	struct Mapping {
+		void *data;
+		uint32 size;
+
+		Mapping(void *d, uint32 s);
+		~Mapping();
+	};
+
+	typedef Common::SharedPtr<Mapping> MappingPtr;
+
+	MappingPtr _mapping;
+	const byte *_data;
+
+	PosixMmapStream(const MappingPtr &mapping, const byte *data, uint32 size);
+};
+
+#endif
@@ -223,6 +223,24 @@ AbstractFSNode *PSPFilesystemNode::getParent() const {
 	return node;
 }
 
+bool PSPFilesystemNode::getFileInfo(uint32 &size, uint32 &modificationTime) const {
+	DEBUG_ENTER_FUNC();
+	struct stat st;
+
+	if (PowerMan.beginCriticalSection() == PowerManager::Blocked)
+		PSP_DEBUG_PRINT_FUNC("Suspended\n");	// Make sure to block in case of suspend
+
+	const bool ok = (stat(_path.c_str(), &st) == 0) && !S_ISDIR(st.st_mode);
+	PowerMan.endCriticalSection();
+
+	if (!ok)
+		return false;
+
+	size = (uint32)st.st_size;
+	modificationTime = (uint32)st.st_mtime;
+	return true;
+}
+
 Common::SeekableReadStream *PSPFilesystemNode::createReadStream() {
 	const uint32 READ_BUFFER_SIZE = 1024;
 
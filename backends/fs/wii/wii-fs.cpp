@@ -205,6 +205,17 @@ AbstractFSNode *WiiFilesystemNode::getParent() const {
 	return new WiiFilesystemNode(Common::String(start, end - start));
 }
 
+bool WiiFilesystemNode::getFileInfo(uint32 &size, uint32 &modificationTime) const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || S_ISDIR(st.st_mode))
+		return false;
+
+	size = (uint32)st.st_size;
+	modificationTime = (uint32)st.st_mtime;
+	return true;
+}
+
 Common::SeekableReadStream *WiiFilesystemNode::createReadStream() {
 	return StdioStream::makeFromPath(getPath(), false);
 }
@@ -25,6 +25,7 @@
 #if defined(SDL_BACKEND)
 
 #include "backends/mixer/sdl/sdl-mixer.h"
+#include "common/atomic.h"
 #include "common/debug.h"
 #include "common/system.h"
 #include "common/config-manager.h"
@@ -39,7 +40,12 @@
 SdlMixerManager::SdlMixerManager()
 	:
 	_mixer(0),
-	_audioSuspended(false) {
+	_audioSuspended(false),
+	_callbacks(0),
+	_underruns(0),
+	_slowCallbacks(0),
+	_maxCallbackMicros(0),
+	_lastCallbackMicros(0) {
 
 }
 
@@ -48,6 +54,10 @@ SdlMixerManager::~SdlMixerManager() {
 
 	SDL_CloseAudio();
 
+	const CallbackStats stats = getCallbackStats();
+	debug(1, "Audio callback: %u calls, %u underruns, %u slower than a buffer period, %u us at most",
+	      stats.callbacks, stats.underruns, stats.slowCallbacks, stats.maxCallbackMicros);
+
 	delete _mixer;
 }
 
@@ -147,7 +157,31 @@ void SdlMixerManager::sdlCallback(void *this_, byte *samples, int len) {
 	SdlMixerManager *manager = (SdlMixerManager *)this_;
 	assert(manager);
 
+	const uint64 start = g_system->getMicros();
 	manager->callbackHandler(samples, len);
+	const uint32 duration = (uint32)(g_system->getMicros() - start);
+
+	// The samples requested from us last that long on the device. The
+	// mixer always produces 16 bit stereo samples.
+	const uint32 period = (uint32)((uint64)(len / 4) * 1000000 / manager->_mixer->getOutputRate());
+
+	if (manager->_lastCallbackMicros && start - manager->_lastCallbackMicros > 2 * period)
+		Common::atomicStore(&manager->_underruns, manager->_underruns + 1);
+	if (duration > period)
+		Common::atomicStore(&manager->_slowCallbacks, manager->_slowCallbacks + 1);
+	if (duration > manager->_maxCallbackMicros)
+		Common::atomicStore(&manager->_maxCallbackMicros, duration);
+	Common::atomicStore(&manager->_callbacks, manager->_callbacks + 1);
+	manager->_lastCallbackMicros = start;
+}
+
+SdlMixerManager::CallbackStats SdlMixerManager::getCallbackStats() const {
+	CallbackStats stats;
+	stats.callbacks = Common::atomicLoad(&_callbacks);
+	stats.underruns = Common::atomicLoad(&_underruns);
+	stats.slowCallbacks = Common::atomicLoad(&_slowCallbacks);
+	stats.maxCallbackMicros = Common::atomicLoad(&_maxCallbackMicros);
+	return stats;
 }
 
 void SdlMixerManager::suspendAudio() {
@@ -161,6 +195,8 @@ int SdlMixerManager::resumeAudio() {
 	if (SDL_OpenAudio(&_obtained, NULL) < 0) {
 		return -1;
 	}
+	// The pause is no underrun
+	_lastCallbackMicros = 0;
 	SDL_PauseAudio(0);
 	_audioSuspended = false;
 	return 0;
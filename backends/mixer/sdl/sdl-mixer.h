@@ -59,6 +59,30 @@ public:
 	 */
 	virtual int resumeAudio();
 
+	/**
+	 * Counters about the punctuality of the audio callback, to tell how
+	 * often the device was likely starved.
+	 */
+	struct CallbackStats {
+		/** Number of callbacks so far. */
+		uint32 callbacks;
+		/**
+		 * Number of callbacks which came more than two buffer periods
+		 * after the previous one, so that the device ran out of samples.
+		 */
+		uint32 underruns;
+		/** Number of callbacks which took longer than one buffer period. */
+		uint32 slowCallbacks;
+		/** The longest time a callback took, in microseconds. */
+		uint32 maxCallbackMicros;
+	};
+
+	/**
+	 * Get the callback counters. They are updated by the audio thread, so
+	 * they may be off by one callback.
+	 */
+	CallbackStats getCallbackStats() const;
+
 protected:
 	/** The mixer implementation */
 	Audio::MixerImpl *_mixer;
@@ -72,6 +96,15 @@ protected:
 	/** State of the audio system */
 	bool _audioSuspended;
 
+	/** Only written by the audio thread, in sdlCallback(). */
+	volatile uint32 _callbacks;
+	volatile uint32 _underruns;
+	volatile uint32 _slowCallbacks;
+	volatile uint32 _maxCallbackMicros;
+
+	/** Start of the previous callback, 0 before the first one. */
+	uint64 _lastCallbackMicros;
+
 	/**
 	 * Returns the desired audio specification
 	 */
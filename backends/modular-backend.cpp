@@ -26,6 +26,9 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/mutex/mutex.h"
+#include "common/profiler.h"
+#include "common/savefile.h"
+#include "common/threadpool.h"
 #include "gui/EventRecorder.h"
 
 #include "audio/mixer.h"
@@ -40,6 +43,12 @@ ModularBackend::ModularBackend()
 }
 
 ModularBackend::~ModularBackend() {
+	// Stop the worker threads first, their tasks may use the other managers.
+	// Savefiles still being written in the background need them, though.
+	if (_savefileManager)
+		_savefileManager->flushSavefiles();
+	delete _threadPool;
+	_threadPool = 0;
 	delete _graphicsManager;
 	_graphicsManager = 0;
 	delete _mixer;
@@ -142,6 +151,8 @@ void ModularBackend::fillScreen(uint32 col) {
 }
 
 void ModularBackend::updateScreen() {
+	PROFILE_SCOPE("system.update_screen");
+
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.preDrawOverlayGui();
 #endif
@@ -16,6 +16,7 @@ MODULE_OBJS := \
 	midi/timidity.o \
 	saves/savefile.o \
 	saves/default/default-saves.o \
+	threads/threadpool.o \
 	timer/default/default-timer.o
 
 
@@ -70,6 +71,7 @@ MODULE_OBJS += \
 	mixer/sdl/sdl-mixer.o \
 	mutex/sdl/sdl-mutex.o \
 	plugins/sdl/sdl-provider.o \
+	threads/sdl/sdl-threadpool.o \
 	timer/sdl/sdl-timer.o
 
 # SDL 1.3 removed audio CD support
@@ -88,11 +90,17 @@ ifdef POSIX
 MODULE_OBJS += \
 	fs/posix/posix-fs.o \
 	fs/posix/posix-fs-factory.o \
+	fs/posix/posix-mmapstream.o \
 	plugins/posix/posix-provider.o \
 	saves/posix/posix-saves.o \
 	taskbar/unity/unity-taskbar.o
 endif
 
+ifdef USE_PTHREADS
+MODULE_OBJS += \
+	threads/posix/posix-threadpool.o
+endif
+
 ifdef MACOSX
 MODULE_OBJS += \
 	midi/coreaudio.o \
@@ -304,6 +304,8 @@ static int findGames(Game *games, int max, bool use_ini)
     }
   }
 
+  EngineMan.flushDetectionCache();
+
   for (int i=0; i<curr_game; i++)
     if (!loadIcon(games[i], dirs, num_dirs))
       makeDefIcon(games[i].icon);
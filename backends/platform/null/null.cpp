@@ -38,6 +38,7 @@
 #include "backends/mutex/null/null-mutex.h"
 #include "backends/graphics/null/null-graphics.h"
 #include "audio/mixer_intern.h"
+#include "common/config-manager.h"
 #include "common/scummsys.h"
 
 /*
@@ -91,6 +92,10 @@ void OSystem_NULL::initBackend() {
 	_graphicsManager = new NullGraphicsManager();
 	_mixer = new Audio::MixerImpl(this, 22050);
 
+#if defined(POSIX) && !defined(__amigaos4__)
+	POSIXFilesystemFactory::setMemoryMapFiles(ConfMan.getBool("mmap_files"));
+#endif
+
 	((Audio::MixerImpl *)_mixer)->setReady(false);
 
 	// Note that both the mixer and the timer manager are useless
@@ -31,12 +31,17 @@
 #ifdef POSIX
 
 #include "backends/platform/sdl/posix/posix.h"
+#include "common/config-manager.h"
 #include "backends/saves/posix/posix-saves.h"
 #include "backends/fs/posix/posix-fs-factory.h"
 #include "backends/taskbar/unity/unity-taskbar.h"
+#ifdef USE_PTHREADS
+#include "backends/threads/posix/posix-threadpool.h"
+#endif
 
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -55,6 +60,11 @@ void OSystem_POSIX::init() {
 	_taskbarManager = new UnityTaskbarManager();
 #endif
 
+#ifdef USE_PTHREADS
+	// Unlike SDL 1.2, pthreads let us use as many workers as there are CPUs
+	_threadPool = new PosixThreadPool();
+#endif
+
 	// Invoke parent implementation of this method
 	OSystem_SDL::init();
 }
@@ -64,6 +74,9 @@ void OSystem_POSIX::initBackend() {
 	if (_savefileManager == 0)
 		_savefileManager = new POSIXSaveFileManager();
 
+	// Files are opened all the time, so this isn't looked up for each of them
+	POSIXFilesystemFactory::setMemoryMapFiles(ConfMan.getBool("mmap_files"));
+
 	// Invoke parent implementation of this method
 	OSystem_SDL::initBackend();
 
@@ -73,6 +86,12 @@ void OSystem_POSIX::initBackend() {
 #endif
 }
 
+uint64 OSystem_POSIX::getMicros() {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint64)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
 bool OSystem_POSIX::hasFeature(Feature f) {
 	if (f == kFeatureDisplayLogFile)
 		return true;
@@ -35,6 +35,8 @@ public:
 
 	virtual bool displayLogFile();
 
+	virtual uint64 getMicros();
+
 	virtual void init();
 	virtual void initBackend();
 
@@ -45,6 +45,7 @@
 
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/mutex/sdl/sdl-mutex.h"
+#include "backends/threads/sdl/sdl-threadpool.h"
 #include "backends/timer/sdl/sdl-timer.h"
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
 #ifdef USE_OPENGL
@@ -88,6 +89,10 @@ OSystem_SDL::~OSystem_SDL() {
 	// destructor would also take care of this for us. However, various
 	// of our managers must be deleted *before* we call SDL_Quit().
 	// Hence, we perform the destruction on our own.
+	if (_savefileManager)
+		_savefileManager->flushSavefiles();
+	delete _threadPool;
+	_threadPool = 0;
 	delete _savefileManager;
 	_savefileManager = 0;
 	if (_graphicsManager) {
@@ -147,6 +152,9 @@ void OSystem_SDL::init() {
 	if (_mutexManager == 0)
 		_mutexManager = new SdlMutexManager();
 
+	if (_threadPool == 0)
+		_threadPool = new SdlThreadPool();
+
 #if defined(USE_TASKBAR)
 	if (_taskbarManager == 0)
 		_taskbarManager = new Common::TaskbarManager();
@@ -318,6 +326,12 @@ void OSystem_SDL::setWindowCaption(const char *caption) {
 }
 
 void OSystem_SDL::quit() {
+	// Write config changes still waiting for the flush delay. This can't
+	// wait for the destructor, which runs after the subclasses providing
+	// the config file name are gone.
+	if (Common::ConfigManager::hasInstance() && ConfMan.hasPendingFlush())
+		ConfMan.flushToDisk(true);
+
 	delete this;
 	exit(0);
 }
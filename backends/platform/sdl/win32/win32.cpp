@@ -126,6 +126,16 @@ bool OSystem_Win32::displayLogFile() {
 	return false;
 }
 
+uint64 OSystem_Win32::getMicros() {
+	LARGE_INTEGER frequency, counter;
+	if (!QueryPerformanceFrequency(&frequency) || !QueryPerformanceCounter(&counter))
+		return OSystem_SDL::getMicros();
+
+	// Split the division, so that the multiplication can't overflow
+	const uint64 ticks = counter.QuadPart, rate = frequency.QuadPart;
+	return ticks / rate * 1000000 + ticks % rate * 1000000 / rate;
+}
+
 void OSystem_Win32::setupIcon() {
 	HMODULE handle = GetModuleHandle(NULL);
 	HICON   ico    = LoadIcon(handle, MAKEINTRESOURCE(1001 /* IDI_ICON */));
@@ -20,6 +20,14 @@
  *
  */
 
+#if defined(POSIX)
+// Re-enable some forbidden symbols to avoid clashes with unistd.h, which
+// provides fsync().
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_exit		//Needed for IRIX's unistd.h
+#endif
+
 #include "common/scummsys.h"
 
 #if !defined(DISABLE_DEFAULT_SAVEFILEMANAGER)
@@ -31,19 +39,187 @@
 #include "common/fs.h"
 #include "common/archive.h"
 #include "common/config-manager.h"
+#include "common/memstream.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/threadpool.h"
 #include "common/zlib.h"
 
 #ifndef _WIN32_WCE
 #include <errno.h>	// for removeSavefile()
 #endif
 
-DefaultSaveFileManager::DefaultSaveFileManager() {
+#if defined(POSIX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Make sure the contents of a file, or the entries of a directory, are on
+ * the disk. Only supported on POSIX systems, elsewhere this relies on the
+ * file being closed.
+ */
+static bool syncToDisk(const Common::String &path, bool directory) {
+#if defined(POSIX)
+	const int fd = open(path.c_str(), directory ? O_RDONLY : O_WRONLY);
+	if (fd < 0)
+		return false;
+	const bool success = (fsync(fd) == 0);
+	close(fd);
+	return success;
+#else
+	return true;
+#endif
+}
+
+/**
+ * The result of a savefile written in the background, shared by the task
+ * writing it and the stream the engine wrote it to.
+ */
+struct SaveWriteStatus {
+	Common::String name;
+	bool failed;
+	bool reported; ///< Whether err() of the savefile already reported the failure
+
+	SaveWriteStatus(const Common::String &n) : name(n), failed(false), reported(false) {}
+};
+
+/**
+ * Writes a savefile held in memory to disk. The data is written to a
+ * temporary file first, which is synced to the disk and then replaces the
+ * savefile, so that the previous savegame survives if anything goes wrong.
+ */
+class SaveWriteTask : public Common::ThreadTask {
+public:
+	SaveWriteTask(const Common::FSNode &file, byte *data, uint32 size, bool compress, const SaveWriteStatusPtr &status)
+		: _file(file), _tempFile(file.getParent().getChild(file.getName() + ".tmp")),
+		  _data(data), _size(size), _compress(compress), _status(status) {
+	}
+
+	~SaveWriteTask() {
+		free(_data);
+	}
+
+	virtual void run() {
+		_status->failed = !write();
+
+		free(_data);
+		_data = 0;
+	}
+
+	/** The result of the write. Only valid once the task finished. */
+	const SaveWriteStatusPtr &getStatus() const { return _status; }
+
+private:
+	bool write() {
+		Common::WriteStream *stream = _tempFile.createWriteStream();
+		if (!stream)
+			return false;
+		if (_compress)
+			stream = Common::wrapCompressedWriteStream(stream);
+
+		stream->write(_data, _size);
+		stream->finalize();
+		bool success = !stream->err();
+		delete stream;
+
+		const Common::String tempPath = _tempFile.getPath();
+		if (success && syncToDisk(tempPath, false)) {
+			const Common::String path = _file.getPath();
+
+			// Not every system allows renaming onto an existing file
+			bool renamed = (rename(tempPath.c_str(), path.c_str()) == 0);
+			if (!renamed) {
+				remove(path.c_str());
+				renamed = (rename(tempPath.c_str(), path.c_str()) == 0);
+			}
+
+			if (renamed) {
+				// The new name has to survive a crash, too
+				syncToDisk(_file.getParent().getPath(), true);
+				return true;
+			}
+		}
+
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	const Common::FSNode _file;
+	const Common::FSNode _tempFile;
+	byte *_data;
+	const uint32 _size;
+	const bool _compress;
+	SaveWriteStatusPtr _status;
+};
+
+/**
+ * A savefile which is collected in memory, and written to disk in the
+ * background once it is finalized.
+ */
+class AsyncSaveFile : public Common::WriteStream {
+public:
+	AsyncSaveFile(DefaultSaveFileManager *manager, const Common::FSNode &file, bool compress)
+		: _manager(manager), _file(file), _compress(compress), _buffer(DisposeAfterUse::NO) {
+	}
+
+	~AsyncSaveFile() {
+		submit();
+	}
+
+	virtual uint32 write(const void *dataPtr, uint32 dataSize) {
+		assert(!_status);
+		return _buffer.write(dataPtr, dataSize);
+	}
+
+	virtual void finalize() {
+		submit();
+	}
+
+	/**
+	 * Once the savefile is finalized, this waits for it to be written, so
+	 * engines checking for errors still learn about them. Failures reported
+	 * here are not reported again by flushSavefiles().
+	 */
+	virtual bool err() const {
+		if (!_status)
+			return false;
+
+		_manager->waitForSave(_status);
+		if (_status->failed)
+			_status->reported = true;
+		return _status->failed;
+	}
+
+private:
+	void submit() {
+		if (_status)
+			return;
+
+		_status = SaveWriteStatusPtr(new SaveWriteStatus(_file.getName()));
+		_manager->writeInBackground(_file, _buffer.getData(), _buffer.size(), _compress, _status);
+	}
+
+	DefaultSaveFileManager *_manager;
+	const Common::FSNode _file;
+	const bool _compress;
+	Common::MemoryWriteStreamDynamic _buffer;
+	SaveWriteStatusPtr _status; ///< Set once the savefile was handed to the background
+};
+
+DefaultSaveFileManager::DefaultSaveFileManager() : _pool(0) {
 }
 
-DefaultSaveFileManager::DefaultSaveFileManager(const Common::String &defaultSavepath) {
+DefaultSaveFileManager::DefaultSaveFileManager(const Common::String &defaultSavepath) : _pool(0) {
 	ConfMan.registerDefault("savepath", defaultSavepath);
 }
 
+DefaultSaveFileManager::~DefaultSaveFileManager() {
+	// The backends flush before stopping their thread pool, so this only
+	// matters for managers without an owner doing so
+	flushSavefiles();
+}
+
 
 void DefaultSaveFileManager::checkPath(const Common::FSNode &dir) {
 	clearError();
@@ -55,6 +231,9 @@ void DefaultSaveFileManager::checkPath(const Common::FSNode &dir) {
 }
 
 Common::StringArray DefaultSaveFileManager::listSavefiles(const Common::String &pattern) {
+	// Make sure that pending savefiles are listed, and their temporary files are not
+	collectFinishedSaves(true);
+
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
 	if (getError().getCode() != Common::kNoError)
@@ -78,6 +257,8 @@ Common::StringArray DefaultSaveFileManager::listSavefiles(const Common::String &
 }
 
 Common::InSaveFile *DefaultSaveFileManager::openForLoading(const Common::String &filename) {
+	collectFinishedSaves(true);
+
 	// Ensure that the savepath is valid. If not, generate an appropriate error.
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
@@ -109,6 +290,15 @@ Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String
 
 	Common::FSNode file = savePath.getChild(filename);
 
+	if (canSaveInBackground())
+		return new AsyncSaveFile(this, file, compress);
+
+	// A background write of the same file must not overwrite this one later
+	for (TaskList::const_iterator i = _pendingSaves.begin(); i != _pendingSaves.end(); ++i) {
+		if ((*i)->getStatus()->name == filename)
+			_pool->wait(*i);
+	}
+
 	// Open the file for saving
 	Common::WriteStream *sf = file.createWriteStream();
 
@@ -116,6 +306,8 @@ Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String
 }
 
 bool DefaultSaveFileManager::removeSavefile(const Common::String &filename) {
+	collectFinishedSaves(true);
+
 	Common::String savePathName = getSavePath();
 	checkPath(Common::FSNode(savePathName));
 	if (getError().getCode() != Common::kNoError)
@@ -143,6 +335,74 @@ bool DefaultSaveFileManager::removeSavefile(const Common::String &filename) {
 	}
 }
 
+bool DefaultSaveFileManager::flushSavefiles() {
+	collectFinishedSaves(true);
+
+	// The engine already knows about the failures it saw through err()
+	Common::String names;
+	for (StatusList::const_iterator i = _failedSaves.begin(); i != _failedSaves.end(); ++i) {
+		if ((*i)->reported)
+			continue;
+		if (!names.empty())
+			names += ", ";
+		names += (*i)->name;
+	}
+	_failedSaves.clear();
+
+	if (names.empty())
+		return true;
+
+	warning("Could not write savefile(s) %s", names.c_str());
+	setError(Common::kWritingFailed, "Could not write savefile(s) " + names);
+	return false;
+}
+
+void DefaultSaveFileManager::writeInBackground(const Common::FSNode &file, byte *data, uint32 size, bool compress, const SaveWriteStatusPtr &status) {
+	collectFinishedSaves(false);
+
+	if (!_pool)
+		_pool = g_system->getThreadPool();
+
+	// Saving the same file twice in a row has to leave the newer one on disk
+	for (TaskList::const_iterator i = _pendingSaves.begin(); i != _pendingSaves.end(); ++i) {
+		if ((*i)->getStatus()->name == status->name)
+			_pool->wait(*i);
+	}
+
+	SaveWriteTask *task = new SaveWriteTask(file, data, size, compress, status);
+	_pendingSaves.push_back(task);
+	_pool->submit(task);
+}
+
+void DefaultSaveFileManager::waitForSave(const SaveWriteStatusPtr &status) {
+	for (TaskList::const_iterator i = _pendingSaves.begin(); i != _pendingSaves.end(); ++i) {
+		if ((*i)->getStatus() == status)
+			_pool->wait(*i);
+	}
+}
+
+void DefaultSaveFileManager::collectFinishedSaves(bool wait) {
+	TaskList::iterator i = _pendingSaves.begin();
+	while (i != _pendingSaves.end()) {
+		SaveWriteTask *task = *i;
+		if (wait)
+			_pool->wait(task);
+		else if (!_pool->isFinished(task)) {
+			++i;
+			continue;
+		}
+
+		if (task->getStatus()->failed)
+			_failedSaves.push_back(task->getStatus());
+		delete task;
+		i = _pendingSaves.erase(i);
+	}
+}
+
+bool DefaultSaveFileManager::canSaveInBackground() const {
+	return ConfMan.getBool("async_saves") && g_system->getThreadPool()->getThreadCount() > 0;
+}
+
 Common::String DefaultSaveFileManager::getSavePath() const {
 
 	Common::String dir;
@@ -27,6 +27,18 @@
 #include "common/savefile.h"
 #include "common/str.h"
 #include "common/fs.h"
+#include "common/list.h"
+#include "common/ptr.h"
+
+namespace Common {
+class ThreadPool;
+}
+
+class AsyncSaveFile;
+class SaveWriteTask;
+struct SaveWriteStatus;
+
+typedef Common::SharedPtr<SaveWriteStatus> SaveWriteStatusPtr;
 
 /**
  * Provides a default savefile manager implementation for common platforms.
@@ -35,11 +47,13 @@ class DefaultSaveFileManager : public Common::SaveFileManager {
 public:
 	DefaultSaveFileManager();
 	DefaultSaveFileManager(const Common::String &defaultSavepath);
+	virtual ~DefaultSaveFileManager();
 
 	virtual Common::StringArray listSavefiles(const Common::String &pattern);
 	virtual Common::InSaveFile *openForLoading(const Common::String &filename);
 	virtual Common::OutSaveFile *openForSaving(const Common::String &filename, bool compress = true);
 	virtual bool removeSavefile(const Common::String &filename);
+	virtual bool flushSavefiles();
 
 protected:
 	/**
@@ -54,6 +68,39 @@ protected:
 	 * Sets the internal error and error message accordingly.
 	 */
 	virtual void checkPath(const Common::FSNode &dir);
+
+	/**
+	 * Whether savefiles may be written in the background. By default, this
+	 * is the case if the port runs tasks on worker threads and the user did
+	 * not disable it through the "async_saves" setting.
+	 */
+	virtual bool canSaveInBackground() const;
+
+private:
+	friend class AsyncSaveFile;
+
+	typedef Common::List<SaveWriteTask *> TaskList;
+	typedef Common::List<SaveWriteStatusPtr> StatusList;
+
+	/**
+	 * Hand a finished savefile to a background thread, which compresses it
+	 * and moves it into place. Takes ownership of the data, which has to be
+	 * allocated with malloc(). The result of the write is stored in status.
+	 */
+	void writeInBackground(const Common::FSNode &file, byte *data, uint32 size, bool compress, const SaveWriteStatusPtr &status);
+
+	/** Wait until the savefile with the given status is written. */
+	void waitForSave(const SaveWriteStatusPtr &status);
+
+	/**
+	 * Remove the finished tasks from the list of pending writes, after
+	 * waiting for all of them if requested.
+	 */
+	void collectFinishedSaves(bool wait);
+
+	Common::ThreadPool *_pool;
+	TaskList _pendingSaves;
+	StatusList _failedSaves;
 };
 
 #endif
@@ -31,6 +31,11 @@
 class RecorderSaveFileManager : public DefaultSaveFileManager {
 	virtual Common::StringArray listSaveFiles(const Common::String &pattern);
 	virtual Common::InSaveFile *openForLoading(const Common::String &filename);
+
+protected:
+	// Recordings are long streams of events, which should not be held in
+	// memory until they are finalized
+	virtual bool canSaveInBackground() const { return false; }
 };
 
 #endif
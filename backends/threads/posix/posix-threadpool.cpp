@@ -0,0 +1,100 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+
+#include "common/scummsys.h"
+
+#if defined(POSIX) && defined(USE_PTHREADS)
+
+#include "backends/threads/posix/posix-threadpool.h"
+
+#include <unistd.h>
+
+PosixThreadPool::PosixThreadPool() {
+	pthread_mutex_init(&_mutex, 0);
+	pthread_cond_init(&_cond, 0);
+
+	long cpus = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+	startWorkers(cpus > 0 ? (uint)cpus : 1);
+}
+
+PosixThreadPool::~PosixThreadPool() {
+	stopWorkers();
+
+	pthread_cond_destroy(&_cond);
+	pthread_mutex_destroy(&_mutex);
+}
+
+void *PosixThreadPool::workerProc(void *param) {
+	Worker *worker = (Worker *)param;
+	worker->pool->runWorker(worker->index);
+	return 0;
+}
+
+bool PosixThreadPool::createThread(uint index) {
+	Worker &worker = _workers[index];
+	worker.pool = this;
+	worker.index = index;
+	return pthread_create(&worker.thread, 0, workerProc, &worker) == 0;
+}
+
+void PosixThreadPool::joinThread(uint index) {
+	pthread_join(_workers[index].thread, 0);
+}
+
+int PosixThreadPool::getCurrentWorker() const {
+	const pthread_t self = pthread_self();
+	for (uint i = 0; i < getThreadCount(); ++i) {
+		if (pthread_equal(self, _workers[i].thread))
+			return i;
+	}
+
+	return -1;
+}
+
+void PosixThreadPool::lock() {
+	pthread_mutex_lock(&_mutex);
+}
+
+bool PosixThreadPool::tryLock() {
+	return pthread_mutex_trylock(&_mutex) == 0;
+}
+
+void PosixThreadPool::unlock() {
+	pthread_mutex_unlock(&_mutex);
+}
+
+void PosixThreadPool::waitForSignal() {
+	pthread_cond_wait(&_cond, &_mutex);
+}
+
+void PosixThreadPool::signalAll() {
+	pthread_cond_broadcast(&_cond);
+}
+
+#endif
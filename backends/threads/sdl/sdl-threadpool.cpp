@@ -0,0 +1,110 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/threads/sdl/sdl-threadpool.h"
+
+SdlThreadPool::SdlThreadPool() {
+	_mutex = SDL_CreateMutex();
+	_cond = SDL_CreateCond();
+
+#if SDL_VERSION_ATLEAST(1, 3, 0)
+	startWorkers(SDL_GetCPUCount());
+#else
+	// SDL 1.2 can't tell the number of CPUs, so assume a dual core
+	startWorkers(2);
+#endif
+}
+
+SdlThreadPool::~SdlThreadPool() {
+	stopWorkers();
+
+	SDL_DestroyCond(_cond);
+	SDL_DestroyMutex(_mutex);
+}
+
+int SDLCALL SdlThreadPool::workerProc(void *param) {
+	Worker *worker = (Worker *)param;
+	worker->pool->runWorker(worker->index);
+	return 0;
+}
+
+bool SdlThreadPool::createThread(uint index) {
+	Worker &worker = _workers[index];
+	worker.pool = this;
+	worker.index = index;
+#if SDL_VERSION_ATLEAST(1, 3, 0)
+	worker.thread = SDL_CreateThread(workerProc, "ScummVM worker", &worker);
+#else
+	worker.thread = SDL_CreateThread(workerProc, &worker);
+#endif
+	if (!worker.thread)
+		return false;
+
+	worker.threadID = SDL_GetThreadID(worker.thread);
+	return true;
+}
+
+void SdlThreadPool::joinThread(uint index) {
+	SDL_WaitThread(_workers[index].thread, NULL);
+}
+
+int SdlThreadPool::getCurrentWorker() const {
+	const unsigned long self = SDL_ThreadID();
+	for (uint i = 0; i < getThreadCount(); ++i) {
+		if (_workers[i].threadID == self)
+			return i;
+	}
+
+	return -1;
+}
+
+void SdlThreadPool::lock() {
+	SDL_LockMutex(_mutex);
+}
+
+bool SdlThreadPool::tryLock() {
+#if SDL_VERSION_ATLEAST(1, 3, 0)
+	return SDL_TryLockMutex(_mutex) == 0;
+#else
+	// SDL 1.2 can't try, but the pool is only locked for short moments
+	lock();
+	return true;
+#endif
+}
+
+void SdlThreadPool::unlock() {
+	SDL_UnlockMutex(_mutex);
+}
+
+void SdlThreadPool::waitForSignal() {
+	SDL_CondWait(_cond, _mutex);
+}
+
+void SdlThreadPool::signalAll() {
+	SDL_CondBroadcast(_cond);
+}
+
+#endif
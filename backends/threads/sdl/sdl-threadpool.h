@@ -0,0 +1,62 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_THREADS_SDL_THREADPOOL_H
+#define BACKENDS_THREADS_SDL_THREADPOOL_H
+
+#include "backends/threads/threadpool.h"
+#include "backends/platform/sdl/sdl-sys.h"
+
+/**
+ * Thread pool using SDL threads.
+ */
+class SdlThreadPool : public WorkerThreadPool {
+public:
+	SdlThreadPool();
+	~SdlThreadPool();
+
+protected:
+	virtual bool createThread(uint index);
+	virtual void joinThread(uint index);
+	virtual int getCurrentWorker() const;
+	virtual void lock();
+	virtual bool tryLock();
+	virtual void unlock();
+	virtual void waitForSignal();
+	virtual void signalAll();
+
+private:
+	struct Worker {
+		SdlThreadPool *pool;
+		uint index;
+		SDL_Thread *thread;
+		unsigned long threadID;
+	};
+
+	static int SDLCALL workerProc(void *param);
+
+	Worker _workers[kMaxThreads];
+	SDL_mutex *_mutex;
+	SDL_cond *_cond;
+};
+
+#endif
@@ -0,0 +1,207 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "backends/threads/threadpool.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+WorkerThreadPool::WorkerThreadPool() : _threadCount(0), _quit(false) {
+	_queues.resize(1);
+}
+
+void WorkerThreadPool::startWorkers(uint count) {
+	count = CLIP<uint>(count, 1, kMaxThreads);
+
+	// Set up all queues before starting the first thread, so that the array
+	// doesn't change under the feet of running workers.
+	_queues.resize(count + 1);
+
+	lock();
+	for (uint i = 0; i < count; ++i) {
+		if (!createThread(i)) {
+			warning("WorkerThreadPool: Could only start %d out of %d threads", i, count);
+			break;
+		}
+
+		_threadCount++;
+	}
+	unlock();
+}
+
+void WorkerThreadPool::stopWorkers() {
+	lock();
+	_quit = true;
+	signalAll();
+	unlock();
+
+	for (uint i = 0; i < _threadCount; ++i)
+		joinThread(i);
+
+	// Finish the tasks which were still queued on this thread, so that
+	// nobody waits for them forever. Tasks submitted meanwhile run inline.
+	lock();
+	const uint queueCount = _threadCount + 1;
+	_threadCount = 0;
+	for (uint i = 0; i < queueCount; ++i) {
+		while (!_queues[i].empty())
+			runTask(popTask(_queues[i], false));
+	}
+	unlock();
+}
+
+void WorkerThreadPool::runWorker(uint index) {
+	lock();
+	while (!_quit) {
+		Common::ThreadTask *task = takeTask(index);
+		if (task)
+			runTask(task);
+		else
+			waitForSignal();
+	}
+	unlock();
+}
+
+void WorkerThreadPool::submit(Common::ThreadTask *task) {
+	lock();
+	queueTask(task);
+	unlock();
+}
+
+bool WorkerThreadPool::trySubmit(Common::ThreadTask *task) {
+	if (!tryLock())
+		return false;
+
+	const bool idle = !isBusy(task);
+	if (idle)
+		queueTask(task);
+
+	unlock();
+	return idle;
+}
+
+void WorkerThreadPool::detach(Common::ThreadTask *task) {
+	lock();
+	const bool busy = isBusy(task);
+	if (busy)
+		markDetached(task);
+	unlock();
+
+	if (!busy)
+		delete task;
+}
+
+void WorkerThreadPool::queueTask(Common::ThreadTask *task) {
+	markQueued(task);
+
+	if (_threadCount == 0) {
+		// No threads could be started, so run the task right away
+		runTask(task);
+		return;
+	}
+
+	const int worker = getCurrentWorker();
+	pushTask(_queues[worker >= 0 ? worker : _threadCount], task);
+
+	signalAll();
+}
+
+bool WorkerThreadPool::isFinished(const Common::ThreadTask *task) {
+	lock();
+	const bool finished = hasFinished(task);
+	unlock();
+	return finished;
+}
+
+void WorkerThreadPool::wait(const Common::ThreadTask *task) {
+	const int worker = getCurrentWorker();
+
+	lock();
+	while (!hasFinished(task)) {
+		// Workers help out instead of just blocking, which also keeps tasks
+		// waiting for other tasks from running out of workers. Other threads,
+		// like the GUI thread, must not get stuck in unrelated tasks.
+		Common::ThreadTask *other = (worker >= 0) ? takeTask(worker) : 0;
+		if (other)
+			runTask(other);
+		else
+			waitForSignal();
+	}
+	unlock();
+}
+
+void WorkerThreadPool::pushTask(TaskQueue &queue, Common::ThreadTask *task) {
+	prevTask(task) = queue.last;
+	nextTask(task) = 0;
+	if (queue.last)
+		nextTask(queue.last) = task;
+	else
+		queue.first = task;
+	queue.last = task;
+}
+
+Common::ThreadTask *WorkerThreadPool::popTask(TaskQueue &queue, bool last) {
+	Common::ThreadTask *task = last ? queue.last : queue.first;
+	Common::ThreadTask *prev = prevTask(task), *next = nextTask(task);
+
+	if (prev)
+		nextTask(prev) = next;
+	else
+		queue.first = next;
+	if (next)
+		prevTask(next) = prev;
+	else
+		queue.last = prev;
+
+	prevTask(task) = nextTask(task) = 0;
+	return task;
+}
+
+Common::ThreadTask *WorkerThreadPool::takeTask(int worker) {
+	// Prefer the newest task of our own queue, its data is most likely
+	// still in the cache
+	if (worker >= 0 && !_queues[worker].empty())
+		return popTask(_queues[worker], true);
+
+	// Then the shared queue, followed by the oldest tasks of the other workers
+	for (uint i = 0; i <= _threadCount; ++i) {
+		TaskQueue &queue = _queues[(_threadCount + i) % (_threadCount + 1)];
+		if (!queue.empty())
+			return popTask(queue, false);
+	}
+
+	return 0;
+}
+
+void WorkerThreadPool::runTask(Common::ThreadTask *task) {
+	unlock();
+	task->run();
+	lock();
+
+	markFinished(task);
+	signalAll();
+
+	if (isDetached(task)) {
+		unlock();
+		delete task;
+		lock();
+	}
+}
@@ -0,0 +1,125 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_THREADS_THREADPOOL_H
+#define BACKENDS_THREADS_THREADPOOL_H
+
+#include "common/threadpool.h"
+#include "common/array.h"
+
+/**
+ * Base class for thread pools backed by real threads. It implements the
+ * task scheduling on top of a few primitives provided by subclasses.
+ *
+ * Each worker has its own queue. Tasks submitted by a worker go to the back
+ * of its own queue and are picked up from there again first, while tasks
+ * submitted from other threads go to a shared queue. Idle workers take
+ * tasks from the shared queue, or steal the oldest tasks queued by other
+ * workers.
+ *
+ * Subclasses have to call startWorkers() from their constructor and
+ * stopWorkers() from their destructor.
+ */
+class WorkerThreadPool : public Common::ThreadPool {
+public:
+	virtual uint getThreadCount() const { return _threadCount; }
+
+	virtual void submit(Common::ThreadTask *task);
+	virtual bool trySubmit(Common::ThreadTask *task);
+	virtual void detach(Common::ThreadTask *task);
+	virtual bool isFinished(const Common::ThreadTask *task);
+	virtual void wait(const Common::ThreadTask *task);
+
+protected:
+	enum {
+		kMaxThreads = 16
+	};
+
+	WorkerThreadPool();
+
+	/** Start up to count worker threads. */
+	void startWorkers(uint count);
+
+	/**
+	 * Stop and join all worker threads. Tasks still queued are then run on
+	 * the calling thread, so that waiting for them can't hang.
+	 */
+	void stopWorkers();
+
+	/** The main loop of a worker thread. */
+	void runWorker(uint index);
+
+	/** Create the thread for a worker, which must call runWorker(index). */
+	virtual bool createThread(uint index) = 0;
+
+	/** Wait for the thread of a worker to end. */
+	virtual void joinThread(uint index) = 0;
+
+	/** Return the index of the worker running on the calling thread, or -1. */
+	virtual int getCurrentWorker() const = 0;
+
+	/** Lock the pool. */
+	virtual void lock() = 0;
+
+	/** Lock the pool if that is possible without waiting. */
+	virtual bool tryLock() = 0;
+
+	/** Unlock the pool. */
+	virtual void unlock() = 0;
+
+	/** Atomically unlock the pool, wait for signalAll() and relock it. */
+	virtual void waitForSignal() = 0;
+
+	/** Wake up all threads blocked in waitForSignal(). */
+	virtual void signalAll() = 0;
+
+private:
+	/** A queue of tasks, linked through the tasks themselves. */
+	struct TaskQueue {
+		Common::ThreadTask *first, *last;
+
+		TaskQueue() : first(0), last(0) {}
+		bool empty() const { return !first; }
+	};
+
+	/** The queues of all workers, followed by the shared queue. */
+	Common::Array<TaskQueue> _queues;
+	uint _threadCount;
+	bool _quit;
+
+	/** Add a task to the end of a queue. Requires the lock. */
+	void pushTask(TaskQueue &queue, Common::ThreadTask *task);
+
+	/** Remove the first or last task of a non-empty queue. Requires the lock. */
+	Common::ThreadTask *popTask(TaskQueue &queue, bool last);
+
+	/** Queue a task and wake up the workers. Requires the lock. */
+	void queueTask(Common::ThreadTask *task);
+
+	/** Take the next task to run on the given worker (or -1). Requires the lock. */
+	Common::ThreadTask *takeTask(int worker);
+
+	/** Run a task and mark it as finished. Requires the lock, which is dropped while running. */
+	void runTask(Common::ThreadTask *task);
+};
+
+#endif
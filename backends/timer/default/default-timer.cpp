@@ -22,6 +22,7 @@
 
 #include "common/scummsys.h"
 #include "backends/timer/default/default-timer.h"
+#include "common/math.h"
 #include "common/util.h"
 #include "common/system.h"
 
@@ -34,78 +35,129 @@ struct TimerSlot {
 	uint32 nextFireTime;	// in milliseconds
 	uint32 nextFireTimeMicro;	// microseconds part of nextFire
 
-	TimerSlot *next;
-};
-
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot) {
-	// The head points to a fake anchor TimerSlot; this common
-	// trick allows us to get rid of many special cases.
+	// Slots firing in the same millisecond fire in the order they were
+	// scheduled in
+	uint32 sequence;
+	uint queueIndex;	// position in the heap
 
-	const uint32 nextFireTime = newSlot->nextFireTime;
-	TimerSlot *slot = head;
-	newSlot->next = 0;
+	uint64 lastCall;	// getMicros() of the last call, 0 before the first one
+	Common::TimerManager::TimerStats stats;
+};
 
-	// Insert the new slot into the sorted list of already scheduled
-	// timers in such a way that the list stays sorted...
-	while (true) {
-		assert(slot);
-		if (slot->next == 0 || nextFireTime < slot->next->nextFireTime) {
-			newSlot->next = slot->next;
-			slot->next = newSlot;
-			return;
-		}
-		slot = slot->next;
-	}
+static bool firesBefore(const TimerSlot *a, const TimerSlot *b) {
+	if (a->nextFireTime != b->nextFireTime)
+		return a->nextFireTime < b->nextFireTime;
+	return (int32)(a->sequence - b->sequence) < 0;
 }
 
+static void countInBucket(uint32 *buckets, uint32 micros) {
+	const uint32 millis = micros / 1000;
+	const int bucket = millis ? Common::intLog2(millis) + 1 : 0;
+	buckets[MIN<int>(bucket, Common::TimerManager::kStatsBuckets - 1)]++;
+}
 
-DefaultTimerManager::DefaultTimerManager() :
-	_head(0) {
 
-	_head = new TimerSlot();
-	memset(_head, 0, sizeof(TimerSlot));
+DefaultTimerManager::DefaultTimerManager() : _sequence(0) {
 }
 
 DefaultTimerManager::~DefaultTimerManager() {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
-	while (slot) {
-		TimerSlot *next = slot->next;
-		delete slot;
-		slot = next;
+	for (uint i = 0; i < _queue.size(); ++i)
+		delete _queue[i];
+	_queue.clear();
+}
+
+void DefaultTimerManager::siftUp(uint index) {
+	TimerSlot *slot = _queue[index];
+
+	while (index > 0) {
+		const uint parent = (index - 1) / 2;
+		if (!firesBefore(slot, _queue[parent]))
+			break;
+
+		_queue[index] = _queue[parent];
+		_queue[index]->queueIndex = index;
+		index = parent;
 	}
-	_head = 0;
+
+	_queue[index] = slot;
+	slot->queueIndex = index;
+}
+
+void DefaultTimerManager::siftDown(uint index) {
+	TimerSlot *slot = _queue[index];
+	const uint size = _queue.size();
+
+	while (2 * index + 1 < size) {
+		uint child = 2 * index + 1;
+		if (child + 1 < size && firesBefore(_queue[child + 1], _queue[child]))
+			child++;
+
+		if (!firesBefore(_queue[child], slot))
+			break;
+
+		_queue[index] = _queue[child];
+		_queue[index]->queueIndex = index;
+		index = child;
+	}
+
+	_queue[index] = slot;
+	slot->queueIndex = index;
 }
 
 void DefaultTimerManager::handler() {
-	Common::StackLock lock(_mutex);
+	// Callbacks are invoked without holding _mutex, so they can install and
+	// remove timers while others keep being scheduled.
+	Common::StackLock callbackLock(_callbackMutex);
 
-	uint32 curTime = g_system->getMillis(true);
+	const uint32 curTime = g_system->getMillis(true);
+	const uint64 handlerStart = g_system->getMicros();
 
 	// Repeat as long as there is a TimerSlot that is scheduled to fire.
-	TimerSlot *slot = _head->next;
-	while (slot && slot->nextFireTime < curTime) {
-		// Remove the slot from the priority queue
-		_head->next = slot->next;
-
-		// Update the fire time and reinsert the TimerSlot into the priority
-		// queue.
-		assert(slot->interval > 0);
-		slot->nextFireTime += (slot->interval / 1000);
-		slot->nextFireTimeMicro += (slot->interval % 1000);
-		if (slot->nextFireTimeMicro > 1000) {
-			slot->nextFireTime += slot->nextFireTimeMicro / 1000;
-			slot->nextFireTimeMicro %= 1000;
+	while (true) {
+		TimerSlot *slot;
+
+		{
+			Common::StackLock lock(_mutex);
+
+			if (_queue.empty() || _queue[0]->nextFireTime >= curTime)
+				break;
+
+			slot = _queue[0];
+
+			// Measure how punctual the call is
+			const uint64 now = g_system->getMicros();
+			const int64 lateness = ((int64)curTime - slot->nextFireTime) * 1000 - slot->nextFireTimeMicro + (int64)(now - handlerStart);
+			TimerStats &stats = slot->stats;
+			stats.calls++;
+			stats.totalLateness += MAX<int64>(lateness, 0);
+			stats.maxLateness = MAX<uint32>(stats.maxLateness, MAX<int64>(lateness, 0));
+			countInBucket(stats.lateness, MAX<int64>(lateness, 0));
+
+			if (slot->lastCall) {
+				const int64 jitter = ABS<int64>((int64)(now - slot->lastCall) - slot->interval);
+				stats.maxJitter = MAX<uint32>(stats.maxJitter, jitter);
+				countInBucket(stats.jitter, jitter);
+			}
+			slot->lastCall = now;
+
+			// Update the fire time and move the TimerSlot to its new place
+			// in the priority queue.
+			assert(slot->interval > 0);
+			slot->nextFireTime += (slot->interval / 1000);
+			slot->nextFireTimeMicro += (slot->interval % 1000);
+			if (slot->nextFireTimeMicro > 1000) {
+				slot->nextFireTime += slot->nextFireTimeMicro / 1000;
+				slot->nextFireTimeMicro %= 1000;
+			}
+			slot->sequence = _sequence++;
+			siftDown(0);
 		}
-		insertPrioQueue(_head, slot);
 
 		// Invoke the timer callback
 		assert(slot->callback);
 		slot->callback(slot->refCon);
-
-		// Look at the next scheduled timer
-		slot = _head->next;
 	}
 }
 
@@ -113,50 +165,59 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 	assert(interval > 0);
 	Common::StackLock lock(_mutex);
 
-	if (_callbacks.contains(id)) {
-		if (_callbacks[id] != callback) {
-			error("Different callbacks are referred by same name (%s)", id.c_str());
-		}
+	TimerSlotMap::const_iterator named = _callbacks.find(id);
+	if (named != _callbacks.end() && named->_value != callback) {
+		error("Different callbacks are referred by same name (%s)", id.c_str());
 	}
-	TimerSlotMap::const_iterator i;
 
-	for (i = _callbacks.begin(); i != _callbacks.end(); ++i) {
-		if (i->_value == callback) {
-			error("Same callback added twice (old name: %s, new name: %s)", i->_key.c_str(), id.c_str());
-		}
+	TimerProcMap::const_iterator installed = _slots.find(callback);
+	if (installed != _slots.end()) {
+		error("Same callback added twice (old name: %s, new name: %s)", installed->_value->id.c_str(), id.c_str());
 	}
 	_callbacks[id] = callback;
 
-	TimerSlot *slot = new TimerSlot;
+	TimerSlot *slot = new TimerSlot();
 	slot->callback = callback;
 	slot->refCon = refCon;
 	slot->id = id;
 	slot->interval = interval;
 	slot->nextFireTime = g_system->getMillis() + interval / 1000;
 	slot->nextFireTimeMicro = interval % 1000;
-	slot->next = 0;
+	slot->sequence = _sequence++;
+	slot->lastCall = 0;
+	slot->stats.id = id;
+	slot->stats.interval = interval;
+	_slots[callback] = slot;
 
-	insertPrioQueue(_head, slot);
+	_queue.push_back(slot);
+	siftUp(_queue.size() - 1);
 
 	return true;
 }
 
 void DefaultTimerManager::removeTimerProc(TimerProc callback) {
+	// Wait for the callback to return, in case it is running right now. The
+	// mutex is recursive, so callbacks can still remove themselves.
+	Common::StackLock callbackLock(_callbackMutex);
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
+	TimerProcMap::iterator installed = _slots.find(callback);
+	if (installed == _slots.end())
+		return;
 
-	while (slot->next) {
-		if (slot->next->callback == callback) {
-			TimerSlot *next = slot->next->next;
-			delete slot->next;
-			slot->next = next;
-		} else {
-			slot = slot->next;
-		}
+	TimerSlot *slot = installed->_value;
+	_slots.erase(installed);
+
+	TimerSlot *last = _queue.back();
+	_queue.pop_back();
+	if (last != slot) {
+		_queue[slot->queueIndex] = last;
+		last->queueIndex = slot->queueIndex;
+		siftDown(last->queueIndex);
+		siftUp(last->queueIndex);
 	}
 
-	// We need to remove all names referencing the timer proc here.
+	// We need to remove the name referencing the timer proc here.
 	//
 	// Else we run into troubles, when the client code removes and readds timer
 	// callbacks.
@@ -168,8 +229,27 @@ void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 	// name and causing installTimerProc to error out.
 	// A good test case is running a SCUMM with ALSA output and then a KYRA
 	// game for example.
-	for (TimerSlotMap::iterator i = _callbacks.begin(), end = _callbacks.end(); i != end; ++i) {
-		if (i->_value == callback)
-			_callbacks.erase(i);
+	_callbacks.erase(slot->id);
+
+	delete slot;
+}
+
+void DefaultTimerManager::getTimerStats(Common::Array<TimerStats> &stats) const {
+	Common::StackLock lock(_mutex);
+
+	stats.resize(_queue.size());
+	for (uint i = 0; i < _queue.size(); ++i)
+		stats[i] = _queue[i]->stats;
+}
+
+void DefaultTimerManager::resetTimerStats() {
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _queue.size(); ++i) {
+		TimerSlot *slot = _queue[i];
+		slot->lastCall = 0;
+		slot->stats = TimerStats();
+		slot->stats.id = slot->id;
+		slot->stats.interval = slot->interval;
 	}
 }
@@ -23,6 +23,7 @@
 #ifndef BACKENDS_TIMER_DEFAULT_H
 #define BACKENDS_TIMER_DEFAULT_H
 
+#include "common/array.h"
 #include "common/str.h"
 #include "common/hash-str.h"
 #include "common/timer.h"
@@ -34,9 +35,30 @@ class DefaultTimerManager : public Common::TimerManager {
 private:
 	typedef Common::HashMap<Common::String, TimerProc, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> TimerSlotMap;
 
+	struct TimerProc_Hash {
+		uint operator()(TimerProc proc) const { return (uint)(size_t)proc; }
+	};
+
+	typedef Common::HashMap<TimerProc, TimerSlot *, TimerProc_Hash> TimerProcMap;
+
+	/** Guards the queue and the maps. */
 	Common::Mutex _mutex;
-	TimerSlot *_head;
+
+	/**
+	 * Held by handler() while it invokes callbacks, so removeTimerProc can
+	 * wait for a running callback without the callbacks blocking _mutex.
+	 */
+	Common::Mutex _callbackMutex;
+
+	/** Binary min-heap of the installed timers, the next one to fire first. */
+	Common::Array<TimerSlot *> _queue;
+	uint32 _sequence;
+
 	TimerSlotMap _callbacks;
+	TimerProcMap _slots;
+
+	void siftUp(uint index);
+	void siftDown(uint index);
 
 public:
 	DefaultTimerManager();
@@ -44,6 +66,9 @@ public:
 	virtual bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id);
 	virtual void removeTimerProc(TimerProc proc);
 
+	virtual void getTimerStats(Common::Array<TimerStats> &stats) const;
+	virtual void resetTimerStats();
+
 	/**
 	 * Timer callback, to be invoked at regular time intervals by the backend.
 	 */
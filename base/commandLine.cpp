@@ -97,6 +97,8 @@ static const char HELP_STRING[] =
 	"  -d, --debuglevel=NUM     Set debug verbosity level\n"
 	"  --debugflags=FLAGS       Enable engine specific debug flags\n"
 	"                           (separated by commas)\n"
+	"  --profile=FILE           Record profiling zones and write them to FILE in\n"
+	"                           the Chrome trace format on exit\n"
 	"  -u, --dump-scripts       Enable script dumping if a directory called 'dumps'\n"
 	"                           exists in the current directory\n"
 	"\n"
@@ -194,6 +196,8 @@ void registerDefaults() {
 	ConfMan.registerDefault("native_mt32", false);
 	ConfMan.registerDefault("enable_gs", false);
 	ConfMan.registerDefault("midi_gain", 100);
+	ConfMan.registerDefault("audio_resampler", "linear");	// "sinc" for a slower, cleaner resampler
+	ConfMan.registerDefault("audio_decode_ahead", 250);	// Milliseconds of compressed audio to decode in the background
 
 	ConfMan.registerDefault("music_driver", "auto");
 	ConfMan.registerDefault("mt32_device", "null");
@@ -212,6 +216,7 @@ void registerDefaults() {
 	ConfMan.registerDefault("dump_scripts", false);
 	ConfMan.registerDefault("save_slot", -1);
 	ConfMan.registerDefault("autosave_period", 5 * 60);	// By default, trigger autosave every 5 minutes
+	ConfMan.registerDefault("async_saves", true);	// Write savegames in the background where threads are available
 
 #if defined(ENABLE_SCUMM) || defined(ENABLE_SWORD2)
 	ConfMan.registerDefault("object_labels", true);
@@ -248,6 +253,14 @@ void registerDefaults() {
 
 	ConfMan.registerDefault("gui_browser_show_hidden", false);
 
+	// Budget in KB for rendered widgets kept by the theme engine
+	ConfMan.registerDefault("gui_render_cache_size", 2048);
+	ConfMan.registerDefault("gui_render_cache_stats", false);
+
+	ConfMan.registerDefault("mmap_files", false);
+
+	ConfMan.registerDefault("md5_cache", true);
+
 #ifdef USE_FLUIDSYNTH
 	// The settings are deliberately stored the same way as in Qsynth. The
 	// FluidSynth music driver is responsible for transforming them into
@@ -418,6 +431,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION("debugflags")
 			END_OPTION
 
+			DO_LONG_OPTION("profile")
+			END_OPTION
+
 			DO_OPTION('e', "music-driver")
 			END_OPTION
 
@@ -810,6 +826,8 @@ static void runDetectorTest() {
 				   Common::getPlatformCode(x->platform()));
 		}
 	}
+	EngineMan.flushDetectionCache();
+
 	int total = domains.size();
 	printf("Detector test run: %d fail, %d success, %d skipped, out of %d\n",
 			failure, success, total - failure - success, total);
@@ -926,6 +944,7 @@ void upgradeTargets() {
 	}
 
 	// Finally, save our changes to disk
+	EngineMan.flushDetectionCache();
 	ConfMan.flushToDisk();
 }
 #endif
@@ -43,10 +43,13 @@
 #include "common/debug-channels.h" /* for debug manager */
 #include "common/events.h"
 #include "gui/EventRecorder.h"
+#include "common/file.h"
 #include "common/fs.h"
 #ifdef ENABLE_EVENTRECORDER
 #include "common/recorderfile.h"
 #endif
+#include "common/profiler.h"
+#include "common/savefile.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/tokenizer.h"
@@ -57,6 +60,7 @@
 
 #include "audio/mididrv.h"
 #include "audio/musicplugin.h"  /* for music manager */
+#include "audio/soundcache.h"
 
 #include "graphics/cursorman.h"
 #include "graphics/fontman.h"
@@ -155,6 +159,9 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	if (err.getCode() == Common::kNoError)
 		err = (*plugin)->createInstance(&system, &engine);
 
+	// Keep the MD5s the detector computed on the way
+	EngineMan.flushDetectionCache();
+
 	// Check for errors
 	if (!engine || err.getCode() != Common::kNoError) {
 
@@ -252,6 +259,17 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	// Free up memory
 	delete engine;
 
+	// Savegames may still be written in the background, make sure they are
+	// on disk before returning to the launcher (or quitting)
+	Common::SaveFileManager *saveFileMan = system.getSavefileManager();
+	if (!saveFileMan->flushSavefiles()) {
+		// Tell the user, the game believes it saved successfully
+		GUI::displayErrorDialog(Common::Error(Common::kWritingFailed, saveFileMan->getErrorDesc()), _("Error saving game:"));
+	}
+
+	// Cached sounds are keyed by the names of the game's files
+	SoundCache.clear();
+
 	// We clear all debug levels again even though the engine should do it
 	DebugMan.clearAllDebugChannels();
 
@@ -342,6 +360,7 @@ static void setupKeymapper(OSystem &system) {
 
 extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	Common::String specialDebug;
+	Common::String profileFile;
 	Common::String command;
 
 	// Verify that the backend has been initialized (i.e. g_system has been set).
@@ -381,6 +400,11 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 		settings.erase("debugflags");
 	}
 
+	if (settings.contains("profile")) {
+		profileFile = settings["profile"];
+		settings.erase("profile");	// This option should not be passed to ConfMan.
+	}
+
 	PluginManager::instance().init();
  	PluginManager::instance().loadAllPlugins(); // load plugins for cached plugin manager
 
@@ -409,6 +433,10 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// the command line params) was read.
 	system.initBackend();
 
+	// Start profiling as soon as the backend is able to provide timestamps
+	if (!profileFile.empty())
+		ProfMan.setEnabled(true);
+
 	// If we received an invalid graphics mode parameter via command line
 	// we check this here. We can't do it until after the backend is inited,
 	// or there won't be a graphics manager to ask for the supported modes.
@@ -540,9 +568,22 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 		setupGraphics(system);
 		launcherDialog();
 	}
+	if (!profileFile.empty()) {
+		Common::DumpFile traceFile;
+		if (traceFile.open(profileFile)) {
+			uint32 events = ProfMan.writeChromeTrace(traceFile);
+			traceFile.finalize();
+			debug("Wrote %u profiling events to '%s'", events, profileFile.c_str());
+		} else {
+			warning("Could not open '%s' to write the profiling trace", profileFile.c_str());
+		}
+	}
+
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
+	// Write out any changes which are still held back by the flush delay
+	ConfMan.flushToDisk(true);
 	Common::ConfigManager::destroy();
 	Common::DebugManager::destroy();
 #ifdef ENABLE_EVENTRECORDER
@@ -553,6 +594,7 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	Common::TranslationManager::destroy();
 #endif
 	MusicManager::destroy();
+	Audio::DecodedSoundCache::destroy();
 	Graphics::CursorManager::destroy();
 	Graphics::FontManager::destroy();
 #ifdef USE_FREETYPE2
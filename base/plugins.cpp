@@ -444,6 +444,7 @@ void PluginManager::addToPluginsInMemList(Plugin *plugin) {
 
 // Engine plugins
 
+#include "engines/advancedDetector.h"
 #include "engines/metaengine.h"
 
 namespace Common {
@@ -524,12 +525,30 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 		// Iterate over all known games and for each check if it might be
 		// the game in the presented directory.
 		for (iter = plugins.begin(); iter != plugins.end(); ++iter) {
-			candidates.push_back((**iter)->detectGames(fslist));
+			const MetaEngine &metaEngine = ***iter;
+
+			Common::StackLock lock(metaEngine.getDetectionMutex());
+			if (metaEngine.canDetectConcurrently()) {
+				candidates.push_back(metaEngine.detectGames(fslist));
+			} else {
+				Common::StackLock exclusiveLock(_exclusiveDetectionMutex);
+				candidates.push_back(metaEngine.detectGames(fslist));
+			}
 		}
 	} while (PluginManager::instance().loadNextPlugin());
+
 	return candidates;
 }
 
+bool EngineManager::canDetectConcurrently() const {
+	return !PluginManager::instance().loadsPluginsOneAtATime();
+}
+
+void EngineManager::flushDetectionCache() const {
+	// Persist the MD5s computed by the AdvancedDetector based engines
+	ADMD5Cache::instance().flush();
+}
+
 const EnginePlugin::List &EngineManager::getPlugins() const {
 	return (const EnginePlugin::List &)PluginManager::instance().getPlugins(PLUGIN_TYPE_ENGINE);
 }
@@ -333,6 +333,12 @@ public:
 	virtual bool loadPluginFromGameId(const Common::String &gameId) { return false; }
 	virtual void updateConfigWithFileName(const Common::String &gameId) {}
 
+	/**
+	 * Whether loadFirstPlugin() and loadNextPlugin() swap the plugins in
+	 * memory, so that only one thread at a time may iterate over them.
+	 */
+	virtual bool loadsPluginsOneAtATime() const { return false; }
+
 	// Functions used only by the cached PluginManager
 	virtual void loadAllPlugins();
 	void unloadAllPlugins();
@@ -361,6 +367,7 @@ public:
 	virtual bool loadNextPlugin();
 	virtual bool loadPluginFromGameId(const Common::String &gameId);
 	virtual void updateConfigWithFileName(const Common::String &gameId);
+	virtual bool loadsPluginsOneAtATime() const { return true; }
 
 	virtual void loadAllPlugins() {} 	// we don't allow this
 };
@@ -22,6 +22,7 @@
 
 #include "common/archive.h"
 #include "common/fs.h"
+#include "common/str-array.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 
@@ -62,6 +63,9 @@ int Archive::listMatchingMembers(ArchiveMemberList &list, const String &pattern)
 
 
 
+SearchSet::SearchSet() : _indexEnabled(false), _indexHits(0), _indexMisses(0) {
+}
+
 SearchSet::ArchiveNodeList::iterator SearchSet::find(const String &name) {
 	ArchiveNodeList::iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
@@ -92,6 +96,9 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+
+	--it;
+	indexArchive(it);
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -171,6 +178,8 @@ void SearchSet::addSubDirectoriesMatching(const FSNode &directory, String origPa
 void SearchSet::remove(const String &name) {
 	ArchiveNodeList::iterator it = find(name);
 	if (it != _list.end()) {
+		unindexArchive(it->_arc);
+
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
@@ -188,6 +197,8 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+
+	_index.clear(true);
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -200,20 +211,130 @@ void SearchSet::setPriority(const String &name, int priority) {
 	if (priority == it->_priority)
 		return;
 
+	unindexArchive(it->_arc);
+
 	Node node(*it);
 	_list.erase(it);
 	node._priority = priority;
 	insert(node);
 }
 
+void SearchSet::enableIndex(bool enable) {
+	if (enable == _indexEnabled)
+		return;
+
+	_indexEnabled = enable;
+	_index.clear(true);
+
+	// Going by descending priority, no archive can take over members of another
+	for (ArchiveNodeList::const_iterator it = _list.begin(); _indexEnabled && it != _list.end(); ++it)
+		indexArchive(it);
+}
+
+SearchSet::IndexStats SearchSet::getIndexStats() const {
+	IndexStats stats;
+
+	stats.members = _index.size();
+	stats.hits    = _indexHits;
+	stats.misses  = _indexMisses;
+
+	return stats;
+}
+
+void SearchSet::indexArchive(ArchiveNodeList::const_iterator node) {
+	if (!_indexEnabled)
+		return;
+
+	Archive *arc = node->_arc;
+
+	// Members of archives with a lower priority might be served by the new
+	// one as well. There are none if it was added at the end.
+	ArchiveNodeList::const_iterator next = node;
+	if (++next != _list.end()) {
+		for (MemberIndex::iterator it = _index.begin(); it != _index.end(); ++it)
+			if (it->_value._priority < node->_priority && arc->hasFile(it->_key))
+				it->_value = IndexEntry(arc, node->_priority, true);
+	}
+
+	// An archive of higher priority might serve one of the new members
+	// without listing it, so they are checked on their first lookup. This
+	// isn't necessary if the new archive is the first one.
+	const bool verified = (node == _list.begin());
+
+	ArchiveMemberList members;
+	arc->listMembers(members);
+
+	for (ArchiveMemberList::const_iterator m = members.begin(); m != members.end(); ++m) {
+		const String name = (*m)->getName();
+
+		// The listed name is not necessarily the one the archive serves the
+		// member under, e.g. for files in sub directories of a FSDirectory
+		if (!_index.contains(name) && arc->hasFile(name))
+			_index[name] = IndexEntry(arc, node->_priority, verified);
+	}
+}
+
+void SearchSet::unindexArchive(const Archive *arc) {
+	if (!_indexEnabled)
+		return;
+
+	// Names of members which other archives serve as well are added back
+	// once an ordered search found them
+	StringArray names;
+	for (MemberIndex::const_iterator it = _index.begin(); it != _index.end(); ++it)
+		if (it->_value._arc == arc)
+			names.push_back(it->_key);
+
+	for (StringArray::const_iterator it = names.begin(); it != names.end(); ++it)
+		_index.erase(*it);
+}
+
+Archive *SearchSet::findInIndex(const String &name) const {
+	if (!_indexEnabled)
+		return 0;
+
+	MemberIndex::iterator it = _index.find(name);
+	if (it == _index.end()) {
+		_indexMisses++;
+		return 0;
+	}
+
+	IndexEntry &entry = it->_value;
+	if (!entry._verified) {
+		ArchiveNodeList::const_iterator node = _list.begin();
+		for ( ; node->_arc != entry._arc; ++node) {
+			if (node->_arc->hasFile(name)) {
+				entry._arc      = node->_arc;
+				entry._priority = node->_priority;
+				break;
+			}
+		}
+
+		entry._verified = true;
+	}
+
+	_indexHits++;
+	return entry._arc;
+}
+
+void SearchSet::addToIndex(const String &name, ArchiveNodeList::const_iterator node) const {
+	if (_indexEnabled)
+		_index[name] = IndexEntry(node->_arc, node->_priority, true);
+}
+
 bool SearchSet::hasFile(const String &name) const {
 	if (name.empty())
 		return false;
 
+	if (findInIndex(name))
+		return true;
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
+		if (it->_arc->hasFile(name)) {
+			addToIndex(name, it);
 			return true;
+		}
 	}
 
 	return false;
@@ -243,10 +364,16 @@ const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
+	Archive *archive = findInIndex(name);
+	if (archive)
+		return archive->getMember(name);
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
+		if (it->_arc->hasFile(name)) {
+			addToIndex(name, it);
 			return it->_arc->getMember(name);
+		}
 	}
 
 	return ArchiveMemberPtr();
@@ -256,11 +383,20 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	if (name.empty())
 		return 0;
 
+	Archive *archive = findInIndex(name);
+	if (archive) {
+		SeekableReadStream *stream = archive->createReadStreamForMember(name);
+		if (stream)
+			return stream;
+	}
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for ( ; it != _list.end(); ++it) {
 		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
-		if (stream)
+		if (stream) {
+			addToIndex(name, it);
 			return stream;
+		}
 	}
 
 	return 0;
@@ -24,6 +24,8 @@
 #define COMMON_ARCHIVE_H
 
 #include "common/str.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/list.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
@@ -48,6 +50,13 @@ public:
 	virtual SeekableReadStream *createReadStream() const = 0;
 	virtual String getName() const = 0;
 	virtual String getDisplayName() const { return getName(); }
+
+	/**
+	 * Return whether each stream created for this member reads through a
+	 * handle of its own. Only then may it be read on another thread while
+	 * other streams of the same archive are in use.
+	 */
+	virtual bool createsPrivateStreams() const { return false; }
 };
 
 typedef SharedPtr<ArchiveMember> ArchiveMemberPtr;
@@ -146,7 +155,49 @@ class SearchSet : public Archive {
 	// Add an archive keeping the list sorted by descending priority.
 	void insert(const Node& node);
 
+	/** The archive serving a member, as far as the index knows. */
+	struct IndexEntry {
+		Archive *_arc;
+		int      _priority;
+		/** Has it been checked that no archive of higher priority serves the member? */
+		bool     _verified;
+
+		IndexEntry() : _arc(0), _priority(0), _verified(false) {
+		}
+		IndexEntry(Archive *arc, int priority, bool verified) : _arc(arc), _priority(priority), _verified(verified) {
+		}
+	};
+
+	/** Maps a member name to the archive that serves it. */
+	typedef HashMap<String, IndexEntry, IgnoreCase_Hash, IgnoreCase_EqualTo> MemberIndex;
+
+	bool _indexEnabled;
+	mutable MemberIndex _index;
+
+	mutable uint32 _indexHits;
+	mutable uint32 _indexMisses;
+
+	// Add the members of a newly inserted archive to the member index.
+	void indexArchive(ArchiveNodeList::const_iterator node);
+
+	// Remove the members of an archive from the member index.
+	void unindexArchive(const Archive *arc);
+
+	// Find the archive serving the member in the index. Returns 0 if it's not found.
+	Archive *findInIndex(const String &name) const;
+
+	// Remember the archive an ordered search found a member in.
+	void addToIndex(const String &name, ArchiveNodeList::const_iterator node) const;
+
 public:
+	/** Statistics about the member index. */
+	struct IndexStats {
+		uint32 members;  ///< Number of members in the index.
+		uint32 hits;     ///< Number of lookups answered by the index.
+		uint32 misses;   ///< Number of lookups that had to probe all archives.
+	};
+
+	SearchSet();
 	virtual ~SearchSet() { clear(); }
 
 	/**
@@ -230,6 +281,30 @@ public:
 	 */
 	void setPriority(const String& name, int priority);
 
+	/**
+	 * Enable or disable the member index.
+	 *
+	 * With the index enabled, the names of all members of all archives are
+	 * collected in one case-insensitive hash map, together with the archive
+	 * of the highest priority serving them. Lookups of such a member then
+	 * only need a single hash probe, instead of probing every archive.
+	 *
+	 * The index is updated whenever archives are added, removed or
+	 * reprioritized, only looking at the archive in question. Members an
+	 * archive serves without listing them, like files in sub directories of
+	 * a FSDirectory, are added once an ordered search found them. Since the
+	 * index can't notice changes within the contained archives themselves,
+	 * nested search sets included, it should only be enabled when their
+	 * contents are static. Lookups update the index, so a search set with
+	 * the index enabled must not be searched from several threads at once.
+	 */
+	void enableIndex(bool enable);
+
+	/**
+	 * Return statistics about the member index.
+	 */
+	IndexStats getIndexStats() const;
+
 	virtual bool hasFile(const String &name) const;
 	virtual int listMatchingMembers(ArchiveMemberList &list, const String &pattern) const;
 	virtual int listMembers(ArchiveMemberList &list) const;
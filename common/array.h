@@ -40,9 +40,13 @@ namespace Common {
  *
  * The container class closest to this in the C++ standard library is
  * std::vector. However, there are some differences.
+ *
+ * The storage is obtained through the allocator given as second template
+ * parameter (see DefaultAllocator for the interface it has to provide).
+ * This allows e.g. placing temporary arrays into a Common::Arena.
  */
-template<class T>
-class Array {
+template<class T, class Alloc = DefaultAllocator>
+class Array : private Alloc {
 public:
 	typedef T *iterator;
 	typedef const T *const_iterator;
@@ -59,7 +63,13 @@ protected:
 public:
 	Array() : _capacity(0), _size(0), _storage(0) {}
 
-	Array(const Array<T> &array) : _capacity(array._size), _size(array._size), _storage(0) {
+	/**
+	 * Construct an empty array which obtains its storage from the given
+	 * allocator.
+	 */
+	explicit Array(const Alloc &alloc) : Alloc(alloc), _capacity(0), _size(0), _storage(0) {}
+
+	Array(const Array &array) : Alloc(array), _capacity(array._size), _size(array._size), _storage(0) {
 		if (array._storage) {
 			allocCapacity(_size);
 			uninitialized_copy(array._storage, array._storage + _size, _storage);
@@ -77,7 +87,7 @@ public:
 	}
 
 	~Array() {
-		freeStorage(_storage, _size);
+		freeStorage(_storage, _size, _capacity);
 		_storage = 0;
 		_capacity = _size = 0;
 	}
@@ -90,7 +100,7 @@ public:
 			insert_aux(end(), &element, &element + 1);
 	}
 
-	void push_back(const Array<T> &array) {
+	void push_back(const Array &array) {
 		if (_size + array.size() <= _capacity) {
 			uninitialized_copy(array.begin(), array.end(), end());
 			_size += array.size();
@@ -136,7 +146,7 @@ public:
 		insert_aux(_storage + idx, &element, &element + 1);
 	}
 
-	void insert_at(size_type idx, const Array<T> &array) {
+	void insert_at(size_type idx, const Array &array) {
 		assert(idx <= _size);
 		insert_aux(_storage + idx, array.begin(), array.end());
 	}
@@ -164,11 +174,11 @@ public:
 		return _storage[idx];
 	}
 
-	Array<T> &operator=(const Array<T> &array) {
+	Array &operator=(const Array &array) {
 		if (this == &array)
 			return *this;
 
-		freeStorage(_storage, _size);
+		freeStorage(_storage, _size, _capacity);
 		_size = array._size;
 		allocCapacity(_size);
 		uninitialized_copy(array._storage, array._storage + _size, _storage);
@@ -181,7 +191,7 @@ public:
 	}
 
 	void clear() {
-		freeStorage(_storage, _size);
+		freeStorage(_storage, _size, _capacity);
 		_storage = 0;
 		_size = 0;
 		_capacity = 0;
@@ -191,7 +201,12 @@ public:
 		return (_size == 0);
 	}
 
-	bool operator==(const Array<T> &other) const {
+	/** Returns the allocator used for the storage of this array. */
+	const Alloc &getAllocator() const {
+		return *this;
+	}
+
+	bool operator==(const Array &other) const {
 		if (this == &other)
 			return true;
 		if (_size != other._size)
@@ -203,7 +218,7 @@ public:
 		return true;
 	}
 
-	bool operator!=(const Array<T> &other) const {
+	bool operator!=(const Array &other) const {
 		return !(*this == other);
 	}
 
@@ -228,12 +243,13 @@ public:
 			return;
 
 		T *oldStorage = _storage;
+		const size_type oldCapacity = _capacity;
 		allocCapacity(newCapacity);
 
 		if (oldStorage) {
 			// Copy old data
 			uninitialized_copy(oldStorage, oldStorage + _size, _storage);
-			freeStorage(oldStorage, _size);
+			freeStorage(oldStorage, _size, oldCapacity);
 		}
 	}
 
@@ -264,7 +280,7 @@ protected:
 	void allocCapacity(size_type capacity) {
 		_capacity = capacity;
 		if (capacity) {
-			_storage = (T *)malloc(sizeof(T) * capacity);
+			_storage = (T *)Alloc::allocate(sizeof(T) * capacity);
 			if (!_storage)
 				::error("Common::Array: failure to allocate %u bytes", capacity * (size_type)sizeof(T));
 		} else {
@@ -272,10 +288,11 @@ protected:
 		}
 	}
 
-	void freeStorage(T *storage, const size_type elements) {
+	void freeStorage(T *storage, const size_type elements, const size_type capacity) {
 		for (size_type i = 0; i < elements; ++i)
 			storage[i].~T();
-		free(storage);
+		if (storage)
+			Alloc::deallocate(storage, sizeof(T) * capacity);
 	}
 
 	/**
@@ -299,6 +316,7 @@ protected:
 			const size_type idx = pos - _storage;
 			if (_size + n > _capacity || (_storage <= first && first <= _storage + _size)) {
 				T *const oldStorage = _storage;
+				const size_type oldCapacity = _capacity;
 
 				// If there is not enough space, allocate more.
 				// Likewise, if this is a self-insert, we allocate new
@@ -314,7 +332,7 @@ protected:
 				// insert.
 				uninitialized_copy(oldStorage + idx, oldStorage + _size, _storage + idx + n);
 
-				freeStorage(oldStorage, _size);
+				freeStorage(oldStorage, _size, oldCapacity);
 			} else if (idx + n <= _size) {
 				// Make room for the new elements by shifting back
 				// existing ones.
@@ -0,0 +1,143 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup atomic Atomic access to variables shared between threads
+ *
+ * These only cover what lock-free hand-over between threads needs: a store
+ * which publishes everything written before it, a load after which
+ * everything published that way is visible, a compare-and-swap of
+ * pointers for lists several threads add to, and adding to counters for
+ * reference counting. They work for integral types and pointers, which
+ * have to be properly aligned.
+ *
+ * @{
+ */
+
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+
+/** Read a shared variable, with acquire semantics. */
+template<class T>
+inline T atomicLoad(const volatile T *ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/** Write a shared variable, with release semantics. */
+template<class T>
+inline void atomicStore(volatile T *ptr, T value) {
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+/**
+ * Replace a shared pointer by desired if it still equals expected, with
+ * acquire and release semantics.
+ *
+ * @return whether the pointer was replaced
+ */
+template<class T>
+inline bool atomicCompareExchange(T *volatile *ptr, T *expected, T *desired) {
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Add to a shared counter, with acquire and release semantics.
+ *
+ * @return the new value of the counter
+ */
+inline int32 atomicAdd(volatile int32 *ptr, int32 value) {
+	return __atomic_add_fetch(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+#elif defined(__GNUC__)
+
+template<class T>
+inline T atomicLoad(const volatile T *ptr) {
+	T value = *ptr;
+	__sync_synchronize();
+	return value;
+}
+
+template<class T>
+inline void atomicStore(volatile T *ptr, T value) {
+	__sync_synchronize();
+	*ptr = value;
+}
+
+template<class T>
+inline bool atomicCompareExchange(T *volatile *ptr, T *expected, T *desired) {
+	return __sync_bool_compare_and_swap(ptr, expected, desired);
+}
+
+inline int32 atomicAdd(volatile int32 *ptr, int32 value) {
+	return __sync_add_and_fetch(ptr, value);
+}
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+
+// Volatile accesses are ordered on x86, only the compiler must not move
+// other accesses around them
+template<class T>
+inline T atomicLoad(const volatile T *ptr) {
+	T value = *ptr;
+	_ReadWriteBarrier();
+	return value;
+}
+
+template<class T>
+inline void atomicStore(volatile T *ptr, T value) {
+	_ReadWriteBarrier();
+	*ptr = value;
+}
+
+template<class T>
+inline bool atomicCompareExchange(T *volatile *ptr, T *expected, T *desired) {
+	return _InterlockedCompareExchangePointer((void *volatile *)ptr, desired, expected) == expected;
+}
+
+inline int32 atomicAdd(volatile int32 *ptr, int32 value) {
+	return _InterlockedExchangeAdd((volatile long *)ptr, value) + value;
+}
+
+#else
+
+// Plain accesses are neither atomic nor ordered on every system, so
+// silently falling back to them would break the code relying on these
+#error "No atomic operations are known for this compiler, add them to common/atomic.h"
+
+#endif
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -26,8 +26,10 @@
 #define COMMON_BITSTREAM_H
 
 #include "common/scummsys.h"
+#include "common/endian.h"
 #include "common/textconsole.h"
 #include "common/stream.h"
+#include "common/types.h"
 
 namespace Common {
 
@@ -70,6 +72,19 @@ public:
 	/** Add a bit to the value x, making it an n+1-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
+	/** Are the bits handed out in the order of MSB to LSB? */
+	virtual bool isMSBFirst() const = 0;
+
+	/**
+	 * Are peekBits() and skip() cheap, compared to reading bit by bit?
+	 *
+	 * Decoders which can either look ahead or read one bit at a time use
+	 * this to pick the faster way.
+	 */
+	virtual bool hasCheapPeek() const {
+		return false;
+	}
+
 protected:
 	BitStream() {
 	}
@@ -302,6 +317,11 @@ public:
 	bool eos() const {
 		return _stream->eos() || (pos() >= size());
 	}
+
+	/** Are the bits handed out in the order of MSB to LSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
 };
 
 // typedefs for various memory layouts.
@@ -329,6 +349,432 @@ typedef BitStreamImpl<32, false, true > BitStream32BEMSB;
 /** 32-bit big-endian data, LSB to MSB. */
 typedef BitStreamImpl<32, false, false> BitStream32BELSB;
 
+/**
+ * A minimal, non-virtual read stream over a memory buffer, to be used
+ * as the data source of a BitStreamReservoirImpl.
+ *
+ * Reading values from it boils down to a simple pointer access, instead
+ * of a virtual ReadStream call per value.
+ */
+class BitStreamMemoryStream {
+private:
+	const byte * const _ptrOrig;
+	const byte *_ptr;
+	const uint32 _size;
+	uint32 _pos;
+	DisposeAfterUse::Flag _disposeMemory;
+	bool _eos;
+
+public:
+	BitStreamMemoryStream(const byte *dataPtr, uint32 dataSize, DisposeAfterUse::Flag disposeMemory = DisposeAfterUse::NO) :
+		_ptrOrig(dataPtr),
+		_ptr(dataPtr),
+		_size(dataSize),
+		_pos(0),
+		_disposeMemory(disposeMemory),
+		_eos(false) {}
+
+	~BitStreamMemoryStream() {
+		if (_disposeMemory)
+			free(const_cast<byte *>(_ptrOrig));
+	}
+
+	bool eos() const {
+		return _eos;
+	}
+
+	bool err() const {
+		return false;
+	}
+
+	int32 pos() const {
+		return _pos;
+	}
+
+	int32 size() const {
+		return _size;
+	}
+
+	bool seek(uint32 offset) {
+		assert(offset <= _size);
+
+		_eos = false;
+		_pos = offset;
+		_ptr = _ptrOrig + _pos;
+		return true;
+	}
+
+	byte readByte() {
+		if (_pos >= _size) {
+			_eos = true;
+			return 0;
+		}
+
+		_pos++;
+		return *_ptr++;
+	}
+
+	uint16 readUint16LE() {
+		if (_pos + 2 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		uint16 val = READ_LE_UINT16(_ptr);
+
+		_pos += 2;
+		_ptr += 2;
+
+		return val;
+	}
+
+	uint16 readUint16BE() {
+		if (_pos + 2 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		uint16 val = READ_BE_UINT16(_ptr);
+
+		_pos += 2;
+		_ptr += 2;
+
+		return val;
+	}
+
+	uint32 readUint32LE() {
+		if (_pos + 4 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		uint32 val = READ_LE_UINT32(_ptr);
+
+		_pos += 4;
+		_ptr += 4;
+
+		return val;
+	}
+
+	uint32 readUint32BE() {
+		if (_pos + 4 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		uint32 val = READ_BE_UINT32(_ptr);
+
+		_pos += 4;
+		_ptr += 4;
+
+		return val;
+	}
+};
+
+/**
+ * A template implementing a bit stream with a 64-bit bit reservoir.
+ *
+ * Like BitStreamImpl, it reads valueBits-wide values from the data stream,
+ * but it keeps as many of them as fit into the reservoir. peekBits() and
+ * skip() only work on the reservoir, the data stream is only touched when
+ * the reservoir needs to be refilled. Note that the data stream is read
+ * ahead of the bit stream's position by up to 64 bits.
+ *
+ * The data stream can either be a SeekableReadStream or, for data already
+ * in memory, a BitStreamMemoryStream.
+ */
+template<class STREAM, int valueBits, bool isLE, bool isMSB2LSB>
+class BitStreamReservoirImpl : public BitStream {
+private:
+	STREAM *_stream;                         ///< The input stream.
+	DisposeAfterUse::Flag _disposeAfterUse;  ///< Should we delete the stream on destruction?
+
+	uint64 _reservoir;    ///< The bits read from the stream, but not yet handed out.
+	uint8  _reservoirBits; ///< Number of bits in the reservoir.
+
+	/** Read a data value. */
+	inline uint32 readData() {
+		if (isLE) {
+			if (valueBits ==  8)
+				return _stream->readByte();
+			if (valueBits == 16)
+				return _stream->readUint16LE();
+			if (valueBits == 32)
+				return _stream->readUint32LE();
+		} else {
+			if (valueBits ==  8)
+				return _stream->readByte();
+			if (valueBits == 16)
+				return _stream->readUint16BE();
+			if (valueBits == 32)
+				return _stream->readUint32BE();
+		}
+
+		assert(false);
+		return 0;
+	}
+
+	/** Fill the reservoir with as many data values as fit and are available. */
+	inline void refill() {
+		uint32 valuesLeft = (_stream->size() - _stream->pos()) / (valueBits / 8);
+
+		while ((_reservoirBits <= (64 - valueBits)) && (valuesLeft-- > 0)) {
+			uint64 value = readData();
+			if (_stream->err() || _stream->eos())
+				error("BitStreamReservoirImpl::refill(): Read error");
+
+			// MSB2LSB: The reservoir is filled from the top, LSB2MSB: from the bottom
+			if (isMSB2LSB)
+				_reservoir |= value << (64 - valueBits - _reservoirBits);
+			else
+				_reservoir |= value << _reservoirBits;
+
+			_reservoirBits += valueBits;
+		}
+	}
+
+	/** Make sure the reservoir holds at least n bits. */
+	inline void need(uint8 n) {
+		if (_reservoirBits >= n)
+			return;
+
+		refill();
+
+		if (_reservoirBits < n)
+			error("BitStreamReservoirImpl::need(): End of bit stream reached");
+	}
+
+	/** Return the next n bits of the reservoir, 0 < n <= 32. */
+	inline uint32 peekReservoir(uint8 n) const {
+		if (isMSB2LSB)
+			return (uint32)(_reservoir >> (64 - n));
+
+		return (uint32)(_reservoir & ((((uint64) 1) << n) - 1));
+	}
+
+	/** Drop the next n bits of the reservoir, n <= _reservoirBits. */
+	inline void skipReservoir(uint8 n) {
+		if (n >= 64)
+			_reservoir = 0;
+		else if (isMSB2LSB)
+			_reservoir <<= n;
+		else
+			_reservoir >>= n;
+
+		_reservoirBits -= n;
+	}
+
+	/** Empty the reservoir and position the stream at that byte offset. */
+	void reset(uint32 offset) {
+		_stream->seek(offset);
+
+		_reservoir     = 0;
+		_reservoirBits = 0;
+	}
+
+public:
+	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
+	BitStreamReservoirImpl(STREAM *stream, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::NO) :
+		_stream(stream), _disposeAfterUse(disposeAfterUse), _reservoir(0), _reservoirBits(0) {
+
+		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
+			error("BitStreamReservoirImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+	}
+
+	/** Create a bit stream using this input data stream. */
+	BitStreamReservoirImpl(STREAM &stream) :
+		_stream(&stream), _disposeAfterUse(DisposeAfterUse::NO), _reservoir(0), _reservoirBits(0) {
+
+		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
+			error("BitStreamReservoirImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+	}
+
+	~BitStreamReservoirImpl() {
+		if (_disposeAfterUse == DisposeAfterUse::YES)
+			delete _stream;
+	}
+
+	/** Read a bit from the bit stream. */
+	uint32 getBit() {
+		need(1);
+
+		uint32 b = peekReservoir(1);
+		skipReservoir(1);
+
+		return b;
+	}
+
+	/**
+	 * Read a multi-bit value from the bit stream.
+	 *
+	 * The bit order is the same as in BitStreamImpl::getBits().
+	 */
+	uint32 getBits(uint8 n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			error("BitStreamReservoirImpl::getBits(): Too many bits requested to be read");
+
+		need(n);
+
+		uint32 v = peekReservoir(n);
+		skipReservoir(n);
+
+		return v;
+	}
+
+	/** Read a bit from the bit stream, without changing the stream's position. */
+	uint32 peekBit() {
+		need(1);
+
+		return peekReservoir(1);
+	}
+
+	/**
+	 * Read a multi-bit value from the bit stream, without changing the stream's position.
+	 *
+	 * The bit order is the same as in getBits().
+	 */
+	uint32 peekBits(uint8 n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			error("BitStreamReservoirImpl::peekBits(): Too many bits requested to be read");
+
+		need(n);
+
+		return peekReservoir(n);
+	}
+
+	/**
+	 * Add a bit to the value x, making it an n+1-bit value.
+	 *
+	 * The bit order is the same as in BitStreamImpl::addBit().
+	 */
+	void addBit(uint32 &x, uint32 n) {
+		if (n >= 32)
+			error("BitStreamReservoirImpl::addBit(): Too many bits requested to be read");
+
+		if (isMSB2LSB)
+			x = (x << 1) | getBit();
+		else
+			x = (x & ~(1 << n)) | (getBit() << n);
+	}
+
+	/** Rewind the bit stream back to the start. */
+	void rewind() {
+		reset(0);
+	}
+
+	/** Skip the specified amount of bits. */
+	void skip(uint32 n) {
+		if (n <= _reservoirBits) {
+			skipReservoir(n);
+			return;
+		}
+
+		n -= _reservoirBits;
+		skipReservoir(_reservoirBits);
+
+		// Skip whole data values directly in the stream
+		const uint32 values = n / valueBits;
+		if (values > 0) {
+			const uint32 valuesLeft = (_stream->size() - _stream->pos()) / (valueBits / 8);
+			if (valuesLeft < values)
+				error("BitStreamReservoirImpl::skip(): End of bit stream reached");
+
+			reset(_stream->pos() + values * (valueBits / 8));
+		}
+
+		n %= valueBits;
+		if (n > 0) {
+			need(n);
+			skipReservoir(n);
+		}
+	}
+
+	/** Skip the bits to closest data value border. */
+	void align() {
+		skip(_reservoirBits % valueBits);
+	}
+
+	/** Return the stream position in bits. */
+	uint32 pos() const {
+		return ((uint32) _stream->pos()) * 8 - _reservoirBits;
+	}
+
+	/** Return the stream size in bits. */
+	uint32 size() const {
+		return (_stream->size() & ~((uint32) ((valueBits >> 3) - 1))) * 8;
+	}
+
+	bool eos() const {
+		return pos() >= size();
+	}
+
+	/** Are the bits handed out in the order of MSB to LSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
+	/** peekBits() and skip() only touch the reservoir. */
+	bool hasCheapPeek() const {
+		return true;
+	}
+};
+
+// typedefs for various memory layouts, reading from a SeekableReadStream.
+
+/** 8-bit data, MSB to LSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 8, false, true > BitStreamReservoir8MSB;
+/** 8-bit data, LSB to MSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 8, false, false> BitStreamReservoir8LSB;
+
+/** 16-bit little-endian data, MSB to LSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 16, true , true > BitStreamReservoir16LEMSB;
+/** 16-bit little-endian data, LSB to MSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 16, true , false> BitStreamReservoir16LELSB;
+/** 16-bit big-endian data, MSB to LSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 16, false, true > BitStreamReservoir16BEMSB;
+/** 16-bit big-endian data, LSB to MSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 16, false, false> BitStreamReservoir16BELSB;
+
+/** 32-bit little-endian data, MSB to LSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 32, true , true > BitStreamReservoir32LEMSB;
+/** 32-bit little-endian data, LSB to MSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 32, true , false> BitStreamReservoir32LELSB;
+/** 32-bit big-endian data, MSB to LSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 32, false, true > BitStreamReservoir32BEMSB;
+/** 32-bit big-endian data, LSB to MSB. */
+typedef BitStreamReservoirImpl<SeekableReadStream, 32, false, false> BitStreamReservoir32BELSB;
+
+// typedefs for various memory layouts, reading from a BitStreamMemoryStream.
+
+/** 8-bit data, MSB to LSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 8, false, true > BitStreamMemory8MSB;
+/** 8-bit data, LSB to MSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 8, false, false> BitStreamMemory8LSB;
+
+/** 16-bit little-endian data, MSB to LSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 16, true , true > BitStreamMemory16LEMSB;
+/** 16-bit little-endian data, LSB to MSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 16, true , false> BitStreamMemory16LELSB;
+/** 16-bit big-endian data, MSB to LSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 16, false, true > BitStreamMemory16BEMSB;
+/** 16-bit big-endian data, LSB to MSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 16, false, false> BitStreamMemory16BELSB;
+
+/** 32-bit little-endian data, MSB to LSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 32, true , true > BitStreamMemory32LEMSB;
+/** 32-bit little-endian data, LSB to MSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 32, true , false> BitStreamMemory32LELSB;
+/** 32-bit big-endian data, MSB to LSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 32, false, true > BitStreamMemory32BEMSB;
+/** 32-bit big-endian data, LSB to MSB. */
+typedef BitStreamReservoirImpl<BitStreamMemoryStream, 32, false, false> BitStreamMemory32BELSB;
+
 } // End of namespace Common
 
 #endif // COMMON_BITSTREAM_H
@@ -48,7 +48,7 @@ char const *const ConfigManager::kKeymapperDomain = "keymapper";
 #pragma mark -
 
 
-ConfigManager::ConfigManager() : _activeDomain(0) {
+ConfigManager::ConfigManager() : _activeDomain(0), _layoutChanged(true), _flushPending(false), _flushDelay(1000), _lastFlushTime(0) {
 }
 
 void ConfigManager::defragment() {
@@ -71,6 +71,10 @@ void ConfigManager::copyFrom(ConfigManager &source) {
 	_activeDomainName = source._activeDomainName;
 	_activeDomain = &_gameDomains[_activeDomainName];
 	_filename = source._filename;
+	_layoutChanged = source._layoutChanged;
+	_flushPending = source._flushPending;
+	_flushDelay = source._flushDelay;
+	_lastFlushTime = source._lastFlushTime;
 }
 
 
@@ -91,7 +95,7 @@ void ConfigManager::loadDefaultConfigFile() {
 		// No config file -> create new one!
 		debug("Default configuration file missing, creating a new one");
 
-		flushToDisk();
+		flushToDisk(true);
 	}
 }
 
@@ -115,6 +119,7 @@ void ConfigManager::loadConfigFile(const String &filename) {
 void ConfigManager::addDomain(const String &domainName, const ConfigManager::Domain &domain) {
 	if (domainName.empty())
 		return;
+	_layoutChanged = true;
 	if (domainName == kApplicationDomain) {
 		_appDomain = domain;
 #ifdef ENABLE_KEYMAPPER
@@ -145,10 +150,53 @@ void ConfigManager::addDomain(const String &domainName, const ConfigManager::Dom
 }
 
 
+/**
+ * Return the domain which the loader should parse the named domain into.
+ * Most domains are game domains, so these are parsed right into a new entry
+ * in _gameDomains, as copying them there would take as long as parsing them.
+ * Everything else goes through addDomain().
+ **/
+ConfigManager::Domain *ConfigManager::beginLoadedDomain(const String &domainName, Domain &scratch) {
+	if (domainName.empty() || domainName == kApplicationDomain ||
+#ifdef ENABLE_KEYMAPPER
+	    domainName == kKeymapperDomain ||
+#endif
+	    _gameDomains.contains(domainName)) {
+		scratch.clear();
+		return &scratch;
+	}
+
+	return &_gameDomains[domainName];
+}
+
+/**
+ * Put a domain returned by beginLoadedDomain() into its final place, once
+ * it has been parsed completely.
+ **/
+void ConfigManager::endLoadedDomain(const String &domainName, Domain *domain, Domain &scratch) {
+	if (!domain)
+		return;
+
+	if (domain == &scratch) {
+		addDomain(domainName, scratch);
+	} else if (domain->contains("gameid")) {
+		_domainSaveOrder.push_back(domainName);
+
+		// Delete any 'ghost' misc domain with the same name, see addDomain()
+		if (_miscDomains.contains(domainName))
+			_miscDomains.erase(domainName);
+	} else {
+		// Not a game domain after all
+		addDomain(domainName, *domain);
+		_gameDomains.erase(domainName);
+	}
+}
+
 void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 	String domainName;
 	String comment;
-	Domain domain;
+	Domain scratch;
+	Domain *domain = 0;
 	int lineno = 0;
 
 	_appDomain.clear();
@@ -161,16 +209,34 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 	_keymapperDomain.clear();
 #endif
 
+	// Read the whole file in one go, and parse it in place: every line is
+	// terminated in the buffer itself, so that no String has to be built
+	// for lines, only for the keys and values which are actually stored.
+	int32 size = MAX<int32>(stream.size() - stream.pos(), 0);
+	char *buffer = new char[size + 1];
+	size = stream.read(buffer, size);
+	buffer[size] = 0;
+
 	// TODO: Detect if a domain occurs multiple times (or likewise, if
 	// a key occurs multiple times inside one domain).
 
-	while (!stream.eos() && !stream.err()) {
+	char *next = buffer;
+	char *bufferEnd = buffer + size;
+	while (next < bufferEnd) {
 		lineno++;
 
-		// Read a line
-		String line = stream.readLine();
+		// Find the end of the line, accepting LF, CR and CR LF line endings
+		char *line = next;
+		char *lineEnd = line;
+		while (lineEnd < bufferEnd && *lineEnd != '\n' && *lineEnd != '\r')
+			lineEnd++;
+
+		next = lineEnd + 1;
+		if (lineEnd + 1 < bufferEnd && lineEnd[0] == '\r' && lineEnd[1] == '\n')
+			next++;
+		*lineEnd = 0;
 
-		if (line.size() == 0) {
+		if (line == lineEnd) {
 			// Do nothing
 		} else if (line[0] == '#') {
 			// Accumulate comments here. Once we encounter either the start
@@ -181,9 +247,8 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 		} else if (line[0] == '[') {
 			// It's a new domain which begins here.
 			// Determine where the previously accumulated domain goes, if we accumulated anything.
-			addDomain(domainName, domain);
-			domain.clear();
-			const char *p = line.c_str() + 1;
+			endLoadedDomain(domainName, domain, scratch);
+			const char *p = line + 1;
 			// Get the domain name, and check whether it's valid (that
 			// is, verify that it only consists of alphanumerics,
 			// dashes and underscores).
@@ -195,16 +260,17 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 			else if (*p != ']')
 				error("Config file buggy: Invalid character '%c' occurred in section name in line %d", *p, lineno);
 
-			domainName = String(line.c_str() + 1, p);
+			domainName = String(line + 1, p);
 
-			domain.setDomainComment(comment);
+			domain = beginLoadedDomain(domainName, scratch);
+			domain->setDomainComment(comment);
 			comment.clear();
 
 		} else {
 			// This line should be a line with a 'key=value' pair, or an empty one.
 
 			// Skip leading whitespaces
-			const char *t = line.c_str();
+			const char *t = line;
 			while (isSpace(*t))
 				t++;
 
@@ -222,27 +288,111 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 			if (!p)
 				error("Config file buggy: Junk found in line line %d: '%s'", lineno, t);
 
-			// Extract the key/value pair
-			String key(t, p);
-			String value(p + 1);
+			// Trim the spaces around the key and the value
+			const char *keyEnd = p;
+			while (keyEnd > t && isSpace(keyEnd[-1]))
+				keyEnd--;
 
-			// Trim of spaces
-			key.trim();
-			value.trim();
+			const char *value = p + 1;
+			const char *valueEnd = lineEnd;
+			while (isSpace(*value))
+				value++;
+			while (valueEnd > value && isSpace(valueEnd[-1]))
+				valueEnd--;
 
 			// Finally, store the key/value pair in the active domain
-			domain[key] = value;
+			String key(t, keyEnd);
+			domain->setVal(key, String(value, valueEnd));
 
 			// Store comment
-			domain.setKVComment(key, comment);
-			comment.clear();
+			if (!comment.empty()) {
+				domain->setKVComment(key, comment);
+				comment.clear();
+			}
 		}
 	}
 
-	addDomain(domainName, domain); // Add the last domain found
+	endLoadedDomain(domainName, domain, scratch); // Add the last domain found
+
+	delete[] buffer;
+
+	markClean();
 }
 
-void ConfigManager::flushToDisk() {
+void ConfigManager::flushToDisk(bool immediate) {
+	if (!isDirty()) {
+		_flushPending = false;
+		return;
+	}
+
+	// Defer the write if the config file was written only recently. Either
+	// processPendingFlush() or the next immediate flush will take care of it.
+	if (!immediate && _flushDelay && g_system) {
+		uint32 now = g_system->getMillis();
+		if (_lastFlushTime && now - _lastFlushTime < _flushDelay) {
+			_flushPending = true;
+			return;
+		}
+	}
+
+	writeToDisk();
+}
+
+void ConfigManager::processPendingFlush() {
+	if (!_flushPending)
+		return;
+
+	if (g_system && g_system->getMillis() - _lastFlushTime < _flushDelay)
+		return;
+
+	flushToDisk(true);
+}
+
+bool ConfigManager::isDirty() const {
+	// Only the domains which are written to the config file count, changes
+	// to the transient and default domains never need to be saved.
+	if (_layoutChanged || _appDomain.isModified())
+		return true;
+#ifdef ENABLE_KEYMAPPER
+	if (_keymapperDomain.isModified())
+		return true;
+#endif
+
+	DomainMap::const_iterator d;
+	for (d = _miscDomains.begin(); d != _miscDomains.end(); ++d) {
+		if (d->_value.isModified())
+			return true;
+	}
+	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d) {
+		if (d->_value.isModified())
+			return true;
+	}
+	return false;
+}
+
+void ConfigManager::markClean() {
+	_appDomain.markSaved();
+#ifdef ENABLE_KEYMAPPER
+	_keymapperDomain.markSaved();
+#endif
+
+	DomainMap::const_iterator d;
+	for (d = _miscDomains.begin(); d != _miscDomains.end(); ++d)
+		d->_value.markSaved();
+	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d)
+		d->_value.markSaved();
+
+	_layoutChanged = false;
+	_flushPending = false;
+}
+
+void ConfigManager::writeToDisk() {
+	// Whether or not the write succeeds, don't retry it until the
+	// configuration changes again.
+	markClean();
+	if (g_system)
+		_lastFlushTime = g_system->getMillis();
+
 #ifndef __DC__
 	WriteStream *stream;
 
@@ -265,40 +415,55 @@ void ConfigManager::flushToDisk() {
 		stream = dump;
 	}
 
+	saveToStream(*stream);
+
+	delete stream;
+
+#endif // !__DC__
+}
+
+void ConfigManager::saveToStream(WriteStream &stream) {
 	// Write the application domain
-	writeDomain(*stream, kApplicationDomain, _appDomain);
+	writeDomain(stream, kApplicationDomain, _appDomain);
 
 #ifdef ENABLE_KEYMAPPER
 	// Write the keymapper domain
-	writeDomain(*stream, kKeymapperDomain, _keymapperDomain);
+	writeDomain(stream, kKeymapperDomain, _keymapperDomain);
 #endif
 
 	DomainMap::const_iterator d;
 
 	// Write the miscellaneous domains next
 	for (d = _miscDomains.begin(); d != _miscDomains.end(); ++d) {
-		writeDomain(*stream, d->_key, d->_value);
+		writeDomain(stream, d->_key, d->_value);
 	}
 
 	// First write the domains in _domainSaveOrder, in that order.
 	// Note: It's possible for _domainSaveOrder to list domains which
 	// are not present anymore, so we validate each name.
+	uint numWritten = 0;
 	Array<String>::const_iterator i;
 	for (i = _domainSaveOrder.begin(); i != _domainSaveOrder.end(); ++i) {
-		if (_gameDomains.contains(*i)) {
-			writeDomain(*stream, *i, _gameDomains[*i]);
+		d = _gameDomains.find(*i);
+		if (d != _gameDomains.end()) {
+			writeDomain(stream, *i, d->_value);
+			numWritten++;
 		}
 	}
 
-	// Now write the domains which haven't been written yet
-	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d) {
-		if (find(_domainSaveOrder.begin(), _domainSaveOrder.end(), d->_key) == _domainSaveOrder.end())
-			writeDomain(*stream, d->_key, d->_value);
-	}
+	// Now write the domains which haven't been written yet. Usually every
+	// game domain is listed in _domainSaveOrder, so we can skip the lookups.
+	if (numWritten >= _gameDomains.size())
+		return;
 
-	delete stream;
+	HashMap<String, bool> written;
+	for (i = _domainSaveOrder.begin(); i != _domainSaveOrder.end(); ++i)
+		written[*i] = true;
 
-#endif // !__DC__
+	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d) {
+		if (!written.contains(d->_key))
+			writeDomain(stream, d->_key, d->_value);
+	}
 }
 
 void ConfigManager::writeDomain(WriteStream &stream, const String &name, const Domain &domain) {
@@ -308,13 +473,12 @@ void ConfigManager::writeDomain(WriteStream &stream, const String &name, const D
 	// WORKAROUND: Fix for bug #1972625 "ALL: On-the-fly targets are
 	// written to the config file": Do not save domains that came from
 	// the command line
-	if (domain.contains("id_came_from_command_line"))
+	static const String cameFromCommandLine("id_came_from_command_line");
+	if (domain.contains(cameFromCommandLine))
 		return;
 
-	String comment;
-
 	// Write domain comment (if any)
-	comment = domain.getDomainComment();
+	const String &comment = domain.getDomainComment();
 	if (!comment.empty())
 		stream.writeString(comment);
 
@@ -325,21 +489,7 @@ void ConfigManager::writeDomain(WriteStream &stream, const String &name, const D
 	stream.writeByte('\n');
 
 	// Write all key/value pairs in this domain, including comments
-	Domain::const_iterator x;
-	for (x = domain.begin(); x != domain.end(); ++x) {
-		if (!x->_value.empty()) {
-			// Write comment (if any)
-			if (domain.hasKVComment(x->_key)) {
-				comment = domain.getKVComment(x->_key);
-				stream.writeString(comment);
-			}
-			// Write the key/value pair
-			stream.writeString(x->_key);
-			stream.writeByte('=');
-			stream.writeString(x->_value);
-			stream.writeByte('\n');
-		}
-	}
+	stream.writeString(domain.getSerializedBody());
 	stream.writeByte('\n');
 }
 
@@ -510,9 +660,9 @@ void ConfigManager::set(const String &key, const String &value) {
 	// Write the new key/value pair into the active domain, resp. into
 	// the application domain if no game domain is active.
 	if (_activeDomain)
-		(*_activeDomain)[key] = value;
+		_activeDomain->setVal(key, value);
 	else
-		_appDomain[key] = value;
+		_appDomain.setVal(key, value);
 }
 
 void ConfigManager::set(const String &key, const String &value, const String &domName) {
@@ -530,7 +680,7 @@ void ConfigManager::set(const String &key, const String &value, const String &do
 		error("ConfigManager::set(%s,%s,%s) called on non-existent domain",
 		      key.c_str(), value.c_str(), domName.c_str());
 
-	(*domain)[key] = value;
+	domain->setVal(key, value);
 
 	// TODO/FIXME: We used to erase the given key from the transient domain
 	// here. Do we still want to do that?
@@ -573,7 +723,7 @@ void ConfigManager::setBool(const String &key, bool value, const String &domName
 
 
 void ConfigManager::registerDefault(const String &key, const String &value) {
-	_defaultsDomain[key] = value;
+	_defaultsDomain.setVal(key, value);
 }
 
 void ConfigManager::registerDefault(const String &key, const char *value) {
@@ -631,12 +781,14 @@ void ConfigManager::removeGameDomain(const String &domName) {
 		_activeDomain = 0;
 	}
 	_gameDomains.erase(domName);
+	_layoutChanged = true;
 }
 
 void ConfigManager::removeMiscDomain(const String &domName) {
 	assert(!domName.empty());
 	assert(isValidDomainName(domName));
 	_miscDomains.erase(domName);
+	_layoutChanged = true;
 }
 
 
@@ -672,6 +824,7 @@ void ConfigManager::renameDomain(const String &oldName, const String &newName, D
 		newDom[iter->_key] = iter->_value;
 
 	map.erase(oldName);
+	_layoutChanged = true;
 }
 
 bool ConfigManager::hasGameDomain(const String &domName) const {
@@ -687,6 +840,7 @@ bool ConfigManager::hasMiscDomain(const String &domName) const {
 #pragma mark -
 
 void ConfigManager::Domain::setDomainComment(const String &comment) {
+	_modified = true;
 	_domainComment = comment;
 }
 const String &ConfigManager::Domain::getDomainComment() const {
@@ -694,6 +848,7 @@ const String &ConfigManager::Domain::getDomainComment() const {
 }
 
 void ConfigManager::Domain::setKVComment(const String &key, const String &comment) {
+	invalidate();
 	_keyValueComments[key] = comment;
 }
 const String &ConfigManager::Domain::getKVComment(const String &key) const {
@@ -703,4 +858,52 @@ bool ConfigManager::Domain::hasKVComment(const String &key) const {
 	return _keyValueComments.contains(key);
 }
 
+String &ConfigManager::Domain::expose(const String &key, String &value) {
+	// Only the first value handed out since the last check counts. Nothing
+	// needs to be remembered if the domain is rewritten anyway.
+	if ((!_modified || _bodyValid) && !_exposedValues.contains(key))
+		_exposedValues[key] = value;
+	return value;
+}
+
+void ConfigManager::Domain::checkExposed() const {
+	for (StringMap::const_iterator x = _exposedValues.begin(); x != _exposedValues.end(); ++x) {
+		// Erased values already invalidated the domain
+		if (_entries.contains(x->_key) && _entries[x->_key] != x->_value) {
+			_bodyValid = false;
+			_modified = true;
+			break;
+		}
+	}
+	_exposedValues.clear();
+}
+
+bool ConfigManager::Domain::isModified() const {
+	checkExposed();
+	return _modified;
+}
+
+const String &ConfigManager::Domain::getSerializedBody() const {
+	checkExposed();
+	if (_bodyValid)
+		return _body;
+
+	_body.clear();
+	for (const_iterator x = begin(); x != end(); ++x) {
+		if (!x->_value.empty()) {
+			// Write comment (if any)
+			if (hasKVComment(x->_key))
+				_body += getKVComment(x->_key);
+			// Write the key/value pair
+			_body += x->_key;
+			_body += '=';
+			_body += x->_value;
+			_body += '\n';
+		}
+	}
+
+	_bodyValid = true;
+	return _body;
+}
+
 } // End of namespace Common
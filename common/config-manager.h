@@ -52,7 +52,31 @@ public:
 		StringMap _keyValueComments;
 		String _domainComment;
 
+		/**
+		 * The serialized key/value lines of this domain, as written by
+		 * flushToDisk(). Kept until the domain is modified, so that
+		 * flushing only has to re-serialize the domains which changed.
+		 */
+		mutable String _body;
+		mutable bool _bodyValid;
+
+		/** Whether the domain changed since it was last loaded or written. */
+		mutable bool _modified;
+
+		/**
+		 * The values non-const references were handed out for since the
+		 * domain was last checked, as they were back then. Comparing them
+		 * finds out whether they were written to.
+		 */
+		mutable StringMap _exposedValues;
+
+		void invalidate() { _bodyValid = false; _modified = true; }
+		String &expose(const String &key, String &value);
+		void checkExposed() const;
+
 	public:
+		Domain() : _bodyValid(false), _modified(false) {}
+
 		typedef StringMap::const_iterator const_iterator;
 		const_iterator begin() const { return _entries.begin(); }
 		const_iterator end()   const { return _entries.end(); }
@@ -61,17 +85,28 @@ public:
 
 		bool contains(const String &key) const { return _entries.contains(key); }
 
-		String &operator[](const String &key) { return _entries[key]; }
+		String &operator[](const String &key) { return expose(key, _entries[key]); }
 		const String &operator[](const String &key) const { return _entries[key]; }
 
-		void setVal(const String &key, const String &value) { _entries.setVal(key, value); }
+		void setVal(const String &key, const String &value) {
+			String &entry = _entries[key];
+			if (entry != value) {
+				invalidate();
+				entry = value;
+			}
+		}
 
-		String &getVal(const String &key) { return _entries.getVal(key); }
+		String &getVal(const String &key) { return expose(key, _entries.getVal(key)); }
 		const String &getVal(const String &key) const { return _entries.getVal(key); }
 
-		void clear() { _entries.clear(); }
+		void clear() { invalidate(); _entries.clear(); _keyValueComments.clear(); }
 
-		void erase(const String &key) { _entries.erase(key); }
+		void erase(const String &key) {
+			if (_entries.contains(key)) {
+				invalidate();
+				_entries.erase(key);
+			}
+		}
 
 		void setDomainComment(const String &comment);
 		const String &getDomainComment() const;
@@ -79,6 +114,21 @@ public:
 		void setKVComment(const String &key, const String &comment);
 		const String &getKVComment(const String &key) const;
 		bool hasKVComment(const String &key) const;
+
+		/**
+		 * Return the key/value lines of this domain in config file syntax.
+		 * The result is cached until the domain is modified next.
+		 */
+		const String &getSerializedBody() const;
+
+		/**
+		 * Return whether the domain changed since it was last loaded or
+		 * written. Values only read through non-const access don't count.
+		 */
+		bool isModified() const;
+
+		/** Mark the domain as unchanged, once it was loaded or written. */
+		void markSaved() const { _modified = false; _exposedValues.clear(); }
 	};
 
 	typedef HashMap<String, Domain, IgnoreCase_Hash, IgnoreCase_EqualTo> DomainMap;
@@ -144,7 +194,49 @@ public:
 	void				registerDefault(const String &key, int value);
 	void				registerDefault(const String &key, bool value);
 
-	void				flushToDisk();
+	/**
+	 * Write the configuration to disk, if it changed since the last write.
+	 *
+	 * Writes are debounced: if the last write happened less than the flush
+	 * delay ago, the write is deferred until processPendingFlush() is called
+	 * after the delay has expired. This keeps bursts of changes (like the
+	 * options dialog applying one setting after another) from rewriting the
+	 * whole file each time. Deferred writes are also performed by error()
+	 * and by the SDL backend when quitting.
+	 *
+	 * Note that each write still rewrites the whole file. Only the domains
+	 * which changed are serialized anew.
+	 *
+	 * @param immediate	write now, even if the last write was only recently
+	 */
+	void				flushToDisk(bool immediate = false);
+
+	/**
+	 * Perform a write deferred by flushToDisk(), once the flush delay has
+	 * expired. This is called regularly by the event manager.
+	 */
+	void				processPendingFlush();
+
+	/** Return whether a deferred write is waiting to be performed. */
+	bool				hasPendingFlush() const { return _flushPending; }
+
+	/**
+	 * Set the minimum time in milliseconds between two writes of the config
+	 * file. A delay of 0 disables debouncing.
+	 */
+	void				setFlushDelay(uint32 delay) { _flushDelay = delay; }
+
+	/** Return whether the configuration changed since it was last loaded or written. */
+	bool				isDirty() const;
+
+	/**
+	 * Replace the current configuration with the one read from the given
+	 * stream. The stream is read in one go and parsed in place.
+	 */
+	void				loadFromStream(SeekableReadStream &stream);
+
+	/** Write the configuration in config file syntax to the given stream. */
+	void				saveToStream(WriteStream &stream);
 
 	void				setActiveDomain(const String &domName);
 	Domain *			getActiveDomain() { return _activeDomain; }
@@ -173,8 +265,9 @@ private:
 	friend class Singleton<SingletonBaseType>;
 	ConfigManager();
 
-	void			loadFromStream(SeekableReadStream &stream);
 	void			addDomain(const String &domainName, const Domain &domain);
+	Domain *		beginLoadedDomain(const String &domainName, Domain &scratch);
+	void			endLoadedDomain(const String &domainName, Domain *domain, Domain &scratch);
 	void			writeDomain(WriteStream &stream, const String &name, const Domain &domain);
 	void			renameDomain(const String &oldName, const String &newName, DomainMap &map);
 
@@ -194,6 +287,14 @@ private:
 	Domain *		_activeDomain;
 
 	String			_filename;
+
+	bool			_layoutChanged;		///< Domains were added, removed or replaced since the last load or write
+	bool			_flushPending;
+	uint32			_flushDelay;
+	uint32			_lastFlushTime;
+
+	void			writeToDisk();
+	void			markClean();
 };
 
 } // End of namespace Common
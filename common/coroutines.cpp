@@ -25,6 +25,8 @@
 #include "common/debug.h"
 #include "common/hashmap.h"
 #include "common/hash-str.h"
+#include "common/list.h"
+#include "common/memorypool.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 
@@ -35,6 +37,32 @@ CoroContext nullContext = NULL;
 
 DECLARE_SINGLETON(CoroutineScheduler);
 
+namespace {
+/** Pool the coroutine contexts are allocated from */
+SizeClassPool *s_contextPool = 0;
+
+/** Number of allocated coroutine contexts */
+uint s_contextCount = 0;
+
+/** Whether to free the pool once the last context is gone */
+bool s_freeContextPool = false;
+
+/**
+ * Free the context pool, or, if contexts are still alive, e.g. held by an
+ * engine outside of the scheduler, do so once the last one is deleted.
+ */
+void freeContextPool() {
+	if (s_contextCount > 0) {
+		s_freeContextPool = true;
+		return;
+	}
+
+	delete s_contextPool;
+	s_contextPool = 0;
+	s_freeContextPool = false;
+}
+} // End of anonymous namespace
+
 #ifdef COROUTINE_DEBUG
 namespace {
 /** Count of active coroutines */
@@ -92,6 +120,27 @@ CoroBaseContext::~CoroBaseContext() {
 	delete _subctx;
 }
 
+void *CoroBaseContext::operator new(size_t size) {
+	if (!s_contextPool)
+		s_contextPool = new SizeClassPool();
+
+	s_freeContextPool = false;
+	s_contextCount++;
+	return s_contextPool->allocate(size);
+}
+
+void CoroBaseContext::operator delete(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	assert(s_contextPool && s_contextCount > 0);
+	s_contextCount--;
+	s_contextPool->deallocate(ptr, size);
+
+	if (s_freeContextPool)
+		freeContextPool();
+}
+
 //--------------------- Scheduler Class ------------------------
 
 CoroutineScheduler::CoroutineScheduler() {
@@ -99,11 +148,12 @@ CoroutineScheduler::CoroutineScheduler() {
 	pFreeProcesses = NULL;
 	pCurrent = NULL;
 
-#ifdef DEBUG
 	// diagnostic process counters
 	numProcs = 0;
 	maxProcs = 0;
-#endif
+
+	_dispatches = _lastDispatches = 0;
+	_wakeups = _lastWakeups = 0;
 
 	pRCfunction = NULL;
 	pidCounter = 0;
@@ -131,16 +181,16 @@ CoroutineScheduler::~CoroutineScheduler() {
 	active = 0;
 
 	// Clear the event list
-	Common::List<EVENT *>::iterator i;
+	Common::HashMap<uint32, EVENT *>::iterator i;
 	for (i = _events.begin(); i != _events.end(); ++i)
-		delete *i;
+		delete i->_value;
+
+	freeContextPool();
 }
 
 void CoroutineScheduler::reset() {
-#ifdef DEBUG
 	// clear number of process in use
 	numProcs = 0;
-#endif
 
 	if (processList == NULL) {
 		// first time - allocate memory for process list
@@ -161,11 +211,14 @@ void CoroutineScheduler::reset() {
 		delete pProc->state;
 		pProc->state = 0;
 		Common::fill(&pProc->pidWaiting[0], &pProc->pidWaiting[CORO_MAX_PID_WAITING], 0);
+		pProc->blocked = false;
 		pProc = pProc->pNext;
 	}
 
 	// no active processes
 	pCurrent = active->pNext = NULL;
+	_processes.clear();
+	_waitLists.clear();
 
 	// place first process on free list
 	pFreeProcesses = processList;
@@ -184,6 +237,37 @@ void CoroutineScheduler::printStats() {
 }
 #endif
 
+String CoroutineStats::toString() const {
+	return String::format("Processes: %u live (%u blocked), %u max\n"
+	                      "Contexts: %u live, %u bytes (%u max)\n"
+	                      "Last frame: %u processes run, %u woken up\n",
+	                      liveProcesses, blockedProcesses, maxProcesses,
+	                      liveContexts, (uint)contextBytes, (uint)maxContextBytes,
+	                      dispatches, wakeups);
+}
+
+CoroutineStats CoroutineScheduler::getStats() const {
+	CoroutineStats stats;
+
+	stats.liveProcesses = numProcs;
+	stats.maxProcesses = maxProcs;
+
+	stats.blockedProcesses = 0;
+	for (PROCESS *pProc = active->pNext; pProc != NULL; pProc = pProc->pNext) {
+		if (pProc->blocked)
+			stats.blockedProcesses++;
+	}
+
+	stats.liveContexts = s_contextCount;
+	stats.contextBytes = s_contextPool ? s_contextPool->getBytesInUse() : 0;
+	stats.maxContextBytes = s_contextPool ? s_contextPool->getHighWaterMark() : 0;
+
+	stats.dispatches = _lastDispatches;
+	stats.wakeups = _lastWakeups;
+
+	return stats;
+}
+
 #ifdef DEBUG
 void CoroutineScheduler::checkStack() {
 	Common::List<PROCESS *> pList;
@@ -223,12 +307,32 @@ void CoroutineScheduler::schedule() {
 	// start dispatching active process list
 	PROCESS *pNext;
 	PROCESS *pProc = active->pNext;
+	uint32 now = 0;
 	while (pProc != NULL) {
 		pNext = pProc->pNext;
 
+		if (pProc->blocked) {
+			// Blocked processes only need to be looked at if they wait with a timeout
+			if (pProc->wakeTime == CORO_INFINITE) {
+				pProc = pNext;
+				continue;
+			}
+
+			if (!now)
+				now = g_system->getMillis();
+			if (now < pProc->wakeTime) {
+				pProc = pNext;
+				continue;
+			}
+
+			pProc->blocked = false;
+			_wakeups++;
+		}
+
 		if (--pProc->sleepTime <= 0) {
 			// process is ready for dispatch, activate it
 			pCurrent = pProc;
+			_dispatches++;
 			pProc->coroAddr(pProc->state, pProc->param);
 
 			if (!pProc->state || pProc->state->_sleep <= 0) {
@@ -248,13 +352,17 @@ void CoroutineScheduler::schedule() {
 	}
 
 	// Disable any events that were pulsed
-	Common::List<EVENT *>::iterator i;
-	for (i = _events.begin(); i != _events.end(); ++i) {
-		EVENT *evt = *i;
-		if (evt->pulsing) {
+	for (uint i = 0; i < _pulsedEvents.size(); ++i) {
+		EVENT *evt = getEvent(_pulsedEvents[i]);
+		if (evt && evt->pulsing) {
 			evt->pulsing = evt->signalled = false;
 		}
 	}
+	_pulsedEvents.clear();
+
+	_lastDispatches = _dispatches;
+	_lastWakeups = _wakeups;
+	_dispatches = _wakeups = 0;
 }
 
 void CoroutineScheduler::rescheduleAll() {
@@ -355,7 +463,7 @@ void CoroutineScheduler::waitForSingleObject(CORO_PARAM, int pid, uint32 duratio
 	CORO_BEGIN_CODE(_ctx);
 
 	// Signal the process Id this process is now waiting for
-	pCurrent->pidWaiting[0] = pid;
+	beginWait(pCurrent, pid);
 
 	_ctx->endTime = (duration == CORO_INFINITE) ? CORO_INFINITE : g_system->getMillis() + duration;
 	if (expired)
@@ -363,7 +471,7 @@ void CoroutineScheduler::waitForSingleObject(CORO_PARAM, int pid, uint32 duratio
 		*expired = true;
 
 	// Outer loop for doing checks until expiry
-	while (g_system->getMillis() <= _ctx->endTime) {
+	while (_ctx->endTime == CORO_INFINITE || g_system->getMillis() <= _ctx->endTime) {
 		// Check to see if a process or event with the given Id exists
 		_ctx->pProcess = getProcess(pid);
 		_ctx->pEvent = !_ctx->pProcess ? getEvent(pid) : NULL;
@@ -388,12 +496,13 @@ void CoroutineScheduler::waitForSingleObject(CORO_PARAM, int pid, uint32 duratio
 			break;
 		}
 
-		// Sleep until the next cycle
+		// Sleep until the process finishes or the event changes
+		blockProcess(pCurrent, (_ctx->endTime == CORO_INFINITE) ? CORO_INFINITE : _ctx->endTime + 1);
 		CORO_SLEEP(1);
 	}
 
 	// Signal waiting is done
-	Common::fill(&pCurrent->pidWaiting[0], &pCurrent->pidWaiting[CORO_MAX_PID_WAITING], 0);
+	endWait(pCurrent);
 
 	CORO_END_CODE;
 }
@@ -416,7 +525,7 @@ void CoroutineScheduler::waitForMultipleObjects(CORO_PARAM, int nCount, uint32 *
 
 	// Signal the waiting events
 	assert(nCount < CORO_MAX_PID_WAITING);
-	Common::copy(pidList, pidList + nCount, pCurrent->pidWaiting);
+	beginWait(pCurrent, nCount, pidList);
 
 	_ctx->endTime = (duration == CORO_INFINITE) ? CORO_INFINITE : g_system->getMillis() + duration;
 	if (expired)
@@ -424,7 +533,7 @@ void CoroutineScheduler::waitForMultipleObjects(CORO_PARAM, int nCount, uint32 *
 		*expired = true;
 
 	// Outer loop for doing checks until expiry
-	while (g_system->getMillis() <= _ctx->endTime) {
+	while (_ctx->endTime == CORO_INFINITE || g_system->getMillis() <= _ctx->endTime) {
 		_ctx->signalled = bWaitAll;
 
 		for (_ctx->i = 0; _ctx->i < nCount; ++_ctx->i) {
@@ -446,7 +555,8 @@ void CoroutineScheduler::waitForMultipleObjects(CORO_PARAM, int nCount, uint32 *
 			for (_ctx->i = 0; _ctx->i < nCount; ++_ctx->i) {
 				_ctx->pEvent = getEvent(pidList[_ctx->i]);
 
-				if (!_ctx->pEvent->manualReset)
+				// Finished processes have no event to reset
+				if (_ctx->pEvent && !_ctx->pEvent->manualReset)
 					_ctx->pEvent->signalled = false;
 			}
 
@@ -455,12 +565,13 @@ void CoroutineScheduler::waitForMultipleObjects(CORO_PARAM, int nCount, uint32 *
 			break;
 		}
 
-		// Sleep until the next cycle
+		// Sleep until one of the processes finishes or events changes
+		blockProcess(pCurrent, (_ctx->endTime == CORO_INFINITE) ? CORO_INFINITE : _ctx->endTime + 1);
 		CORO_SLEEP(1);
 	}
 
 	// Signal waiting is done
-	Common::fill(&pCurrent->pidWaiting[0], &pCurrent->pidWaiting[CORO_MAX_PID_WAITING], 0);
+	endWait(pCurrent);
 
 	CORO_END_CODE;
 }
@@ -481,7 +592,8 @@ void CoroutineScheduler::sleep(CORO_PARAM, uint32 duration) {
 
 	// Outer loop for doing checks until expiry
 	while (g_system->getMillis() < _ctx->endTime) {
-		// Sleep until the next cycle
+		// Sleep until the time is reached
+		blockProcess(pCurrent, _ctx->endTime);
 		CORO_SLEEP(1);
 	}
 
@@ -497,11 +609,9 @@ PROCESS *CoroutineScheduler::createProcess(uint32 pid, CORO_ADDR coroAddr, const
 	// trap no free process
 	assert(pProc != NULL); // Out of processes
 
-#ifdef DEBUG
 	// one more process in use
 	if (++numProcs > maxProcs)
 		maxProcs = numProcs;
-#endif
 
 	// get link to next free process
 	pFreeProcesses = pProc->pNext;
@@ -539,6 +649,12 @@ PROCESS *CoroutineScheduler::createProcess(uint32 pid, CORO_ADDR coroAddr, const
 
 	// set new process id
 	pProc->pid = pid;
+	addProcessPid(pProc);
+
+	// not waiting for anything
+	Common::fill(&pProc->pidWaiting[0], &pProc->pidWaiting[CORO_MAX_PID_WAITING], 0);
+	pProc->blocked = false;
+	pProc->wakeTime = CORO_INFINITE;
 
 	// set new process specific info
 	if (sizeParam) {
@@ -568,18 +684,12 @@ void CoroutineScheduler::killProcess(PROCESS *pKillProc) {
 	// can not kill the current process using killProcess !
 	assert(pCurrent != pKillProc);
 
-#ifdef DEBUG
 	// one less process in use
 	--numProcs;
 	assert(numProcs >= 0);
-#endif
 
 	// Free process' resources
-	if (pRCfunction != NULL)
-		(pRCfunction)(pKillProc);
-
-	delete pKillProc->state;
-	pKillProc->state = 0;
+	releaseProcess(pKillProc);
 
 	// Take the process out of the active chain list
 	pKillProc->pPrevious->pNext = pKillProc->pNext;
@@ -624,11 +734,7 @@ int CoroutineScheduler::killMatchingProcess(uint32 pidKill, int pidMask) {
 				numKilled++;
 
 				// Free the process' resources
-				if (pRCfunction != NULL)
-					(pRCfunction)(pProc);
-
-				delete pProc->state;
-				pProc->state = 0;
+				releaseProcess(pProc);
 
 				// make prev point to next to unlink pProc
 				pPrev->pNext = pProc->pNext;
@@ -649,11 +755,9 @@ int CoroutineScheduler::killMatchingProcess(uint32 pidKill, int pidMask) {
 		}
 	}
 
-#ifdef DEBUG
 	// adjust process in use
 	numProcs -= numKilled;
 	assert(numProcs >= 0);
-#endif
 
 	// return number of processes killed
 	return numKilled;
@@ -664,22 +768,107 @@ void CoroutineScheduler::setResourceCallback(VFPTRPP pFunc) {
 }
 
 PROCESS *CoroutineScheduler::getProcess(uint32 pid) {
-	PROCESS *pProc = active->pNext;
-	while ((pProc != NULL) && (pProc->pid != pid))
-		pProc = pProc->pNext;
-
-	return pProc;
+	return _processes.getVal(pid, NULL);
 }
 
 EVENT *CoroutineScheduler::getEvent(uint32 pid) {
-	Common::List<EVENT *>::iterator i;
-	for (i = _events.begin(); i != _events.end(); ++i) {
-		EVENT *evt = *i;
-		if (evt->pid == pid)
-			return evt;
+	return _events.getVal(pid, NULL);
+}
+
+void CoroutineScheduler::addProcessPid(PROCESS *pProc) {
+	PROCESS *&pFirst = _processes[pProc->pid];
+	pProc->pNextPid = pFirst;
+	pFirst = pProc;
+}
+
+void CoroutineScheduler::removeProcessPid(PROCESS *pProc) {
+	Common::HashMap<uint32, PROCESS *>::iterator i = _processes.find(pProc->pid);
+	assert(i != _processes.end());
+
+	if (i->_value == pProc) {
+		if (pProc->pNextPid)
+			i->_value = pProc->pNextPid;
+		else
+			_processes.erase(i);
+		return;
 	}
 
-	return NULL;
+	PROCESS *pPrev = i->_value;
+	while (pPrev->pNextPid != pProc) {
+		assert(pPrev->pNextPid);
+		pPrev = pPrev->pNextPid;
+	}
+	pPrev->pNextPid = pProc->pNextPid;
+}
+
+void CoroutineScheduler::releaseProcess(PROCESS *pProc) {
+	if (pRCfunction != NULL)
+		(pRCfunction)(pProc);
+
+	delete pProc->state;
+	pProc->state = 0;
+
+	// Take the process off the wait lists it is on
+	endWait(pProc);
+
+	removeProcessPid(pProc);
+
+	// Processes waiting for this one to finish can continue
+	wakeWaiting(pProc->pid);
+}
+
+void CoroutineScheduler::beginWait(PROCESS *pProc, uint32 pid) {
+	beginWait(pProc, 1, &pid);
+}
+
+void CoroutineScheduler::beginWait(PROCESS *pProc, int nCount, const uint32 *pidList) {
+	assert(nCount <= CORO_MAX_PID_WAITING);
+
+	for (int i = 0; i < nCount; ++i) {
+		pProc->pidWaiting[i] = pidList[i];
+		_waitLists[pidList[i]].push_back(pProc);
+	}
+}
+
+void CoroutineScheduler::endWait(PROCESS *pProc) {
+	for (int i = 0; i < CORO_MAX_PID_WAITING && pProc->pidWaiting[i]; ++i) {
+		WaitListMap::iterator list = _waitLists.find(pProc->pidWaiting[i]);
+		if (list == _waitLists.end())
+			continue;
+
+		Common::Array<PROCESS *> &waiting = list->_value;
+		for (uint j = 0; j < waiting.size(); ++j) {
+			if (waiting[j] == pProc) {
+				waiting.remove_at(j);
+				break;
+			}
+		}
+
+		if (waiting.empty())
+			_waitLists.erase(list);
+	}
+
+	Common::fill(&pProc->pidWaiting[0], &pProc->pidWaiting[CORO_MAX_PID_WAITING], 0);
+	pProc->blocked = false;
+}
+
+void CoroutineScheduler::blockProcess(PROCESS *pProc, uint32 wakeTime) {
+	pProc->blocked = true;
+	pProc->wakeTime = wakeTime;
+}
+
+void CoroutineScheduler::wakeWaiting(uint32 pid) {
+	WaitListMap::iterator list = _waitLists.find(pid);
+	if (list == _waitLists.end())
+		return;
+
+	Common::Array<PROCESS *> &waiting = list->_value;
+	for (uint i = 0; i < waiting.size(); ++i) {
+		if (waiting[i]->blocked) {
+			waiting[i]->blocked = false;
+			_wakeups++;
+		}
+	}
 }
 
 
@@ -690,22 +879,27 @@ uint32 CoroutineScheduler::createEvent(bool bManualReset, bool bInitialState) {
 	evt->signalled = bInitialState;
 	evt->pulsing = false;
 
-	_events.push_back(evt);
+	_events[evt->pid] = evt;
 	return evt->pid;
 }
 
 void CoroutineScheduler::closeEvent(uint32 pidEvent) {
 	EVENT *evt = getEvent(pidEvent);
 	if (evt) {
-		_events.remove(evt);
+		_events.erase(pidEvent);
 		delete evt;
+
+		// Waiting for a non-existent event is over
+		wakeWaiting(pidEvent);
 	}
 }
 
 void CoroutineScheduler::setEvent(uint32 pidEvent) {
 	EVENT *evt = getEvent(pidEvent);
-	if (evt)
+	if (evt) {
 		evt->signalled = true;
+		wakeWaiting(pidEvent);
+	}
 }
 
 void CoroutineScheduler::resetEvent(uint32 pidEvent) {
@@ -722,6 +916,8 @@ void CoroutineScheduler::pulseEvent(uint32 pidEvent) {
 	// Set the event as signalled and pulsing
 	evt->signalled = true;
 	evt->pulsing = true;
+	_pulsedEvents.push_back(pidEvent);
+	wakeWaiting(pidEvent);
 
 	// If there's an active process, and it's not the first in the queue, then reschedule all
 	// the other prcoesses in the queue to run again this frame
@@ -25,8 +25,10 @@
 
 #include "common/scummsys.h"
 #include "common/util.h"    // for SCUMMVM_CURRENT_FUNCTION
-#include "common/list.h"
+#include "common/array.h"
+#include "common/hashmap.h"
 #include "common/singleton.h"
+#include "common/str.h"
 
 namespace Common {
 
@@ -66,6 +68,13 @@ struct CoroBaseContext {
 	 * Destructor for coroutine context
 	 */
 	virtual ~CoroBaseContext();
+
+	/**
+	 * Contexts are allocated from a pool, since they are created and
+	 * destroyed all the time.
+	 */
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
 };
 
 typedef CoroBaseContext *CoroContext;
@@ -305,9 +314,13 @@ struct PROCESS {
 	CoroContext state;      ///< the state of the coroutine
 	CORO_ADDR  coroAddr;    ///< the entry point of the coroutine
 
+	PROCESS *pNextPid;  ///< next active process with the same process ID
+
 	int sleepTime;      ///< number of scheduler cycles to sleep
 	uint32 pid;         ///< process ID
 	uint32 pidWaiting[CORO_MAX_PID_WAITING];    ///< Process ID(s) process is currently waiting on
+	bool blocked;       ///< process is not run until one of pidWaiting changes or wakeTime is reached
+	uint32 wakeTime;    ///< time in milliseconds a blocked process is woken up at
 	char param[CORO_PARAM_SIZE];    ///< process specific info
 };
 typedef PROCESS *PPROCESS;
@@ -322,8 +335,27 @@ struct EVENT {
 };
 
 
+/** Statistics of the coroutine scheduler, e.g. for display in the debugger. */
+struct CoroutineStats {
+	uint liveProcesses;     ///< number of processes currently running
+	uint maxProcesses;      ///< maximum number of processes running at once
+	uint blockedProcesses;  ///< number of processes waiting for a process or event
+	uint liveContexts;      ///< number of allocated coroutine contexts
+	size_t contextBytes;    ///< memory used by the coroutine contexts
+	size_t maxContextBytes; ///< maximum memory ever used by the coroutine contexts
+	uint dispatches;        ///< number of processes run during the last schedule() call
+	uint wakeups;           ///< number of processes woken up during the last schedule() call
+
+	/** Describe the statistics in a few lines, e.g. for a debugger command. */
+	String toString() const;
+};
+
 /**
  * Creates and manages "processes" (really coroutines).
+ *
+ * Processes waiting for another process or an event are not polled every
+ * cycle. Instead, they are put on the wait list of that process/event ID,
+ * and only run again once the process finishes or the event changes.
  */
 class CoroutineScheduler : public Singleton<CoroutineScheduler> {
 public:
@@ -359,14 +391,28 @@ private:
 	/** Auto-incrementing process Id */
 	int pidCounter;
 
-	/** Event list */
-	Common::List<EVENT *> _events;
+	/** Events by ID */
+	Common::HashMap<uint32, EVENT *> _events;
+
+	/** IDs of the events pulsed during the current cycle */
+	Common::Array<uint32> _pulsedEvents;
+
+	/** First active process of each process ID, further ones are chained by pNextPid */
+	Common::HashMap<uint32, PROCESS *> _processes;
+
+	typedef Common::HashMap<uint32, Common::Array<PROCESS *> > WaitListMap;
+
+	/** Processes waiting on each process/event ID */
+	WaitListMap _waitLists;
 
-#ifdef DEBUG
 	// diagnostic process counters
 	int numProcs;
 	int maxProcs;
 
+	uint _dispatches, _lastDispatches;
+	uint _wakeups, _lastWakeups;
+
+#ifdef DEBUG
 	/**
 	 * Checks both the active and free process list to insure all the links are valid,
 	 * and that no processes have been lost
@@ -382,6 +428,31 @@ private:
 
 	PROCESS *getProcess(uint32 pid);
 	EVENT *getEvent(uint32 pid);
+
+	void addProcessPid(PROCESS *pProc);
+	void removeProcessPid(PROCESS *pProc);
+
+	/**
+	 * Frees the state and resources of a process which is about to be put
+	 * back on the free list, and wakes up the processes waiting for it.
+	 */
+	void releaseProcess(PROCESS *pProc);
+
+	/** Puts a process on the wait lists of the given IDs. */
+	void beginWait(PROCESS *pProc, uint32 pid);
+	void beginWait(PROCESS *pProc, int nCount, const uint32 *pidList);
+
+	/** Takes a process off all wait lists. */
+	void endWait(PROCESS *pProc);
+
+	/**
+	 * Stops running a process until one of the IDs it is waiting for
+	 * changes, or the given time is reached.
+	 */
+	void blockProcess(PROCESS *pProc, uint32 wakeTime);
+
+	/** Wakes up all processes waiting for the given ID. */
+	void wakeWaiting(uint32 pid);
 public:
 	/**
 	 * Kills all processes and places them on the free list.
@@ -395,6 +466,11 @@ public:
 	void printStats();
 #endif
 
+	/**
+	 * Returns the current scheduler statistics.
+	 */
+	CoroutineStats getStats() const;
+
 	/**
 	 * Give all active processes a chance to run
 	 */
@@ -206,6 +206,21 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieves the size and the time of the last modification of the file
+	 * referred by this node, without opening it. This is cheaper than
+	 * opening the file to query its size, and can be used to check whether
+	 * a file changed since it was last looked at.
+	 *
+	 * @note The modification time is only meant to be compared against
+	 *       earlier values for the same file; its unit and epoch depend on
+	 *       the backend.
+	 *
+	 * @return true if both values could be determined, false otherwise
+	 *         (e.g. if the backend does not support it).
+	 */
+	bool getFileInfo(uint32 &size, uint32 &modificationTime) const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -215,6 +230,9 @@ public:
 	 */
 	virtual SeekableReadStream *createReadStream() const;
 
+	/** Each stream opens the file anew. */
+	virtual bool createsPrivateStreams() const { return true; }
+
 	/**
 	 * Creates a WriteStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
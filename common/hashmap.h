@@ -44,6 +44,7 @@
 
 
 #include "common/func.h"
+#include "common/memory.h"
 
 #ifdef DEBUG_HASH_COLLISIONS
 #include "common/debug.h"
@@ -64,6 +65,49 @@ namespace Common {
 template<class T> class IteratorImpl;
 #endif
 
+/**
+ * Storage for the nodes of a HashMap. With a custom allocator, every node
+ * is obtained from that allocator.
+ */
+template<class Node, class Alloc, size_t POOL_SIZE>
+class HashMapNodeStorage {
+public:
+	void *allocNode(Alloc &alloc) {
+		return alloc.allocate(sizeof(Node));
+	}
+
+	void freeNode(Alloc &alloc, Node *node) {
+		node->~Node();
+		alloc.deallocate(node, sizeof(Node));
+	}
+
+	void freeUnusedPages() {}
+};
+
+#ifdef USE_HASHMAP_MEMORY_POOL
+/**
+ * With the default allocator, the nodes come from a memory pool owned by
+ * the HashMap.
+ */
+template<class Node, size_t POOL_SIZE>
+class HashMapNodeStorage<Node, DefaultAllocator, POOL_SIZE> {
+private:
+	ObjectPool<Node, POOL_SIZE> _nodePool;
+
+public:
+	void *allocNode(DefaultAllocator &) {
+		return _nodePool.allocChunk();
+	}
+
+	void freeNode(DefaultAllocator &, Node *node) {
+		_nodePool.deleteChunk(node);
+	}
+
+	void freeUnusedPages() {
+		_nodePool.freeUnusedPages();
+	}
+};
+#endif
 
 /**
  * HashMap<Key,Val> maps objects of type Key to objects of type Val.
@@ -77,15 +121,18 @@ template<class T> class IteratorImpl;
  * referenced, for a new key. If the object is const, then an assertion is
  * triggered instead. Hence if you are not sure whether a key is contained in
  * the map, use contains() first to check for its presence.
+ *
+ * Both the hash table itself and the nodes are obtained through the allocator
+ * given as last template parameter (see DefaultAllocator).
  */
-template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
-class HashMap {
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key>, class Alloc = DefaultAllocator>
+class HashMap : private Alloc {
 public:
 	typedef uint size_type;
 
 private:
 
-	typedef HashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+	typedef HashMap<Key, Val, HashFunc, EqualFunc, Alloc> HM_t;
 
 	struct Node {
 		const Key _key;
@@ -109,9 +156,7 @@ private:
 		HASHMAP_MEMORYPOOL_SIZE = HASHMAP_MIN_CAPACITY * HASHMAP_LOADFACTOR_NUMERATOR / HASHMAP_LOADFACTOR_DENOMINATOR
 	};
 
-#ifdef USE_HASHMAP_MEMORY_POOL
-	ObjectPool<Node, HASHMAP_MEMORYPOOL_SIZE> _nodePool;
-#endif
+	HashMapNodeStorage<Node, Alloc, HASHMAP_MEMORYPOOL_SIZE> _nodePool;
 
 	Node **_storage;	///< hashtable of size arrsize.
 	size_type _mask;		///< Capacity of the HashMap minus one; must be a power of two of minus one
@@ -132,20 +177,25 @@ private:
 #endif
 
 	Node *allocNode(const Key &key) {
-#ifdef USE_HASHMAP_MEMORY_POOL
-		return new (_nodePool) Node(key);
-#else
-		return new Node(key);
-#endif
+		void *mem = _nodePool.allocNode(*this);
+		assert(mem != NULL);
+		return new (mem) Node(key);
 	}
 
 	void freeNode(Node *node) {
 		if (node && node != HASHMAP_DUMMY_NODE)
-#ifdef USE_HASHMAP_MEMORY_POOL
-			_nodePool.deleteChunk(node);
-#else
-			delete node;
-#endif
+			_nodePool.freeNode(*this, node);
+	}
+
+	Node **allocStorage(size_type capacity) {
+		Node **storage = (Node **)Alloc::allocate(capacity * sizeof(Node *));
+		assert(storage != NULL);
+		memset(storage, 0, capacity * sizeof(Node *));
+		return storage;
+	}
+
+	void freeStorage(Node **storage, size_type capacity) {
+		Alloc::deallocate(storage, capacity * sizeof(Node *));
 	}
 
 	void assign(const HM_t &map);
@@ -219,7 +269,11 @@ public:
 	typedef IteratorImpl<Node> iterator;
 	typedef IteratorImpl<const Node> const_iterator;
 
-	HashMap();
+	/**
+	 * Creates an empty hashmap, which obtains its memory from the given
+	 * allocator.
+	 */
+	explicit HashMap(const Alloc &alloc = Alloc());
 	HashMap(const HM_t &map);
 	~HashMap();
 
@@ -229,7 +283,7 @@ public:
 
 		// Remove the previous content and ...
 		clear();
-		delete[] _storage;
+		freeStorage(_storage, _mask + 1);
 		// ... copy the new stuff.
 		assign(map);
 		return *this;
@@ -295,6 +349,11 @@ public:
 	bool empty() const {
 		return (_size == 0);
 	}
+
+	/** Returns the allocator used by this hashmap. */
+	const Alloc &getAllocator() const {
+		return *this;
+	}
 };
 
 //-------------------------------------------------------
@@ -303,20 +362,18 @@ public:
 /**
  * Base constructor, creates an empty hashmap.
  */
-template<class Key, class Val, class HashFunc, class EqualFunc>
-HashMap<Key, Val, HashFunc, EqualFunc>::HashMap()
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::HashMap(const Alloc &alloc)
 //
 // We have to skip _defaultVal() on PS2 to avoid gcc 3.2.2 ICE
 //
 #ifdef __PLAYSTATION2__
-	{
+	: Alloc(alloc) {
 #else
-	: _defaultVal() {
+	: Alloc(alloc), _defaultVal() {
 #endif
 	_mask = HASHMAP_MIN_CAPACITY - 1;
-	_storage = new Node *[HASHMAP_MIN_CAPACITY];
-	assert(_storage != NULL);
-	memset(_storage, 0, HASHMAP_MIN_CAPACITY * sizeof(Node *));
+	_storage = allocStorage(HASHMAP_MIN_CAPACITY);
 
 	_size = 0;
 	_deleted = 0;
@@ -333,9 +390,9 @@ HashMap<Key, Val, HashFunc, EqualFunc>::HashMap()
  * We must provide a custom copy constructor as we use pointers
  * to heap buffers for the internal storage.
  */
-template<class Key, class Val, class HashFunc, class EqualFunc>
-HashMap<Key, Val, HashFunc, EqualFunc>::HashMap(const HM_t &map) :
-	_defaultVal() {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::HashMap(const HM_t &map) :
+	Alloc(map), _defaultVal() {
 #ifdef DEBUG_HASH_COLLISIONS
 	_collisions = 0;
 	_lookups = 0;
@@ -347,12 +404,12 @@ HashMap<Key, Val, HashFunc, EqualFunc>::HashMap(const HM_t &map) :
 /**
  * Destructor, frees all used memory.
  */
-template<class Key, class Val, class HashFunc, class EqualFunc>
-HashMap<Key, Val, HashFunc, EqualFunc>::~HashMap() {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::~HashMap() {
 	for (size_type ctr = 0; ctr <= _mask; ++ctr)
 	  freeNode(_storage[ctr]);
 
-	delete[] _storage;
+	freeStorage(_storage, _mask + 1);
 #ifdef DEBUG_HASH_COLLISIONS
 	extern void updateHashCollisionStats(int, int, int, int, int);
 	updateHashCollisionStats(_collisions, _dummyHits, _lookups, _mask+1, _size);
@@ -366,12 +423,10 @@ HashMap<Key, Val, HashFunc, EqualFunc>::~HashMap() {
  * @note We do *not* deallocate the previous storage here -- the caller is
  *       responsible for doing that!
  */
-template<class Key, class Val, class HashFunc, class EqualFunc>
-void HashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+void HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::assign(const HM_t &map) {
 	_mask = map._mask;
-	_storage = new Node *[_mask+1];
-	assert(_storage != NULL);
-	memset(_storage, 0, (_mask+1) * sizeof(Node *));
+	_storage = allocStorage(_mask + 1);
 
 	// Simply clone the map given to us, one by one.
 	_size = 0;
@@ -392,32 +447,28 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
 }
 
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-void HashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+void HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::clear(bool shrinkArray) {
 	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
 		freeNode(_storage[ctr]);
 		_storage[ctr] = NULL;
 	}
 
-#ifdef USE_HASHMAP_MEMORY_POOL
 	_nodePool.freeUnusedPages();
-#endif
 
 	if (shrinkArray && _mask >= HASHMAP_MIN_CAPACITY) {
-		delete[] _storage;
+		freeStorage(_storage, _mask + 1);
 
-		_mask = HASHMAP_MIN_CAPACITY;
-		_storage = new Node *[HASHMAP_MIN_CAPACITY];
-		assert(_storage != NULL);
-		memset(_storage, 0, HASHMAP_MIN_CAPACITY * sizeof(Node *));
+		_mask = HASHMAP_MIN_CAPACITY - 1;
+		_storage = allocStorage(HASHMAP_MIN_CAPACITY);
 	}
 
 	_size = 0;
 	_deleted = 0;
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-void HashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+void HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::expandStorage(size_type newCapacity) {
 	assert(newCapacity > _mask+1);
 
 #ifndef NDEBUG
@@ -430,9 +481,7 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity
 	_size = 0;
 	_deleted = 0;
 	_mask = newCapacity - 1;
-	_storage = new Node *[newCapacity];
-	assert(_storage != NULL);
-	memset(_storage, 0, newCapacity * sizeof(Node *));
+	_storage = allocStorage(newCapacity);
 
 	// rehash all the old elements
 	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
@@ -457,13 +506,13 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::expandStorage(size_type newCapacity
 	// This check will fail if some previous operation corrupted this hashmap.
 	assert(_size == old_size);
 
-	delete[] old_storage;
+	freeStorage(old_storage, old_mask + 1);
 
 	return;
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+typename HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::size_type HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::lookup(const Key &key) const {
 	const size_type hash = _hash(key);
 	size_type ctr = hash & _mask;
 	for (size_type perturb = hash; ; perturb >>= HASHMAP_PERTURB_SHIFT) {
@@ -493,8 +542,8 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 	return ctr;
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+typename HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::size_type HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::lookupAndCreateIfMissing(const Key &key) {
 	const size_type hash = _hash(key);
 	size_type ctr = hash & _mask;
 	const size_type NONE_FOUND = _mask + 1;
@@ -554,36 +603,36 @@ typename HashMap<Key, Val, HashFunc, EqualFunc>::size_type HashMap<Key, Val, Has
 }
 
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-bool HashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+bool HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::contains(const Key &key) const {
 	size_type ctr = lookup(key);
 	return (_storage[ctr] != NULL);
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-Val &HashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+Val &HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::operator[](const Key &key) {
 	return getVal(key);
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-const Val &HashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+const Val &HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::operator[](const Key &key) const {
 	return getVal(key);
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+Val &HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::getVal(const Key &key) {
 	size_type ctr = lookupAndCreateIfMissing(key);
 	assert(_storage[ctr] != NULL);
 	return _storage[ctr]->_value;
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-const Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+const Val &HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::getVal(const Key &key) const {
 	return getVal(key, _defaultVal);
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-const Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+const Val &HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::getVal(const Key &key, const Val &defaultVal) const {
 	size_type ctr = lookup(key);
 	if (_storage[ctr] != NULL)
 		return _storage[ctr]->_value;
@@ -591,15 +640,15 @@ const Val &HashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const
 		return defaultVal;
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-void HashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+void HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::setVal(const Key &key, const Val &val) {
 	size_type ctr = lookupAndCreateIfMissing(key);
 	assert(_storage[ctr] != NULL);
 	_storage[ctr]->_value = val;
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-void HashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+void HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::erase(iterator entry) {
 	// Check whether we have a valid iterator
 	assert(entry._hashmap == this);
 	const size_type ctr = entry._idx;
@@ -615,8 +664,8 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
 	_deleted++;
 }
 
-template<class Key, class Val, class HashFunc, class EqualFunc>
-void HashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+template<class Key, class Val, class HashFunc, class EqualFunc, class Alloc>
+void HashMap<Key, Val, HashFunc, EqualFunc, Alloc>::erase(const Key &key) {
 
 	size_type ctr = lookup(key);
 	if (_storage[ctr] == NULL)
@@ -32,6 +32,9 @@ namespace Common {
 Huffman::Symbol::Symbol(uint32 c, uint32 s) : code(c), symbol(s) {
 }
 
+Huffman::PrefixEntry::PrefixEntry() : symbol(0), length(0) {
+}
+
 
 Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const uint8 *lengths, const uint32 *symbols) {
 	assert(codeCount > 0);
@@ -58,6 +61,10 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 		// And put the pointer to the symbol/code struct into the symbol list.
 		_symbols[i] = &_codes[lengths[i] - 1].back();
 	}
+
+	_prefixBits = MIN<uint8>(maxLength, (uint8)kMaxPrefixBits);
+
+	buildPrefixTables();
 }
 
 Huffman::~Huffman() {
@@ -66,12 +73,73 @@ Huffman::~Huffman() {
 void Huffman::setSymbols(const uint32 *symbols) {
 	for (uint32 i = 0; i < _symbols.size(); i++)
 		_symbols[i]->symbol = symbols ? *symbols++ : i;
+
+	buildPrefixTables();
+}
+
+void Huffman::buildPrefixTables() {
+	const uint32 tableSize = 1 << _prefixBits;
+
+	for (int msb = 0; msb < 2; msb++) {
+		_prefixTable[msb].clear();
+		_prefixTable[msb].resize(tableSize);
+	}
+
+	// Shorter codes take precedence, as they would when walking the codes bit by bit
+	for (uint32 i = 0; i < _prefixBits; i++) {
+		const uint8  length = i + 1;
+		const uint32 fill   = 1 << (_prefixBits - length);
+
+		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode) {
+			// A code with more bits than its length can never match
+			if ((cCode->code >> length) != 0)
+				continue;
+
+			// MSB2LSB: The code occupies the top bits of the index, any bits may follow
+			for (uint32 j = 0; j < fill; j++) {
+				PrefixEntry &entry = _prefixTable[1][(cCode->code << (_prefixBits - length)) | j];
+				if (entry.length != 0)
+					continue;
+
+				entry.symbol = cCode->symbol;
+				entry.length = length;
+			}
+
+			// LSB2MSB: The code occupies the bottom bits of the index, any bits may follow
+			for (uint32 j = 0; j < fill; j++) {
+				PrefixEntry &entry = _prefixTable[0][cCode->code | (j << length)];
+				if (entry.length != 0)
+					continue;
+
+				entry.symbol = cCode->symbol;
+				entry.length = length;
+			}
+		}
+	}
 }
 
 uint32 Huffman::getSymbol(BitStream &bits) const {
-	uint32 code = 0;
+	// Peeking is slower than walking the codes bit by bit with streams that
+	// have to seek back, and impossible if there aren't enough bits left
+	if (!bits.hasCheapPeek() || (bits.size() - bits.pos()) < _prefixBits)
+		return getSymbolSlow(bits, 0, 0);
+
+	uint32 code = bits.peekBits(_prefixBits);
+
+	const PrefixEntry &entry = _prefixTable[bits.isMSBFirst() ? 1 : 0][code];
+	if (entry.length != 0) {
+		bits.skip(entry.length);
+		return entry.symbol;
+	}
+
+	// The code is longer than the table, continue with the bits we already know
+	bits.skip(_prefixBits);
+
+	return getSymbolSlow(bits, code, _prefixBits);
+}
 
-	for (uint32 i = 0; i < _codes.size(); i++) {
+uint32 Huffman::getSymbolSlow(BitStream &bits, uint32 code, uint32 length) const {
+	for (uint32 i = length; i < _codes.size(); i++) {
 		bits.addBit(code, i);
 
 		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
@@ -59,6 +59,11 @@ public:
 	uint32 getSymbol(BitStream &bits) const;
 
 private:
+	/** Maximal number of bits resolved with a single prefix table lookup. */
+	enum {
+		kMaxPrefixBits = 8
+	};
+
 	struct Symbol {
 		uint32 code;
 		uint32 symbol;
@@ -66,6 +71,14 @@ private:
 		Symbol(uint32 c, uint32 s);
 	};
 
+	/** An entry in the prefix lookup table. */
+	struct PrefixEntry {
+		uint32 symbol;
+		uint8  length; ///< Length of the code, 0 if no code fits into the table.
+
+		PrefixEntry();
+	};
+
 	typedef List<Symbol> CodeList;
 	typedef Array<CodeList> CodeLists;
 	typedef Array<Symbol *> SymbolList;
@@ -75,6 +88,22 @@ private:
 
 	/** Sorted list of pointers to the symbols. */
 	SymbolList _symbols;
+
+	/** Number of bits looked up at once in the prefix tables. */
+	uint8 _prefixBits;
+
+	/**
+	 * Lookup tables for all codes not longer than _prefixBits, indexed
+	 * by the next _prefixBits bits of the stream. The first table is used
+	 * for LSB2MSB streams, the second one for MSB2LSB streams.
+	 */
+	Array<PrefixEntry> _prefixTable[2];
+
+	/** Fill the prefix tables with the codes currently known. */
+	void buildPrefixTables();
+
+	/** Look for the code, bit by bit, starting with a code of the given length. */
+	uint32 getSymbolSlow(BitStream &bits, uint32 code, uint32 length) const;
 };
 
 } // End of namespace Common
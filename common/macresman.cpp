@@ -45,8 +45,9 @@ namespace Common {
 #define MBI_RFLEN 87
 #define MAXNAMELEN 63
 
-MacResManager::MacResManager() {
-	memset(this, 0, sizeof(MacResManager));
+MacResManager::MacResManager() : _stream(0), _mode(kResForkNone), _resForkOffset(-1), _resForkSize(0),
+		_dataOffset(0), _dataLength(0), _mapOffset(0), _mapLength(0), _resTypes(0), _resLists(0) {
+	memset(&_resMap, 0, sizeof(_resMap));
 	close();
 }
 
@@ -70,6 +71,7 @@ void MacResManager::close() {
 	delete[] _resTypes; _resTypes = 0;
 	delete _stream; _stream = 0;
 	_resMap.numTypes = 0;
+	_fileNode = FSNode();
 }
 
 bool MacResManager::hasDataFork() const {
@@ -169,6 +171,8 @@ bool MacResManager::open(const String &fileName) {
 bool MacResManager::open(const FSNode &path, const String &fileName) {
 	close();
 
+	// When changing the files tried here, update listForkFiles() as well
+
 #ifdef MACOSX
 	// Check the actual fork on a Mac computer
 	String fullPath = path.getPath() + "/" + fileName + "/..namedfork/rsrc";
@@ -178,6 +182,7 @@ bool MacResManager::open(const FSNode &path, const String &fileName) {
 
 		if (macResForkRawStream && loadFromRawFork(*macResForkRawStream)) {
 			_baseFileName = fileName;
+			_fileNode = resFsNode;
 			return true;
 		}
 
@@ -191,6 +196,7 @@ bool MacResManager::open(const FSNode &path, const String &fileName) {
 		SeekableReadStream *stream = fsNode.createReadStream();
 		if (loadFromRawFork(*stream)) {
 			_baseFileName = fileName;
+			_fileNode = fsNode;
 			return true;
 		}
 		delete stream;
@@ -202,6 +208,7 @@ bool MacResManager::open(const FSNode &path, const String &fileName) {
 		SeekableReadStream *stream = fsNode.createReadStream();
 		if (loadFromAppleDouble(*stream)) {
 			_baseFileName = fileName;
+			_fileNode = fsNode;
 			return true;
 		}
 		delete stream;
@@ -213,6 +220,7 @@ bool MacResManager::open(const FSNode &path, const String &fileName) {
 		SeekableReadStream *stream = fsNode.createReadStream();
 		if (loadFromMacBinary(*stream)) {
 			_baseFileName = fileName;
+			_fileNode = fsNode;
 			return true;
 		}
 		delete stream;
@@ -223,6 +231,7 @@ bool MacResManager::open(const FSNode &path, const String &fileName) {
 	if (fsNode.exists() && !fsNode.isDirectory()) {
 		SeekableReadStream *stream = fsNode.createReadStream();
 		_baseFileName = fileName;
+		_fileNode = fsNode;
 
 		// FIXME: Is this really needed?
 		if (isMacBinary(*stream)) {
@@ -240,6 +249,17 @@ bool MacResManager::open(const FSNode &path, const String &fileName) {
 	return false;
 }
 
+void MacResManager::listForkFiles(const FSNode &path, const String &fileName, FSList &candidates) {
+	// This has to match the order open() tries them in
+#ifdef MACOSX
+	candidates.push_back(FSNode(path.getPath() + "/" + fileName + "/..namedfork/rsrc"));
+#endif
+	candidates.push_back(path.getChild(fileName + ".rsrc"));
+	candidates.push_back(path.getChild(constructAppleDoubleName(fileName)));
+	candidates.push_back(path.getChild(fileName + ".bin"));
+	candidates.push_back(path.getChild(fileName));
+}
+
 bool MacResManager::exists(const String &fileName) {
 	// Try the file name by itself
 	if (File::exists(fileName))
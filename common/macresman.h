@@ -74,6 +74,16 @@ public:
 	 */
 	bool open(const FSNode &path, const String &fileName);
 
+	/**
+	 * List the files open(const FSNode &, const String &) looks for the
+	 * forks in, in the order it tries them, without opening any of them.
+	 *
+	 * @param path The path that holds the forks
+	 * @param fileName The base file name of the file
+	 * @param candidates Receives the candidate files, which need not exist
+	 */
+	static void listForkFiles(const FSNode &path, const String &fileName, FSList &candidates);
+
 	/**
 	 * See if a Mac data/resource fork pair exists.
 	 * @param fileName The base file name of the file
@@ -155,6 +165,13 @@ public:
 	 */
 	String getBaseFileName() const { return _baseFileName; }
 
+	/**
+	 * Get the node of the file the forks were loaded from.
+	 * @note This is only set when opened through open(const FSNode &, const String &).
+	 * @return The node of the opened file
+	 */
+	FSNode getFileNode() const { return _fileNode; }
+
 	/**
 	 * Return list of resource IDs with specified type ID
 	 */
@@ -168,6 +185,7 @@ public:
 private:
 	SeekableReadStream *_stream;
 	String _baseFileName;
+	FSNode _fileNode;
 
 	bool load(SeekableReadStream &stream);
 
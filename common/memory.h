@@ -27,6 +27,24 @@
 
 namespace Common {
 
+/**
+ * The allocator used by default by the container classes (Common::Array,
+ * Common::HashMap). It simply forwards to malloc/free.
+ *
+ * Custom allocators have to provide the same two methods. They are passed
+ * by value into the containers, so they should be small and cheap to copy,
+ * e.g. a pointer to the actual memory manager.
+ */
+struct DefaultAllocator {
+	void *allocate(size_t size) {
+		return malloc(size);
+	}
+
+	void deallocate(void *ptr, size_t size) {
+		free(ptr);
+	}
+};
+
 /**
  * Copies data from the range [first, last) to [dst, dst + (last - first)).
  * It requires the range [dst, dst + (last - first)) to be valid and
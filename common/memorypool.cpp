@@ -179,4 +179,174 @@ void MemoryPool::freeUnusedPages() {
 	}
 }
 
+
+#pragma mark -
+
+Arena::Arena(size_t blockSize)
+	: _blockSize(blockSize), _current(NULL), _free(NULL),
+	  _bytesUsed(0), _bytesReserved(0), _highWaterMark(0) {
+	assert(blockSize > 0);
+}
+
+Arena::~Arena() {
+	reset();
+	freeUnusedBlocks();
+}
+
+Arena::Block *Arena::allocBlock(size_t size) {
+	// Reuse a kept block if possible; only regular sized blocks are kept
+	if (size <= _blockSize && _free) {
+		Block *block = _free;
+		_free = block->next;
+		block->used = 0;
+		return block;
+	}
+
+	size = MAX(size, _blockSize);
+
+	Block *block = (Block *)::malloc(sizeof(Block) + size);
+	if (!block)
+		::error("Common::Arena: failure to allocate %u bytes", (uint)(sizeof(Block) + size));
+
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+
+	_bytesReserved += sizeof(Block) + size;
+	return block;
+}
+
+void Arena::releaseBlock(Block *block) {
+	if (block->size == _blockSize) {
+		block->next = _free;
+		_free = block;
+	} else {
+		_bytesReserved -= sizeof(Block) + block->size;
+		::free(block);
+	}
+}
+
+void *Arena::allocate(size_t size, size_t alignment) {
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	if (_current) {
+		byte *base = (byte *)(_current + 1);
+		size_t start = _current->used + ((alignment - ((size_t)(base + _current->used) & (alignment - 1))) & (alignment - 1));
+		if (start + size <= _current->size) {
+			_bytesUsed += start + size - _current->used;
+			_highWaterMark = MAX(_highWaterMark, _bytesUsed);
+			_current->used = start + size;
+			return base + start;
+		}
+	}
+
+	// Not enough space left in the current block, start a new one. Reserve
+	// enough space to align the allocation, whatever the block's address.
+	Block *block = allocBlock(size + alignment - 1);
+	block->next = _current;
+	_current = block;
+
+	return allocate(size, alignment);
+}
+
+void Arena::reset() {
+	while (_current) {
+		Block *next = _current->next;
+		releaseBlock(_current);
+		_current = next;
+	}
+
+	_bytesUsed = 0;
+}
+
+void Arena::freeUnusedBlocks() {
+	while (_free) {
+		Block *next = _free->next;
+		_bytesReserved -= sizeof(Block) + _free->size;
+		::free(_free);
+		_free = next;
+	}
+}
+
+Arena::Marker Arena::getMarker() const {
+	Marker marker = { _current, _current ? _current->used : 0, _bytesUsed };
+	return marker;
+}
+
+void Arena::rewind(const Marker &marker) {
+	while (_current != marker.block) {
+		assert(_current);
+		Block *next = _current->next;
+		releaseBlock(_current);
+		_current = next;
+	}
+
+	if (_current) {
+		assert(marker.used <= _current->used);
+		_current->used = marker.used;
+	}
+
+	_bytesUsed = marker.bytesUsed;
+}
+
+#pragma mark -
+
+SizeClassPool::SizeClassPool() : _bytesInUse(0), _highWaterMark(0) {
+	for (int i = 0; i < kNumClasses; ++i)
+		_pools[i] = new MemoryPool((size_t)1 << (i + kMinClassShift));
+}
+
+SizeClassPool::~SizeClassPool() {
+	for (int i = 0; i < kNumClasses; ++i)
+		delete _pools[i];
+}
+
+int SizeClassPool::getSizeClass(size_t size) {
+	if (size > getMaxPooledSize())
+		return -1;
+
+	int sizeClass = 0;
+	while (((size_t)1 << (sizeClass + kMinClassShift)) < size)
+		++sizeClass;
+	return sizeClass;
+}
+
+void *SizeClassPool::allocate(size_t size) {
+	const int sizeClass = getSizeClass(size);
+
+	void *ptr;
+	if (sizeClass < 0) {
+		ptr = ::malloc(size);
+		if (!ptr)
+			::error("Common::SizeClassPool: failure to allocate %u bytes", (uint)size);
+		_bytesInUse += size;
+	} else {
+		ptr = _pools[sizeClass]->allocChunk();
+		_bytesInUse += _pools[sizeClass]->getChunkSize();
+	}
+
+	_highWaterMark = MAX(_highWaterMark, _bytesInUse);
+	return ptr;
+}
+
+void SizeClassPool::deallocate(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	const int sizeClass = getSizeClass(size);
+
+	if (sizeClass < 0) {
+		::free(ptr);
+		_bytesInUse -= size;
+	} else {
+		_pools[sizeClass]->freeChunk(ptr);
+		_bytesInUse -= _pools[sizeClass]->getChunkSize();
+	}
+}
+
+void SizeClassPool::freeUnusedPages() {
+	for (int i = 0; i < kNumClasses; ++i)
+		_pools[i]->freeUnusedPages();
+}
+
 } // End of namespace Common
@@ -141,6 +141,217 @@ public:
 	}
 };
 
+/**
+ * A bump allocator for short-lived memory, e.g. scratch buffers which are
+ * only needed while decoding or rendering a single frame.
+ *
+ * Memory is handed out linearly from large blocks and is never freed
+ * individually. Instead, the whole arena is reset() at once (typically at
+ * the end of each frame), or rewound to a previously taken Marker. The blocks
+ * are kept for reuse, so in the steady state no malloc() calls are made at
+ * all, which avoids fragmenting the heap during long play sessions.
+ *
+ * Allocations bigger than the block size get a block of their own, which is
+ * released again on reset.
+ */
+class Arena {
+protected:
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+
+	struct Block {
+		Block *next;
+		size_t size;	///< Usable bytes following the block header
+		size_t used;
+	};
+
+	const size_t	_blockSize;
+	Block			*_current;	///< Block allocations are made from; earlier blocks are chained to it
+	Block			*_free;		///< Blocks kept for reuse after reset()
+
+	size_t			_bytesUsed;
+	size_t			_bytesReserved;
+	size_t			_highWaterMark;
+
+	Block	*allocBlock(size_t size);
+	void	releaseBlock(Block *block);
+
+public:
+	enum {
+		kDefaultBlockSize = 64 * 1024,
+		kDefaultAlignment = 2 * sizeof(void *)
+	};
+
+	/**
+	 * A position inside the arena, which can be returned to by rewind().
+	 */
+	struct Marker {
+		Block *block;
+		size_t used;
+		size_t bytesUsed;
+	};
+
+	/**
+	 * Constructor for an arena with the given block size.
+	 * @param blockSize		the size of each block memory is taken from
+	 */
+	explicit Arena(size_t blockSize = kDefaultBlockSize);
+	~Arena();
+
+	/**
+	 * Allocate memory from the arena. It stays valid until the next reset(),
+	 * or until the arena is rewound to a marker taken before this call.
+	 *
+	 * @param size			the number of bytes to allocate
+	 * @param alignment		the alignment of the returned pointer, must be a power of 2
+	 */
+	void	*allocate(size_t size, size_t alignment = kDefaultAlignment);
+
+	/**
+	 * Release all allocations made from the arena at once. The blocks are
+	 * kept around for the allocations of the next frame.
+	 */
+	void	reset();
+
+	/**
+	 * Return the blocks kept for reuse back to the system.
+	 */
+	void	freeUnusedBlocks();
+
+	/** Return the current position inside the arena. */
+	Marker	getMarker() const;
+
+	/**
+	 * Release all allocations made after the given marker was taken.
+	 */
+	void	rewind(const Marker &marker);
+
+	/** Return the number of bytes currently allocated from the arena. */
+	size_t	getBytesUsed() const { return _bytesUsed; }
+
+	/** Return the number of bytes the arena currently obtained from the system. */
+	size_t	getBytesReserved() const { return _bytesReserved; }
+
+	/** Return the highest number of bytes ever allocated from the arena at once. */
+	size_t	getHighWaterMark() const { return _highWaterMark; }
+
+	void	resetHighWaterMark() { _highWaterMark = _bytesUsed; }
+};
+
+/**
+ * Rewinds an arena to the position it had when the scope was entered.
+ */
+class ArenaScope {
+private:
+	ArenaScope(const ArenaScope&);
+	ArenaScope& operator=(const ArenaScope&);
+
+	Arena &_arena;
+	const Arena::Marker _marker;
+
+public:
+	explicit ArenaScope(Arena &arena) : _arena(arena), _marker(arena.getMarker()) {}
+	~ArenaScope() { _arena.rewind(_marker); }
+};
+
+/**
+ * A general purpose allocator serving blocks of arbitrary size from a set of
+ * memory pools of power-of-two chunk sizes. Requests bigger than the largest
+ * size class are passed on to malloc().
+ *
+ * Since the size of a block is not stored, it has to be passed to
+ * deallocate() again, just like with the container allocators.
+ */
+class SizeClassPool {
+protected:
+	SizeClassPool(const SizeClassPool&);
+	SizeClassPool& operator=(const SizeClassPool&);
+
+	enum {
+		kMinClassShift = 3,
+		kMaxClassShift = 12,
+		kNumClasses = kMaxClassShift - kMinClassShift + 1
+	};
+
+	MemoryPool	*_pools[kNumClasses];
+
+	size_t		_bytesInUse;
+	size_t		_highWaterMark;
+
+	static int	getSizeClass(size_t size);
+
+public:
+	SizeClassPool();
+	~SizeClassPool();
+
+	/** Allocate a block of the given size. */
+	void	*allocate(size_t size);
+
+	/**
+	 * Return a block to the pool.
+	 * @param ptr			the block, as returned by allocate()
+	 * @param size			the size the block was allocated with
+	 */
+	void	deallocate(void *ptr, size_t size);
+
+	/** Return unused pages of all size classes back to the system. */
+	void	freeUnusedPages();
+
+	/** Return the size of the largest size class. */
+	static size_t	getMaxPooledSize() { return (size_t)1 << kMaxClassShift; }
+
+	/** Return the number of bytes currently allocated from the pool. */
+	size_t	getBytesInUse() const { return _bytesInUse; }
+
+	/** Return the highest number of bytes ever allocated from the pool at once. */
+	size_t	getHighWaterMark() const { return _highWaterMark; }
+
+	void	resetHighWaterMark() { _highWaterMark = _bytesInUse; }
+};
+
+/**
+ * Allocator for the container classes using an Arena. Nothing is ever freed
+ * individually, so a container using it must be destroyed before the arena
+ * is reset.
+ */
+class ArenaAllocator {
+private:
+	Arena *_arena;
+
+public:
+	explicit ArenaAllocator(Arena &arena) : _arena(&arena) {}
+
+	void *allocate(size_t size) {
+		return _arena->allocate(size);
+	}
+
+	void deallocate(void *ptr, size_t size) {
+	}
+
+	Arena &getArena() const { return *_arena; }
+};
+
+/**
+ * Allocator for the container classes using a SizeClassPool.
+ */
+class PoolAllocator {
+private:
+	SizeClassPool *_pool;
+
+public:
+	explicit PoolAllocator(SizeClassPool &pool) : _pool(&pool) {}
+
+	void *allocate(size_t size) {
+		return _pool->allocate(size);
+	}
+
+	void deallocate(void *ptr, size_t size) {
+		_pool->deallocate(ptr, size);
+	}
+
+	SizeClassPool &getPool() const { return *_pool; }
+};
+
 } // End of namespace Common
 
 /**
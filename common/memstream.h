@@ -170,7 +170,10 @@ private:
 
 		byte *old_data = _data;
 
+		// Grow geometrically, so that many small writes stay linear in time
 		_capacity = new_len + 32;
+		if (_capacity < _size * 2)
+			_capacity = _size * 2;
 		_data = (byte *)malloc(_capacity);
 		_ptr = _data + _pos;
 
@@ -0,0 +1,197 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/profiler.h"
+#include "common/array.h"
+#include "common/atomic.h"
+#include "common/stream.h"
+#include "common/str.h"
+#include "common/system.h"
+#include "common/util.h"
+
+#if defined(HAVE_THREAD_LOCAL)
+#define PROFILER_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#endif
+
+namespace Common {
+
+DECLARE_SINGLETON(Profiler);
+
+volatile bool Profiler::_enabled = false;
+
+#ifdef PROFILER_THREAD_LOCAL
+// The buffer of a thread is only valid if it belongs to the current profiler,
+// the thread may have recorded zones for one destroyed earlier
+static PROFILER_THREAD_LOCAL Profiler::ThreadBuffer *s_threadBuffer = 0;
+static PROFILER_THREAD_LOCAL uint32 s_threadGeneration = 0;
+#endif
+
+static uint32 s_generation = 0;
+
+Profiler::Profiler() : _generation(++s_generation), _droppedEvents(0), _sharedBufferLock(0) {
+	for (uint i = 0; i < kMaxThreads; ++i) {
+		_buffers[i] = 0;
+		_cleared[i] = 0;
+	}
+}
+
+Profiler::~Profiler() {
+	_enabled = false;
+
+	for (uint i = 0; i < kMaxThreads; ++i)
+		delete _buffers[i];
+}
+
+void Profiler::setEnabled(bool enabled) {
+	_enabled = enabled;
+}
+
+void Profiler::clear() {
+	// The buffers are written by their threads without a lock, so only
+	// remember which events to skip
+	for (uint i = 0; i < kMaxThreads; ++i) {
+		const ThreadBuffer *buffer = atomicLoad(&_buffers[i]);
+		if (buffer)
+			_cleared[i] = atomicLoad(&buffer->written);
+	}
+
+	atomicStore(&_droppedEvents, (int32)0);
+}
+
+uint64 Profiler::getTime() {
+	return g_system->getMicros();
+}
+
+Profiler::ThreadBuffer *Profiler::addThreadBuffer() {
+	for (uint i = 0; i < kMaxThreads; ++i) {
+		if (atomicLoad(&_buffers[i]))
+			continue;
+
+		ThreadBuffer *buffer = new ThreadBuffer();
+		buffer->written = 0;
+
+		if (atomicCompareExchange(&_buffers[i], (ThreadBuffer *)0, buffer))
+			return buffer;
+
+		// Another thread took the slot meanwhile
+		delete buffer;
+	}
+
+	atomicAdd(&_droppedEvents, 1);
+	return 0;
+}
+
+void Profiler::record(const char *name, uint64 start) {
+	const uint64 end = getTime();
+
+#ifdef PROFILER_THREAD_LOCAL
+	ThreadBuffer *buffer = s_threadBuffer;
+	if (!buffer || s_threadGeneration != _generation) {
+		buffer = s_threadBuffer = addThreadBuffer();
+		s_threadGeneration = _generation;
+		if (!buffer)
+			return;
+	}
+#else
+	// Without thread local storage, all threads share the first buffer.
+	// Instead of waiting for another thread recording, drop the event.
+	if (!atomicCompareExchange(&_sharedBufferLock, (void *)0, (void *)this)) {
+		atomicAdd(&_droppedEvents, 1);
+		return;
+	}
+
+	ThreadBuffer *buffer = atomicLoad(&_buffers[0]);
+	if (!buffer)
+		buffer = addThreadBuffer();
+	if (!buffer) {
+		atomicStore(&_sharedBufferLock, (void *)0);
+		return;
+	}
+#endif
+
+	// Only this thread changes written, publish the event once it is complete
+	const uint32 written = buffer->written;
+	Event &event = buffer->events[written % kEventsPerThread];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	atomicStore(&buffer->written, written + 1);
+
+#ifndef PROFILER_THREAD_LOCAL
+	atomicStore(&_sharedBufferLock, (void *)0);
+#endif
+}
+
+uint32 Profiler::writeChromeTrace(WriteStream &stream) {
+	const bool wasEnabled = _enabled;
+	_enabled = false;
+
+	uint32 count = 0;
+	stream.writeString("{\"traceEvents\":[\n");
+
+	Array<Event> events;
+
+	for (uint i = 0; i < kMaxThreads; ++i) {
+		ThreadBuffer *buffer = atomicLoad(&_buffers[i]);
+		if (!buffer)
+			continue;
+
+		// Threads still inside record() keep writing while the events are
+		// copied, so copy first and then drop the ones overwritten meanwhile
+		const uint32 written = atomicLoad(&buffer->written);
+		const uint32 size = MIN<uint32>(written - _cleared[i], kEventsPerThread);
+
+		events.resize(size);
+		for (uint32 j = 0; j < size; ++j)
+			events[j] = buffer->events[(written - size + j) % kEventsPerThread];
+
+		// The read-modify-write keeps the copies from being moved after it
+		const uint32 now = (uint32)atomicAdd((volatile int32 *)&buffer->written, 0);
+
+		for (uint32 j = 0; j < size; ++j) {
+			// The thread writing event number now overwrites now - kEventsPerThread
+			if (now - (written - size + j) >= kEventsPerThread)
+				continue;
+
+			const Event &event = events[j];
+
+			String name(event.name);
+			for (uint k = 0; k < name.size(); ++k) {
+				if (name[k] == '"' || name[k] == '\\')
+					name.setChar('_', k);
+			}
+
+			stream.writeString(String::format("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu}",
+				count ? ",\n" : "", name.c_str(), i, (unsigned long long)event.start, (unsigned long long)(event.end - event.start)));
+			count++;
+		}
+	}
+
+	stream.writeString("\n]}\n");
+
+	_enabled = wasEnabled;
+	return count;
+}
+
+} // End of namespace Common
@@ -0,0 +1,167 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_PROFILER_H
+#define COMMON_PROFILER_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+#include "common/singleton.h"
+
+namespace Common {
+
+class WriteStream;
+
+/**
+ * Records how long named zones of code took to run, to be inspected in a
+ * viewer for the Chrome trace event format (e.g. chrome://tracing).
+ *
+ * Zones are marked with PROFILE_SCOPE. Recording is off by default, in
+ * which case entering a zone only costs a check of a flag. Each thread
+ * records into a ring buffer of its own, so only the most recent events of
+ * every thread are kept. On compilers without thread local storage, all
+ * threads share one buffer, and events of threads recording at the same
+ * time are dropped.
+ *
+ * Timestamps come from OSystem::getMicros(), so zones are only measured
+ * with millisecond precision on backends which don't override it.
+ *
+ * The profiler must only be destroyed once no other thread records zones
+ * anymore, which is why the OSystem destructor destroys it last.
+ */
+class Profiler : public Singleton<Profiler> {
+public:
+	enum {
+		kEventsPerThread = 16384,
+		kMaxThreads = 32
+	};
+
+	/** A single execution of a zone. */
+	struct Event {
+		const char *name;
+		uint64 start;
+		uint64 end;
+	};
+
+	/** Check whether zones are currently being recorded. */
+	static bool isEnabled() { return _enabled; }
+
+	/** Start or stop recording zones. */
+	void setEnabled(bool enabled);
+
+	/** Discard all recorded events. Safe to call while other threads record. */
+	void clear();
+
+	/** Get the current time, in microseconds. */
+	static uint64 getTime();
+
+	/**
+	 * Record the execution of a zone, which ends now.
+	 *
+	 * @param name	the name of the zone, which must stay valid (i.e. a string literal)
+	 * @param start	the time the zone was entered, as returned by getTime()
+	 */
+	void record(const char *name, uint64 start);
+
+	/**
+	 * Write all recorded events in the Chrome trace event format. Recording
+	 * is paused while doing so, events other threads are still recording
+	 * meanwhile may be left out.
+	 *
+	 * @return the number of events written
+	 */
+	uint32 writeChromeTrace(WriteStream &stream);
+
+	/**
+	 * Get the number of events lost because too many threads recorded zones,
+	 * or, without thread local storage, because they recorded at the same time.
+	 */
+	uint32 getDroppedEvents() const { return _droppedEvents; }
+
+	/** The events of a single thread. */
+	struct ThreadBuffer {
+		Event events[kEventsPerThread];
+		volatile uint32 written; ///< Total number of events written, the ring buffer holds the last ones
+	};
+
+private:
+	friend class Singleton<SingletonBaseType>;
+	Profiler();
+	~Profiler();
+
+	/** Allocate the buffer for another thread, or return 0 if all are taken. */
+	ThreadBuffer *addThreadBuffer();
+
+	static volatile bool _enabled;
+
+	/** Tells profilers apart, so that threads notice their buffer is gone. */
+	const uint32 _generation;
+
+	/**
+	 * The buffers of the threads, in the order they were added. Threads
+	 * claim free slots with atomic operations instead of a Mutex, so that
+	 * the profiler doesn't need the backend to be destroyed.
+	 */
+	ThreadBuffer *volatile _buffers[kMaxThreads];
+	uint32 _cleared[kMaxThreads]; ///< The number of events written to each buffer at the last clear()
+	volatile int32 _droppedEvents;
+	void *volatile _sharedBufferLock; ///< Held while recording into the shared buffer, without thread local storage
+};
+
+/**
+ * Records the time from its construction to its destruction as a zone.
+ * Normally used through the PROFILE_SCOPE macro.
+ */
+class ProfileScope : NonCopyable {
+public:
+	explicit ProfileScope(const char *name) : _name(name), _recording(Profiler::isEnabled()), _start(0) {
+		if (_recording)
+			_start = Profiler::getTime();
+	}
+
+	~ProfileScope() {
+		if (_recording)
+			Profiler::instance().record(_name, _start);
+	}
+
+private:
+	const char *_name;
+	bool _recording;
+	uint64 _start;
+};
+
+} // End of namespace Common
+
+/** Shortcut for accessing the profiler. */
+#define ProfMan		Common::Profiler::instance()
+
+#define PROFILE_SCOPE_CONCAT_(a, b) a ## b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_(a, b)
+
+/**
+ * Record the time until the end of the enclosing scope as a zone with the
+ * given name, which must be a string literal. By convention, names are
+ * prefixed with the subsystem or engine, e.g. PROFILE_SCOPE("sci.run_vm").
+ */
+#define PROFILE_SCOPE(name) Common::ProfileScope PROFILE_SCOPE_CONCAT(profileScope, __LINE__)(name)
+
+#endif
@@ -161,6 +161,21 @@ public:
 	 * @see Common::matchString()
 	 */
 	virtual StringArray listSavefiles(const String &pattern) = 0;
+
+	/**
+	 * Wait until all savefiles opened through openForSaving() are written to
+	 * their final location. Savefile managers may write savefiles in the
+	 * background once they are finalized. I/O errors during that write are
+	 * reported through err() of the stream, which waits for the write, if
+	 * it is called after finalize(). All others are reported here.
+	 *
+	 * This has to be called before the written files are accessed by other
+	 * means than this savefile manager, e.g. when quitting.
+	 *
+	 * @return true if all savefiles were written, false otherwise. In the
+	 *         latter case, the error is set to kWritingFailed.
+	 */
+	virtual bool flushSavefiles() { return true; }
 };
 
 } // End of namespace Common
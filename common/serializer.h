@@ -23,8 +23,10 @@
 #ifndef COMMON_SERIALIZER_H
 #define COMMON_SERIALIZER_H
 
+#include "common/endian.h"
 #include "common/stream.h"
 #include "common/str.h"
+#include "common/util.h"
 
 namespace Common {
 
@@ -43,6 +45,20 @@ namespace Common {
 		_bytesSynced += SIZE; \
 	}
 
+#define SYNC_FORMAT(NAME,TYPE,SIZE,READ,WRITE,NATIVE) \
+	struct NAME { \
+		typedef TYPE Type; \
+		enum { kSize = SIZE, kNative = NATIVE }; \
+		static TYPE read(const byte *ptr) { return (TYPE)READ(ptr); } \
+		static void write(byte *ptr, TYPE val) { WRITE(ptr, val); } \
+	};
+
+#ifdef SCUMM_LITTLE_ENDIAN
+#define SYNC_NATIVE_LE true
+#else
+#define SYNC_NATIVE_LE false
+#endif
+
 
 /**
  * This class allows syncing / serializing data (primarily game savestates)
@@ -53,6 +69,11 @@ namespace Common {
  *
  * This class was heavily inspired by the save/load code in the SCUMM engine.
  *
+ * A serializer created without any streams performs a "dry run": it acts
+ * like a saving serializer, but only counts the bytes synced. This can be
+ * used to find out the size of a savestate beforehand, in order to write it
+ * into a single preallocated buffer afterwards.
+ *
  * @todo Maybe rename this to Synchronizer?
  *
  * @todo One feature the SCUMM code has but that is missing here: Support for
@@ -67,7 +88,49 @@ public:
 	typedef uint32 Version;
 	static const Version kLastVersion = 0xFFFFFFFF;
 
+	/**
+	 * The formats arrays can be synced in with syncArray(), e.g.
+	 *   s.syncArray<Common::Serializer::Uint16LE>(values, count);
+	 */
+	struct Byte {
+		typedef byte Type;
+		enum { kSize = 1, kNative = true };
+		static byte read(const byte *ptr) { return *ptr; }
+		static void write(byte *ptr, byte val) { *ptr = val; }
+	};
+
+	SYNC_FORMAT(Uint16LE, uint16, 2, READ_LE_UINT16, WRITE_LE_UINT16, SYNC_NATIVE_LE)
+	SYNC_FORMAT(Uint16BE, uint16, 2, READ_BE_UINT16, WRITE_BE_UINT16, !SYNC_NATIVE_LE)
+	SYNC_FORMAT(Sint16LE, int16, 2, READ_LE_UINT16, WRITE_LE_UINT16, SYNC_NATIVE_LE)
+	SYNC_FORMAT(Sint16BE, int16, 2, READ_BE_UINT16, WRITE_BE_UINT16, !SYNC_NATIVE_LE)
+
+	SYNC_FORMAT(Uint32LE, uint32, 4, READ_LE_UINT32, WRITE_LE_UINT32, SYNC_NATIVE_LE)
+	SYNC_FORMAT(Uint32BE, uint32, 4, READ_BE_UINT32, WRITE_BE_UINT32, !SYNC_NATIVE_LE)
+	SYNC_FORMAT(Sint32LE, int32, 4, READ_LE_UINT32, WRITE_LE_UINT32, SYNC_NATIVE_LE)
+	SYNC_FORMAT(Sint32BE, int32, 4, READ_BE_UINT32, WRITE_BE_UINT32, !SYNC_NATIVE_LE)
+
 protected:
+	/**
+	 * The stream a dry run "saves" to. It only counts the bytes written.
+	 */
+	class DryRunStream : public WriteStream {
+	private:
+		uint32 _pos;
+	public:
+		DryRunStream() : _pos(0) {}
+
+		uint32 write(const void *dataPtr, uint32 dataSize) {
+			_pos += dataSize;
+			return dataSize;
+		}
+
+		int32 pos() const { return _pos; }
+	};
+
+	enum {
+		kBulkBufferSize = 4096
+	};
+
 	SeekableReadStream *_loadStream;
 	WriteStream *_saveStream;
 
@@ -75,15 +138,40 @@ protected:
 
 	Version _version;
 
+	DryRunStream _dryRunStream;
+
 public:
 	Serializer(SeekableReadStream *in, WriteStream *out)
 		: _loadStream(in), _saveStream(out), _bytesSynced(0), _version(0) {
-		assert(in || out);
+		if (!in && !out)
+			_saveStream = &_dryRunStream;
+	}
+
+	/**
+	 * A copy of a dry run counts into its own stream, starting at the
+	 * number of bytes synced so far.
+	 */
+	Serializer(const Serializer &other)
+		: _loadStream(other._loadStream), _saveStream(other._saveStream), _bytesSynced(other._bytesSynced),
+		  _version(other._version), _dryRunStream(other._dryRunStream) {
+		if (other.isDryRun())
+			_saveStream = &_dryRunStream;
 	}
+
+	Serializer &operator=(const Serializer &other) {
+		_loadStream = other._loadStream;
+		_saveStream = other.isDryRun() ? &_dryRunStream : other._saveStream;
+		_bytesSynced = other._bytesSynced;
+		_version = other._version;
+		_dryRunStream = other._dryRunStream;
+		return *this;
+	}
+
 	virtual ~Serializer() {}
 
 	inline bool isSaving() { return (_saveStream != 0); }
 	inline bool isLoading() { return (_loadStream != 0); }
+	inline bool isDryRun() const { return (_saveStream == &_dryRunStream); }
 
 	// WORKAROUND for bugs #2892515 "BeOS: tinsel does not compile" and
 	// #2892510 "BeOS: Cruise does not compile". gcc 2.95.3, which is used
@@ -181,6 +269,60 @@ public:
 		_bytesSynced += size;
 	}
 
+	/**
+	 * Sync an array of values in the given format, e.g.
+	 *   s.syncArray<Common::Serializer::Sint32LE>(globals, numGlobals);
+	 * produces the same data as calling syncAsSint32LE() for each element,
+	 * but converts all values in bulk, with a single stream call wherever
+	 * possible. If the element type has the size of the format and the
+	 * byte order matches, the data is read and written in place.
+	 *
+	 * @param vals		the array to sync; the element type must be an integer or enum type
+	 * @param count		the number of elements in the array
+	 */
+	template<class Format, typename T>
+	void syncArray(T *vals, uint32 count, Version minVersion = 0, Version maxVersion = kLastVersion) {
+		if (_version < minVersion || _version > maxVersion)
+			return;	// Ignore anything which is not supposed to be present in this save game version
+
+		const uint32 size = Format::kSize;
+		if (isLoading()) {
+			if (sizeof(T) == size) {
+				// Read straight into the array and convert in place
+				_loadStream->read(vals, count * size);
+				if (!Format::kNative) {
+					for (uint32 i = 0; i < count; ++i)
+						vals[i] = static_cast<T>(Format::read((const byte *)&vals[i]));
+				}
+			} else {
+				byte buf[kBulkBufferSize];
+				for (uint32 i = 0; i < count; ) {
+					const uint32 n = MIN<uint32>(count - i, sizeof(buf) / size);
+					_loadStream->read(buf, n * size);
+					for (uint32 j = 0; j < n; ++j)
+						vals[i + j] = static_cast<T>(Format::read(buf + j * size));
+					i += n;
+				}
+			}
+		} else {
+			if (sizeof(T) == size && Format::kNative) {
+				_saveStream->write(vals, count * size);
+			} else {
+				byte buf[kBulkBufferSize];
+				for (uint32 i = 0; i < count; ) {
+					const uint32 n = MIN<uint32>(count - i, sizeof(buf) / size);
+					for (uint32 j = 0; j < n; ++j) {
+						typename Format::Type tmp = vals[i + j];
+						Format::write(buf + j * size, tmp);
+					}
+					_saveStream->write(buf, n * size);
+					i += n;
+				}
+			}
+		}
+		_bytesSynced += count * size;
+	}
+
 	/**
 	 * Sync a 'magic id' of up to 256 bytes, and return whether it matched.
 	 * When saving, this will simply write out the magic id and return true.
@@ -236,6 +378,8 @@ public:
 };
 
 #undef SYNC_AS
+#undef SYNC_FORMAT
+#undef SYNC_NATIVE_LE
 
 
 // Mixin class / interface
@@ -75,6 +75,11 @@ public:
 	static void destroy() {
 		T::destroyInstance();
 	}
+
+	/** Return whether the instance exists, without creating it. */
+	static bool hasInstance() {
+		return _singleton != 0;
+	}
 protected:
 	Singleton<T>()		{ }
 #ifdef __SYMBIAN32__
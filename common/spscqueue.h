@@ -0,0 +1,101 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_SPSCQUEUE_H
+#define COMMON_SPSCQUEUE_H
+
+#include "common/scummsys.h"
+#include "common/atomic.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * A fixed size queue which one thread can push to while another one pops
+ * from it, without any locking. This is meant for handing commands to a
+ * thread which must not block, like the audio callback.
+ *
+ * At most one thread may push at a time, and at most one thread may pop
+ * at a time. Callers with several producers have to serialize them with
+ * a lock of their own, which the consumer never takes.
+ *
+ * @param T	the type of the items, which is copied in and out
+ * @param N	the capacity of the queue, which must be a power of two
+ */
+template<class T, uint N>
+class SPSCQueue : NonCopyable {
+public:
+	SPSCQueue() : _head(0), _tail(0) {}
+
+	/**
+	 * Add an item at the end of the queue. May only be called by the
+	 * producer.
+	 *
+	 * @return false if the queue is full, in which case nothing is added
+	 */
+	bool push(const T &item) {
+		const uint32 tail = _tail;
+		if (tail - atomicLoad(&_head) == N)
+			return false;
+
+		_items[tail % N] = item;
+		atomicStore(&_tail, tail + 1);
+		return true;
+	}
+
+	/**
+	 * Remove the item at the front of the queue. May only be called by
+	 * the consumer.
+	 *
+	 * @return false if the queue is empty, in which case item is unchanged
+	 */
+	bool pop(T &item) {
+		const uint32 head = _head;
+		if (head == atomicLoad(&_tail))
+			return false;
+
+		item = _items[head % N];
+		atomicStore(&_head, head + 1);
+		return true;
+	}
+
+	/** Check whether the queue is empty. Only reliable on the consumer. */
+	bool empty() const {
+		return atomicLoad(&_head) == atomicLoad(&_tail);
+	}
+
+	/** The number of items the queue can hold. */
+	uint capacity() const { return N; }
+
+private:
+	T _items[N];
+
+	/** Count of items popped so far, only written by the consumer. */
+	volatile uint32 _head;
+
+	/** Count of items pushed so far, only written by the producer. */
+	volatile uint32 _tail;
+};
+
+} // End of namespace Common
+
+#endif
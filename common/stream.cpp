@@ -206,6 +206,21 @@ uint32 SubReadStream::read(void *dataPtr, uint32 dataSize) {
 	return dataSize;
 }
 
+SeekableReadStream *SubReadStream::readStream(uint32 dataSize) {
+	if (!_shareParentData)
+		return ReadStream::readStream(dataSize);
+
+	if (dataSize > _end - _pos) {
+		dataSize = _end - _pos;
+		_eos = true;
+	}
+
+	SeekableReadStream *stream = _parentStream->readStream(dataSize);
+	_pos += stream->size();
+
+	return stream;
+}
+
 SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, uint32 begin, uint32 end, DisposeAfterUse::Flag disposeParentStream)
 	: SubReadStream(parentStream, end, disposeParentStream),
 	_parentStream(parentStream),
@@ -247,6 +262,16 @@ uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
 	return SeekableSubReadStream::read(dataPtr, dataSize);
 }
 
+SeekableReadStream *SafeSeekableSubReadStream::readStream(uint32 dataSize) {
+	if (!_shareParentData)
+		return ReadStream::readStream(dataSize);
+
+	// Make sure the parent stream is at the right position
+	seek(0, SEEK_CUR);
+
+	return SeekableSubReadStream::readStream(dataSize);
+}
+
 
 #pragma mark -
 
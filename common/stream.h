@@ -318,8 +318,11 @@ public:
 	 * if reading more failed, because of an I/O error or because
 	 * the end of the stream was reached. Which can be determined by
 	 * calling err() and eos().
+	 *
+	 * Streams that already have their data in memory may override this to
+	 * hand out a view onto that memory instead of copying it.
 	 */
-	SeekableReadStream *readStream(uint32 dataSize);
+	virtual SeekableReadStream *readStream(uint32 dataSize);
 
 };
 
@@ -43,12 +43,14 @@ protected:
 	uint32 _pos;
 	uint32 _end;
 	bool _eos;
+	bool _shareParentData;
 public:
 	SubReadStream(ReadStream *parentStream, uint32 end, DisposeAfterUse::Flag disposeParentStream = DisposeAfterUse::NO)
 		: _parentStream(parentStream, disposeParentStream),
 		  _pos(0),
 		  _end(end),
-		  _eos(false) {
+		  _eos(false),
+		  _shareParentData(false) {
 		assert(parentStream);
 	}
 
@@ -56,6 +58,17 @@ public:
 	virtual bool err() const { return _parentStream->err(); }
 	virtual void clearErr() { _eos = false; _parentStream->clearErr(); }
 	virtual uint32 read(void *dataPtr, uint32 dataSize);
+
+	/**
+	 * Let readStream() ask the parent stream for the data, so that parents
+	 * with their data in memory can hand out views instead of copies.
+	 *
+	 * This bypasses read(). Subclasses overriding read(), e.g. to lock a
+	 * mutex, must not enable it.
+	 */
+	void shareParentData() { _shareParentData = true; }
+
+	virtual SeekableReadStream *readStream(uint32 dataSize);
 };
 
 /*
@@ -114,6 +127,7 @@ public:
 	}
 
 	virtual uint32 read(void *dataPtr, uint32 dataSize);
+	virtual SeekableReadStream *readStream(uint32 dataSize);
 };
 
 
@@ -25,9 +25,11 @@
 #include "common/system.h"
 #include "common/events.h"
 #include "common/fs.h"
+#include "common/profiler.h"
 #include "common/savefile.h"
 #include "common/str.h"
 #include "common/taskbar.h"
+#include "common/threadpool.h"
 #include "common/updates.h"
 #include "common/textconsole.h"
 #ifdef ENABLE_EVENTRECORDER
@@ -51,10 +53,18 @@ OSystem::OSystem() {
 #if defined(USE_UPDATES)
 	_updateManager = 0;
 #endif
+	_threadPool = 0;
 	_fsFactory = 0;
 }
 
 OSystem::~OSystem() {
+	// Stop the worker threads first, their tasks may use the other managers.
+	// Savefiles still being written in the background need them, though.
+	if (_savefileManager)
+		_savefileManager->flushSavefiles();
+	delete _threadPool;
+	_threadPool = 0;
+
 	delete _audiocdManager;
 	_audiocdManager = 0;
 
@@ -79,6 +89,10 @@ OSystem::~OSystem() {
 
 	delete _fsFactory;
 	_fsFactory = 0;
+
+	// The subclasses have stopped the mixer by now, and the threads of the
+	// pool and the timer are gone as well, so no zones are recorded anymore
+	Common::Profiler::destroy();
 }
 
 void OSystem::initBackend() {
@@ -101,6 +115,12 @@ void OSystem::initBackend() {
 	// set it.
 // 	if (!_fsFactory)
 // 		error("Backend failed to instantiate fs factory");
+
+	// Ports without thread support get a pool running tasks right away.
+	// It is created here, before any other thread may ask for it, instead
+	// of in getThreadPool().
+	if (!_threadPool)
+		_threadPool = new Common::SerialThreadPool();
 }
 
 bool OSystem::setGraphicsMode(const char *name) {
@@ -160,6 +180,15 @@ Common::TimerManager *OSystem::getTimerManager() {
 	return _timerManager;
 }
 
+uint64 OSystem::getMicros() {
+	return (uint64)getMillis(true) * 1000;
+}
+
+Common::ThreadPool *OSystem::getThreadPool() {
+	assert(_threadPool);
+	return _threadPool;
+}
+
 Common::SaveFileManager *OSystem::getSavefileManager() {
 #ifdef ENABLE_EVENTRECORDER
 	return g_eventRec.getSaveManager(_savefileManager);
@@ -48,6 +48,7 @@ class TaskbarManager;
 #if defined(USE_UPDATES)
 class UpdateManager;
 #endif
+class ThreadPool;
 class TimerManager;
 class SeekableReadStream;
 class WriteStream;
@@ -178,6 +179,15 @@ protected:
 	Common::UpdateManager *_updateManager;
 #endif
 
+	/**
+	 * If no value has been set for _threadPool by the backend,
+	 * initBackend() creates a Common::SerialThreadPool.
+	 *
+	 * @note _threadPool is deleted by the OSystem destructor, before
+	 *       any other manager.
+	 */
+	Common::ThreadPool *_threadPool;
+
 	/**
 	 * No default value is provided for _fsFactory by OSystem.
 	 *
@@ -899,6 +909,16 @@ public:
 	*/
 	virtual uint32 getMillis(bool skipRecord = false) = 0;
 
+	/**
+	 * Get a timestamp in microseconds, meant for measuring short intervals
+	 * (e.g. for profiling). The starting point is unspecified, and unlike
+	 * getMillis() it is never recorded by the event recorder.
+	 *
+	 * The default implementation is based on getMillis(), and thus only has
+	 * millisecond precision.
+	 */
+	virtual uint64 getMicros();
+
 	/** Delay/sleep for the specified amount of milliseconds. */
 	virtual void delayMillis(uint msecs) = 0;
 
@@ -1116,6 +1136,17 @@ public:
 	}
 #endif
 
+	/**
+	 * Returns the ThreadPool, used to run work on background threads.
+	 * On ports without thread support, the returned pool runs all tasks
+	 * on the calling thread.
+	 *
+	 * @note This may only be called once initBackend() has been called.
+	 *
+	 * @return the ThreadPool for the current architecture
+	 */
+	Common::ThreadPool *getThreadPool();
+
 	/**
 	 * Returns the FilesystemFactory object, depending on the current architecture.
 	 *
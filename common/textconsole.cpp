@@ -23,6 +23,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_exit
 
 #include "common/textconsole.h"
+#include "common/config-manager.h"
 #include "common/system.h"
 #include "common/str.h"
 
@@ -95,6 +96,14 @@ void NORETURN_PRE error(const char *s, ...) {
 	// TODO: Think of a good fallback in case we do not have
 	// any OSystem yet.
 
+	// Don't lose config changes still waiting for the flush delay. The
+	// flag guards against errors raised while writing the config file.
+	static bool flushingConfig = false;
+	if (!flushingConfig && Common::ConfigManager::hasInstance() && ConfMan.hasPendingFlush()) {
+		flushingConfig = true;
+		ConfMan.flushToDisk(true);
+	}
+
 	// If there is an error handler, invoke it now
 	if (Common::s_errorHandler)
 		(*Common::s_errorHandler)(buf_output);
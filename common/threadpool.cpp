@@ -0,0 +1,115 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/threadpool.h"
+#include "common/array.h"
+#include "common/util.h"
+
+namespace Common {
+
+namespace {
+
+/** A task calling a functor for a range of indices. */
+class RangeTask : public ThreadTask {
+public:
+	RangeTask(const Functor1<uint, void> &func, uint begin, uint end) : _func(func), _begin(begin), _end(end) {}
+
+	virtual void run() {
+		for (uint i = _begin; i < _end; ++i)
+			_func(i);
+	}
+
+private:
+	const Functor1<uint, void> &_func;
+	uint _begin, _end;
+};
+
+} // End of anonymous namespace
+
+void ThreadPool::parallelFor(uint begin, uint end, const Functor1<uint, void> &func, uint grainSize) {
+	if (begin >= end)
+		return;
+
+	const uint count = end - begin;
+
+	// Use a few chunks per thread, so that threads finishing early can
+	// pick up some of the remaining work.
+	const uint chunkSize = MAX<uint>(count / ((getThreadCount() + 1) * 4), MAX<uint>(grainSize, 1));
+
+	if (getThreadCount() == 0 || chunkSize >= count) {
+		for (uint i = begin; i < end; ++i)
+			func(i);
+		return;
+	}
+
+	// The last chunk is handled by the calling thread, which only waits
+	// for the others afterwards
+	Array<RangeTask *> tasks;
+	uint index = begin;
+	for (; index + chunkSize < end; index += chunkSize) {
+		tasks.push_back(new RangeTask(func, index, index + chunkSize));
+		submit(tasks.back());
+	}
+
+	for (; index < end; ++index)
+		func(index);
+
+	for (uint i = 0; i < tasks.size(); ++i) {
+		wait(tasks[i]);
+		delete tasks[i];
+	}
+}
+
+void SerialThreadPool::submit(ThreadTask *task) {
+	markQueued(task);
+	task->run();
+	markFinished(task);
+
+	if (isDetached(task))
+		delete task;
+}
+
+bool SerialThreadPool::trySubmit(ThreadTask *task) {
+	// Only busy if it submits itself from within run()
+	if (isBusy(task))
+		return false;
+
+	submit(task);
+	return true;
+}
+
+void SerialThreadPool::detach(ThreadTask *task) {
+	if (isBusy(task))
+		markDetached(task);
+	else
+		delete task;
+}
+
+bool SerialThreadPool::isFinished(const ThreadTask *task) {
+	return hasFinished(task);
+}
+
+void SerialThreadPool::wait(const ThreadTask *task) {
+	assert(hasFinished(task));
+}
+
+} // End of namespace Common
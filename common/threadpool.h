@@ -0,0 +1,315 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include "common/scummsys.h"
+#include "common/func.h"
+#include "common/noncopyable.h"
+#include "common/ptr.h"
+
+namespace Common {
+
+class ThreadPool;
+
+/**
+ * A unit of work which can be run by a ThreadPool.
+ *
+ * The run() method of a task may be called on any thread, so everything it
+ * touches has to be either private to the task or properly locked.
+ */
+class ThreadTask : NonCopyable {
+public:
+	ThreadTask() : _finished(false), _busy(false), _detached(false), _prev(0), _next(0) {}
+	virtual ~ThreadTask() {}
+
+	virtual void run() = 0;
+
+private:
+	friend class ThreadPool;
+
+	// These are only accessed by the pool (and under its lock)
+
+	/** Set once run() returned. */
+	bool _finished;
+	/** Set while the task is queued or running. */
+	bool _busy;
+	/** Set if the pool has to delete the task once it finished. */
+	bool _detached;
+	/** Links of the queue the task waits in, so that queuing needs no memory. */
+	ThreadTask *_prev, *_next;
+};
+
+/**
+ * A task running a functor and storing its result.
+ */
+template<class T>
+class FunctorTask : public ThreadTask {
+public:
+	/** Create a task for the given functor, which the task takes ownership of. */
+	FunctorTask(Functor0<T> *func) : _func(func), _result() {}
+	~FunctorTask() { delete _func; }
+
+	virtual void run() { _result = (*_func)(); }
+
+	const T &getResult() const { return _result; }
+
+private:
+	Functor0<T> *_func;
+	T _result;
+};
+
+template<>
+class FunctorTask<void> : public ThreadTask {
+public:
+	FunctorTask(Functor0<void> *func) : _func(func) {}
+	~FunctorTask() { delete _func; }
+
+	virtual void run() { (*_func)(); }
+
+	void getResult() const {}
+
+private:
+	Functor0<void> *_func;
+};
+
+/**
+ * Deleter used by Future, making sure that a task has finished before it is
+ * deleted.
+ */
+template<class T>
+struct FutureTaskDeleter {
+	ThreadPool *_pool;
+
+	FutureTaskDeleter(ThreadPool *pool) : _pool(pool) {}
+	void operator()(FunctorTask<T> *task);
+};
+
+/**
+ * The result of a task started through ThreadPool::async().
+ *
+ * Copies of a future refer to the same task. When the last copy goes away,
+ * it waits for the task to finish. Futures themselves are not thread safe,
+ * i.e. all copies of a future must be used on the same thread.
+ */
+template<class T>
+class Future {
+public:
+	Future() : _pool(0) {}
+
+	/** Whether this future refers to a task at all. */
+	bool isValid() const { return _task; }
+
+	/**
+	 * Check whether the task has finished, without blocking. A future not
+	 * referring to a task is never ready.
+	 */
+	bool isReady() const;
+
+	/** Wait for the task to finish. Returns at once if there is no task. */
+	void wait() const;
+
+	/** Wait for the task to finish and return its result. Requires a task. */
+	const T &get() const { wait(); return _task->getResult(); }
+
+private:
+	friend class ThreadPool;
+
+	Future(ThreadPool *pool, FunctorTask<T> *task) : _pool(pool), _task(task, FutureTaskDeleter<T>(pool)) {}
+
+	ThreadPool *_pool;
+	SharedPtr<FunctorTask<T> > _task;
+};
+
+template<>
+class Future<void> {
+public:
+	Future() : _pool(0) {}
+
+	bool isValid() const { return _task; }
+	bool isReady() const;
+	void wait() const;
+	void get() const { wait(); }
+
+private:
+	friend class ThreadPool;
+
+	Future(ThreadPool *pool, FunctorTask<void> *task) : _pool(pool), _task(task, FutureTaskDeleter<void>(pool)) {}
+
+	ThreadPool *_pool;
+	SharedPtr<FunctorTask<void> > _task;
+};
+
+/**
+ * A pool of threads running tasks in the background.
+ *
+ * The pool for the current port is returned by OSystem::getThreadPool().
+ * Ports without thread support use a SerialThreadPool, which runs each
+ * task on the calling thread as soon as it is submitted. Code using the
+ * pool therefore must not depend on tasks actually running concurrently.
+ *
+ * A task waiting for another task (through wait(), a Future or
+ * parallelFor()) runs other queued tasks in the meantime, so it is safe to
+ * wait from within a task. Other threads just block while waiting.
+ */
+class ThreadPool : NonCopyable {
+public:
+	virtual ~ThreadPool() {}
+
+	/**
+	 * Return the number of threads running tasks in the background. This
+	 * is 0 if tasks are run on the thread submitting them.
+	 */
+	virtual uint getThreadCount() const = 0;
+
+	/**
+	 * Queue a task to be run. The task is not owned by the pool and must
+	 * stay valid until it has finished.
+	 */
+	virtual void submit(ThreadTask *task) = 0;
+
+	/**
+	 * Queue a task without blocking or allocating memory, for threads which
+	 * must not wait, like the audio callback. Unlike with submit(), the task
+	 * may have been submitted before, it is only queued again once it has
+	 * finished.
+	 *
+	 * @return whether the task was queued. If it was not, because it is
+	 *         still queued or running or the pool is in use by another
+	 *         thread, the caller should try again later.
+	 */
+	virtual bool trySubmit(ThreadTask *task) = 0;
+
+	/**
+	 * Hand a submitted task over to the pool, which deletes it once it has
+	 * finished, without waiting for that. The task must not be used by the
+	 * caller anymore.
+	 */
+	virtual void detach(ThreadTask *task) = 0;
+
+	/** Check whether a submitted task has finished, without blocking. */
+	virtual bool isFinished(const ThreadTask *task) = 0;
+
+	/**
+	 * Wait until a submitted task has finished. When called from within a
+	 * task, other queued tasks may be run while waiting.
+	 */
+	virtual void wait(const ThreadTask *task) = 0;
+
+	/**
+	 * Run a functor as a task.
+	 *
+	 * @param func	the functor to run, the task takes ownership of it
+	 * @return a future for the result of the functor
+	 */
+	template<class T>
+	Future<T> async(Functor0<T> *func) {
+		FunctorTask<T> *task = new FunctorTask<T>(func);
+		Future<T> future(this, task);
+		submit(task);
+		return future;
+	}
+
+	/**
+	 * Call a functor for every index in the range [begin, end), spread
+	 * over the threads of the pool, and wait for all calls to return.
+	 *
+	 * The functor is called concurrently and in no particular order.
+	 *
+	 * @param begin		the first index
+	 * @param end		the index after the last one
+	 * @param func		the functor to call for each index
+	 * @param grainSize	the minimum number of indices handled by one task
+	 */
+	void parallelFor(uint begin, uint end, const Functor1<uint, void> &func, uint grainSize = 1);
+
+protected:
+	// All of these must be called under the pool's lock, if any
+
+	/** Mark a task as queued, clearing the finished mark of a previous run. */
+	static void markQueued(ThreadTask *task) { task->_finished = false; task->_busy = true; }
+
+	/** Mark a task as finished. */
+	static void markFinished(ThreadTask *task) { task->_finished = true; task->_busy = false; }
+
+	/** Check the finished mark of a task. */
+	static bool hasFinished(const ThreadTask *task) { return task->_finished; }
+
+	/** Check whether a task is queued or running. */
+	static bool isBusy(const ThreadTask *task) { return task->_busy; }
+
+	/** Mark a task to be deleted once it finished. */
+	static void markDetached(ThreadTask *task) { task->_detached = true; }
+
+	/** Check whether a task has to be deleted once it finished. */
+	static bool isDetached(const ThreadTask *task) { return task->_detached; }
+
+	/** The links of the queue a task waits in. */
+	static ThreadTask *&prevTask(ThreadTask *task) { return task->_prev; }
+	static ThreadTask *&nextTask(ThreadTask *task) { return task->_next; }
+};
+
+/**
+ * A thread pool without any threads, for ports lacking thread support.
+ * Tasks are run right away when they are submitted.
+ */
+class SerialThreadPool : public ThreadPool {
+public:
+	virtual uint getThreadCount() const { return 0; }
+
+	virtual void submit(ThreadTask *task);
+	virtual bool trySubmit(ThreadTask *task);
+	virtual void detach(ThreadTask *task);
+	virtual bool isFinished(const ThreadTask *task);
+	virtual void wait(const ThreadTask *task);
+};
+
+template<class T>
+void FutureTaskDeleter<T>::operator()(FunctorTask<T> *task) {
+	_pool->wait(task);
+	delete task;
+}
+
+template<class T>
+bool Future<T>::isReady() const {
+	return _task && _pool->isFinished(_task.get());
+}
+
+template<class T>
+void Future<T>::wait() const {
+	if (_task)
+		_pool->wait(_task.get());
+}
+
+inline bool Future<void>::isReady() const {
+	return _task && _pool->isFinished(_task.get());
+}
+
+inline void Future<void>::wait() const {
+	if (_task)
+		_pool->wait(_task.get());
+}
+
+} // End of namespace Common
+
+#endif
@@ -24,6 +24,7 @@
 #define COMMON_TIMER_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/str.h"
 #include "common/noncopyable.h"
 
@@ -33,6 +34,34 @@ class TimerManager : NonCopyable {
 public:
 	typedef void (*TimerProc)(void *refCon);
 
+	enum {
+		/**
+		 * Number of buckets in the histograms of TimerStats. Bucket 0 counts
+		 * values below 1ms, bucket i values from 2^(i-1) up to 2^i ms. The
+		 * last bucket counts everything above.
+		 */
+		kStatsBuckets = 8
+	};
+
+	/**
+	 * How punctually an installed timer is invoked. All times are in
+	 * microseconds.
+	 */
+	struct TimerStats {
+		String id;
+		int32 interval;
+		uint32 calls;
+
+		/** How late the calls were compared to when they were scheduled. */
+		uint64 totalLateness;
+		uint32 maxLateness;
+		uint32 lateness[kStatsBuckets];
+
+		/** How much the time between two calls differed from the interval. */
+		uint32 maxJitter;
+		uint32 jitter[kStatsBuckets];
+	};
+
 	virtual ~TimerManager() {}
 
 	/**
@@ -55,6 +84,17 @@ public:
 	 * and no instance of this callback will be running anymore.
 	 */
 	virtual void removeTimerProc(TimerProc proc) = 0;
+
+	/**
+	 * Get the statistics of all installed timers. Timer managers which
+	 * don't keep any return none.
+	 */
+	virtual void getTimerStats(Array<TimerStats> &stats) const { stats.clear(); }
+
+	/**
+	 * Start collecting the statistics of all installed timers from scratch.
+	 */
+	virtual void resetTimerStats() {}
 };
 
 } // End of namespace Common
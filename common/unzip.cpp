@@ -106,6 +106,12 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/threadpool.h"
+#include "common/zlib.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -380,6 +386,7 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _sharedStream; /* owner of _stream, shared with member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -542,6 +549,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_sharedStream = Common::SharedPtr<Common::SeekableReadStream>(stream);
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -593,7 +601,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -642,7 +649,6 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -1032,6 +1038,32 @@ static int unzlocal_CheckCurrentFileCoherencyHeader(unz_s* s, uInt* piSizeVar,
 	return err;
 }
 
+/*
+  Get the position of the current file's (possibly compressed) data in the
+  zipfile, as an absolute offset into its stream.
+  If there is no error, the return value is UNZ_OK.
+*/
+static int unzlocal_GetCurrentFileDataOffset(unzFile file, uLong *poffset) {
+	uInt iSizeVar;
+	unz_s* s;
+	uLong offset_local_extrafield;
+	uInt  size_local_extrafield;
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	if (!s->current_file_ok)
+		return UNZ_PARAMERROR;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s,&iSizeVar,
+				&offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
+		return UNZ_BADZIPFILE;
+
+	*poffset = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER +
+	           iSizeVar + s->byte_before_the_zipfile;
+	return UNZ_OK;
+}
+
 /*
   Open for reading data the current file in the zipfile.
   If there is no error and the file is opened, the return value is UNZ_OK.
@@ -1418,47 +1450,188 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 namespace Common {
 
 
-class ZipArchive : public Archive {
-	unzFile _zipFile;
+namespace {
+
+/**
+ * A sub stream onto a part of the ZIP file, which keeps the ZIP file's
+ * stream alive for as long as it is used. Several of these can be in
+ * use at the same time.
+ *
+ * Sub streams onto stored members verify the CRC of the data read, like
+ * unzCloseCurrentFile() does: the checksum follows sequential reads, and
+ * once it covers the whole member, a mismatch sets the err() flag.
+ */
+class ZipSubReadStream : public SafeSeekableSubReadStream {
+	SharedPtr<SeekableReadStream> _zipStream;
+
+	bool _checkCrc;
+	bool _crcError;
+	uint32 _crcWanted;
+	uint32 _crcData;
+	uint32 _checked;   ///< Size of the member prefix _crcData covers.
+
+	void checksum(uint32 start, const byte *data, uint32 len);
 
 public:
-	ZipArchive(unzFile zipFile);
+	/** A sub stream onto data that isn't checksummed, e.g. deflated data. */
+	ZipSubReadStream(const SharedPtr<SeekableReadStream> &zipStream, uint32 begin, uint32 end) :
+		SafeSeekableSubReadStream(zipStream.get(), begin, end), _zipStream(zipStream),
+		_checkCrc(false), _crcError(false), _crcWanted(0), _crcData(0), _checked(0) {
+		// Stored members of a memory mapped archive are handed out as views
+		shareParentData();
+	}
+
+	/** A sub stream onto a stored member, with the given CRC. */
+	ZipSubReadStream(const SharedPtr<SeekableReadStream> &zipStream, uint32 begin, uint32 end, uint32 crc) :
+		SafeSeekableSubReadStream(zipStream.get(), begin, end), _zipStream(zipStream),
+		_checkCrc(false), _crcError(false), _crcWanted(crc), _crcData(0), _checked(0) {
+#ifdef USE_ZLIB
+		// Without zlib, there's no crc32(), and unzip doesn't verify either
+		_checkCrc = (begin < end);
+#endif
+		shareParentData();
+	}
+
+	virtual bool err() const { return _crcError || SafeSeekableSubReadStream::err(); }
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 start = pos();
+		const uint32 len = SafeSeekableSubReadStream::read(dataPtr, dataSize);
 
+		checksum(start, (const byte *)dataPtr, len);
+		return len;
+	}
+
+	virtual SeekableReadStream *readStream(uint32 dataSize) {
+		const uint32 start = pos();
+		SeekableReadStream *stream = SafeSeekableSubReadStream::readStream(dataSize);
 
-	~ZipArchive();
+		// Without a view, the data went through read() already
+		if (!_checkCrc || !_shareParentData || (start > _checked))
+			return stream;
+
+		// Views bypass read(), so checksum their data here
+		byte buffer[4096];
+		uint32 done = 0;
+		while (uint32 len = stream->read(buffer, sizeof(buffer))) {
+			checksum(start + done, buffer, len);
+			done += len;
+		}
 
-	virtual bool hasFile(const String &name) const;
-	virtual int listMembers(ArchiveMemberList &list) const;
-	virtual const ArchiveMemberPtr getMember(const String &name) const;
-	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
+		stream->seek(0);
+		return stream;
+	}
 };
 
-/*
-class ZipArchiveMember : public ArchiveMember {
-	unzFile _zipFile;
+void ZipSubReadStream::checksum(uint32 start, const byte *data, uint32 len) {
+#ifdef USE_ZLIB
+	// Only data continuing the checksummed prefix can be added to it
+	if (!_checkCrc || (start > _checked) || (start + len <= _checked))
+		return;
+
+	const uint32 skip = _checked - start;
+	_crcData = crc32(_crcData, data + skip, len - skip);
+	_checked += len - skip;
 
+	if (_checked < (uint32)size())
+		return;
+
+	_checkCrc = false;
+	if (_crcData != _crcWanted) {
+		warning("ZipSubReadStream: CRC mismatch in stored member");
+		_crcError = true;
+	}
+#endif
+}
+
+} // End of anonymous namespace
+
+/**
+ * Inflate, or just copy, the raw data of a member and verify its CRC.
+ * The data is read up front, so that this doesn't touch the ZIP file.
+ */
+class ZipArchive::PrefetchTask : public ThreadTask {
 public:
-	ZipArchiveMember(FSNode &node) : _node(node) {
+	PrefetchTask(byte *raw, uint32 rawSize, uint16 method, uint32 size, uint32 crc) :
+		_raw(raw), _rawSize(rawSize), _method(method), _crc(crc), _data(0), _size(size) {
 	}
 
-	String getName() const {
-		...
+	~PrefetchTask() {
+		free(_raw);
+		free(_data);
 	}
 
-	SeekableReadStream *open() {
-		...
+	virtual void run() {
+		if (_method == 0) {
+			_data = _raw;
+			_raw = 0;
+		} else {
+			_data = (byte *)malloc(_size);
+			assert(_data);
+
+#ifdef USE_ZLIB
+			const bool inflated = (_method == Z_DEFLATED) &&
+				inflateZlibHeaderless(_data, _size, _raw, _rawSize);
+#else
+			const bool inflated = false;
+#endif
+
+			free(_raw);
+			_raw = 0;
+
+			if (!inflated) {
+				free(_data);
+				_data = 0;
+				return;
+			}
+		}
+
+#ifdef USE_ZLIB
+		if (_size > 0 && crc32(0, _data, _size) != _crc) {
+			free(_data);
+			_data = 0;
+		}
+#endif
+	}
+
+	/** Take the prefetched data, or 0 if prefetching failed. */
+	SeekableReadStream *takeStream() {
+		if (!_data && _size > 0)
+			return 0;
+
+		SeekableReadStream *stream = new MemoryReadStream(_data, _size, DisposeAfterUse::YES);
+		_data = 0;
+		return stream;
 	}
+
+private:
+	byte *_raw;
+	uint32 _rawSize;
+	uint16 _method;
+	uint32 _crc;
+
+	byte *_data;
+	uint32 _size;
 };
-*/
 
-ZipArchive::ZipArchive(unzFile zipFile) : _zipFile(zipFile) {
+ZipArchive::ZipArchive(void *zipFile) : _zipFile(zipFile), _streamingThreshold(0) {
 	assert(_zipFile);
 }
 
 ZipArchive::~ZipArchive() {
+	for (PrefetchMap::iterator it = _prefetched.begin(); it != _prefetched.end(); ++it)
+		finishPrefetch(it->_value);
+
 	unzClose(_zipFile);
 }
 
+void ZipArchive::finishPrefetch(const PrefetchedMember &member) {
+	if (member.pool)
+		member.pool->wait(member.task);
+
+	delete member.task;
+}
+
 bool ZipArchive::hasFile(const String &name) const {
 	return (unzLocateFile(_zipFile, name.c_str(), 2) == UNZ_OK);
 }
@@ -1484,46 +1657,172 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 }
 
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
+	// A prefetched member is handed out, and forgotten, right away
+	PrefetchMap::iterator prefetched = _prefetched.find(name);
+	if (prefetched != _prefetched.end()) {
+		PrefetchedMember member = prefetched->_value;
+		_prefetched.erase(prefetched);
+
+		if (member.pool)
+			member.pool->wait(member.task);
+
+		SeekableReadStream *stream = member.task->takeStream();
+		finishPrefetch(member);
+
+		// Otherwise, read it normally, which reports what went wrong
+		if (stream)
+			return stream;
+	}
+
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
+	return createReadStreamForCurrentMember();
+}
+
+void ZipArchive::setStreamingThreshold(uint32 threshold) {
+	_streamingThreshold = threshold;
+}
+
+uint32 ZipArchive::prefetch(const StringArray &names, ThreadPool *pool) {
+	unz_s *const archive = (unz_s *)_zipFile;
+
+	if (!pool && g_system)
+		pool = g_system->getThreadPool();
+
+	uint32 count = 0;
+
+	for (StringArray::const_iterator name = names.begin(); name != names.end(); ++name) {
+		if (_prefetched.contains(*name)) {
+			count++;
+			continue;
+		}
+
+		if (unzLocateFile(_zipFile, name->c_str(), 2) != UNZ_OK)
+			continue;
+
+		unz_file_info fileInfo;
+		if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+			continue;
+
+		uLong offset;
+		if (unzlocal_GetCurrentFileDataOffset(_zipFile, &offset) != UNZ_OK)
+			continue;
+
+		// Only the ZIP file is shared with the reading thread, so read the
+		// raw data here and leave the rest to the task
+		byte *raw = (byte *)malloc(MAX<uint32>(fileInfo.compressed_size, 1));
+		assert(raw);
+
+		if (!archive->_sharedStream->seek(offset) ||
+		    archive->_sharedStream->read(raw, fileInfo.compressed_size) != fileInfo.compressed_size) {
+			free(raw);
+			continue;
+		}
+
+		PrefetchedMember member;
+		member.task = new PrefetchTask(raw, fileInfo.compressed_size, fileInfo.compression_method,
+		                               fileInfo.uncompressed_size, fileInfo.crc);
+		member.pool = pool;
+
+		if (pool)
+			pool->submit(member.task);
+		else
+			member.task->run();
+
+		_prefetched[*name] = member;
+		count++;
+	}
+
+	return count;
+}
+
+uint32 ZipArchive::getDirectoryChecksum() const {
+	uint32 checksum = 0;
+	char name[UNZ_MAXFILENAMEINZIP + 1];
+
+	for (int err = unzGoToFirstFile(_zipFile); err == UNZ_OK; err = unzGoToNextFile(_zipFile)) {
+		unz_file_info fileInfo;
+		if (unzGetCurrentFileInfo(_zipFile, &fileInfo, name, sizeof(name), NULL, 0, NULL, 0) != UNZ_OK)
+			break;
+
+		checksum = checksum * 31 + hashit(name);
+		checksum = checksum * 31 + fileInfo.crc;
+		checksum = checksum * 31 + fileInfo.uncompressed_size;
+	}
+
+	return checksum;
+}
+
+SeekableReadStream *ZipArchive::createReadStreamForCurrentMember() const {
+	unz_s *const archive = (unz_s *)_zipFile;
+
 	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
+	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
 		return 0;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+	uLong offset;
+	if (unzlocal_GetCurrentFileDataOffset(_zipFile, &offset) != UNZ_OK)
 		return 0;
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
+	// Stored members can be read straight out of the ZIP file
+	if (fileInfo.compression_method == 0)
+		return new ZipSubReadStream(archive->_sharedStream, offset, offset + fileInfo.uncompressed_size, fileInfo.crc);
 
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
-		return 0;
+#ifdef USE_ZLIB
+	// Large deflated members are inflated while reading them
+	if ((fileInfo.compression_method == Z_DEFLATED) &&
+	    (_streamingThreshold > 0) && (fileInfo.uncompressed_size >= _streamingThreshold)) {
+
+		SeekableReadStream *compressed =
+			new ZipSubReadStream(archive->_sharedStream, offset, offset + fileInfo.compressed_size);
+
+		return wrapDeflateReadStream(compressed, fileInfo.uncompressed_size);
 	}
+#endif
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
+	byte *data;
+	uint32 size;
+	if (!inflateCurrentMember(data, size))
 		return 0;
+
+	return new MemoryReadStream(data, size, DisposeAfterUse::YES);
+}
+
+bool ZipArchive::inflateCurrentMember(byte *&data, uint32 &size) const {
+	unz_file_info fileInfo;
+	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
+		return false;
+
+	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+		return false;
+
+	data = (byte *)malloc(fileInfo.uncompressed_size);
+	size = fileInfo.uncompressed_size;
+	assert(data);
+
+	if (unzReadCurrentFile(_zipFile, data, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
+		free(data);
+		return false;
 	}
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
+		free(data);
+		return false;
+	}
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	return true;
 }
 
-Archive *makeZipArchive(const String &name) {
+ZipArchive *makeZipArchive(const String &name) {
 	return makeZipArchive(SearchMan.createReadStreamForMember(name));
 }
 
-Archive *makeZipArchive(const FSNode &node) {
+ZipArchive *makeZipArchive(const FSNode &node) {
 	return makeZipArchive(node.createReadStream());
 }
 
-Archive *makeZipArchive(SeekableReadStream *stream) {
+ZipArchive *makeZipArchive(SeekableReadStream *stream) {
 	if (!stream)
 		return 0;
 	unzFile zipFile = unzOpen(stream);
@@ -23,13 +23,95 @@
 #ifndef COMMON_UNZIP_H
 #define COMMON_UNZIP_H
 
+#include "common/archive.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/str.h"
+#include "common/str-array.h"
 
 namespace Common {
 
-class Archive;
 class FSNode;
 class SeekableReadStream;
+class ThreadPool;
+
+/**
+ * An Archive onto the contents of a ZIP file.
+ *
+ * Members stored without compression are handed out as sub streams of the
+ * ZIP file itself, which set their err() flag if their CRC doesn't match
+ * once they have been read completely. Deflated members are normally
+ * inflated into memory as a whole, but members above a configurable size
+ * can instead be inflated on the fly while reading them.
+ */
+class ZipArchive : public Archive {
+public:
+	/** Create a ZipArchive from a handle returned by unzOpen(). */
+	ZipArchive(void *zipFile);
+	~ZipArchive();
+
+	virtual bool hasFile(const String &name) const;
+	virtual int listMembers(ArchiveMemberList &list) const;
+	virtual const ArchiveMemberPtr getMember(const String &name) const;
+	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
+
+	/**
+	 * Set the uncompressed size from which on deflated members are inflated
+	 * on the fly instead of up front. 0, the default, disables that.
+	 *
+	 * Streams inflated on the fly don't need the whole member in memory,
+	 * but seeking backwards in them is expensive.
+	 */
+	void setStreamingThreshold(uint32 threshold);
+
+	/**
+	 * Start inflating the given members into memory, so that a following
+	 * createReadStreamForMember() can return them without any further work.
+	 *
+	 * The compressed data is read right away, while inflating it and
+	 * verifying its CRC runs on the given thread pool, or the system's one
+	 * if none is given. createReadStreamForMember() waits for a member that
+	 * is still being inflated, and falls back to reading it normally if
+	 * that failed.
+	 *
+	 * Each prefetched member is handed out once and then dropped from
+	 * the prefetch cache.
+	 *
+	 * @return the number of members found and being prefetched
+	 */
+	uint32 prefetch(const StringArray &names, ThreadPool *pool = 0);
+
+	/**
+	 * Compute a checksum over the central directory of the ZIP file, i.e.
+	 * over the names, sizes and CRCs of all members. It changes whenever
+	 * any member is added, removed or modified, without reading any data.
+	 */
+	uint32 getDirectoryChecksum() const;
+
+private:
+	class PrefetchTask;
+
+	struct PrefetchedMember {
+		PrefetchTask *task;
+		ThreadPool *pool;   ///< The pool running the task, or 0 if it already ran.
+	};
+
+	typedef HashMap<String, PrefetchedMember, IgnoreCase_Hash, IgnoreCase_EqualTo> PrefetchMap;
+
+	void *_zipFile;            ///< The unzFile handle.
+	uint32 _streamingThreshold;
+
+	mutable PrefetchMap _prefetched;
+
+	/** Read the member the ZIP file is currently positioned on. */
+	SeekableReadStream *createReadStreamForCurrentMember() const;
+
+	/** Wait for a prefetched member and drop it from the cache. */
+	static void finishPrefetch(const PrefetchedMember &member);
+
+	/** Inflate the member the ZIP file is currently positioned on into memory. */
+	bool inflateCurrentMember(byte *&data, uint32 &size) const;
+};
 
 /**
  * This factory method creates an Archive instance corresponding to the content
@@ -37,7 +119,7 @@ class SeekableReadStream;
  *
  * May return 0 in case of a failure.
  */
-Archive *makeZipArchive(const String &name);
+ZipArchive *makeZipArchive(const String &name);
 
 /**
  * This factory method creates an Archive instance corresponding to the content
@@ -45,7 +127,7 @@ Archive *makeZipArchive(const String &name);
  *
  * May return 0 in case of a failure.
  */
-Archive *makeZipArchive(const FSNode &node);
+ZipArchive *makeZipArchive(const FSNode &node);
 
 /**
  * This factory method creates an Archive instance corresponding to the content
@@ -55,7 +137,7 @@ Archive *makeZipArchive(const FSNode &node);
  *
  * May return 0 in case of a failure. In this case stream will still be deleted.
  */
-Archive *makeZipArchive(SeekableReadStream *stream);
+ZipArchive *makeZipArchive(SeekableReadStream *stream);
 
 } // End of namespace Common
 
@@ -23,13 +23,13 @@
 #ifndef COMMON_WINEXE_NE_H
 #define COMMON_WINEXE_NE_H
 
+#include "common/array.h"
 #include "common/list.h"
 #include "common/str.h"
 #include "common/winexe.h"
 
 namespace Common {
 
-template<class T> class Array;
 class SeekableReadStream;
 
 /** The default Windows resources. */
@@ -80,53 +80,34 @@ void XMLParser::close() {
 bool XMLParser::parserError(const String &errStr) {
 	_state = kParserError;
 
-	const int startPosition = _stream->pos();
-	int currentPosition = startPosition;
+	// Point right behind the offending character
+	const char *position = MIN(_pos + 1, _textEnd);
 	int lineCount = 1;
-	char c = 0;
 
-	_stream->seek(0, SEEK_SET);
-
-	while (currentPosition--) {
-		c = _stream->readByte();
-
-		if (c == '\n' || c == '\r')
+	for (const char *c = _text; c < position; ++c) {
+		if (*c == '\n' || *c == '\r')
 			lineCount++;
 	}
 
-	assert(_stream->pos() == startPosition);
-	currentPosition = startPosition;
-
-	int keyOpening = 0;
-	int keyClosing = 0;
-
-	while (currentPosition-- && keyOpening == 0) {
-		_stream->seek(-2, SEEK_CUR);
-		c = _stream->readByte();
+	// Find the key around the error position
+	const char *keyOpening = position;
+	const char *keyClosing = 0;
 
-		if (c == '<')
-			keyOpening = currentPosition - 1;
-		else if (c == '>')
-			keyClosing = currentPosition;
+	while (keyOpening > _text && *keyOpening != '<') {
+		keyOpening--;
+		if (*keyOpening == '>' && !keyClosing)
+			keyClosing = keyOpening + 1;
 	}
 
-	_stream->seek(startPosition, SEEK_SET);
-	currentPosition = startPosition;
-	while (keyClosing == 0 && c && currentPosition++) {
-		c = _stream->readByte();
-
-		if (c == '>')
-			keyClosing = currentPosition;
+	if (!keyClosing) {
+		keyClosing = position;
+		while (keyClosing < _textEnd && *keyClosing && *keyClosing++ != '>')
+			;
 	}
 
 	Common::String errorMessage = Common::String::format("\n  File <%s>, line %d:\n", _fileName.c_str(), lineCount);
 
-	currentPosition = (keyClosing - keyOpening);
-	_stream->seek(keyOpening, SEEK_SET);
-
-	while (currentPosition--)
-		errorMessage += (char)_stream->readByte();
-
+	errorMessage += String(keyOpening, keyClosing);
 	errorMessage += "\n\nParser error: ";
 	errorMessage += errStr;
 	errorMessage += "\n\n";
@@ -162,12 +143,13 @@ bool XMLParser::parseActiveKey(bool closed) {
 		return parseXMLHeader(key) && closeKey();
 	}
 
+	// The layout was usually looked up already when the key name was parsed
 	XMLKeyLayout *layout = (_activeKey.size() == 1) ? _XMLkeys : getParentNode(key)->layout;
-
-	if (layout->children.contains(key->name)) {
+	if (!key->layout && layout->children.contains(key->name))
 		key->layout = layout->children[key->name];
 
-		StringMap localMap = key->values;
+	if (key->layout) {
+		const StringMap &localMap = key->values;
 		int keyCount = localMap.size();
 
 		for (List<XMLKeyLayout::XMLKeyProperty>::const_iterator i = key->layout->properties.begin(); i != key->layout->properties.end(); ++i) {
@@ -207,34 +189,33 @@ bool XMLParser::parseActiveKey(bool closed) {
 	return true;
 }
 
-bool XMLParser::parseKeyValue(String keyName) {
+bool XMLParser::parseKeyValue(const String &keyName) {
 	assert(_activeKey.empty() == false);
 
 	if (_activeKey.top()->values.contains(keyName))
 		return false;
 
-	_token.clear();
 	char stringStart;
 
 	if (_char == '"' || _char == '\'') {
 		stringStart = _char;
-		_char = _stream->readByte();
+		nextChar();
 
-		while (_char && _char != stringStart) {
-			_token += _char;
-			_char = _stream->readByte();
-		}
+		_tokenStart = _pos;
+		while (_char && _char != stringStart)
+			nextChar();
+		_tokenEnd = _pos;
 
 		if (_char == 0)
 			return false;
 
-		_char = _stream->readByte();
+		nextChar();
 
 	} else if (!parseToken()) {
 		return false;
 	}
 
-	_activeKey.top()->values[keyName] = _token;
+	_activeKey.top()->values[keyName] = tokenString();
 	return true;
 }
 
@@ -300,9 +281,28 @@ bool XMLParser::parse() {
 	if (_stream == 0)
 		return false;
 
-	// Make sure we are at the start of the stream.
+	// Read the whole stream in one go. The tokenizer then walks through the
+	// text directly, and only creates Strings for the values it stores.
 	_stream->seek(0, SEEK_SET);
+	int32 size = MAX<int32>(_stream->size(), 0);
+	char *text = new char[size];
+	size = _stream->read(text, size);
 
+	_text = text;
+	_textEnd = text + size;
+	_pos = _text;
+	_char = (_pos < _textEnd) ? *_pos : 0;
+
+	bool result = parseText();
+
+	delete[] text;
+	_text = _textEnd = _pos = _tokenStart = _tokenEnd = 0;
+	_char = 0;
+
+	return result;
+}
+
+bool XMLParser::parseText() {
 	if (_XMLkeys == 0)
 		buildLayout();
 
@@ -318,8 +318,6 @@ bool XMLParser::parse() {
 	_state = kParserNeedHeader;
 	_activeKey.clear();
 
-	_char = _stream->readByte();
-
 	while (_char && _state != kParserError) {
 		if (skipSpaces())
 			continue;
@@ -335,7 +333,8 @@ bool XMLParser::parse() {
 				break;
 			}
 
-			if ((_char = _stream->readByte()) == 0) {
+			nextChar();
+			if (_char == 0) {
 				parserError("Unexpected end of file.");
 				break;
 			}
@@ -346,10 +345,10 @@ bool XMLParser::parse() {
 					break;
 				}
 
-				_char = _stream->readByte();
+				nextChar();
 				activeHeader = true;
 			} else if (_char == '/') {
-				_char = _stream->readByte();
+				nextChar();
 				activeClosure = true;
 			} else if (_char == '?') {
 				parserError("Unexpected header. There may only be one XML header per file.");
@@ -366,17 +365,30 @@ bool XMLParser::parse() {
 			}
 
 			if (activeClosure) {
-				if (_activeKey.empty() || _token != _activeKey.top()->name) {
+				if (_activeKey.empty() || _activeKey.top()->name.size() != tokenLength() ||
+				    memcmp(_activeKey.top()->name.c_str(), _tokenStart, tokenLength())) {
 					parserError("Unexpected closure.");
 					break;
 				}
 			} else {
 				ParserNode *node = allocNode(); //new ParserNode;
-				node->name = _token;
 				node->ignore = false;
 				node->header = activeHeader;
 				node->depth = _activeKey.size();
 				node->layout = 0;
+
+				// Share the name with the layout if the key is known in
+				// the active scope. Unknown keys are reported once the
+				// whole key has been parsed.
+				XMLKeyLayout *scope = _activeKey.empty() ? _XMLkeys : _activeKey.top()->layout;
+				ChildMap::const_iterator child;
+				if (!activeHeader && scope && (child = scope->findChild(_tokenStart, tokenLength())) != scope->children.end()) {
+					node->name = child->_key;
+					node->layout = child->_value;
+				} else {
+					node->name = tokenString();
+				}
+
 				_activeKey.push(node);
 			}
 
@@ -397,7 +409,7 @@ bool XMLParser::parse() {
 				else
 					_state = kParserNeedKey;
 
-				_char = _stream->readByte();
+				nextChar();
 				break;
 			}
 
@@ -405,14 +417,14 @@ bool XMLParser::parse() {
 
 			if (_char == '/' || (_char == '?' && activeHeader)) {
 				selfClosure = true;
-				_char = _stream->readByte();
+				nextChar();
 			}
 
 			if (_char == '>') {
 				if (activeHeader && !selfClosure) {
 					parserError("XML Header must be self-closed.");
 				} else if (parseActiveKey(selfClosure)) {
-					_char = _stream->readByte();
+					nextChar();
 					_state = kParserNeedKey;
 				}
 
@@ -435,16 +447,22 @@ bool XMLParser::parse() {
 			else
 				_state = kParserNeedPropertyValue;
 
-			_char = _stream->readByte();
+			nextChar();
 			break;
 
-		case kParserNeedPropertyValue:
-			if (!parseKeyValue(_token))
+		case kParserNeedPropertyValue: {
+			// The property name is still the current token, as only
+			// whitespace and comments may follow it until the value.
+			XMLKeyLayout *layout = _activeKey.top()->layout;
+			const String *name = layout ? layout->findProperty(_tokenStart, tokenLength()) : 0;
+
+			if (!parseKeyValue(name ? *name : tokenString()))
 				parserError("Invalid key value.");
 			else
 				_state = kParserNeedPropertyName;
 
 			break;
+			}
 
 		default:
 			break;
@@ -465,39 +483,40 @@ bool XMLParser::skipSpaces() {
 		return false;
 
 	while (_char && isSpace(_char))
-		_char = _stream->readByte();
+		nextChar();
 
 	return true;
 }
 
 bool XMLParser::skipComments() {
 	if (_char == '<') {
-		_char = _stream->readByte();
-
-		if (_char != '!') {
-			_stream->seek(-1, SEEK_CUR);
-			_char = '<';
+		if (_pos + 1 >= _textEnd || _pos[1] != '!')
 			return false;
-		}
 
-		if (_stream->readByte() != '-' || _stream->readByte() != '-')
+		nextChar();
+		nextChar();
+		if (_char != '-')
+			return parserError("Malformed comment syntax.");
+		nextChar();
+		if (_char != '-')
 			return parserError("Malformed comment syntax.");
 
-		_char = _stream->readByte();
+		nextChar();
 
 		while (_char) {
 			if (_char == '-') {
-				if (_stream->readByte() == '-') {
-
-					if (_stream->readByte() != '>')
+				nextChar();
+				if (_char == '-') {
+					nextChar();
+					if (_char != '>')
 						return parserError("Malformed comment (double-hyphen inside comment body).");
 
-					_char = _stream->readByte();
+					nextChar();
 					return true;
 				}
 			}
 
-			_char = _stream->readByte();
+			nextChar();
 		}
 
 		return parserError("Comment has no closure.");
@@ -507,14 +526,38 @@ bool XMLParser::skipComments() {
 }
 
 bool XMLParser::parseToken() {
-	_token.clear();
+	_tokenStart = _pos;
 
-	while (isValidNameChar(_char)) {
-		_token += _char;
-		_char = _stream->readByte();
-	}
+	while (isValidNameChar(_char))
+		nextChar();
+
+	_tokenEnd = _pos;
 
 	return isSpace(_char) != 0 || _char == '>' || _char == '=' || _char == '/';
 }
 
+#pragma mark -
+
+XMLParser::ChildMap::const_iterator XMLParser::XMLKeyLayout::findChild(const char *name, uint32 length) const {
+	// Key layouts only have a handful of children, so it's quicker to
+	// compare them all than to build a String for a hash lookup. Only exact
+	// matches are shared, as callbacks compare the names case-sensitively.
+	ChildMap::const_iterator i;
+	for (i = children.begin(); i != children.end(); ++i) {
+		if (i->_key.size() == length && !memcmp(i->_key.c_str(), name, length))
+			break;
+	}
+
+	return i;
+}
+
+const String *XMLParser::XMLKeyLayout::findProperty(const char *name, uint32 length) const {
+	for (List<XMLKeyProperty>::const_iterator i = properties.begin(); i != properties.end(); ++i) {
+		if (i->name.size() == length && !memcmp(i->name.c_str(), name, length))
+			return &i->name;
+	}
+
+	return 0;
+}
+
 } // End of namespace Common
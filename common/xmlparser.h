@@ -92,7 +92,7 @@ public:
 	/**
 	 * Parser constructor.
 	 */
-	XMLParser() : _XMLkeys(0), _stream(0) {}
+	XMLParser() : _XMLkeys(0), _char(0), _pos(0), _text(0), _textEnd(0), _stream(0), _tokenStart(0), _tokenEnd(0) {}
 
 	virtual ~XMLParser();
 
@@ -114,7 +114,14 @@ public:
 
 	typedef HashMap<String, XMLParser::XMLKeyLayout*, IgnoreCase_Hash, IgnoreCase_EqualTo> ChildMap;
 
-	/** nested struct representing the layout of the XML file */
+	/**
+	 * Nested struct representing the layout of the XML file.
+	 *
+	 * The names of keys and properties stored in the layout double as the
+	 * interned key table of the parser: when a key or property name in the
+	 * file matches one of them, the parsed node shares the layout's String
+	 * instead of building a new one.
+	 */
 	struct XMLKeyLayout {
 		struct XMLKeyProperty {
 			String name;
@@ -129,6 +136,12 @@ public:
 		virtual ~XMLKeyLayout() {
 			properties.clear();
 		}
+
+		/** Find the child key with the given name, or return children.end(). */
+		ChildMap::const_iterator findChild(const char *name, uint32 length) const;
+
+		/** Find the property with the given name, or return 0. */
+		const String *findProperty(const char *name, uint32 length) const;
 	};
 
 	XMLKeyLayout *_XMLkeys;
@@ -262,7 +275,7 @@ protected:
 	/**
 	 * Parses the value of a given key. There's no reason to overload this.
 	 */
-	bool parseKeyValue(String keyName);
+	bool parseKeyValue(const String &keyName);
 
 	/**
 	 * Called once a key has been parsed. It handles the closing/cleanup of the
@@ -299,10 +312,17 @@ protected:
 	}
 
 	/**
-	 * Parses a the first textual token found.
+	 * Parses a the first textual token found. The token is not copied,
+	 * but referenced in the text being parsed.
 	 */
 	bool parseToken();
 
+	/** Return the length of the current token. */
+	uint32 tokenLength() const { return _tokenEnd - _tokenStart; }
+
+	/** Return the current token as a String. */
+	String tokenString() const { return String(_tokenStart, _tokenEnd); }
+
 	/**
 	 * Parses the values inside an integer key.
 	 * The count parameter specifies the number of values inside
@@ -337,14 +357,33 @@ protected:
 	List<XMLKeyLayout *> _layoutList;
 
 private:
-	char _char;
+	/**
+	 * Advance to the next character of the text. Once the end of the
+	 * text is reached, _char stays 0.
+	 */
+	void nextChar() {
+		if (_pos < _textEnd)
+			_pos++;
+		_char = (_pos < _textEnd) ? *_pos : 0;
+	}
+
+	/** Parse the text read from _stream. */
+	bool parseText();
+
+	char _char; /** Current character */
+	const char *_pos; /** Position of the current character in the text */
+	const char *_text; /** The text to parse, read in one go from the stream */
+	const char *_textEnd;
+
 	SeekableReadStream *_stream;
 	String _fileName;
 
 	ParserState _state; /** Internal state of the parser */
 
 	String _error; /** Current error message */
-	String _token; /** Current text token */
+
+	const char *_tokenStart; /** Current text token, referencing the text */
+	const char *_tokenEnd;
 
 	Stack<ParserNode *> _activeKey; /** Node stack of the parsed keys */
 };
@@ -24,6 +24,7 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -141,19 +142,41 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
 	return true;
 }
 
-#ifndef RELEASE_BUILD
+// inflateGetDictionary() is needed to store checkpoints for seeking
+#if ZLIB_VERNUM >= 0x1271
+#define GZIP_SEEK_INDEX
+#endif
+
+#if !defined(RELEASE_BUILD) && !defined(GZIP_SEEK_INDEX)
 static bool _shownBackwardSeekingWarning = false;
 #endif
 
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * Assumes the compressed data to be in gzip format, or, if headerless is set,
+ * to be raw deflate data.
+ *
+ * While reading, the state of the decompressor is saved every
+ * CHECKPOINT_INTERVAL bytes of output (at the next deflate block boundary).
+ * Seeking then resumes decompression from the nearest checkpoint, instead of
+ * restarting at the beginning of the file for every backward seek.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+		WINDOWSIZE = 32768,		// Size of the deflate window
+		CHECKPOINT_INTERVAL = 256 * 1024
+	};
+
+	/** The state needed to resume decompression at a block boundary. */
+	struct Checkpoint {
+		uint32 outPos;		///< Position in the uncompressed data
+		uint32 inPos;		///< Position in the wrapped stream
+		int bits;			///< Number of bits of the byte before inPos still to be decoded
+		uint32 windowSize;
+		byte *window;		///< The last (up to) WINDOWSIZE bytes of output before outPos
 	};
 
 	byte	_buf[BUFSIZE];
@@ -161,19 +184,106 @@ protected:
 	ScopedPtr<SeekableReadStream> _wrapped;
 	z_stream _stream;
 	int _zlibErr;
+	int _windowBits;
 	uint32 _pos;
 	uint32 _origSize;
 	bool _eos;
 
+	Array<Checkpoint> _checkpoints;
+
+	void resetInflater(int windowBits) {
+		inflateEnd(&_stream);
+		_stream = z_stream();
+		_zlibErr = inflateInit2(&_stream, windowBits);
+
+		// Setup input buffer
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+	}
+
+#ifdef GZIP_SEEK_INDEX
+	/**
+	 * Remember the decompressor state, if inflate() stopped at a block
+	 * boundary far enough from the last checkpoint.
+	 */
+	void addCheckpoint(uint32 outPos) {
+		// Bit 7 is set at the end of a block, bit 6 if it was the last one
+		if ((_stream.data_type & 192) != 128)
+			return;
+		if (outPos < (_checkpoints.empty() ? 0 : _checkpoints.back().outPos) + CHECKPOINT_INTERVAL)
+			return;
+
+		Checkpoint checkpoint;
+		checkpoint.outPos = outPos;
+		checkpoint.inPos = _wrapped->pos() - _stream.avail_in;
+		checkpoint.bits = _stream.data_type & 7;
+		checkpoint.window = (byte *)malloc(WINDOWSIZE);
+		if (!checkpoint.window)
+			return;
+
+		uInt windowSize = WINDOWSIZE;
+		if (inflateGetDictionary(&_stream, checkpoint.window, &windowSize) != Z_OK) {
+			free(checkpoint.window);
+			return;
+		}
+		checkpoint.windowSize = windowSize;
+
+		_checkpoints.push_back(checkpoint);
+	}
+
+	/** Find the last checkpoint at or before the given position. */
+	const Checkpoint *findCheckpoint(uint32 pos) const {
+		const Checkpoint *checkpoint = 0;
+
+		uint first = 0, last = _checkpoints.size();
+		while (first < last) {
+			const uint mid = (first + last) / 2;
+			if (_checkpoints[mid].outPos <= pos) {
+				checkpoint = &_checkpoints[mid];
+				first = mid + 1;
+			} else {
+				last = mid;
+			}
+		}
+
+		return checkpoint;
+	}
+
+	/**
+	 * Restart decompression at the given checkpoint. After that, the
+	 * remaining data is raw deflate data, no matter the original format.
+	 */
+	bool restoreCheckpoint(const Checkpoint &checkpoint) {
+		resetInflater(-MAX_WBITS);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_wrapped->seek(checkpoint.inPos - (checkpoint.bits ? 1 : 0), SEEK_SET);
+		if (checkpoint.bits) {
+			const byte lastByte = _wrapped->readByte();
+			_zlibErr = inflatePrime(&_stream, checkpoint.bits, lastByte >> (8 - checkpoint.bits));
+			if (_zlibErr != Z_OK)
+				return false;
+		}
+
+		_zlibErr = inflateSetDictionary(&_stream, checkpoint.window, checkpoint.windowSize);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_pos = checkpoint.outPos;
+		return true;
+	}
+#endif
+
 public:
 
-	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0) : _wrapped(w), _stream() {
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0, bool headerless = false) : _wrapped(w), _stream() {
 		assert(w != 0);
 
 		// Verify file header is correct
 		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
+		uint16 header = headerless ? 0 : w->readUint16BE();
+		assert(headerless || header == 0x1F8B ||
 		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
 
 		if (header == 0x1F8B) {
@@ -194,7 +304,9 @@ public:
 		// the compressed file. This feature was added in zlib 1.2.0.4,
 		// released 10 August 2003.
 		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		// Negative MAX_WBITS tells zlib there's no header at all.
+		_windowBits = headerless ? -MAX_WBITS : MAX_WBITS + 32;
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -205,6 +317,9 @@ public:
 
 	~GZipReadStream() {
 		inflateEnd(&_stream);
+
+		for (uint i = 0; i < _checkpoints.size(); ++i)
+			free(_checkpoints[i].window);
 	}
 
 	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
@@ -224,7 +339,14 @@ public:
 				_stream.next_in = _buf;
 				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
 			}
+#ifdef GZIP_SEEK_INDEX
+			// Stop at each block boundary, to be able to add checkpoints
+			_zlibErr = inflate(&_stream, Z_BLOCK);
+			if (_zlibErr == Z_OK)
+				addCheckpoint(_pos + dataSize - _stream.avail_out);
+#else
 			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+#endif
 		}
 
 		// Update the position counter
@@ -262,12 +384,20 @@ public:
 
 		assert(newPos >= 0);
 
+#ifdef GZIP_SEEK_INDEX
+		// Resume from the nearest checkpoint, if it is closer than the
+		// current position (either backwards, or further ahead)
+		const Checkpoint *checkpoint = findCheckpoint(newPos);
+		if (checkpoint && (checkpoint->outPos > _pos || (uint32)newPos < _pos)) {
+			if (!restoreCheckpoint(*checkpoint))
+				return false;	// FIXME: STREAM REWRITE
+		} else
+#endif
 		if ((uint32)newPos < _pos) {
-			// To search backward, we have to restart the whole decompression
-			// from the start of the file. A rather wasteful operation, best
-			// to avoid it. :/
+			// To search backward without a checkpoint, we have to restart
+			// the whole decompression from the start of the file.
 
-#ifndef RELEASE_BUILD
+#if !defined(RELEASE_BUILD) && !defined(GZIP_SEEK_INDEX)
 			if (!_shownBackwardSeekingWarning) {
 				// We only throw this warning once per stream, to avoid
 				// getting the console swarmed with warnings when consecutive
@@ -279,11 +409,9 @@ public:
 
 			_pos = 0;
 			_wrapped->seek(0, SEEK_SET);
-			_zlibErr = inflateReset(&_stream);
+			resetInflater(_windowBits);
 			if (_zlibErr != Z_OK)
 				return false;	// FIXME: STREAM REWRITE
-			_stream.next_in = _buf;
-			_stream.avail_in = 0;
 		}
 
 		offset = newPos - _pos;
@@ -428,6 +556,16 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, ui
 	return toBeWrapped;
 }
 
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize) {
+#if defined(USE_ZLIB)
+	if (toBeWrapped)
+		return new GZipReadStream(toBeWrapped, knownSize, true);
+#else
+	delete toBeWrapped;
+#endif
+	return 0;
+}
+
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped)
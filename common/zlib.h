@@ -120,6 +120,21 @@ bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcL
  */
 SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize = 0);
 
+/**
+ * Take an arbitrary SeekableReadStream containing raw deflate data, without
+ * any zlib or gzip header, and wrap it in a custom stream which provides
+ * transparent on-the-fly decompression. Since raw deflate data carries no
+ * length, the size of the uncompressed data has to be supplied.
+ *
+ * If there is no ZLIB support, NULL is returned and the stream is destroyed.
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param toBeWrapped	the stream with the deflate data to be wrapped
+ * @param knownSize		the length of the uncompressed data
+ */
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize);
+
 /**
  * Take an arbitrary WriteStream and wrap it in a custom stream which provides
  * transparent on-the-fly compression. The compressed data is written in the
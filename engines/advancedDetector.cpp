@@ -372,7 +372,15 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 	// FIXME/TODO: We don't handle the case that a file is listed as a regular
 	// file and as one with resource fork.
 
+	ADMD5Cache &cache = ADMD5Cache::instance();
+
 	if (game.flags & ADGF_MACRESFORK) {
+		// Ask the cache before opening, and parsing, any of the fork files
+		Common::FSList candidates;
+		Common::MacResManager::listForkFiles(parent, fname, candidates);
+		if (cache.lookup(candidates, true, _md5Bytes, fileProps))
+			return true;
+
 		Common::MacResManager macResMan;
 
 		if (!macResMan.open(parent, fname))
@@ -380,19 +388,25 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 
 		fileProps.md5 = macResMan.computeResForkMD5AsString(_md5Bytes);
 		fileProps.size = macResMan.getResForkDataSize();
+		cache.store(macResMan.getFileNode(), true, _md5Bytes, fileProps);
 		return true;
 	}
 
 	if (!allFiles.contains(fname))
 		return false;
 
+	const Common::FSNode &node = allFiles[fname];
+	if (cache.lookup(node, false, _md5Bytes, fileProps))
+		return true;
+
 	Common::File testFile;
 
-	if (!testFile.open(allFiles[fname]))
+	if (!testFile.open(node))
 		return false;
 
 	fileProps.size = (int32)testFile.size();
 	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+	cache.store(node, false, _md5Bytes, fileProps);
 	return true;
 }
 
@@ -27,12 +27,14 @@
 #include "engines/engine.h"
 
 #include "common/hash-str.h"
+#include "common/singleton.h"
 
 #include "common/gui_options.h" // FIXME: Temporary hack?
 
 namespace Common {
 class Error;
 class FSList;
+class FSNode;
 }
 
 /**
@@ -61,6 +63,82 @@ struct ADFileProperties {
  */
 typedef Common::HashMap<Common::String, ADFileProperties, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> ADFilePropertiesMap;
 
+/**
+ * A persistent cache of the file properties computed while detecting, so
+ * that rescanning a directory does not need to reread every candidate file.
+ *
+ * Entries are keyed by the path of the file, whether its data or resource
+ * fork was hashed and the number of hashed bytes. An entry is only used as
+ * long as the size and modification time of the file are unchanged, which
+ * means that backends unable to report those never hit the cache.
+ *
+ * The cache is loaded on first use and written back by flush(), which
+ * also drops entries unused for a few months and trims the cache to a
+ * maximum size. It can be turned off with the "md5_cache" config key.
+ */
+class ADMD5Cache : public Common::Singleton<ADMD5Cache> {
+public:
+	/**
+	 * Look up the properties of a file.
+	 *
+	 * @param node		the file the MD5 is computed from
+	 * @param resFork	whether the MD5 is that of the resource fork
+	 * @param md5Bytes	the number of bytes the MD5 is computed for
+	 * @param fileProps	receives the cached properties on a hit
+	 * @return true on a cache hit, false otherwise
+	 */
+	bool lookup(const Common::FSNode &node, bool resFork, uint md5Bytes, ADFileProperties &fileProps);
+
+	/**
+	 * Look up the properties of a file which may be stored in any of the
+	 * given candidates, e.g. a resource fork before opening it. The first
+	 * candidate with a valid entry is used.
+	 */
+	bool lookup(const Common::FSList &candidates, bool resFork, uint md5Bytes, ADFileProperties &fileProps);
+
+	/** Add the freshly computed properties of a file to the cache. */
+	void store(const Common::FSNode &node, bool resFork, uint md5Bytes, const ADFileProperties &fileProps);
+
+	/** Write the cache back to disk, if it changed. */
+	void flush();
+
+	/** Get the number of lookups answered from the cache. */
+	uint32 getHits() const { return _hits; }
+
+	/** Get the number of lookups which required computing the MD5. */
+	uint32 getMisses() const { return _misses; }
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	ADMD5Cache();
+
+	struct Entry {
+		uint32 fileSize;
+		uint32 modificationTime;
+		uint32 lastUsed;           ///< Day number of the last lookup or store
+		ADFileProperties props;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	/** Detectors of several engines may use the cache at once. */
+	Common::Mutex _mutex;
+
+	EntryMap _entries;
+	bool _loaded;
+	bool _dirty;
+	uint32 _today;
+	uint32 _hits;
+	uint32 _misses;
+
+	bool isEnabled();
+	void load();
+	void prune();
+	bool find(const Common::FSNode &node, bool resFork, uint md5Bytes, ADFileProperties &fileProps);
+	static uint32 getDayNumber();
+	static Common::String makeKey(const Common::FSNode &node, bool resFork, uint md5Bytes);
+};
+
 /**
  * A shortcut to produce an empty ADGameFileDescription record. Used to mark
  * the end of a list of these.
@@ -0,0 +1,247 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/algorithm.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/fs.h"
+#include "common/savefile.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "engines/advancedDetector.h"
+
+namespace Common {
+DECLARE_SINGLETON(ADMD5Cache);
+}
+
+static const char *const kMD5CacheFileName = "detection.md5cache";
+static const char *const kMD5CacheHeader = "ScummVM MD5 cache 3";
+
+/** Written instead of an empty MD5, e.g. that of a missing resource fork. */
+static const char *const kMD5CacheNoMD5 = "-";
+
+/** Entries not used for this many days are dropped when flushing. */
+static const uint32 kMD5CacheMaxUnusedDays = 90;
+
+/** The number of entries the cache is trimmed to when flushing. */
+static const uint kMD5CacheMaxEntries = 10000;
+
+ADMD5Cache::ADMD5Cache() : _loaded(false), _dirty(false), _today(0), _hits(0), _misses(0) {
+}
+
+uint32 ADMD5Cache::getDayNumber() {
+	TimeDate t;
+	g_system->getTimeAndDate(t);
+
+	// Not a real calendar, but good enough to tell how long ago an entry was used
+	return ((t.tm_year + 1900) * 12 + t.tm_mon) * 31 + t.tm_mday - 1;
+}
+
+bool ADMD5Cache::isEnabled() {
+	return !ConfMan.hasKey("md5_cache") || ConfMan.getBool("md5_cache");
+}
+
+Common::String ADMD5Cache::makeKey(const Common::FSNode &node, bool resFork, uint md5Bytes) {
+	return Common::String::format("%c:%u:%s", resFork ? 'r' : 'd', md5Bytes, node.getPath().c_str());
+}
+
+bool ADMD5Cache::lookup(const Common::FSNode &node, bool resFork, uint md5Bytes, ADFileProperties &fileProps) {
+	if (!isEnabled())
+		return false;
+
+	Common::StackLock lock(_mutex);
+
+	if (find(node, resFork, md5Bytes, fileProps)) {
+		_hits++;
+		return true;
+	}
+
+	_misses++;
+	return false;
+}
+
+bool ADMD5Cache::lookup(const Common::FSList &candidates, bool resFork, uint md5Bytes, ADFileProperties &fileProps) {
+	if (!isEnabled())
+		return false;
+
+	Common::StackLock lock(_mutex);
+
+	for (Common::FSList::const_iterator node = candidates.begin(); node != candidates.end(); ++node) {
+		if (find(*node, resFork, md5Bytes, fileProps)) {
+			_hits++;
+			return true;
+		}
+	}
+
+	_misses++;
+	return false;
+}
+
+bool ADMD5Cache::find(const Common::FSNode &node, bool resFork, uint md5Bytes, ADFileProperties &fileProps) {
+	uint32 fileSize, modificationTime;
+	if (!node.getFileInfo(fileSize, modificationTime))
+		return false;
+
+	load();
+
+	EntryMap::iterator entry = _entries.find(makeKey(node, resFork, md5Bytes));
+	if (entry == _entries.end() || entry->_value.fileSize != fileSize || entry->_value.modificationTime != modificationTime)
+		return false;
+
+	// Remember that the entry is still in use, at most once a day
+	if (entry->_value.lastUsed != _today) {
+		entry->_value.lastUsed = _today;
+		_dirty = true;
+	}
+
+	fileProps = entry->_value.props;
+	return true;
+}
+
+void ADMD5Cache::store(const Common::FSNode &node, bool resFork, uint md5Bytes, const ADFileProperties &fileProps) {
+	if (!isEnabled())
+		return;
+
+	Entry entry;
+	if (!node.getFileInfo(entry.fileSize, entry.modificationTime))
+		return;
+
+	Common::StackLock lock(_mutex);
+
+	load();
+
+	entry.props = fileProps;
+	entry.lastUsed = _today;
+	_entries[makeKey(node, resFork, md5Bytes)] = entry;
+	_dirty = true;
+}
+
+void ADMD5Cache::prune() {
+	uint pruned = 0;
+
+	for (EntryMap::iterator entry = _entries.begin(); entry != _entries.end(); ++entry) {
+		// Entries from the future stem from a changed clock, keep those
+		if (entry->_value.lastUsed + kMD5CacheMaxUnusedDays < _today) {
+			_entries.erase(entry);
+			pruned++;
+		}
+	}
+
+	if (_entries.size() > kMD5CacheMaxEntries) {
+		// Drop the least recently used entries
+		Common::Array<uint32> lastUsed;
+		for (EntryMap::const_iterator entry = _entries.begin(); entry != _entries.end(); ++entry)
+			lastUsed.push_back(entry->_value.lastUsed);
+
+		Common::sort(lastUsed.begin(), lastUsed.end());
+		const uint32 cutOff = lastUsed[lastUsed.size() - kMD5CacheMaxEntries];
+
+		for (EntryMap::iterator entry = _entries.begin(); entry != _entries.end(); ++entry) {
+			if (entry->_value.lastUsed < cutOff) {
+				_entries.erase(entry);
+				pruned++;
+			}
+		}
+	}
+
+	if (pruned) {
+		debug(2, "Pruned %u entries from the MD5 cache", pruned);
+		_dirty = true;
+	}
+}
+
+void ADMD5Cache::load() {
+	if (_loaded)
+		return;
+
+	_loaded = true;
+	_today = getDayNumber();
+
+	Common::InSaveFile *file = g_system->getSavefileManager()->openForLoading(kMD5CacheFileName);
+	if (!file)
+		return;
+
+	if (file->readLine() != kMD5CacheHeader) {
+		warning("Ignoring MD5 cache with unknown format");
+		delete file;
+		return;
+	}
+
+	while (!file->eos() && !file->err()) {
+		Common::String line = file->readLine();
+		if (line.empty())
+			continue;
+
+		// Each line reads "<last used> <file size> <modification time> <size> <md5 or -> <key>"
+		Entry entry;
+		char md5[33];
+		int keyPos = 0;
+		if (sscanf(line.c_str(), "%u %u %u %d %32s %n", &entry.lastUsed, &entry.fileSize, &entry.modificationTime, &entry.props.size, md5, &keyPos) != 5 || !keyPos) {
+			warning("Malformed MD5 cache line \"%s\"", line.c_str());
+			continue;
+		}
+
+		if (strcmp(md5, kMD5CacheNoMD5))
+			entry.props.md5 = md5;
+		_entries[line.c_str() + keyPos] = entry;
+	}
+
+	delete file;
+	debug(2, "Loaded %u entries from the MD5 cache", _entries.size());
+}
+
+void ADMD5Cache::flush() {
+	Common::StackLock lock(_mutex);
+
+	if (_hits || _misses)
+		debug(1, "MD5 cache: %u hits, %u misses", _hits, _misses);
+
+	if (!_loaded)
+		return;
+
+	prune();
+	if (!_dirty)
+		return;
+
+	Common::OutSaveFile *file = g_system->getSavefileManager()->openForSaving(kMD5CacheFileName, false);
+	if (!file) {
+		warning("Could not write the MD5 cache");
+		return;
+	}
+
+	file->writeString(kMD5CacheHeader);
+	file->writeByte('\n');
+
+	for (EntryMap::const_iterator entry = _entries.begin(); entry != _entries.end(); ++entry) {
+		const Common::String &md5 = entry->_value.props.md5;
+		file->writeString(Common::String::format("%u %u %u %d %s %s\n", entry->_value.lastUsed, entry->_value.fileSize, entry->_value.modificationTime,
+			entry->_value.props.size, md5.empty() ? kMD5CacheNoMD5 : md5.c_str(), entry->_key.c_str()));
+	}
+
+	file->finalize();
+	if (file->err())
+		warning("Could not write the MD5 cache");
+	else
+		_dirty = false;
+
+	delete file;
+}
@@ -26,6 +26,7 @@
 #include "common/scummsys.h"
 #include "common/error.h"
 #include "common/array.h"
+#include "common/mutex.h"
 
 #include "engines/game.h"
 #include "engines/savestate.h"
@@ -81,6 +82,19 @@ public:
 	 */
 	virtual GameList detectGames(const Common::FSList &fslist) const = 0;
 
+	/**
+	 * Whether detectGames() may run while other engines detect games on
+	 * other threads. Detectors changing global state, like adding archives
+	 * to SearchMan, must return false, so that they only run one at a time.
+	 *
+	 * Either way, the detector of one engine never runs on two threads at
+	 * once, so it may keep state of its own in static memory.
+	 */
+	virtual bool canDetectConcurrently() const { return true; }
+
+	/** Get the lock held while detectGames() runs, see canDetectConcurrently(). */
+	Common::Mutex &getDetectionMutex() const { return _detectionMutex; }
+
 	/**
 	 * Tries to instantiate an engine instance based on the settings of
 	 * the currently active ConfMan target. That is, the MetaEngine should
@@ -245,6 +259,9 @@ public:
 	}
 
 	//@}
+
+private:
+	mutable Common::Mutex _detectionMutex;
 };
 
 
@@ -259,8 +276,33 @@ class EngineManager : public Common::Singleton<EngineManager> {
 public:
 	GameDescriptor findGameInLoadedPlugins(const Common::String &gameName, const EnginePlugin **plugin = NULL) const;
 	GameDescriptor findGame(const Common::String &gameName, const EnginePlugin **plugin = NULL) const;
+	/**
+	 * Run the detectors of all engines on the given list of files.
+	 *
+	 * This may be called from several threads at once, for different
+	 * directories, as long as canDetectConcurrently() says so.
+	 */
 	GameList detectGames(const Common::FSList &fslist) const;
+
+	/**
+	 * Whether detectGames() may be called from several threads at once.
+	 * This isn't the case when the plugins are loaded one at a time while
+	 * detecting.
+	 */
+	bool canDetectConcurrently() const;
+
+	/**
+	 * Write what the detectors keep across runs, like the MD5 cache, to
+	 * disk. Call this on the main thread once a scan or the launch of a
+	 * game is complete, not after every single detection.
+	 */
+	void flushDetectionCache() const;
+
 	const EnginePlugin::List &getPlugins() const;
+
+private:
+	/** Held while a detector which can't detect concurrently runs. */
+	mutable Common::Mutex _exclusiveDetectionMutex;
 };
 
 /** Convenience shortcut for accessing the engine manager. */
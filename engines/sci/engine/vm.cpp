@@ -22,6 +22,7 @@
 
 #include "common/debug.h"
 #include "common/debug-channels.h"
+#include "common/profiler.h"
 
 #include "sci/sci.h"
 #include "sci/console.h"
@@ -536,6 +537,8 @@ int readPMachineInstruction(const byte *src, byte &extOpcode, int16 opparams[4])
 }
 
 void run_vm(EngineState *s) {
+	PROFILE_SCOPE("sci.run_vm");
+
 	assert(s);
 
 	int temp;
@@ -21,6 +21,7 @@
  */
 
 #include "common/config-manager.h"
+#include "audio/soundcache.h"
 #include "sci/sound/audio.h"
 #include "sci/sound/music.h"
 #include "sci/sound/soundcmd.h"
@@ -89,13 +90,23 @@ void SoundCommandParser::initSoundResource(MusicEntry *newSound) {
 	if (g_sci->getGameId() == GID_HOYLE4)
 		checkAudioResource = false;
 
-	if (checkAudioResource && _resMan->testResource(ResourceId(kResourceTypeAudio, newSound->resourceId))) {
+	const ResourceId audioId(kResourceTypeAudio, newSound->resourceId);
+	Resource *audioRes = checkAudioResource ? _resMan->testResource(audioId) : 0;
+	if (audioRes) {
 		// Found a relevant audio resource, create an audio stream if there is
 		// no associated sound resource, or if both resources exist and the
 		// user wants the digital version.
 		if (_useDigitalSFX || !newSound->soundRes) {
-			int sampleLen;
-			newSound->pStreamAud = _audio->getAudioStream(newSound->resourceId, 65535, &sampleLen);
+			// The same effects are played over and over again, so keep them
+			// decoded instead of decompressing them each time
+			const Audio::DecodedSoundKey key(audioId.toString(), 0, audioRes->size);
+			newSound->pStreamAud = SoundCache.find(key);
+			if (!newSound->pStreamAud) {
+				int sampleLen;
+				Audio::RewindableAudioStream *stream = _audio->getAudioStream(newSound->resourceId, 65535, &sampleLen);
+				if (stream)
+					newSound->pStreamAud = SoundCache.decode(key, stream);
+			}
 			newSound->soundType = Audio::Mixer::kSFXSoundType;
 		}
 	}
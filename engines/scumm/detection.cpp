@@ -948,6 +948,8 @@ public:
 	virtual GameList getSupportedGames() const;
 	virtual GameDescriptor findGame(const char *gameid) const;
 	virtual GameList detectGames(const Common::FSList &fslist) const;
+	// Disk images are opened through SearchMan
+	virtual bool canDetectConcurrently() const { return false; }
 
 	virtual Common::Error createInstance(OSystem *syst, Engine **engine) const;
 
@@ -24,6 +24,7 @@
 #include "common/debug-channels.h"
 #include "common/md5.h"
 #include "common/events.h"
+#include "common/profiler.h"
 #include "common/system.h"
 #include "common/translation.h"
 
@@ -2115,6 +2116,8 @@ void ScummEngine_v0::scummLoop(int delta) {
 }
 
 void ScummEngine::scummLoop(int delta) {
+	PROFILE_SCOPE("scumm.loop");
+
 	if (_game.version >= 3) {
 		VAR(VAR_TMR_1) += delta;
 		VAR(VAR_TMR_2) += delta;
@@ -299,12 +299,12 @@ void Music::startMusic(int32 tuneId, int32 loopFlag) {
 		if (SwordEngine::isPsx()) {
 			if (_handles[newStream].playPSX(tuneId, loopFlag != 0)) {
 				_mutex.lock();
-				_converter[newStream] = Audio::makeRateConverter(_handles[newStream].getRate(), _mixer->getOutputRate(), _handles[newStream].isStereo(), false);
+				_converter[newStream] = _mixer->makeRateConverter(_handles[newStream].getRate(), _handles[newStream].isStereo());
 				_mutex.unlock();
 			}
 		} else if (_handles[newStream].play(_tuneList[tuneId], loopFlag != 0)) {
 			_mutex.lock();
-			_converter[newStream] = Audio::makeRateConverter(_handles[newStream].getRate(), _mixer->getOutputRate(), _handles[newStream].isStereo(), false);
+			_converter[newStream] = _mixer->makeRateConverter(_handles[newStream].getRate(), _handles[newStream].isStereo());
 			_mutex.unlock();
 		} else {
 			if (tuneId != 81) // file 81 was apparently removed from BS.
@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/coroutines.h"
 #include "tinsel/tinsel.h"
 #include "tinsel/debugger.h"
 #include "tinsel/dialogs.h"
@@ -67,6 +68,7 @@ Console::Console() : GUI::Debugger() {
 	registerCmd("music",		WRAP_METHOD(Console, cmd_music));
 	registerCmd("sound",		WRAP_METHOD(Console, cmd_sound));
 	registerCmd("string",		WRAP_METHOD(Console, cmd_string));
+	registerCmd("coroutines",	WRAP_METHOD(Console, cmd_coroutines));
 }
 
 Console::~Console() {
@@ -161,4 +163,9 @@ bool Console::cmd_string(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmd_coroutines(int argc, const char **argv) {
+	debugPrintf("%s", CoroScheduler.getStats().toString().c_str());
+	return true;
+}
+
 } // End of namespace Tinsel
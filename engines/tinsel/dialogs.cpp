@@ -5586,8 +5586,7 @@ extern void syncInvInfo(Common::Serializer &s) {
 	}
 
 	if (TinselV2) {
-		for (int i = 0; i < g_numObjects; ++i)
-			s.syncAsUint32LE(g_invFilms[i]);
+		s.syncArray<Common::Serializer::Uint32LE>(g_invFilms, g_numObjects);
 		s.syncAsUint32LE(g_heldFilm);
 	}
 }
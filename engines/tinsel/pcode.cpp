@@ -476,9 +476,7 @@ void FreeGlobals() {
  * (Un)serialize the global data for save/restore game.
  */
 void syncGlobInfo(Common::Serializer &s) {
-	for (int i = 0; i < g_numGlobals; i++) {
-		s.syncAsSint32LE(g_pGlobals[i]);
-	}
+	s.syncArray<Common::Serializer::Sint32LE>(g_pGlobals, g_numGlobals);
 }
 
 /**
@@ -498,8 +496,7 @@ void INT_CONTEXT::syncWithSerializer(Common::Serializer &s) {
 	s.syncAsSint32LE(hPoly);
 	s.syncAsSint32LE(idActor);
 
-	for (int i = 0; i < PCODE_STACK_SIZE; ++i)
-		s.syncAsSint32LE(stack[i]);
+	s.syncArray<Common::Serializer::Sint32LE>(stack, PCODE_STACK_SIZE);
 
 	s.syncAsSint32LE(sp);
 	s.syncAsSint32LE(bp);
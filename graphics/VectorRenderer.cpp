@@ -72,6 +72,66 @@ int VectorRenderer::stepGetRadius(const DrawStep &step, const Common::Rect &area
 	return radius;
 }
 
+Common::Rect VectorRenderer::stepGetDrawnArea(const DrawStep &step, const Common::Rect &area, uint32 extra) {
+	uint16 x, y, w, h;
+	stepGetPositions(step, area, x, y, w, h);
+
+	Common::Rect drawn(x, y, x + w, y + h);
+	const int shadow = _disableShadows ? 0 : step.shadow;
+
+	// The margins follow the drawing algorithms in VectorRendererSpec and
+	// VectorRendererAA
+	if (step.drawingCall == &VectorRenderer::drawCallback_CIRCLE) {
+		const int r = stepGetRadius(step, area);
+		drawn = Common::Rect(x, y, x + 2 * r + 1, y + 2 * r + 1);
+		// The shadow is a full circle moved by the shadow offset plus one
+		if (shadow) {
+			drawn.right += shadow + 1;
+			drawn.bottom += shadow + 1;
+		}
+	} else if (step.drawingCall == &VectorRenderer::drawCallback_LINE ||
+	           step.drawingCall == &VectorRenderer::drawCallback_CROSS) {
+		// Lines run diagonally by the width, end point included, with half
+		// the stroke on either side
+		const int half = step.stroke >> 1;
+		drawn = Common::Rect(x - half, y - half, x + w + 1 + half, y + MAX(w, h) + 1 + half);
+	} else if (step.drawingCall == &VectorRenderer::drawCallback_BITMAP) {
+		// Bitmaps are centered in the step, but not clipped to it
+		if (step.blitSrc) {
+			if (w > step.blitSrc->w)
+				drawn.left += (w >> 1) - (step.blitSrc->w >> 1);
+			if (h > step.blitSrc->h)
+				drawn.top += (h >> 1) - (step.blitSrc->h >> 1);
+			drawn.setWidth(step.blitSrc->w);
+			drawn.setHeight(step.blitSrc->h);
+		}
+	} else if (step.drawingCall == &VectorRenderer::drawCallback_SQUARE) {
+		drawn.right += shadow;
+		drawn.bottom += shadow;
+	} else if (step.drawingCall == &VectorRenderer::drawCallback_ROUNDSQ) {
+		// Shadows start 2 pixels to the left, and are one pixel bigger
+		// than the square plus the offset
+		if (shadow) {
+			drawn.left -= 2;
+			drawn.right += shadow + 1;
+			drawn.bottom += shadow + 2;
+		}
+	} else if (step.drawingCall == &VectorRenderer::drawCallback_BEVELSQ) {
+		drawn.grow(step.bevel);
+	} else if (step.drawingCall == &VectorRenderer::drawCallback_TAB) {
+		// The base line of active tabs extends to both sides. The tab's
+		// shadow is fixed, 3 pixels to the right and 4 below the tab.
+		drawn.left -= extra >> 16;
+		drawn.right += MAX<int>(2, 1 + (extra & 0xFFFF));
+		drawn.bottom += MAX<int>(5, 1 + step.stroke);
+	} else if (step.drawingCall == &VectorRenderer::drawCallback_TRIANGLE) {
+		drawn.right++;
+		drawn.bottom++;
+	}
+
+	return drawn;
+}
+
 void VectorRenderer::stepGetPositions(const DrawStep &step, const Common::Rect &area, uint16 &in_x, uint16 &in_y, uint16 &in_w, uint16 &in_h) {
 	if (!step.autoWidth) {
 		in_w = step.w == -1 ? area.height() : step.w;
@@ -263,6 +263,15 @@ public:
 	 */
 	virtual void setGradientColors(uint8 r1, uint8 g1, uint8 b1, uint8 r2, uint8 g2, uint8 b2) = 0;
 
+	/**
+	 * Gets the colors currently set, in the order foreground, background,
+	 * bevel, gradient start and gradient end. Steps which don't set a
+	 * color use the one left behind by an earlier step or string.
+	 *
+	 * @param colors Array receiving the colors in the surface's format.
+	 */
+	virtual void getColors(uint32 colors[5]) const = 0;
+
 	/**
 	 * Sets the active drawing surface. All drawing from this
 	 * point on will be done on that surface.
@@ -273,6 +282,13 @@ public:
 		_activeSurface = surface;
 	}
 
+	/**
+	 * Returns the active drawing surface.
+	 */
+	Surface *getSurface() const {
+		return _activeSurface;
+	}
+
 	/**
 	 * Fills the active surface with the specified fg/bg color or the active gradient.
 	 * Defaults to using the active Foreground color for filling.
@@ -352,6 +368,14 @@ public:
 	 */
 	int stepGetRadius(const DrawStep &step, const Common::Rect &area);
 
+	/**
+	 * Returns the rect a drawstep may change pixels in, including its
+	 * shadows, bevels and strokes, as drawn by drawStep() with the given
+	 * area and extra data. Steps filling the whole surface or drawing a
+	 * bitmap are bounded by their position data only.
+	 */
+	Common::Rect stepGetDrawnArea(const DrawStep &step, const Common::Rect &area, uint32 extra);
+
 	/**
 	 * DrawStep callback functions for each drawing feature
 	 */
@@ -483,6 +507,7 @@ public:
 	 */
 	virtual void disableShadows() { _disableShadows = true; }
 	virtual void enableShadows() { _disableShadows = false; }
+	bool shadowsEnabled() const { return !_disableShadows; }
 
 	/**
 	 * Applies a whole-screen shading effect, used before opening a new dialog.
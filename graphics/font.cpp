@@ -31,6 +31,11 @@ int Font::getKerningOffset(uint32 left, uint32 right) const {
 	return 0;
 }
 
+void Font::drawChars(Surface *dst, const uint32 *chars, const int *xs, uint count, int y, uint32 color) const {
+	for (uint i = 0; i < count; ++i)
+		drawChar(dst, chars[i], xs[i], y, color);
+}
+
 Common::Rect Font::getBoundingBox(uint32 chr) const {
 	return Common::Rect(getCharWidth(chr), getFontHeight());
 }
@@ -107,6 +112,12 @@ void drawStringImpl(const Font &font, Surface *dst, const StringType &str, int x
 		x = x + w - width;
 	x += deltax;
 
+	// The visible characters are handed to drawChars in runs
+	const uint kRunSize = 64;
+	uint32 chars[kRunSize];
+	int xs[kRunSize];
+	uint count = 0;
+
 	typename StringType::unsigned_type last = 0;
 	for (typename StringType::const_iterator i = str.begin(), end = str.end(); i != end; ++i) {
 		const typename StringType::unsigned_type cur = *i;
@@ -115,10 +126,19 @@ void drawStringImpl(const Font &font, Surface *dst, const StringType &str, int x
 		w = font.getCharWidth(cur);
 		if (x+w > rightX)
 			break;
-		if (x+w >= leftX)
-			font.drawChar(dst, cur, x, y, color);
+		if (x+w >= leftX) {
+			chars[count] = cur;
+			xs[count] = x;
+			if (++count == kRunSize) {
+				font.drawChars(dst, chars, xs, count, y, color);
+				count = 0;
+			}
+		}
 		x += w;
 	}
+
+	if (count)
+		font.drawChars(dst, chars, xs, count, y, color);
 }
 
 template<class StringType>
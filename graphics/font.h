@@ -23,14 +23,11 @@
 #ifndef GRAPHICS_FONT_H
 #define GRAPHICS_FONT_H
 
+#include "common/array.h"
 #include "common/str.h"
 #include "common/ustr.h"
 #include "common/rect.h"
 
-namespace Common {
-template<class T> class Array;
-}
-
 namespace Graphics {
 
 struct Surface;
@@ -142,6 +139,23 @@ public:
 	 */
 	virtual void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const = 0;
 
+	/**
+	 * Draw a run of characters on a single line at once. This is used by
+	 * drawString for the characters it does not clip away.
+	 *
+	 * The default implementation draws the characters one by one using
+	 * drawChar. Fonts can override this to draw the whole run in one pass.
+	 *
+	 * @param dst   The surface to drawn on.
+	 * @param chars The characters to draw.
+	 * @param xs    The x coordinate where to draw each character, as
+	 *              passed to drawChar. Kerning is already applied.
+	 * @param count The number of characters in the run.
+	 * @param y     The y coordinate where to draw the characters.
+	 * @param color The color of the characters.
+	 */
+	virtual void drawChars(Surface *dst, const uint32 *chars, const int *xs, uint count, int y, uint32 color) const;
+
 	// TODO: Add doxygen comments to this
 	void drawString(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align = kTextAlignLeft, int deltax = 0, bool useEllipsis = true) const;
 	void drawString(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align = kTextAlignLeft) const;
@@ -114,6 +114,8 @@ public:
 	virtual Common::Rect getBoundingBox(uint32 chr) const;
 
 	virtual void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const;
+
+	virtual void drawChars(Surface *dst, const uint32 *chars, const int *xs, uint count, int y, uint32 color) const;
 private:
 	bool _initialized;
 	FT_Face _face;
@@ -125,7 +127,7 @@ private:
 	int _ascent, _descent;
 
 	struct Glyph {
-		Surface image;
+		Surface image; ///< Points into an atlas page, it does not own its pixels
 		int xOffset, yOffset;
 		int advance;
 		FT_UInt slot;
@@ -137,6 +139,82 @@ private:
 	bool _allowLateCaching;
 	void assureCached(uint32 chr) const;
 
+	/**
+	 * The glyph images are packed into a few big surfaces, row by row, instead
+	 * of allocating a surface for every glyph.
+	 */
+	struct AtlasPage {
+		Surface surface;
+		int shelfX, shelfY, shelfHeight;
+	};
+
+	typedef Common::Array<AtlasPage *> Atlas;
+	mutable Atlas _atlas;
+	void allocateGlyphImage(Surface &image, int w, int h) const;
+
+	/**
+	 * Kerning offsets by (left << 16 | right), added when a pair is first
+	 * used. Text only uses a small part of all possible pairs.
+	 */
+	typedef Common::HashMap<uint32, int> KerningCache;
+	mutable KerningCache _kerning;
+	int getFTKerningOffset(uint32 left, uint32 right) const;
+
+	/**
+	 * Runs of characters drawn by drawChars. Labels are redrawn with the same
+	 * text over and over, so the coverage of the whole run is cached and
+	 * blended in one pass. Only the covered spans of each line are kept, a
+	 * run is mostly empty space between and around the glyphs. Short gaps
+	 * stay in the spans, blending them is cheaper than starting a new span.
+	 * Where glyphs overlap, the spans of each further glyph follow after all
+	 * others, so every pixel is blended exactly like drawChar would do it.
+	 */
+	struct RunKey {
+		Common::Array<uint32> chars; ///< Pairs of character and x offset to the first one
+	};
+
+	struct RunKey_Hash {
+		uint operator()(const RunKey &key) const {
+			uint hash = 0;
+			for (uint i = 0; i < key.chars.size(); ++i)
+				hash = hash * 31 + key.chars[i];
+			return hash;
+		}
+	};
+
+	struct RunKey_EqualTo {
+		bool operator()(const RunKey &a, const RunKey &b) const {
+			return a.chars == b.chars;
+		}
+	};
+
+	struct Span {
+		int16 x, y;    ///< Position relative to where the run is drawn
+		uint16 length;
+		uint32 offset; ///< Offset of the coverage in Run::coverage
+	};
+
+	struct Run {
+		Common::Array<Span> spans;
+		Common::Array<uint8> coverage;
+	};
+
+	typedef Common::HashMap<RunKey, Run, RunKey_Hash, RunKey_EqualTo> RunCache;
+	mutable RunCache _runs;
+	mutable uint32 _runCacheSize;
+	void clearRuns() const;
+	const Run &cacheRun(const uint32 *chars, const int *xs, uint count) const;
+
+	template<typename ColorType>
+	void blendRun(Surface *dst, const Run &run, int x, int y, ColorType color) const;
+
+	/**
+	 * The color components of the format last drawn to, expanded to 8 bits
+	 * like PixelFormat::colorToRGB does it.
+	 */
+	mutable PixelFormat _expandFormat;
+	mutable uint8 _expandR[256], _expandG[256], _expandB[256];
+
 	FT_Int32 _loadFlags;
 	FT_Render_Mode _renderMode;
 	bool _hasKerning;
@@ -145,7 +223,7 @@ private:
 TTFFont::TTFFont()
     : _initialized(false), _face(), _ttfFile(0), _size(0), _width(0), _height(0), _ascent(0),
       _descent(0), _glyphs(), _loadFlags(FT_LOAD_TARGET_NORMAL), _renderMode(FT_RENDER_MODE_NORMAL),
-      _hasKerning(false), _allowLateCaching(false) {
+      _hasKerning(false), _allowLateCaching(false), _runCacheSize(0) {
 }
 
 TTFFont::~TTFFont() {
@@ -155,8 +233,12 @@ TTFFont::~TTFFont() {
 		delete[] _ttfFile;
 		_ttfFile = 0;
 
-		for (GlyphCache::iterator i = _glyphs.begin(), end = _glyphs.end(); i != end; ++i)
-			i->_value.image.free();
+		for (Atlas::iterator i = _atlas.begin(); i != _atlas.end(); ++i) {
+			(*i)->surface.free();
+			delete *i;
+		}
+
+		clearRuns();
 
 		_initialized = false;
 	}
@@ -283,6 +365,20 @@ int TTFFont::getKerningOffset(uint32 left, uint32 right) const {
 	if (!_hasKerning)
 		return 0;
 
+	if (left > 0xFFFF || right > 0xFFFF)
+		return getFTKerningOffset(left, right);
+
+	const uint32 pair = (left << 16) | right;
+	KerningCache::const_iterator kerning = _kerning.find(pair);
+	if (kerning != _kerning.end())
+		return kerning->_value;
+
+	const int offset = getFTKerningOffset(left, right);
+	_kerning[pair] = offset;
+	return offset;
+}
+
+int TTFFont::getFTKerningOffset(uint32 left, uint32 right) const {
 	assureCached(left);
 	assureCached(right);
 
@@ -360,28 +456,16 @@ void renderGlyph(uint8 *dstPos, const int dstPitch, const uint8 *srcPos, const i
 	}
 }
 
-} // End of anonymous namespace
-
-void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const {
-	assureCached(chr);
-	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
-	if (glyphEntry == _glyphs.end())
-		return;
-
-	const Glyph &glyph = glyphEntry->_value;
-
-	x += glyph.xOffset;
-	y += glyph.yOffset;
-
+void blendCoverage(Surface *dst, const Surface &coverage, int x, int y, uint32 color) {
 	if (x > dst->w)
 		return;
 	if (y > dst->h)
 		return;
 
-	int w = glyph.image.w;
-	int h = glyph.image.h;
+	int w = coverage.w;
+	int h = coverage.h;
 
-	const uint8 *srcPos = (const uint8 *)glyph.image.getPixels();
+	const uint8 *srcPos = (const uint8 *)coverage.getPixels();
 
 	// Make sure we are not drawing outside the screen bounds
 	if (x < 0) {
@@ -397,7 +481,7 @@ void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) con
 		return;
 
 	if (y < 0) {
-		srcPos -= y * glyph.image.pitch;
+		srcPos -= y * coverage.pitch;
 		h += y;
 		y = 0;
 	}
@@ -426,13 +510,248 @@ void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) con
 			}
 
 			dstPos += dst->pitch;
-			srcPos += glyph.image.pitch;
+			srcPos += coverage.pitch;
 		}
 	} else if (dst->format.bytesPerPixel == 2) {
-		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format);
+		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, coverage.pitch, w, h, color, dst->format);
 	} else if (dst->format.bytesPerPixel == 4) {
-		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format);
+		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, coverage.pitch, w, h, color, dst->format);
+	}
+}
+
+} // End of anonymous namespace
+
+void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const {
+	assureCached(chr);
+	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
+	if (glyphEntry == _glyphs.end())
+		return;
+
+	const Glyph &glyph = glyphEntry->_value;
+	blendCoverage(dst, glyph.image, x + glyph.xOffset, y + glyph.yOffset, color);
+}
+
+void TTFFont::drawChars(Surface *dst, const uint32 *chars, const int *xs, uint count, int y, uint32 color) const {
+	// Palette surfaces can't blend, there drawChar only sets the pixels of
+	// a glyph with a coverage of at least 50%.
+	if (count < 2 || dst->format.bytesPerPixel == 1) {
+		Font::drawChars(dst, chars, xs, count, y, color);
+		return;
+	}
+
+	const Run &run = cacheRun(chars, xs, count);
+
+	if (dst->format.bytesPerPixel == 2)
+		blendRun<uint16>(dst, run, xs[0], y, color);
+	else if (dst->format.bytesPerPixel == 4)
+		blendRun<uint32>(dst, run, xs[0], y, color);
+}
+
+template<typename ColorType>
+void TTFFont::blendRun(Surface *dst, const Run &run, int x, int y, ColorType color) const {
+	const PixelFormat &format = dst->format;
+
+	// Look up the components instead of expanding them for every pixel, the
+	// result is the same as in renderGlyph
+	if (_expandFormat != format) {
+		_expandFormat = format;
+		for (uint i = 0; i < 256; ++i)
+			format.colorToRGB(format.RGBToColor(i, i, i), _expandR[i >> format.rLoss], _expandG[i >> format.gLoss], _expandB[i >> format.bLoss]);
+	}
+
+	const uint rMask = 0xFF >> format.rLoss, gMask = 0xFF >> format.gLoss, bMask = 0xFF >> format.bLoss;
+
+	uint8 sR, sG, sB;
+	format.colorToRGB(color, sR, sG, sB);
+
+	for (Common::Array<Span>::const_iterator span = run.spans.begin(); span != run.spans.end(); ++span) {
+		const int spanY = y + span->y;
+		if (spanY < 0 || spanY >= dst->h)
+			continue;
+
+		int spanX = x + span->x;
+		int length = span->length;
+		const uint8 *src = &run.coverage[span->offset];
+
+		if (spanX < 0) {
+			src -= spanX;
+			length += spanX;
+			spanX = 0;
+		}
+
+		if (spanX + length > dst->w)
+			length = dst->w - spanX;
+
+		if (length <= 0)
+			continue;
+
+		ColorType *rDst = (ColorType *)dst->getBasePtr(spanX, spanY);
+
+		for (int i = 0; i < length; ++i, ++rDst, ++src) {
+			if (*src == 255) {
+				*rDst = color;
+			} else if (*src) {
+				const uint a = *src;
+
+				const uint dR = _expandR[(*rDst >> format.rShift) & rMask];
+				const uint dG = _expandG[(*rDst >> format.gShift) & gMask];
+				const uint dB = _expandB[(*rDst >> format.bShift) & bMask];
+
+				*rDst = format.RGBToColor(((255 - a) * dR + a * sR) / 255,
+				                          ((255 - a) * dG + a * sG) / 255,
+				                          ((255 - a) * dB + a * sB) / 255);
+			}
+		}
+	}
+}
+
+const TTFFont::Run &TTFFont::cacheRun(const uint32 *chars, const int *xs, uint count) const {
+	RunKey key;
+	key.chars.resize(2 * count);
+	for (uint i = 0; i < count; ++i) {
+		key.chars[2 * i] = chars[i];
+		key.chars[2 * i + 1] = xs[i] - xs[0];
+	}
+
+	RunCache::const_iterator cached = _runs.find(key);
+	if (cached != _runs.end())
+		return cached->_value;
+
+	Common::Rect bounds;
+	for (uint i = 0; i < count; ++i) {
+		assureCached(chars[i]);
+		GlyphCache::const_iterator glyphEntry = _glyphs.find(chars[i]);
+		if (glyphEntry == _glyphs.end())
+			continue;
+
+		const Glyph &glyph = glyphEntry->_value;
+		Common::Rect glyphBounds(glyph.image.w, glyph.image.h);
+		glyphBounds.translate(xs[i] - xs[0] + glyph.xOffset, glyph.yOffset);
+		if (bounds.isEmpty())
+			bounds = glyphBounds;
+		else if (!glyphBounds.isEmpty())
+			bounds.extend(glyphBounds);
+	}
+
+	const int w = bounds.width(), h = bounds.height();
+
+	// Blending glyphs one after the other rounds after every glyph, so
+	// combining the coverage of overlapping glyphs would change the result.
+	// Instead, a pixel keeps the coverage of each glyph drawn over it, in
+	// drawing order: layer n holds the nth of them, and the layers are
+	// blended one after the other. Full coverage replaces anything below.
+	Common::Array<Common::Array<uint8> > layers;
+	Common::Array<uint> depth;
+	depth.resize(w * h);
+
+	for (uint i = 0; i < count; ++i) {
+		GlyphCache::const_iterator glyphEntry = _glyphs.find(chars[i]);
+		if (glyphEntry == _glyphs.end())
+			continue;
+
+		const Glyph &glyph = glyphEntry->_value;
+		const int left = xs[i] - xs[0] + glyph.xOffset - bounds.left;
+		const int top = glyph.yOffset - bounds.top;
+
+		for (int cy = 0; cy < glyph.image.h; ++cy) {
+			const uint8 *src = (const uint8 *)glyph.image.getBasePtr(0, cy);
+			uint pos = (top + cy) * w + left;
+
+			for (int cx = 0; cx < glyph.image.w; ++cx, ++src, ++pos) {
+				if (!*src)
+					continue;
+
+				if (*src == 255) {
+					for (uint layer = 1; layer < depth[pos]; ++layer)
+						layers[layer][pos] = 0;
+					depth[pos] = 0;
+				}
+
+				if (depth[pos] == layers.size()) {
+					layers.push_back(Common::Array<uint8>());
+					layers.back().resize(w * h);
+				}
+				layers[depth[pos]++][pos] = *src;
+			}
+		}
+	}
+
+	// Keep the cache from growing without bounds, e.g. for scrolling text
+	const uint32 kMaxRunCacheSize = 256 * 1024;
+	if (_runCacheSize > kMaxRunCacheSize)
+		clearRuns();
+
+	Run &run = _runs[key];
+
+	for (uint layer = 0; layer < layers.size(); ++layer) {
+		for (int cy = 0; cy < h; ++cy) {
+			const uint8 *line = &layers[layer][cy * w];
+
+			for (int cx = 0; cx < w; ) {
+				if (!line[cx]) {
+					++cx;
+					continue;
+				}
+
+				const int kMaxGap = 16;
+
+				int end = cx + 1;
+				for (int gap = 0; end < w && gap < kMaxGap; ++end)
+					gap = line[end] ? 0 : gap + 1;
+				while (!line[end - 1])
+					--end;
+
+				Span span;
+				span.x = bounds.left + cx;
+				span.y = bounds.top + cy;
+				span.length = end - cx;
+				span.offset = run.coverage.size();
+				run.spans.push_back(span);
+
+				while (cx < end)
+					run.coverage.push_back(line[cx++]);
+			}
+		}
 	}
+
+	_runCacheSize += run.coverage.size() + run.spans.size() * sizeof(Span);
+	return run;
+}
+
+void TTFFont::clearRuns() const {
+	_runs.clear();
+	_runCacheSize = 0;
+}
+
+void TTFFont::allocateGlyphImage(Surface &image, int w, int h) const {
+	if (!w || !h) {
+		image.init(w, h, 0, 0, PixelFormat::createFormatCLUT8());
+		return;
+	}
+
+	AtlasPage *page = _atlas.empty() ? 0 : _atlas.back();
+
+	if (page && page->shelfX + w > page->surface.w) {
+		page->shelfX = 0;
+		page->shelfY += page->shelfHeight;
+		page->shelfHeight = 0;
+	}
+
+	if (!page || page->shelfX + w > page->surface.w || page->shelfY + h > page->surface.h) {
+		// Pages hold many glyphs of the usual font sizes, huge glyphs get
+		// a page of their own
+		const int kAtlasPageSize = 256;
+
+		page = new AtlasPage();
+		page->surface.create(MAX(w, kAtlasPageSize), MAX(h, kAtlasPageSize), PixelFormat::createFormatCLUT8());
+		page->shelfX = page->shelfY = page->shelfHeight = 0;
+		_atlas.push_back(page);
+	}
+
+	image = page->surface.getSubArea(Common::Rect(page->shelfX, page->shelfY, page->shelfX + w, page->shelfY + h));
+
+	page->shelfX += w;
+	page->shelfHeight = MAX(page->shelfHeight, h);
 }
 
 bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
@@ -460,7 +779,12 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	glyph.advance = ftCeil26_6(_face->glyph->advance.x);
 
 	const FT_Bitmap &bitmap = _face->glyph->bitmap;
-	glyph.image.create(bitmap.width, bitmap.rows, PixelFormat::createFormatCLUT8());
+	if (bitmap.pixel_mode != FT_PIXEL_MODE_MONO && bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap.pixel_mode);
+		return false;
+	}
+
+	allocateGlyphImage(glyph.image, bitmap.width, bitmap.rows);
 
 	const uint8 *src = bitmap.buffer;
 	int srcPitch = bitmap.pitch;
@@ -470,12 +794,12 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	}
 
 	uint8 *dst = (uint8 *)glyph.image.getPixels();
-	memset(dst, 0, glyph.image.h * glyph.image.pitch);
 
 	switch (bitmap.pixel_mode) {
 	case FT_PIXEL_MODE_MONO:
 		for (int y = 0; y < bitmap.rows; ++y) {
 			const uint8 *curSrc = src;
+			uint8 *curDst = dst;
 			uint8 mask = 0;
 
 			for (int x = 0; x < bitmap.width; ++x) {
@@ -483,12 +807,13 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 					mask = *curSrc++;
 
 				if (mask & 0x80)
-					*dst = 255;
+					*curDst = 255;
 
 				mask <<= 1;
-				++dst;
+				++curDst;
 			}
 
+			dst += glyph.image.pitch;
 			src += srcPitch;
 		}
 		break;
@@ -502,9 +827,7 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 		break;
 
 	default:
-		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap.pixel_mode);
-		glyph.image.free();
-		return false;
+		break;
 	}
 
 	return true;
@@ -22,6 +22,7 @@
 
 #include "common/system.h"
 #include "common/config-manager.h"
+#include "common/endian.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/unzip.h"
@@ -37,6 +38,8 @@
 
 #include "image/bmp.h"
 
+#include "base/version.h"
+
 #include "gui/widget.h"
 #include "gui/ThemeEngine.h"
 #include "gui/ThemeEval.h"
@@ -62,6 +65,11 @@ const char * const ThemeEngine::kImageFastReplaySmallbtn = "fastreplay_small.bmp
 
 struct TextDrawData {
 	const Graphics::Font *_fontPtr;
+
+	/** The font as specified by the theme, to reload it from the theme cache */
+	Common::String _file;
+	Common::String _scalableFile;
+	int _pointSize;
 };
 
 struct TextColorData {
@@ -93,6 +101,111 @@ struct WidgetDrawData {
 	 * value will be added when restoring the background of the widget.
 	 */
 	void calcBackgroundOffset();
+
+	/**
+	 * Calculates the rect all DrawSteps draw into when drawing into the given
+	 * area. Returns false when the result isn't worth caching, because all
+	 * steps are cheap to draw, or can't be cached, because a step fills the
+	 * whole surface or depends on the absolute position.
+	 */
+	bool calcDrawnArea(Graphics::VectorRenderer *renderer, const Common::Rect &area, uint32 dynamic, Common::Rect &drawn) const;
+};
+
+/**
+ * A cache of rendered DrawData items, with a budget in bytes. The least
+ * recently used items are dropped first.
+ *
+ * DrawSteps blend into what is already on the surface, so items are cached
+ * together with the background they were drawn onto, and are only reused
+ * on an identical background. An item drawn onto a different background
+ * replaces the cached one.
+ */
+class DrawDataCache {
+public:
+	struct Key {
+		const WidgetDrawData *data;
+		uint32 dynamic;
+		Common::Rect area;  ///< The area drawn into, relative to the cached rect
+		int16 w, h;         ///< Size of the cached rect
+		bool shadows;
+		uint32 colors[5];   ///< Colors the steps may inherit from the renderer
+	};
+
+	DrawDataCache() : _budget(0), _size(0), _hits(0), _misses(0) {}
+	~DrawDataCache() { clear(); }
+
+	void setBudget(uint32 budget) {
+		_budget = budget;
+		evict(0);
+	}
+
+	bool isEnabled() const { return _budget != 0; }
+
+	/**
+	 * Items bigger than a quarter of the budget would push out too much,
+	 * those are not cached at all.
+	 */
+	bool fits(int w, int h, int bytesPerPixel) const {
+		return sizeof(Entry) + 2 * w * h * bytesPerPixel <= _budget / 4;
+	}
+
+	/**
+	 * Copies the cached result for the given key onto the rect of the
+	 * surface, if it was drawn onto the background currently in the rect.
+	 *
+	 * @return false if no result is cached for the key
+	 */
+	bool blit(const Key &key, Graphics::Surface &surface, const Common::Rect &rect);
+
+	/**
+	 * Stores the result drawn into the rect of the surface. The background
+	 * is the content of the rect before drawing, the cache takes it over.
+	 */
+	void store(const Key &key, Graphics::Surface *background, const Graphics::Surface &surface, const Common::Rect &rect);
+
+	void clear();
+
+	uint32 getHits() const { return _hits; }
+	uint32 getMisses() const { return _misses; }
+	uint32 getSize() const { return _size; }
+
+private:
+	struct Entry {
+		Key key;
+		Graphics::Surface *background;
+		Graphics::Surface result;
+
+		uint32 getSize() const { return sizeof(Entry) + 2 * result.h * result.w * result.format.bytesPerPixel; }
+	};
+
+	struct Key_Hash {
+		uint operator()(const Key &key) const {
+			uint hash = (uint)(size_t)key.data;
+			hash = hash * 31 + key.dynamic;
+			hash = hash * 31 + ((key.w << 16) | (uint16)key.h);
+			return hash;
+		}
+	};
+
+	struct Key_EqualTo {
+		bool operator()(const Key &a, const Key &b) const {
+			return a.data == b.data && a.dynamic == b.dynamic && a.area == b.area && a.w == b.w && a.h == b.h &&
+			       a.shadows == b.shadows && !memcmp(a.colors, b.colors, sizeof(a.colors));
+		}
+	};
+
+	typedef Common::List<Entry *> EntryList;
+	typedef Common::HashMap<Key, EntryList::iterator, Key_Hash, Key_EqualTo> EntryMap;
+
+	/** Drops the least recently used entries until the given size fits into the budget. */
+	void evict(uint32 size);
+	void remove(EntryMap::iterator entry);
+
+	EntryList _entries; ///< Most recently used first
+	EntryMap _map;
+	uint32 _budget;
+	uint32 _size;
+	uint32 _hits, _misses;
 };
 
 class ThemeItem {
@@ -157,6 +270,90 @@ protected:
 
 
 
+/**********************************************************
+ * DrawDataCache functions
+ *********************************************************/
+static bool equalSurfaceRect(const Graphics::Surface &surface, const Common::Rect &rect, const Graphics::Surface &other) {
+	const uint bytes = rect.width() * surface.format.bytesPerPixel;
+
+	for (int y = rect.top; y < rect.bottom; ++y) {
+		if (memcmp(surface.getBasePtr(rect.left, y), other.getBasePtr(0, y - rect.top), bytes))
+			return false;
+	}
+
+	return true;
+}
+
+bool DrawDataCache::blit(const Key &key, Graphics::Surface &surface, const Common::Rect &rect) {
+	EntryMap::iterator i = _map.find(key);
+	if (i == _map.end() || !equalSurfaceRect(surface, rect, *(*i->_value)->background)) {
+		_misses++;
+		return false;
+	}
+
+	Entry *entry = *i->_value;
+	surface.copyRectToSurface(entry->result, rect.left, rect.top, Common::Rect(entry->result.w, entry->result.h));
+
+	// Move the entry to the front, it's the most recently used now
+	_entries.erase(i->_value);
+	_entries.push_front(entry);
+	i->_value = _entries.begin();
+
+	_hits++;
+	return true;
+}
+
+void DrawDataCache::store(const Key &key, Graphics::Surface *background, const Graphics::Surface &surface, const Common::Rect &rect) {
+	Entry *entry = new Entry;
+	entry->key = key;
+	entry->background = background;
+	entry->result.copyFrom(surface.getSubArea(rect));
+
+	const uint32 size = entry->getSize();
+	if (size > _budget / 4) {
+		entry->result.free();
+		entry->background->free();
+		delete entry->background;
+		delete entry;
+		return;
+	}
+
+	EntryMap::iterator old = _map.find(key);
+	if (old != _map.end())
+		remove(old);
+
+	evict(size);
+
+	_entries.push_front(entry);
+	_map[key] = _entries.begin();
+	_size += size;
+}
+
+void DrawDataCache::remove(EntryMap::iterator i) {
+	Entry *entry = *i->_value;
+
+	_size -= entry->getSize();
+	_entries.erase(i->_value);
+	_map.erase(i);
+
+	entry->result.free();
+	entry->background->free();
+	delete entry->background;
+	delete entry;
+}
+
+void DrawDataCache::evict(uint32 size) {
+	while (!_entries.empty() && _size + size > _budget)
+		remove(_map.find(_entries.back()->key));
+}
+
+void DrawDataCache::clear() {
+	while (!_entries.empty())
+		remove(_map.find(_entries.back()->key));
+}
+
+
+
 /**********************************************************
  *  Data definitions for theme engine elements
  *********************************************************/
@@ -233,11 +430,8 @@ void ThemeItemDrawData::drawSelf(bool draw, bool restore) {
 	if (restore)
 		_engine->restoreBackground(extendedRect);
 
-	if (draw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step)
-			_engine->renderer()->drawStep(_area, *step, _dynamicData);
-	}
+	if (draw)
+		_engine->renderDrawData(_data, _area, _dynamicData);
 
 	_engine->addDirtyRect(extendedRect);
 }
@@ -283,6 +477,11 @@ ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 	_parser = new ThemeParser(this);
 	_themeEval = new GUI::ThemeEval();
 
+	_drawCache = new DrawDataCache();
+	_drawCache->setBudget(MAX(ConfMan.getInt("gui_render_cache_size"), 0) * 1024);
+	_showDrawCacheStats = ConfMan.getBool("gui_render_cache_stats");
+	_drawCacheStatsShown = 0;
+
 	_useCursor = false;
 
 	for (int i = 0; i < kDrawDataMAX; ++i) {
@@ -309,6 +508,7 @@ ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 
 	_graphicsMode = mode;
 	_themeArchive = 0;
+	_themeArchiveSize = _themeArchiveTime = 0;
 	_initOk = false;
 
 	// We prefer files in archive bundles over the common search paths.
@@ -322,6 +522,7 @@ ThemeEngine::~ThemeEngine() {
 	_backBuffer.free();
 
 	unloadTheme();
+	delete _drawCache;
 
 	// Release all graphics surfaces
 	for (ImagesMap::iterator i = _bitmaps.begin(); i != _bitmaps.end(); ++i) {
@@ -411,18 +612,31 @@ bool ThemeEngine::init() {
 		} else if (_themeFile.matchString("*.zip", true)) {
 			// TODO: Also use "node" directly?
 			// Look for the zip file via SearchMan
+			Common::ZipArchive *zipArchive;
 			Common::ArchiveMemberPtr member = SearchMan.getMember(_themeFile);
 			if (member) {
-				_themeArchive = Common::makeZipArchive(member->createReadStream());
-				if (!_themeArchive) {
+				zipArchive = Common::makeZipArchive(member->createReadStream());
+				if (!zipArchive) {
 					warning("Failed to open Zip archive '%s'.", member->getDisplayName().c_str());
 				}
 			} else {
-				_themeArchive = Common::makeZipArchive(node);
-				if (!_themeArchive) {
+				zipArchive = Common::makeZipArchive(node);
+				if (!zipArchive) {
 					warning("Failed to open Zip archive '%s'.", node.getPath().c_str());
 				}
 			}
+
+			// Only zipped themes are cached. Their size and modification
+			// time tell whether they changed. Without these, e.g. for themes
+			// found through SearchMan, a checksum over the ZIP directory
+			// stands in for the time, which still reads no member data.
+			if (zipArchive) {
+				if (member || !node.getFileInfo(_themeArchiveSize, _themeArchiveTime) || !_themeArchiveTime) {
+					_themeArchiveSize = 0;
+					_themeArchiveTime = zipArchive->getDirectoryChecksum();
+				}
+			}
+			_themeArchive = zipArchive;
 		}
 
 		if (_themeArchive)
@@ -524,6 +738,9 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	_vectorRenderer = Graphics::createRenderer(mode);
 	_vectorRenderer->setSurface(&_screen);
 
+	// Cached items were drawn by the old renderer
+	_drawCache->clear();
+
 	// Since we reinitialized our screen surfaces we know nothing has been
 	// drawn so far. Sometimes we still end up with dirty screen bits in the
 	// list. Clearing it avoids invalid overlay writes when the backend
@@ -545,6 +762,96 @@ void WidgetDrawData::calcBackgroundOffset() {
 	_backgroundOffset = maxShadow;
 }
 
+bool WidgetDrawData::calcDrawnArea(Graphics::VectorRenderer *renderer, const Common::Rect &area, uint32 dynamic, Common::Rect &drawn) const {
+	drawn = Common::Rect();
+
+	// Plain lines and squares are drawn faster than their background is compared
+	bool expensive = false;
+
+	for (Common::List<Graphics::DrawStep>::const_iterator step = _steps.begin(); step != _steps.end(); ++step) {
+		if (step->drawingCall == &Graphics::VectorRenderer::drawCallback_FILLSURFACE)
+			return false;
+
+		if (step->drawingCall == &Graphics::VectorRenderer::drawCallback_VOID)
+			continue;
+
+		// Scaled steps are positioned relative to the surface origin
+		if (step->scale != (1 << 16) && step->scale != 0)
+			return false;
+
+		if (step->fillMode == Graphics::VectorRenderer::kFillGradient || step->shadow ||
+		    step->drawingCall == &Graphics::VectorRenderer::drawCallback_ROUNDSQ ||
+		    step->drawingCall == &Graphics::VectorRenderer::drawCallback_CIRCLE)
+			expensive = true;
+
+		const Common::Rect stepArea = renderer->stepGetDrawnArea(*step, area, dynamic);
+		if (drawn.isEmpty())
+			drawn = stepArea;
+		else if (!stepArea.isEmpty())
+			drawn.extend(stepArea);
+	}
+
+	return expensive;
+}
+
+void ThemeEngine::renderDrawData(const WidgetDrawData *data, const Common::Rect &area, uint32 dynamic) {
+	Graphics::Surface &surface = *_vectorRenderer->getSurface();
+	Common::Rect drawn;
+
+	if (_drawCache->isEnabled() && data->calcDrawnArea(_vectorRenderer, area, dynamic, drawn)) {
+		drawn.clip(surface.w, surface.h);
+		if (drawn.isEmpty())
+			return;
+
+		// Comparing and copying big items like dialog backgrounds costs more
+		// than drawing them, so only the ones the cache would keep are looked up
+		if (_drawCache->fits(drawn.width(), drawn.height(), surface.format.bytesPerPixel)) {
+			DrawDataCache::Key key;
+			key.data = data;
+			key.dynamic = dynamic;
+			key.area = area;
+			key.area.translate(-drawn.left, -drawn.top);
+			key.w = drawn.width();
+			key.h = drawn.height();
+			key.shadows = _vectorRenderer->shadowsEnabled();
+			_vectorRenderer->getColors(key.colors);
+
+			if (_drawCache->blit(key, surface, drawn))
+				return;
+
+			Graphics::Surface *background = new Graphics::Surface();
+			background->copyFrom(surface.getSubArea(drawn));
+
+			for (Common::List<Graphics::DrawStep>::const_iterator step = data->_steps.begin(); step != data->_steps.end(); ++step)
+				_vectorRenderer->drawStep(area, *step, dynamic);
+
+			_drawCache->store(key, background, surface, drawn);
+			return;
+		}
+	}
+
+	for (Common::List<Graphics::DrawStep>::const_iterator step = data->_steps.begin(); step != data->_steps.end(); ++step)
+		_vectorRenderer->drawStep(area, *step, dynamic);
+}
+
+void ThemeEngine::drawRenderCacheStats() {
+	const uint32 hits = _drawCache->getHits();
+	const uint32 lookups = hits + _drawCache->getMisses();
+	if (!_showDrawCacheStats || !lookups || lookups == _drawCacheStatsShown)
+		return;
+
+	_drawCacheStatsShown = lookups;
+
+	const Common::String stats = Common::String::format("Render cache: %u%% of %u hit, %u KB",
+	                                                    hits * 100 / lookups, lookups, _drawCache->getSize() / 1024);
+	const Common::Rect area(0, 0, MIN<int>(_font->getStringWidth(stats) + 4, _screen.w), MIN<int>(_font->getFontHeight() + 2, _screen.h));
+
+	restoreBackground(area);
+	_font->drawString(&_screen, stats, area.left + 2, area.top + 1, area.width() - 4,
+	                  _overlayFormat.RGBToColor(0xFF, 0xFF, 0x00), Graphics::kTextAlignLeft, 0, false);
+	addDirtyRect(area);
+}
+
 void ThemeEngine::restoreBackground(Common::Rect r) {
 	r.clip(_screen.w, _screen.h);
 	_vectorRenderer->blitSurface(&_backBuffer, r);
@@ -584,6 +891,9 @@ bool ThemeEngine::addFont(TextData textId, const Common::String &file, const Com
 		delete _texts[textId];
 
 	_texts[textId] = new TextDrawData;
+	_texts[textId]->_file = file;
+	_texts[textId]->_scalableFile = scalableFile;
+	_texts[textId]->_pointSize = pointsize;
 
 	if (file == "default") {
 		_texts[textId]->_fontPtr = _font;
@@ -688,11 +998,21 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 
 	debug(6, "Loading theme %s", themeId.c_str());
 
-	if (themeId == "builtin") {
-		_themeOk = loadDefaultXML();
+	if (loadThemeCache()) {
+		_themeOk = true;
 	} else {
-		// Load the archive containing image and XML data
-		_themeOk = loadThemeXML(themeId);
+		// Drop whatever an outdated or broken cache left behind
+		unloadTheme();
+
+		if (themeId == "builtin") {
+			_themeOk = loadDefaultXML();
+		} else {
+			// Load the archive containing image and XML data
+			_themeOk = loadThemeXML(themeId);
+		}
+
+		if (_themeOk)
+			saveThemeCache();
 	}
 
 	if (!_themeOk) {
@@ -710,9 +1030,6 @@ void ThemeEngine::loadTheme(const Common::String &themeId) {
 }
 
 void ThemeEngine::unloadTheme() {
-	if (!_themeOk)
-		return;
-
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
 		_widgets[i] = 0;
@@ -728,21 +1045,24 @@ void ThemeEngine::unloadTheme() {
 		_textColors[i] = 0;
 	}
 
+	_cursorFile.clear();
+	_drawCache->clear();
 	_themeEval->reset();
 	_themeOk = false;
 }
 
-bool ThemeEngine::loadDefaultXML() {
-
-	// The default XML theme is included on runtime from a pregenerated
-	// file inside the themes directory.
-	// Use the Python script "makedeftheme.py" to convert a normal XML theme
-	// into the "default.inc" file, which is ready to be included in the code.
 #ifndef DISABLE_GUI_BUILTIN_THEME
-	const char *defaultXML =
+// The default XML theme is included on runtime from a pregenerated
+// file inside the themes directory.
+// Use the Python script "makedeftheme.py" to convert a normal XML theme
+// into the "default.inc" file, which is ready to be included in the code.
+static const char *const defaultXML =
 #include "themes/default.inc"
-	    ;
+    ;
+#endif
 
+bool ThemeEngine::loadDefaultXML() {
+#ifndef DISABLE_GUI_BUILTIN_THEME
 	if (!_parser->loadBuffer((const byte *)defaultXML, strlen(defaultXML)))
 		return false;
 
@@ -816,6 +1136,389 @@ bool ThemeEngine::loadThemeXML(const Common::String &themeId) {
 
 
 
+/**********************************************************
+ * Theme cache
+ *********************************************************/
+#define THEME_CACHE_VERSION 3
+
+static void writeCacheString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeString(str);
+	stream.writeByte('\n');
+}
+
+static void writeCacheColor(Common::WriteStream &stream, const Graphics::DrawStep::Color &color) {
+	stream.writeByte(color.r);
+	stream.writeByte(color.g);
+	stream.writeByte(color.b);
+	stream.writeByte(color.set);
+}
+
+static void readCacheColor(Common::SeekableReadStream &stream, Graphics::DrawStep::Color &color) {
+	color.r = stream.readByte();
+	color.g = stream.readByte();
+	color.b = stream.readByte();
+	color.set = stream.readByte() != 0;
+}
+
+bool ThemeEngine::getThemeStamp(uint32 &size, uint32 &modificationTime) const {
+	if (_themeFile.empty()) {
+#ifndef DISABLE_GUI_BUILTIN_THEME
+		// The builtin theme only changes along with the version, but its
+		// hash doesn't hurt either
+		size = strlen(defaultXML);
+		modificationTime = Common::hashit(defaultXML);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	size = _themeArchiveSize;
+	modificationTime = _themeArchiveTime;
+	return _themeArchiveTime != 0;
+}
+
+Common::FSNode ThemeEngine::getThemeCacheFile() const {
+	const Common::String configFile = _system->getDefaultConfigFileName();
+	if (configFile.empty())
+		return Common::FSNode();
+
+	// Themes found through SearchMan get the "builtin" id, so name the
+	// cache after the theme file instead
+	Common::String name = "builtin";
+	if (!_themeFile.empty()) {
+		name = Common::FSNode(_themeFile).getName();
+		if (name.matchString("*.zip", true))
+			name = Common::String(name.c_str(), name.size() - 4);
+	}
+
+	name += ".themecache";
+	return Common::FSNode(configFile).getParent().getChild(name);
+}
+
+Common::String ThemeEngine::getBitmapName(const Graphics::Surface *surf) const {
+	for (ImagesMap::const_iterator i = _bitmaps.begin(); i != _bitmaps.end(); ++i) {
+		if (i->_value == surf)
+			return i->_key;
+	}
+
+	return Common::String();
+}
+
+void ThemeEngine::saveThemeCache() {
+	uint32 themeSize, themeTime;
+	if (!getThemeStamp(themeSize, themeTime))
+		return;
+
+	Common::FSNode node = getThemeCacheFile();
+	Common::DumpFile file;
+	if (!file.open(node)) {
+		debug(2, "Could not write the cache of theme '%s'", _themeId.c_str());
+		return;
+	}
+
+	// The header tells which theme and display the cache is valid for
+	file.writeUint32BE(MKTAG('S','V','T','C'));
+	file.writeUint32BE(THEME_CACHE_VERSION);
+	writeCacheString(file, gScummVMFullVersion);
+	writeCacheString(file, _themeFile);
+	file.writeUint32BE(themeSize);
+	file.writeUint32BE(themeTime);
+	file.writeUint16BE(_system->getOverlayWidth());
+	file.writeUint16BE(_system->getOverlayHeight());
+	file.writeByte(_overlayFormat.bytesPerPixel);
+	file.writeByte(_overlayFormat.rLoss);
+	file.writeByte(_overlayFormat.gLoss);
+	file.writeByte(_overlayFormat.bLoss);
+	file.writeByte(_overlayFormat.aLoss);
+	file.writeByte(_overlayFormat.rShift);
+	file.writeByte(_overlayFormat.gShift);
+	file.writeByte(_overlayFormat.bShift);
+	file.writeByte(_overlayFormat.aShift);
+
+	writeCacheString(file, _themeName);
+
+	// Bitmaps, already converted to the overlay format
+	file.writeUint32BE(_bitmaps.size());
+	for (ImagesMap::const_iterator i = _bitmaps.begin(); i != _bitmaps.end(); ++i) {
+		const Graphics::Surface *surf = i->_value;
+
+		writeCacheString(file, i->_key);
+		file.writeByte(surf != 0);
+		if (!surf)
+			continue;
+
+		file.writeUint16BE(surf->w);
+		file.writeUint16BE(surf->h);
+		for (int y = 0; y < surf->h; ++y)
+			file.write(surf->getBasePtr(0, y), surf->w * surf->format.bytesPerPixel);
+	}
+
+	writeCacheString(file, _cursorFile);
+	file.writeSint16BE(_cursorHotspotX);
+	file.writeSint16BE(_cursorHotspotY);
+
+	// Fonts are reloaded through the font manager, so only how they were
+	// specified is stored
+	for (int i = 0; i < kTextDataMAX; ++i) {
+		file.writeByte(_texts[i] != 0);
+		if (!_texts[i])
+			continue;
+
+		writeCacheString(file, _texts[i]->_file);
+		writeCacheString(file, _texts[i]->_scalableFile);
+		file.writeSint32BE(_texts[i]->_pointSize);
+	}
+
+	for (int i = 0; i < kTextColorMAX; ++i) {
+		file.writeByte(_textColors[i] != 0);
+		if (!_textColors[i])
+			continue;
+
+		file.writeByte(_textColors[i]->r);
+		file.writeByte(_textColors[i]->g);
+		file.writeByte(_textColors[i]->b);
+	}
+
+	for (int i = 0; i < kDrawDataMAX; ++i) {
+		const WidgetDrawData *widget = _widgets[i];
+
+		file.writeByte(widget != 0);
+		if (!widget)
+			continue;
+
+		file.writeByte(widget->_buffer);
+		file.writeSint16BE(widget->_textDataId);
+		file.writeSint16BE(widget->_textColorId);
+		file.writeSint16BE(widget->_textAlignH);
+		file.writeSint16BE(widget->_textAlignV);
+
+		file.writeUint32BE(widget->_steps.size());
+		for (Common::List<Graphics::DrawStep>::const_iterator step = widget->_steps.begin(); step != widget->_steps.end(); ++step) {
+			writeCacheColor(file, step->fgColor);
+			writeCacheColor(file, step->bgColor);
+			writeCacheColor(file, step->gradColor1);
+			writeCacheColor(file, step->gradColor2);
+			writeCacheColor(file, step->bevelColor);
+			file.writeByte(step->autoWidth);
+			file.writeByte(step->autoHeight);
+			file.writeSint16BE(step->x);
+			file.writeSint16BE(step->y);
+			file.writeSint16BE(step->w);
+			file.writeSint16BE(step->h);
+			file.writeSint16BE(step->padding.left);
+			file.writeSint16BE(step->padding.top);
+			file.writeSint16BE(step->padding.right);
+			file.writeSint16BE(step->padding.bottom);
+			file.writeByte(step->xAlign);
+			file.writeByte(step->yAlign);
+			file.writeByte(step->shadow);
+			file.writeByte(step->stroke);
+			file.writeByte(step->factor);
+			file.writeByte(step->radius);
+			file.writeByte(step->bevel);
+			file.writeByte(step->fillMode);
+			file.writeByte(step->shadowFillMode);
+			file.writeUint32BE(step->extraData);
+			file.writeUint32BE(step->scale);
+			writeCacheString(file, ThemeParser::getDrawingFunctionName(step->drawingCall));
+			writeCacheString(file, step->blitSrc ? getBitmapName(step->blitSrc) : Common::String());
+		}
+	}
+
+	_themeEval->saveToCache(file);
+
+	file.finalize();
+	if (file.err()) {
+		warning("Failed to write the cache of theme '%s'", _themeId.c_str());
+		file.close();
+		// Leave no truncated cache behind
+		file.open(node);
+	}
+}
+
+bool ThemeEngine::loadThemeCache() {
+	uint32 themeSize, themeTime;
+	if (!getThemeStamp(themeSize, themeTime))
+		return false;
+
+	Common::FSNode node = getThemeCacheFile();
+	if (!node.exists() || !node.isReadable())
+		return false;
+
+	// Caches are small enough to be read in one go
+	Common::SeekableReadStream *file = node.createReadStream();
+	if (!file)
+		return false;
+
+	Common::SeekableReadStream *stream = file->readStream(file->size());
+	delete file;
+	if (!stream)
+		return false;
+
+	if (stream->readUint32BE() != MKTAG('S','V','T','C') ||
+	    stream->readUint32BE() != THEME_CACHE_VERSION ||
+	    stream->readLine() != gScummVMFullVersion ||
+	    stream->readLine() != _themeFile ||
+	    stream->readUint32BE() != themeSize ||
+	    stream->readUint32BE() != themeTime ||
+	    stream->readUint16BE() != _system->getOverlayWidth() ||
+	    stream->readUint16BE() != _system->getOverlayHeight() ||
+	    stream->readByte() != _overlayFormat.bytesPerPixel ||
+	    stream->readByte() != _overlayFormat.rLoss ||
+	    stream->readByte() != _overlayFormat.gLoss ||
+	    stream->readByte() != _overlayFormat.bLoss ||
+	    stream->readByte() != _overlayFormat.aLoss ||
+	    stream->readByte() != _overlayFormat.rShift ||
+	    stream->readByte() != _overlayFormat.gShift ||
+	    stream->readByte() != _overlayFormat.bShift ||
+	    stream->readByte() != _overlayFormat.aShift) {
+		debug(2, "The cache of theme '%s' is outdated", _themeId.c_str());
+		delete stream;
+		return false;
+	}
+
+	_themeName = stream->readLine();
+
+	bool success = true;
+	uint32 bitmaps = stream->readUint32BE();
+	for (uint32 i = 0; i < bitmaps && success && !stream->eos(); ++i) {
+		const Common::String name = stream->readLine();
+
+		Graphics::Surface *surf = 0;
+		if (stream->readByte()) {
+			const uint16 w = stream->readUint16BE();
+			const uint16 h = stream->readUint16BE();
+
+			// Don't trust a corrupt size to allocate the surface
+			const uint32 left = stream->size() - stream->pos();
+			if (!w || !h || (uint32)w * h > left / _overlayFormat.bytesPerPixel) {
+				success = false;
+				break;
+			}
+
+			surf = new Graphics::Surface();
+			surf->create(w, h, _overlayFormat);
+			for (int y = 0; y < surf->h; ++y)
+				stream->read(surf->getBasePtr(0, y), surf->w * surf->format.bytesPerPixel);
+		}
+
+		if (_bitmaps.contains(name) && _bitmaps[name]) {
+			_bitmaps[name]->free();
+			delete _bitmaps[name];
+		}
+
+		_bitmaps[name] = surf;
+	}
+
+	const Common::String cursorFile = stream->readLine();
+	const int cursorHotspotX = stream->readSint16BE();
+	const int cursorHotspotY = stream->readSint16BE();
+	if (success && !cursorFile.empty())
+		createCursor(cursorFile, cursorHotspotX, cursorHotspotY);
+
+	for (int i = 0; i < kTextDataMAX && success; ++i) {
+		if (!stream->readByte())
+			continue;
+
+		const Common::String fontFile = stream->readLine();
+		const Common::String scalableFile = stream->readLine();
+		const int pointSize = stream->readSint32BE();
+		addFont((TextData)i, fontFile, scalableFile, pointSize);
+	}
+
+	for (int i = 0; i < kTextColorMAX && success; ++i) {
+		if (!stream->readByte())
+			continue;
+
+		const int r = stream->readByte();
+		const int g = stream->readByte();
+		const int b = stream->readByte();
+		addTextColor((TextColor)i, r, g, b);
+	}
+
+	for (int i = 0; i < kDrawDataMAX && success && !stream->eos(); ++i) {
+		if (!stream->readByte())
+			continue;
+
+		WidgetDrawData *widget = new WidgetDrawData;
+		_widgets[i] = widget;
+
+		widget->_buffer = stream->readByte() != 0;
+		widget->_textDataId = (TextData)stream->readSint16BE();
+		widget->_textColorId = (TextColor)stream->readSint16BE();
+		widget->_textAlignH = (Graphics::TextAlign)stream->readSint16BE();
+		widget->_textAlignV = (TextAlignVertical)stream->readSint16BE();
+
+		uint32 steps = stream->readUint32BE();
+		for (uint32 j = 0; j < steps && !stream->eos(); ++j) {
+			Graphics::DrawStep step;
+
+			readCacheColor(*stream, step.fgColor);
+			readCacheColor(*stream, step.bgColor);
+			readCacheColor(*stream, step.gradColor1);
+			readCacheColor(*stream, step.gradColor2);
+			readCacheColor(*stream, step.bevelColor);
+			step.autoWidth = stream->readByte() != 0;
+			step.autoHeight = stream->readByte() != 0;
+			step.x = stream->readSint16BE();
+			step.y = stream->readSint16BE();
+			step.w = stream->readSint16BE();
+			step.h = stream->readSint16BE();
+			step.padding.left = stream->readSint16BE();
+			step.padding.top = stream->readSint16BE();
+			step.padding.right = stream->readSint16BE();
+			step.padding.bottom = stream->readSint16BE();
+			step.xAlign = (Graphics::DrawStep::VectorAlignment)stream->readByte();
+			step.yAlign = (Graphics::DrawStep::VectorAlignment)stream->readByte();
+			step.shadow = stream->readByte();
+			step.stroke = stream->readByte();
+			step.factor = stream->readByte();
+			step.radius = stream->readByte();
+			step.bevel = stream->readByte();
+			step.fillMode = stream->readByte();
+			step.shadowFillMode = stream->readByte();
+			step.extraData = stream->readUint32BE();
+			step.scale = stream->readUint32BE();
+			step.drawingCall = ThemeParser::getDrawingFunctionCallback(stream->readLine());
+
+			const Common::String blitSrc = stream->readLine();
+			step.blitSrc = blitSrc.empty() ? 0 : getBitmap(blitSrc);
+
+			if (!step.drawingCall || (!blitSrc.empty() && !step.blitSrc)) {
+				success = false;
+				break;
+			}
+
+			widget->_steps.push_back(step);
+		}
+	}
+
+	success = success && _themeEval->loadFromCache(*stream) && !stream->err() && !stream->eos();
+	delete stream;
+
+	if (!success) {
+		warning("The cache of theme '%s' is corrupt", _themeId.c_str());
+
+		// Bitmaps outlive the theme, so don't leave broken ones behind
+		for (ImagesMap::iterator i = _bitmaps.begin(); i != _bitmaps.end(); ++i) {
+			Graphics::Surface *surf = i->_value;
+			if (surf) {
+				surf->free();
+				delete surf;
+			}
+		}
+		_bitmaps.clear();
+
+		return false;
+	}
+
+	debug(3, "Loaded theme '%s' from its cache", _themeId.c_str());
+	return true;
+}
+
+
+
 /**********************************************************
  * Drawing Queue management
  *********************************************************/
@@ -1246,6 +1949,8 @@ void ThemeEngine::updateScreen(bool render) {
 		_screenQueue.clear();
 	}
 
+	drawRenderCacheStats();
+
 	if (render)
 		renderDirtyScreen();
 }
@@ -1381,6 +2086,7 @@ bool ThemeEngine::createCursor(const Common::String &filename, int hotspotX, int
 	}
 
 	_useCursor = true;
+	_cursorFile = filename;
 	_cursorPalSize = colorsFound;
 
 	return true;
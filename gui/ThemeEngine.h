@@ -48,6 +48,7 @@ class VectorRenderer;
 namespace GUI {
 
 struct WidgetDrawData;
+class DrawDataCache;
 struct TextDrawData;
 struct TextColorData;
 class Dialog;
@@ -494,6 +495,13 @@ public:
 	inline ThemeEval *getEvaluator() { return _themeEval; }
 	inline Graphics::VectorRenderer *renderer() { return _vectorRenderer; }
 
+	/**
+	 * Draws all steps of the given DrawData onto the active surface of the
+	 * renderer. Results are kept in a cache, so drawing the same item with
+	 * the same size onto the same background again is a plain copy.
+	 */
+	void renderDrawData(const WidgetDrawData *data, const Common::Rect &area, uint32 dynamic);
+
 	inline bool supportsImages() const { return true; }
 	inline bool ownCursor() const { return _useCursor; }
 
@@ -559,6 +567,39 @@ protected:
 	 */
 	void unloadTheme();
 
+	/**
+	 * Determines the size and modification time of the current theme, which
+	 * tell whether its cache is still up to date.
+	 *
+	 * @returns false if the theme can't be cached
+	 */
+	bool getThemeStamp(uint32 &size, uint32 &modificationTime) const;
+
+	/**
+	 * Returns the file of the binary cache for the current theme. It is
+	 * stored next to the config file. There is only one per theme, which
+	 * is replaced when the overlay size changes, so that caches for sizes
+	 * no longer in use don't pile up.
+	 */
+	Common::FSNode getThemeCacheFile() const;
+
+	/**
+	 * Loads the current theme from its binary cache, which holds the parsed
+	 * DrawData steps, the evaluated layouts and the decoded bitmaps.
+	 *
+	 * @returns false if there is no valid cache for the theme, in which
+	 *          case it has to be parsed from its STX files.
+	 */
+	bool loadThemeCache();
+
+	/**
+	 * Writes the currently loaded theme to its binary cache.
+	 */
+	void saveThemeCache();
+
+	/** Returns the filename the given bitmap was loaded from, or an empty string. */
+	Common::String getBitmapName(const Graphics::Surface *surf) const;
+
 	const Graphics::Font *loadScalableFont(const Common::String &filename, const Common::String &charset, const int pointsize, Common::String &name);
 	const Graphics::Font *loadFont(const Common::String &filename, Common::String &name);
 	Common::String genCacheFilename(const Common::String &filename) const;
@@ -572,6 +613,12 @@ protected:
 	 */
 	void renderDirtyScreen();
 
+	/**
+	 * Draws the hit rate of the DrawData cache into the top left corner
+	 * of the screen, if enabled with the "gui_render_cache_stats" option.
+	 */
+	void drawRenderCacheStats();
+
 	/**
 	 * Generates a DrawQueue item and enqueues it so it's drawn to the screen
 	 * when the drawing queue is processed.
@@ -658,6 +705,11 @@ protected:
 	/** Array of all font colors available. */
 	TextColorData *_textColors[kTextColorMAX];
 
+	/** Cache of rendered DrawData items. */
+	DrawDataCache *_drawCache;
+	bool _showDrawCacheStats;
+	uint32 _drawCacheStatsShown; ///< Cache lookups when the stats were last drawn
+
 	ImagesMap _bitmaps;
 	Graphics::PixelFormat _overlayFormat;
 #ifdef USE_RGB_COLOR
@@ -682,8 +734,11 @@ protected:
 	Common::String _themeFile;
 	Common::Archive *_themeArchive;
 	Common::SearchSet _themeFiles;
+	uint32 _themeArchiveSize; ///< Size of a zipped theme, or 0 if unknown
+	uint32 _themeArchiveTime; ///< Modification time of a zipped theme or a checksum standing in for it, 0 for other themes
 
 	bool _useCursor;
+	Common::String _cursorFile;
 	int _cursorHotspotX, _cursorHotspotY;
 	enum {
 		MAX_CURS_COLORS = 255
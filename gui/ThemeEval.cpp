@@ -24,6 +24,7 @@
 
 #include "graphics/scaler.h"
 
+#include "common/stream.h"
 #include "common/system.h"
 #include "common/tokenizer.h"
 
@@ -50,6 +51,50 @@ void ThemeEval::reset() {
 	_layouts.clear();
 }
 
+void ThemeEval::saveToCache(Common::WriteStream &stream) const {
+	stream.writeUint32BE(_vars.size());
+	for (VariablesMap::const_iterator i = _vars.begin(); i != _vars.end(); ++i) {
+		stream.writeString(i->_key);
+		stream.writeByte('\n');
+		stream.writeSint32BE(i->_value);
+	}
+
+	stream.writeUint32BE(_layouts.size());
+	for (LayoutsMap::const_iterator i = _layouts.begin(); i != _layouts.end(); ++i) {
+		stream.writeString(i->_key);
+		stream.writeByte('\n');
+		i->_value->saveToCache(stream);
+	}
+}
+
+bool ThemeEval::loadFromCache(Common::SeekableReadStream &stream) {
+	reset();
+
+	uint32 vars = stream.readUint32BE();
+	for (uint32 i = 0; i < vars && !stream.eos(); ++i) {
+		Common::String name = stream.readLine();
+		_vars[name] = stream.readSint32BE();
+	}
+
+	uint32 layouts = stream.readUint32BE();
+	for (uint32 i = 0; i < layouts && !stream.eos(); ++i) {
+		Common::String name = stream.readLine();
+		ThemeLayout *layout = ThemeLayout::loadFromCache(stream);
+		if (!layout)
+			break;
+
+		delete _layouts[name];
+		_layouts[name] = layout;
+	}
+
+	if (_vars.size() != vars || _layouts.size() != layouts || stream.err() || stream.eos()) {
+		reset();
+		return false;
+	}
+
+	return true;
+}
+
 bool ThemeEval::getWidgetData(const Common::String &widget, int16 &x, int16 &y, uint16 &w, uint16 &h) {
 	Common::StringTokenizer tokenizer(widget, ".");
 
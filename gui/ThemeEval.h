@@ -97,6 +97,17 @@ public:
 
 	void reset();
 
+	/** Write all variables and dialog layouts, as currently laid out, to a theme cache. */
+	void saveToCache(Common::WriteStream &stream) const;
+
+	/**
+	 * Replace all variables and dialog layouts with those read from a
+	 * theme cache written by saveToCache().
+	 *
+	 * @return false if the cache is truncated or corrupt
+	 */
+	bool loadFromCache(Common::SeekableReadStream &stream);
+
 private:
 	VariablesMap _vars;
 	VariablesMap _builtin;
@@ -21,6 +21,7 @@
  */
 
 #include "common/util.h"
+#include "common/stream.h"
 #include "common/system.h"
 
 #include "gui/ThemeLayout.h"
@@ -81,6 +82,118 @@ Graphics::TextAlign ThemeLayout::getWidgetTextHAlign(const Common::String &name)
 	return Graphics::kTextAlignInvalid;
 }
 
+void ThemeLayout::saveToCache(Common::WriteStream &stream) const {
+	saveCacheHeader(stream);
+
+	stream.writeSint16BE(_x);
+	stream.writeSint16BE(_y);
+	stream.writeSint16BE(_w);
+	stream.writeSint16BE(_h);
+	stream.writeSint16BE(_defaultW);
+	stream.writeSint16BE(_defaultH);
+	stream.writeSint16BE(_padding.left);
+	stream.writeSint16BE(_padding.right);
+	stream.writeSint16BE(_padding.top);
+	stream.writeSint16BE(_padding.bottom);
+	stream.writeByte(_centered);
+	stream.writeSint16BE(_textHAlign);
+
+	stream.writeUint16BE(_children.size());
+	for (uint i = 0; i < _children.size(); ++i)
+		_children[i]->saveToCache(stream);
+}
+
+ThemeLayout *ThemeLayout::loadFromCache(Common::SeekableReadStream &stream, ThemeLayout *parent) {
+	ThemeLayout *layout = 0;
+
+	switch (stream.readByte()) {
+	case kCacheMain: {
+		int16 x = stream.readSint16BE();
+		int16 y = stream.readSint16BE();
+		if (parent)
+			return 0;
+		layout = new ThemeLayoutMain(x, y, -1, -1);
+		break;
+	}
+
+	case kCacheStacked: {
+		LayoutType type = (LayoutType)stream.readByte();
+		int8 spacing = stream.readSByte();
+		if (!parent || (type != kLayoutVertical && type != kLayoutHorizontal))
+			return 0;
+		layout = new ThemeLayoutStacked(parent, type, spacing, false);
+		break;
+	}
+
+	case kCacheWidget: {
+		Common::String name = stream.readLine();
+		if (!parent)
+			return 0;
+		layout = new ThemeLayoutWidget(parent, name, -1, -1, Graphics::kTextAlignInvalid);
+		break;
+	}
+
+	case kCacheSpacing:
+		if (!parent)
+			return 0;
+		layout = new ThemeLayoutSpacing(parent, 0);
+		break;
+
+	default:
+		return 0;
+	}
+
+	layout->_x = stream.readSint16BE();
+	layout->_y = stream.readSint16BE();
+	layout->_w = stream.readSint16BE();
+	layout->_h = stream.readSint16BE();
+	layout->_defaultW = stream.readSint16BE();
+	layout->_defaultH = stream.readSint16BE();
+	layout->_padding.left = stream.readSint16BE();
+	layout->_padding.right = stream.readSint16BE();
+	layout->_padding.top = stream.readSint16BE();
+	layout->_padding.bottom = stream.readSint16BE();
+	layout->_centered = stream.readByte() != 0;
+	layout->_textHAlign = (Graphics::TextAlign)stream.readSint16BE();
+
+	uint16 children = stream.readUint16BE();
+	for (uint i = 0; i < children && !stream.err() && !stream.eos(); ++i) {
+		ThemeLayout *child = loadFromCache(stream, layout);
+		if (!child)
+			break;
+		layout->addChild(child);
+	}
+
+	if (layout->_children.size() != children || stream.err() || stream.eos()) {
+		delete layout;
+		return 0;
+	}
+
+	return layout;
+}
+
+void ThemeLayoutMain::saveCacheHeader(Common::WriteStream &stream) const {
+	stream.writeByte(kCacheMain);
+	stream.writeSint16BE(_defaultX);
+	stream.writeSint16BE(_defaultY);
+}
+
+void ThemeLayoutStacked::saveCacheHeader(Common::WriteStream &stream) const {
+	stream.writeByte(kCacheStacked);
+	stream.writeByte(_type);
+	stream.writeSByte(_spacing);
+}
+
+void ThemeLayoutWidget::saveCacheHeader(Common::WriteStream &stream) const {
+	stream.writeByte(kCacheWidget);
+	stream.writeString(_name);
+	stream.writeByte('\n');
+}
+
+void ThemeLayoutSpacing::saveCacheHeader(Common::WriteStream &stream) const {
+	stream.writeByte(kCacheSpacing);
+}
+
 int16 ThemeLayoutStacked::getParentWidth() {
 	ThemeLayout *p = _parent;
 	int width = 0;
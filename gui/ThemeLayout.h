@@ -27,6 +27,11 @@
 #include "common/rect.h"
 #include "graphics/font.h"
 
+namespace Common {
+class SeekableReadStream;
+class WriteStream;
+}
+
 #ifdef LAYOUT_DEBUG_DIALOG
 namespace Graphics {
 class Surface;
@@ -95,6 +100,17 @@ protected:
 
 	virtual ThemeLayout *makeClone(ThemeLayout *newParent) = 0;
 
+	/** Kinds of layouts, as stored in theme caches. */
+	enum CacheType {
+		kCacheMain,
+		kCacheStacked,
+		kCacheWidget,
+		kCacheSpacing
+	};
+
+	/** Write the kind of this layout and its construction parameters. */
+	virtual void saveCacheHeader(Common::WriteStream &stream) const = 0;
+
 public:
 	virtual bool getWidgetData(const Common::String &name, int16 &x, int16 &y, uint16 &w, uint16 &h);
 
@@ -104,6 +120,16 @@ public:
 
 	Graphics::TextAlign getTextHAlign() { return _textHAlign; }
 
+	/** Write this layout and its children, as currently laid out, to a theme cache. */
+	void saveToCache(Common::WriteStream &stream) const;
+
+	/**
+	 * Read a layout written by saveToCache(), including its children.
+	 *
+	 * @return the layout, or 0 if the cache is truncated or corrupt
+	 */
+	static ThemeLayout *loadFromCache(Common::SeekableReadStream &stream, ThemeLayout *parent = 0);
+
 #ifdef LAYOUT_DEBUG_DIALOG
 	void debugDraw(Graphics::Surface *screen, const Graphics::Font *font);
 
@@ -143,6 +169,7 @@ public:
 protected:
 	LayoutType getLayoutType() { return kLayoutMain; }
 	ThemeLayout *makeClone(ThemeLayout *newParent) { assert(!"Do not copy Main Layouts!"); return 0; }
+	void saveCacheHeader(Common::WriteStream &stream) const;
 
 	int16 _defaultX;
 	int16 _defaultY;
@@ -189,6 +216,8 @@ protected:
 		return n;
 	}
 
+	void saveCacheHeader(Common::WriteStream &stream) const;
+
 	const LayoutType _type;
 	int8 _spacing;
 };
@@ -220,6 +249,8 @@ protected:
 		return n;
 	}
 
+	void saveCacheHeader(Common::WriteStream &stream) const;
+
 	Common::String _name;
 };
 
@@ -249,6 +280,8 @@ protected:
 		n->_parent = newParent;
 		return n;
 	}
+
+	void saveCacheHeader(Common::WriteStream &stream) const;
 };
 
 }
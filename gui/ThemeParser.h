@@ -26,6 +26,8 @@
 #include "common/scummsys.h"
 #include "common/xmlparser.h"
 
+#include "graphics/VectorRenderer.h"
+
 namespace GUI {
 
 class ThemeEngine;
@@ -47,6 +49,12 @@ public:
 		return true;
 	}
 
+	/** Look up the drawing function with the given name, as used by drawsteps. */
+	static Graphics::DrawingFunctionCallback getDrawingFunctionCallback(const Common::String &name);
+
+	/** Look up the name of a drawing function, the inverse of getDrawingFunctionCallback(). */
+	static const char *getDrawingFunctionName(Graphics::DrawingFunctionCallback callback);
+
 protected:
 	ThemeEngine *_theme;
 
@@ -25,7 +25,12 @@
 
 #include "common/debug.h"
 #include "common/debug-channels.h"
+#include "common/file.h"
+#include "common/profiler.h"
 #include "common/system.h"
+#include "common/timer.h"
+
+#include "audio/soundcache.h"
 
 #include "engines/engine.h"
 
@@ -66,6 +71,10 @@ Debugger::Debugger() {
 	registerCmd("debugflag_list",		WRAP_METHOD(Debugger, cmdDebugFlagsList));
 	registerCmd("debugflag_enable",	WRAP_METHOD(Debugger, cmdDebugFlagEnable));
 	registerCmd("debugflag_disable",	WRAP_METHOD(Debugger, cmdDebugFlagDisable));
+
+	registerCmd("profile",			WRAP_METHOD(Debugger, cmdProfile));
+	registerCmd("timers",			WRAP_METHOD(Debugger, cmdTimers));
+	registerCmd("soundcache",		WRAP_METHOD(Debugger, cmdSoundCache));
 }
 
 Debugger::~Debugger() {
@@ -572,6 +581,92 @@ bool Debugger::cmdDebugFlagDisable(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::cmdProfile(int argc, const char **argv) {
+	if (argc >= 2 && !scumm_stricmp(argv[1], "start")) {
+		ProfMan.setEnabled(true);
+		debugPrintf("Started recording profiling zones\n");
+	} else if (argc >= 2 && !scumm_stricmp(argv[1], "stop")) {
+		ProfMan.setEnabled(false);
+		debugPrintf("Stopped recording profiling zones\n");
+	} else if (argc >= 2 && !scumm_stricmp(argv[1], "clear")) {
+		ProfMan.clear();
+		debugPrintf("Cleared the recorded profiling zones\n");
+	} else if (argc >= 3 && !scumm_stricmp(argv[1], "dump")) {
+		Common::DumpFile file;
+		if (!file.open(argv[2])) {
+			debugPrintf("Failed to open '%s'\n", argv[2]);
+			return true;
+		}
+
+		uint32 events = ProfMan.writeChromeTrace(file);
+		file.finalize();
+		debugPrintf("Wrote %d events to '%s'\n", events, argv[2]);
+		if (ProfMan.getDroppedEvents())
+			debugPrintf("%d events were dropped for lack of thread buffers\n", ProfMan.getDroppedEvents());
+	} else {
+		debugPrintf("Profiling is currently %s\n", Common::Profiler::isEnabled() ? "enabled" : "disabled");
+		debugPrintf("Usage: %s [start | stop | clear | dump <file>]\n", argv[0]);
+		debugPrintf("The dump is written in the Chrome trace format (see chrome://tracing)\n");
+	}
+	return true;
+}
+
+bool Debugger::cmdTimers(int argc, const char **argv) {
+	Common::TimerManager *timerManager = g_system->getTimerManager();
+
+	if (argc >= 2 && !scumm_stricmp(argv[1], "reset")) {
+		timerManager->resetTimerStats();
+		debugPrintf("Reset the timer statistics\n");
+		return true;
+	}
+
+	Common::Array<Common::TimerManager::TimerStats> stats;
+	timerManager->getTimerStats(stats);
+	if (stats.empty()) {
+		debugPrintf("No timer statistics available\n");
+		return true;
+	}
+
+	debugPrintf("%-24s %8s %8s %8s %8s %8s\n", "Timer", "Interval", "Calls", "Late avg", "Late max", "Jit max");
+	for (uint i = 0; i < stats.size(); ++i) {
+		const Common::TimerManager::TimerStats &timer = stats[i];
+		debugPrintf("%-24s %8d %8u %8u %8u %8u\n", timer.id.c_str(), timer.interval, timer.calls,
+		            timer.calls ? (uint32)(timer.totalLateness / timer.calls) : 0, timer.maxLateness, timer.maxJitter);
+
+		Common::String lateness = "  lateness", jitter = "  jitter  ";
+		for (int bucket = 0; bucket < Common::TimerManager::kStatsBuckets; ++bucket) {
+			const Common::String label = bucket + 1 < Common::TimerManager::kStatsBuckets ?
+			                             Common::String::format(" <%dms", 1 << bucket) : Common::String::format(" %dms+", 1 << (bucket - 1));
+			lateness += label + Common::String::format(" %u", timer.lateness[bucket]);
+			jitter += label + Common::String::format(" %u", timer.jitter[bucket]);
+		}
+		debugPrintf("%s\n%s\n", lateness.c_str(), jitter.c_str());
+	}
+
+	debugPrintf("Times are in microseconds, use '%s reset' to start over\n", argv[0]);
+	return true;
+}
+
+bool Debugger::cmdSoundCache(int argc, const char **argv) {
+	if (argc >= 2 && !scumm_stricmp(argv[1], "reset")) {
+		SoundCache.resetStats();
+		debugPrintf("Reset the sound cache statistics\n");
+		return true;
+	} else if (argc >= 2 && !scumm_stricmp(argv[1], "clear")) {
+		SoundCache.clear();
+		debugPrintf("Dropped all cached sounds\n");
+		return true;
+	}
+
+	const Audio::DecodedSoundCache::Stats stats = SoundCache.getStats();
+	const uint32 lookups = stats.hits + stats.misses;
+	debugPrintf("Cached sounds: %u, using %u of %u KB\n", stats.sounds, stats.memory / 1024, stats.memoryLimit / 1024);
+	debugPrintf("Hits: %u, misses: %u (%u%% hits), too large: %u, evicted: %u\n", stats.hits, stats.misses,
+	            lookups ? stats.hits * 100 / lookups : 0, stats.tooLarge, stats.evictions);
+	debugPrintf("Use '%s reset' to start counting over, '%s clear' to drop all sounds\n", argv[0], argv[0]);
+	return true;
+}
+
 // Console handler
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 bool Debugger::debuggerInputCallback(GUI::ConsoleDialog *console, const char *input, void *refCon) {
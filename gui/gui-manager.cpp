@@ -25,6 +25,7 @@
 #include "common/util.h"
 #include "common/config-manager.h"
 #include "common/algorithm.h"
+#include "common/profiler.h"
 #include "common/rect.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
@@ -289,6 +290,8 @@ void GuiManager::runLoop() {
 	bool tooltipCheck = false;
 
 	while (!_dialogStack.empty() && activeDialog == getTopDialog() && !eventMan->shouldQuit()) {
+		PROFILE_SCOPE("gui.run_loop");
+
 		redraw();
 
 		// Don't "tickle" the dialog until the theme has had a chance
@@ -846,6 +846,7 @@ void LauncherDialog::addGame() {
 			// ...so let's determine a list of candidates, games that
 			// could be contained in the specified directory.
 			GameList candidates(EngineMan.detectGames(files));
+			EngineMan.flushDetectionCache();
 
 			int idx;
 			if (candidates.empty()) {
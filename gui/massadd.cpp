@@ -26,6 +26,7 @@
 #include "common/debug.h"
 #include "common/system.h"
 #include "common/taskbar.h"
+#include "common/threadpool.h"
 #include "common/translation.h"
 
 #include "gui/launcher.h"	// For addGameToConf()
@@ -48,7 +49,13 @@ enum {
 	// Upper bound (im milliseconds) we want to spend in handleTickle.
 	// Setting this low makes the GUI more responsive but also slows
 	// down the scanning.
-	kMaxScanTime = 50
+	kMaxScanTime = 50,
+
+	// Upper bound for the number of directories which have been listed
+	// but not yet passed to the detector. Walking the tree ahead of the
+	// detector keeps it busy, this keeps the walk from running away on
+	// large collections.
+	kMaxPendingJobs = 16
 };
 
 enum {
@@ -63,6 +70,7 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	_dirsScanned(0),
 	_oldGamesCount(0),
 	_dirTotal(0),
+	_maxDetectionTasks(1),
 	_okButton(0),
 	_dirProgressText(0),
 	_gameProgressText(0) {
@@ -72,6 +80,10 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	// The dir we start our scan at
 	_scanStack.push(startDir);
 
+	// Detect as many directories at once as there are threads to run them
+	if (EngineMan.canDetectConcurrently())
+		_maxDetectionTasks = MAX<uint>(1, g_system->getThreadPool()->getThreadCount());
+
 	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
 	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
 
@@ -171,88 +183,168 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 	}
 }
 
-void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
-		return;	// We have finished scanning
+void MassAddDialog::walkDirectory(const Common::FSNode &dir) {
+	DetectionJob job;
+	job.dir = dir;
 
-	uint32 t = g_system->getMillis();
+	if (!dir.getChildren(job.files, Common::FSNode::kListAll)) {
+		return;
+	}
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
+	// Recurse into all subdirs
+	for (Common::FSList::const_iterator file = job.files.begin(); file != job.files.end(); ++file) {
+		if (file->isDirectory()) {
+			_scanStack.push(*file);
 
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
+			_dirTotal++;
 		}
+	}
 
-		// Run the detector on the dir
-		GameList candidates(EngineMan.detectGames(files));
-
-		// Just add all detected games / game variants. If we get more than one,
-		// that either means the directory contains multiple games, or the detector
-		// could not fully determine which game variant it was seeing. In either
-		// case, let the user choose which entries he wants to keep.
-		//
-		// However, we only add games which are not already in the config file.
-		for (GameList::const_iterator cand = candidates.begin(); cand != candidates.end(); ++cand) {
-			GameDescriptor result = *cand;
-			Common::String path = dir.getPath();
-
-			// Remove trailing slashes
-			while (path != "/" && path.lastChar() == '/')
-				path.deleteLastChar();
-
-			// Check for existing config entries for this path/gameid/lang/platform combination
-			if (_pathToTargets.contains(path)) {
-				bool duplicate = false;
-				const StringArray &targets = _pathToTargets[path];
-				for (StringArray::const_iterator iter = targets.begin(); iter != targets.end(); ++iter) {
-					// If the gameid, platform and language match -> skip it
-					Common::ConfigManager::Domain *dom = ConfMan.getDomain(*iter);
-					assert(dom);
-
-					if ((*dom)["gameid"] == result["gameid"] &&
-					    (*dom)["platform"] == result["platform"] &&
-					    (*dom)["language"] == result["language"]) {
-						duplicate = true;
-						break;
-					}
-				}
-				if (duplicate) {
-					_oldGamesCount++;
-					break;	// Skip duplicates
-				}
-			}
-			result["path"] = path;
-			_games.push_back(result);
+	_pendingJobs.push(job);
+}
+
+void MassAddDialog::runDetection(DetectionJob &job) {
+	job.candidates = EngineMan.detectGames(job.files);
+}
+
+/** Runs the detector on a directory on the system's thread pool. */
+class MassAddDialog::DetectionTask : public Common::ThreadTask {
+public:
+	DetectionTask(const DetectionJob &job) : _job(job) {}
+
+	virtual void run() { runDetection(_job); }
+
+	const DetectionJob &getJob() const { return _job; }
+
+private:
+	DetectionJob _job;
+};
+
+MassAddDialog::~MassAddDialog() {
+	// The detection tasks own their jobs, so they don't need the dialog,
+	// but the engines must not detect anything anymore once it's gone
+	Common::ThreadPool *pool = g_system->getThreadPool();
+	for (uint i = 0; i < _detectionTasks.size(); i++) {
+		pool->wait(_detectionTasks[i]);
+		delete _detectionTasks[i];
+	}
+}
 
-			_list->append(result.description());
+bool MassAddDialog::collectDetectionTasks() {
+	Common::ThreadPool *pool = g_system->getThreadPool();
+	bool collected = false;
+
+	for (uint i = 0; i < _detectionTasks.size();) {
+		DetectionTask *task = _detectionTasks[i];
+		if (pool->isFinished(task)) {
+			_finishedJobs.push(task->getJob());
+			delete task;
+			_detectionTasks.remove_at(i);
+			collected = true;
+		} else {
+			i++;
 		}
+	}
 
+	return collected;
+}
 
-		// Recurse into all subdirs
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			if (file->isDirectory()) {
-				_scanStack.push(*file);
+void MassAddDialog::addCandidates(const DetectionJob &job) {
+	// Just add all detected games / game variants. If we get more than one,
+	// that either means the directory contains multiple games, or the detector
+	// could not fully determine which game variant it was seeing. In either
+	// case, let the user choose which entries he wants to keep.
+	//
+	// However, we only add games which are not already in the config file.
+	for (GameList::const_iterator cand = job.candidates.begin(); cand != job.candidates.end(); ++cand) {
+		GameDescriptor result = *cand;
+		Common::String path = job.dir.getPath();
+
+		// Remove trailing slashes
+		while (path != "/" && path.lastChar() == '/')
+			path.deleteLastChar();
 
-				_dirTotal++;
+		// Check for existing config entries for this path/gameid/lang/platform combination
+		if (_pathToTargets.contains(path)) {
+			bool duplicate = false;
+			const StringArray &targets = _pathToTargets[path];
+			for (StringArray::const_iterator iter = targets.begin(); iter != targets.end(); ++iter) {
+				// If the gameid, platform and language match -> skip it
+				Common::ConfigManager::Domain *dom = ConfMan.getDomain(*iter);
+				assert(dom);
+
+				if ((*dom)["gameid"] == result["gameid"] &&
+				    (*dom)["platform"] == result["platform"] &&
+				    (*dom)["language"] == result["language"]) {
+					duplicate = true;
+					break;
+				}
+			}
+			if (duplicate) {
+				_oldGamesCount++;
+				break;	// Skip duplicates
 			}
 		}
+		result["path"] = path;
+		_games.push_back(result);
 
-		_dirsScanned++;
+		_list->append(result.description());
+	}
+
+	_dirsScanned++;
 
 #if defined(USE_TASKBAR)
-		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
+	g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
+	g_system->getTaskbarManager()->setCount(_games.size());
 #endif
+}
+
+void MassAddDialog::handleTickle() {
+	if (isScanComplete())
+		return;	// We have finished scanning
+
+	uint32 t = g_system->getMillis();
+
+	Common::ThreadPool *pool = g_system->getThreadPool();
+
+	// Perform a depth-first scan of the filesystem. The scan is split into
+	// three stages, connected by queues: walking the tree, running the
+	// detector on the directories found, and adding their results to the
+	// dialog.
+	//
+	// The detector runs on the thread pool, for several directories at
+	// once, while the tree is walked. The dialog never waits for it, the
+	// directories detected so far are collected on every tickle.
+	while (!isScanComplete() && (g_system->getMillis() - t) < kMaxScanTime) {
+		bool progress = collectDetectionTasks();
+
+		while (!_pendingJobs.empty() && _detectionTasks.size() < _maxDetectionTasks) {
+			DetectionTask *task = new DetectionTask(_pendingJobs.pop());
+			_detectionTasks.push_back(task);
+			pool->submit(task);
+			progress = true;
+		}
+
+		if (!_scanStack.empty() && _pendingJobs.size() < kMaxPendingJobs) {
+			walkDirectory(_scanStack.pop());
+			progress = true;
+		}
+
+		while (!_finishedJobs.empty())
+			addCandidates(_finishedJobs.pop());
+
+		// Everything left to do is waiting for the detector
+		if (!progress)
+			break;
 	}
 
 
 	// Update the dialog
 	Common::String buf;
 
-	if (_scanStack.empty()) {
+	if (isScanComplete()) {
+		EngineMan.flushDetectionCache();
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
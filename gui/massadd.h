@@ -26,6 +26,7 @@
 #include "gui/dialog.h"
 #include "common/fs.h"
 #include "common/hashmap.h"
+#include "common/queue.h"
 #include "common/stack.h"
 #include "common/str.h"
 
@@ -37,6 +38,7 @@ class MassAddDialog : public Dialog {
 	typedef Common::Array<Common::String> StringArray;
 public:
 	MassAddDialog(const Common::FSNode &startDir);
+	~MassAddDialog();
 
 	//void open();
 	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data);
@@ -49,7 +51,42 @@ public:
 	}
 
 private:
+	/**
+	 * A directory found while walking the tree. It is queued for detection
+	 * once it has been listed, and for adding its candidates to the dialog
+	 * once detection has run on it.
+	 */
+	struct DetectionJob {
+		Common::FSNode dir;
+		Common::FSList files;
+		GameList candidates;
+	};
+
+	/** List the contents of a directory and queue it for detection. */
+	void walkDirectory(const Common::FSNode &dir);
+
+	class DetectionTask;
+
+	/** Run the detector on a listed directory. */
+	static void runDetection(DetectionJob &job);
+
+	/** Add the new games detected in a directory to the list. */
+	void addCandidates(const DetectionJob &job);
+
+	/** Move the jobs of the detection tasks which have finished to the finished jobs. */
+	bool collectDetectionTasks();
+
+	bool isScanComplete() const {
+		return _scanStack.empty() && _pendingJobs.empty() && _detectionTasks.empty() && _finishedJobs.empty();
+	}
+
 	Common::Stack<Common::FSNode>  _scanStack;
+	Common::Queue<DetectionJob> _pendingJobs;
+	Common::Array<DetectionTask *> _detectionTasks;
+	Common::Queue<DetectionJob> _finishedJobs;
+
+	/** The number of directories detected at the same time. */
+	uint _maxDetectionTasks;
 	GameList _games;
 
 	/**
@@ -0,0 +1,203 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decodeahead.h"
+
+#include "common/atomic.h"
+#include "common/threadpool.h"
+
+#if defined(POSIX) && defined(USE_PTHREADS)
+#include "backends/threads/posix/posix-threadpool.h"
+#endif
+
+#include "helper.h"
+#include "test/system/null_osystem.h"
+
+class DecodeAheadTestSuite : public CxxTest::TestSuite {
+	/**
+	 * A slow stream whose samples differ for a long time, so that reading
+	 * from a wrong position shows.
+	 */
+	class SlowStream : public Audio::SeekableAudioStream {
+	public:
+		SlowStream(int frames, bool stereo) : _length(frames * (stereo ? 2 : 1)), _stereo(stereo), _pos(0) {
+			Common::atomicAdd(&_alive, 1);
+		}
+		~SlowStream() { Common::atomicAdd(&_alive, -1); }
+
+		static int16 sampleAt(int pos) { return (int16)(pos * 7 + (pos >> 9)); }
+
+		int readBuffer(int16 *buffer, const int numSamples) {
+			// Take some time, so that readers catch up with the decoding
+			for (volatile int i = 0; i < numSamples * 4; i++) {
+			}
+
+			const int count = MIN(numSamples, _length - _pos);
+			for (int i = 0; i < count; i++)
+				buffer[i] = sampleAt(_pos + i);
+			_pos += count;
+			return count;
+		}
+
+		bool isStereo() const { return _stereo; }
+		int getRate() const { return 22050; }
+		bool endOfData() const { return _pos >= _length; }
+
+		bool seek(const Audio::Timestamp &where) {
+			_pos = MIN<int>(where.convertToFramerate(22050).totalNumberOfFrames() * (_stereo ? 2 : 1), _length);
+			return true;
+		}
+		Audio::Timestamp getLength() const { return Audio::Timestamp(0, _length / (_stereo ? 2 : 1), 22050); }
+
+		/** Number of streams not deleted yet, which happens on the pool's threads. */
+		static volatile int32 _alive;
+
+	private:
+		const int _length;
+		const bool _stereo;
+		int _pos;
+	};
+
+	/** Read both streams in chunks of the given size and compare them. */
+	static void compare(Audio::AudioStream *wrapped, Audio::AudioStream *reference, int chunk) {
+		int16 *a = new int16[chunk];
+		int16 *b = new int16[chunk];
+
+		for (;;) {
+			const int readA = wrapped->readBuffer(a, chunk);
+			const int readB = reference->readBuffer(b, chunk);
+			TS_ASSERT_EQUALS(readA, readB);
+			if (readA != readB || readA <= 0)
+				break;
+			TS_ASSERT_EQUALS(memcmp(a, b, readA * sizeof(int16)), 0);
+		}
+
+		TS_ASSERT(wrapped->endOfData());
+		TS_ASSERT(reference->endOfData());
+
+		delete[] a;
+		delete[] b;
+	}
+
+public:
+	void test_read() {
+		Common::SerialThreadPool pool;
+
+		for (int stereo = 0; stereo < 2; stereo++) {
+			Audio::BufferedDecodeAheadStream wrapped(createSineStream<int16>(22050, 2, 0, false, stereo), DisposeAfterUse::YES, &pool, 100);
+			Audio::SeekableAudioStream *reference = createSineStream<int16>(22050, 2, 0, false, stereo);
+
+			TS_ASSERT_EQUALS(wrapped.isStereo(), (bool)stereo);
+			TS_ASSERT_EQUALS(wrapped.getRate(), 22050);
+			TS_ASSERT_EQUALS(wrapped.getLength().msecs(), 2000);
+
+			// Chunks like a backend would ask for
+			compare(&wrapped, reference, 2048);
+			TS_ASSERT_EQUALS(wrapped.getUnderruns(), 0u);
+
+			delete reference;
+		}
+	}
+
+	void test_read_more_than_buffered() {
+		Common::SerialThreadPool pool;
+		Audio::BufferedDecodeAheadStream wrapped(createSineStream<int16>(11025, 4, 0, false, false), DisposeAfterUse::YES, &pool, 0);
+		Audio::SeekableAudioStream *reference = createSineStream<int16>(11025, 4, 0, false, false);
+
+		// Reads beyond the buffer decode on the calling thread
+		compare(&wrapped, reference, 30000);
+		TS_ASSERT_LESS_THAN(0u, wrapped.getUnderruns());
+
+		delete reference;
+	}
+
+	void test_seek() {
+		Common::SerialThreadPool pool;
+		Audio::BufferedDecodeAheadStream wrapped(createSineStream<int16>(22050, 2, 0, false, true), DisposeAfterUse::YES, &pool, 100);
+		Audio::SeekableAudioStream *reference = createSineStream<int16>(22050, 2, 0, false, true);
+
+		int16 buffer[1000];
+		TS_ASSERT_EQUALS(wrapped.readBuffer(buffer, 1000), 1000);
+
+		// Seeking drops what was decoded ahead
+		TS_ASSERT(wrapped.seek(1500));
+		TS_ASSERT(reference->seek(1500));
+		compare(&wrapped, reference, 1000);
+
+		// Rewinding after the end starts over
+		TS_ASSERT(wrapped.rewind());
+		TS_ASSERT(reference->rewind());
+		TS_ASSERT(!wrapped.endOfData());
+		compare(&wrapped, reference, 1000);
+
+		delete reference;
+	}
+
+	void test_looping() {
+		Common::SerialThreadPool pool;
+		Audio::AudioStream *wrapped = Audio::makeLoopingAudioStream(new Audio::BufferedDecodeAheadStream(createSineStream<int16>(11025, 1, 0, false, false), DisposeAfterUse::YES, &pool, 100), 3);
+		Audio::AudioStream *reference = Audio::makeLoopingAudioStream(createSineStream<int16>(11025, 1, 0, false, false), 3);
+
+		compare(wrapped, reference, 4000);
+
+		delete wrapped;
+		delete reference;
+	}
+
+	void test_stress_posix_pool() {
+#if defined(POSIX) && defined(USE_PTHREADS)
+		// For the mutex guarding the wrapped stream
+		OSystem *oldSystem = g_system;
+		NullOSystem system;
+		g_system = &system;
+
+		{
+			PosixThreadPool pool;
+			uint32 random = 12345;
+
+			for (int round = 0; round < 20; round++) {
+				const bool stereo = round & 1;
+				const int channels = stereo ? 2 : 1;
+				const int frames = 22050 * 2;
+				Audio::BufferedDecodeAheadStream wrapped(new SlowStream(frames, stereo), DisposeAfterUse::YES, &pool, 50);
+
+				// Read in chunks of random size, and seek now and then
+				int16 buffer[4096];
+				int pos = 0, errors = 0;
+				while (!wrapped.endOfData()) {
+					random = random * 1103515245 + 12345;
+					if ((random >> 16) % 16 == 0) {
+						const int frame = (random >> 8) % frames;
+						TS_ASSERT(wrapped.seek(Audio::Timestamp(0, frame, 22050)));
+						pos = frame * channels;
+					}
+
+					const int wanted = ((random >> 4) % (4096 / channels) + 1) * channels;
+					const int read = wrapped.readBuffer(buffer, wanted);
+					TS_ASSERT_EQUALS(read, MIN(wanted, frames * channels - pos));
+					for (int i = 0; i < read; i++)
+						errors += (buffer[i] != SlowStream::sampleAt(pos + i));
+					pos += read;
+				}
+				TS_ASSERT_EQUALS(errors, 0);
+				TS_ASSERT_EQUALS(pos, frames * channels);
+			}
+
+			// Delete streams while they are still decoding, their tasks end
+			// on their own
+			for (int round = 0; round < 50; round++) {
+				Audio::BufferedDecodeAheadStream *wrapped = new Audio::BufferedDecodeAheadStream(new SlowStream(22050, true), DisposeAfterUse::YES, &pool, 500);
+				int16 buffer[256];
+				wrapped->readBuffer(buffer, round * 4);
+				delete wrapped;
+			}
+		}
+
+		// The pool has deleted all wrapped streams once it is gone
+		TS_ASSERT_EQUALS(Common::atomicLoad(&SlowStream::_alive), 0);
+
+		g_system = oldSystem;
+#endif
+	}
+};
+
+volatile int32 DecodeAheadTestSuite::SlowStream::_alive = 0;
@@ -0,0 +1,182 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixbus.h"
+#include "audio/mixer.h"
+#include "audio/mixer_intern.h"
+#include "audio/rate.h"
+
+#include "helper.h"
+#include "test/system/benchmark.h"
+#include "test/system/null_osystem.h"
+
+class MixBusTestSuite : public CxxTest::TestSuite {
+	/** Create a mono stream at the output rate, which holds the same value all the time. */
+	static Audio::AudioStream *createConstantStream(int16 value, int samples) {
+		byte *data = (byte *)malloc(samples * 2);
+		for (int i = 0; i < samples; i++)
+			WRITE_LE_UINT16(data + i * 2, value);
+		return Audio::makeRawStream(data, samples * 2, 44100, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN);
+	}
+
+	/**
+	 * Mix the given streams for one second of output, in chunks of the size
+	 * a backend would ask for, and return the time taken in nanoseconds per
+	 * output frame.
+	 */
+	static uint32 mixOneSecond(Common::Array<Audio::AudioStream *> &streams, Common::Array<Audio::RateConverter *> &converters, uint outRate, bool useBus) {
+		const uint kChunk = 1024;
+		Audio::st_sample_t out[kChunk * 2];
+		Audio::st_mix_t bus[kChunk * 2];
+
+		BenchmarkTimer timer;
+		for (uint frames = 0; frames < outRate; frames += kChunk) {
+			if (useBus) {
+				memset(bus, 0, sizeof(bus));
+				for (uint i = 0; i < streams.size(); i++)
+					converters[i]->flowMix(*streams[i], bus, kChunk, 128, 128);
+				Audio::clampMixBus(bus, out, kChunk * 2);
+			} else {
+				memset(out, 0, sizeof(out));
+				for (uint i = 0; i < streams.size(); i++)
+					converters[i]->flow(*streams[i], out, kChunk, 128, 128);
+			}
+		}
+
+		return timer.nanosPer(outRate);
+	}
+
+public:
+	void test_clamp() {
+		// More samples than one SIMD step, so that the remainder is covered as well
+		const Audio::st_mix_t bus[] = {
+			0, 1, -1, 32767, 32768, -32768, -32769, 100000,
+			-100000, 12345, 70000, -70000, 5, -6, 7, 2147483647, -2147483647 - 1
+		};
+		const Audio::st_sample_t expected[] = {
+			0, 1, -1, 32767, 32767, -32768, -32768, 32767,
+			-32768, 12345, 32767, -32768, 5, -6, 7, 32767, -32768
+		};
+
+		Audio::st_sample_t out[ARRAYSIZE(bus)];
+		Audio::clampMixBus(bus, out, ARRAYSIZE(bus));
+
+		for (int i = 0; i < ARRAYSIZE(bus); i++)
+			TS_ASSERT_EQUALS(out[i], expected[i]);
+	}
+
+	void test_flow_mix_matches_flow() {
+		// As long as nothing clips, both ways of mixing yield the same samples.
+		// These cover linear interpolation, simple resampling and copying.
+		static const int rates[][2] = { { 11025, 44100 }, { 44100, 22050 }, { 22050, 22050 } };
+
+		for (int r = 0; r < ARRAYSIZE(rates); r++) {
+			for (int stereo = 0; stereo < 2; stereo++) {
+				Audio::SeekableAudioStream *a = createSineStream<int16>(rates[r][0], 1, 0, false, stereo);
+				Audio::SeekableAudioStream *b = createSineStream<int16>(rates[r][0], 1, 0, false, stereo);
+				Audio::RateConverter *flowConverter = Audio::makeRateConverter(rates[r][0], rates[r][1], stereo);
+				Audio::RateConverter *mixConverter = Audio::makeRateConverter(rates[r][0], rates[r][1], stereo);
+
+				const uint kFrames = 1000;
+				Audio::st_sample_t out[kFrames * 2];
+				Audio::st_mix_t bus[kFrames * 2];
+				memset(out, 0, sizeof(out));
+				memset(bus, 0, sizeof(bus));
+
+				const int flowed = flowConverter->flow(*a, out, kFrames, 100, 200);
+				const int mixed = mixConverter->flowMix(*b, bus, kFrames, 100, 200);
+				TS_ASSERT_EQUALS(flowed, mixed);
+				for (int i = 0; i < flowed * 2; i++)
+					TS_ASSERT_EQUALS(out[i], bus[i]);
+
+				delete flowConverter;
+				delete mixConverter;
+				delete a;
+				delete b;
+			}
+		}
+	}
+
+	void test_clamp_once() {
+		// Loud channels which cancel each other out do not clip on the bus
+		Audio::AudioStream *streams[3] = {
+			createConstantStream(30000, 64), createConstantStream(30000, 64), createConstantStream(-30000, 64)
+		};
+
+		Audio::st_mix_t bus[64 * 2];
+		memset(bus, 0, sizeof(bus));
+		for (int i = 0; i < 3; i++) {
+			Audio::RateConverter *converter = Audio::makeRateConverter(44100, 44100, false);
+			TS_ASSERT_EQUALS(converter->flowMix(*streams[i], bus, 64, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 64);
+			delete converter;
+			delete streams[i];
+		}
+
+		Audio::st_sample_t out[64 * 2];
+		Audio::clampMixBus(bus, out, 64 * 2);
+		for (int i = 0; i < 64 * 2; i++)
+			TS_ASSERT_EQUALS(out[i], 30000);
+	}
+
+	void test_mixer_large_buffer() {
+		// For the mutexes and the channel timing
+		OSystem *oldSystem = g_system;
+		NullOSystem system;
+		g_system = &system;
+
+		{
+			// Buffers larger than the mixing bus are mixed in several parts
+			const uint kFrames = 20000;
+			Audio::MixerImpl mixer(&system, 44100);
+			mixer.setReady(true);
+
+			Audio::SoundHandle handle;
+			((Audio::Mixer &)mixer).playStream(Audio::Mixer::kPlainSoundType, &handle, createConstantStream(1000, kFrames));
+
+			Audio::st_sample_t *out = new Audio::st_sample_t[kFrames * 2];
+			mixer.mixCallback((byte *)out, kFrames * 4);
+
+			TS_ASSERT_DIFFERS(out[0], 0);
+			int errors = 0;
+			for (uint i = 0; i < kFrames * 2; i++)
+				errors += (out[i] != out[0]);
+			TS_ASSERT_EQUALS(errors, 0);
+
+			delete[] out;
+		}
+
+		g_system = oldSystem;
+	}
+
+	void test_benchmark() {
+		// 32 channels of typical game audio: sound effects at low rates,
+		// speech and music at CD rate
+		static const int rates[] = { 11025, 22050, 22050, 44100 };
+		const int kChannels = 32;
+		static const uint outRates[] = { 44100, 48000 };
+
+		for (int o = 0; o < ARRAYSIZE(outRates); o++) {
+			uint32 nanos[2];
+
+			for (int useBus = 0; useBus < 2; useBus++) {
+				Common::Array<Audio::AudioStream *> streams;
+				Common::Array<Audio::RateConverter *> converters;
+				for (int i = 0; i < kChannels; i++) {
+					const int rate = rates[i % ARRAYSIZE(rates)];
+					const bool stereo = (rate == 44100);
+					streams.push_back(createSineStream<int16>(rate, 2, 0, false, stereo));
+					converters.push_back(Audio::makeRateConverter(rate, outRates[o], stereo));
+				}
+
+				nanos[useBus] = mixOneSecond(streams, converters, outRates[o], useBus);
+
+				for (int i = 0; i < kChannels; i++) {
+					delete converters[i];
+					delete streams[i];
+				}
+			}
+
+			TS_TRACE(Common::String::format("Mixing %d channels at %u Hz took %u ns per frame with clamping per channel, %u ns with the mixing bus",
+			         kChannels, outRates[o], nanos[0], nanos[1]).c_str());
+		}
+	}
+};
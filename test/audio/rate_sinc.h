@@ -0,0 +1,159 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/decoders/raw.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+#include "common/endian.h"
+
+#include <math.h>
+
+#include "test/system/benchmark.h"
+
+class SincRateConverterTestSuite : public CxxTest::TestSuite {
+	static const int kAmplitude = 16000;
+
+	/** Create a stream holding a sine tone of the given frequency, on both channels if stereo. */
+	static Audio::AudioStream *createToneStream(int rate, double freq, int frames, bool stereo) {
+		const int channels = stereo ? 2 : 1;
+		byte *data = (byte *)malloc(frames * channels * 2);
+		for (int i = 0; i < frames; i++) {
+			const int16 value = (int16)floor(sin(2 * M_PI * freq * i / rate) * kAmplitude + 0.5);
+			for (int c = 0; c < channels; c++)
+				WRITE_LE_UINT16(data + (i * channels + c) * 2, value);
+		}
+		return Audio::makeRawStream(data, frames * channels * 2, rate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (stereo ? Audio::FLAG_STEREO : 0));
+	}
+
+	/**
+	 * Convert one second of audio, in chunks of the size a backend would ask
+	 * for, and return the time taken in nanoseconds per output frame and
+	 * input channel.
+	 */
+	static uint32 convertOneSecond(Audio::RateConverter *converter, int inRate, int outRate, bool stereo) {
+		Audio::AudioStream *stream = createToneStream(inRate, 440.0, inRate * 2, stereo);
+		const uint kChunk = 1024;
+		Audio::st_mix_t bus[kChunk * 2];
+
+		BenchmarkTimer timer;
+		for (int frames = 0; frames < outRate; frames += kChunk) {
+			memset(bus, 0, sizeof(bus));
+			converter->flowMix(*stream, bus, kChunk, 128, 128);
+		}
+		const uint32 nanos = timer.nanosPer(outRate * (stereo ? 2 : 1));
+
+		delete stream;
+		return nanos;
+	}
+
+public:
+	void test_sine() {
+		// The output is neither delayed nor scaled, so it has to match the
+		// ideal tone once the filter saw enough input
+		static const int rates[][2] = { { 11025, 44100 }, { 22050, 48000 }, { 48000, 44100 } };
+
+		for (int r = 0; r < ARRAYSIZE(rates); r++) {
+			const int inRate = rates[r][0], outRate = rates[r][1];
+			for (int stereo = 0; stereo < 2; stereo++) {
+				Audio::AudioStream *stream = createToneStream(inRate, 1000.0, inRate / 10, stereo);
+				Audio::RateConverter *converter = Audio::makeSincRateConverter(inRate, outRate, stereo);
+
+				const int kFrames = outRate / 20;
+				Audio::st_sample_t out[48000 / 20 * 2];
+				memset(out, 0, sizeof(out));
+				TS_ASSERT_EQUALS(converter->flow(*stream, out, kFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), kFrames);
+
+				int maxError = 0;
+				for (int i = outRate / 100; i < kFrames; i++) {
+					const double expected = sin(2 * M_PI * 1000.0 * i / outRate) * kAmplitude;
+					maxError = MAX(maxError, (int)fabs(out[i * 2] - expected));
+					TS_ASSERT_EQUALS(out[i * 2], out[i * 2 + 1]);
+				}
+				TS_ASSERT_LESS_THAN(maxError, kAmplitude / 200);
+
+				delete converter;
+				delete stream;
+			}
+		}
+	}
+
+	void test_downsampling_removes_high_tones() {
+		// An 18 kHz tone cannot be represented at 22050 Hz. Dropping every
+		// second sample would turn it into a loud 4 kHz tone instead.
+		Audio::AudioStream *stream = createToneStream(44100, 18000.0, 44100 / 10, false);
+		Audio::RateConverter *converter = Audio::makeSincRateConverter(44100, 22050, false);
+
+		const int kFrames = 22050 / 20;
+		Audio::st_sample_t out[kFrames * 2];
+		memset(out, 0, sizeof(out));
+		TS_ASSERT_EQUALS(converter->flow(*stream, out, kFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), kFrames);
+
+		int peak = 0;
+		for (int i = 100; i < kFrames; i++)
+			peak = MAX<int>(peak, ABS(out[i * 2]));
+		TS_ASSERT_LESS_THAN(peak, kAmplitude / 100);
+
+		delete converter;
+		delete stream;
+	}
+
+	void test_many_rates() {
+		// More rates than filters are kept, the converters for the others
+		// have a filter of their own
+		for (int rate = 8000; rate < 8000 + 40 * 97; rate += 97) {
+			Audio::AudioStream *stream = createToneStream(rate, 1000.0, rate / 10, false);
+			Audio::RateConverter *converter = Audio::makeRateConverter(rate, 44100, false, false, Audio::kSincResampler);
+
+			const int kFrames = 44100 / 20;
+			Audio::st_sample_t out[kFrames * 2];
+			memset(out, 0, sizeof(out));
+			TS_ASSERT_EQUALS(converter->flow(*stream, out, kFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), kFrames);
+
+			int maxError = 0;
+			for (int i = 44100 / 100; i < kFrames; i++)
+				maxError = MAX(maxError, (int)fabs(out[i * 2] - sin(2 * M_PI * 1000.0 * i / 44100) * kAmplitude));
+			TS_ASSERT_LESS_THAN(maxError, kAmplitude / 200);
+
+			delete converter;
+			delete stream;
+		}
+	}
+
+	void test_end_of_stream() {
+		// Converting stops once the input ran out
+		Audio::AudioStream *stream = createToneStream(11025, 1000.0, 1000, false);
+		Audio::RateConverter *converter = Audio::makeSincRateConverter(11025, 44100, false);
+
+		Audio::st_sample_t out[8192 * 2];
+		const int flowed = converter->flow(*stream, out, 8192, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_LESS_THAN(3900, flowed);
+		TS_ASSERT_LESS_THAN(flowed, 4000);
+
+		delete converter;
+		delete stream;
+	}
+
+	void test_benchmark() {
+		static const int inRates[] = { 11025, 22050, 44100 };
+		const int kOutRate = 48000;
+
+		for (int r = 0; r < ARRAYSIZE(inRates); r++) {
+			for (int stereo = 0; stereo < 2; stereo++) {
+				Audio::RateConverter *linear = Audio::makeRateConverter(inRates[r], kOutRate, stereo);
+				Audio::RateConverter *sinc = Audio::makeSincRateConverter(inRates[r], kOutRate, stereo);
+
+				uint32 linearNanos = 0, sincNanos = 0;
+				for (int run = 0; run < BenchmarkTimer::kRuns; run++) {
+					BenchmarkTimer::keepBest(linearNanos, convertOneSecond(linear, inRates[r], kOutRate, stereo), run);
+					BenchmarkTimer::keepBest(sincNanos, convertOneSecond(sinc, inRates[r], kOutRate, stereo), run);
+				}
+
+				TS_TRACE(Common::String::format("Resampling %s %d Hz to %d Hz took %u ns per frame and channel with linear interpolation, %u ns with the sinc filter",
+				         stereo ? "stereo" : "mono", inRates[r], kOutRate, linearNanos, sincNanos).c_str());
+
+				delete linear;
+				delete sinc;
+			}
+		}
+	}
+};
@@ -0,0 +1,136 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/soundcache.h"
+
+#include "helper.h"
+
+class SoundCacheTestSuite : public CxxTest::TestSuite {
+	/** Check that a stream plays the same samples as a freshly created sine stream. */
+	static void checkSine(Audio::AudioStream *stream, int rate, int time, bool stereo) {
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		Audio::SeekableAudioStream *reference = createSineStream<int16>(rate, time, 0, false, stereo);
+		TS_ASSERT_EQUALS(stream->getRate(), rate);
+		TS_ASSERT_EQUALS(stream->isStereo(), stereo);
+
+		int16 a[1000], b[1000];
+		for (;;) {
+			const int readA = stream->readBuffer(a, 1000);
+			const int readB = reference->readBuffer(b, 1000);
+			TS_ASSERT_EQUALS(readA, readB);
+			if (readA != readB || readA <= 0)
+				break;
+			TS_ASSERT_EQUALS(memcmp(a, b, readA * sizeof(int16)), 0);
+		}
+
+		delete reference;
+		delete stream;
+	}
+
+public:
+	void test_hit() {
+		Audio::DecodedSoundCache cache;
+		const Audio::DecodedSoundKey key("sfx.bnd", 1024, 4096);
+
+		TS_ASSERT(!cache.find(key));
+		checkSine(cache.decode(key, createSineStream<int16>(11025, 1, 0, false, true)), 11025, 1, true);
+
+		// Every hit hands out a new stream over the same samples
+		checkSine(cache.find(key), 11025, 1, true);
+		checkSine(cache.find(key), 11025, 1, true);
+
+		// The byte range is part of the key
+		TS_ASSERT(!cache.find(Audio::DecodedSoundKey("sfx.bnd", 1024, 4000)));
+		TS_ASSERT(!cache.find(Audio::DecodedSoundKey("sfx.bnd", 0, 4096)));
+
+		const Audio::DecodedSoundCache::Stats stats = cache.getStats();
+		TS_ASSERT_EQUALS(stats.hits, 2u);
+		TS_ASSERT_EQUALS(stats.misses, 1u);
+		TS_ASSERT_EQUALS(stats.sounds, 1u);
+		TS_ASSERT_EQUALS(stats.memory, 11025u * 2 * 2);
+	}
+
+	void test_looped_effect() {
+		// Like the SCI sound effects: looked up whenever they are started,
+		// and only decoded the first time
+		Audio::DecodedSoundCache cache;
+		const Audio::DecodedSoundKey key("Audio.123", 0, 2048);
+
+		for (int i = 0; i < 3; i++) {
+			Audio::RewindableAudioStream *stream = cache.find(key);
+			if (!stream)
+				stream = cache.decode(key, createSineStream<int16>(11025, 1, 0, false, false));
+
+			// Looping rewinds the cached stream
+			Audio::LoopingAudioStream looping(stream, 2);
+			int16 buffer[1000];
+			int samples = 0, read;
+			while ((read = looping.readBuffer(buffer, 1000)) > 0)
+				samples += read;
+			TS_ASSERT_EQUALS(samples, 11025 * 2);
+		}
+
+		const Audio::DecodedSoundCache::Stats stats = cache.getStats();
+		TS_ASSERT_EQUALS(stats.hits, 2u);
+		TS_ASSERT_EQUALS(stats.misses, 1u);
+	}
+
+	void test_lru() {
+		Audio::DecodedSoundCache cache;
+		// Room for four sounds of one second at 11025 Hz
+		cache.setLimits(64 * 1024, 100 * 1024);
+
+		Audio::DecodedSoundKey keys[5];
+		for (int i = 0; i < 4; i++) {
+			keys[i] = Audio::DecodedSoundKey("sfx.bnd", i * 100, 100);
+			delete cache.decode(keys[i], createSineStream<int16>(11025, 1, 0, false, false));
+		}
+
+		// Using the first sound makes the second one the oldest
+		delete cache.find(keys[0]);
+		keys[4] = Audio::DecodedSoundKey("other.bnd", 0, 100);
+		delete cache.decode(keys[4], createSineStream<int16>(11025, 1, 0, false, false));
+
+		TS_ASSERT(!cache.find(keys[1]));
+		checkSine(cache.find(keys[0]), 11025, 1, false);
+		checkSine(cache.find(keys[4]), 11025, 1, false);
+
+		const Audio::DecodedSoundCache::Stats stats = cache.getStats();
+		TS_ASSERT_EQUALS(stats.sounds, 4u);
+		TS_ASSERT_EQUALS(stats.evictions, 1u);
+		TS_ASSERT_LESS_THAN_EQUALS(stats.memory, 100u * 1024);
+	}
+
+	void test_streams_outlive_cache() {
+		Audio::AudioStream *stream;
+		{
+			Audio::DecodedSoundCache cache;
+			const Audio::DecodedSoundKey key("speech.bnd", 0, 100);
+			delete cache.decode(key, createSineStream<int16>(22050, 1, 0, false, false));
+			stream = cache.find(key);
+			cache.clear();
+			TS_ASSERT_EQUALS(cache.getStats().memory, 0u);
+		}
+
+		checkSine(stream, 22050, 1, false);
+	}
+
+	void test_too_large() {
+		Audio::DecodedSoundCache cache;
+		cache.setLimits(64 * 1024, 1024 * 1024);
+		const Audio::DecodedSoundKey key("music.bnd", 0, 100);
+
+		// Long sounds are played from the original stream
+		checkSine(cache.decode(key, createSineStream<int16>(22050, 2, 0, false, true)), 22050, 2, true);
+		checkSine(cache.decode(key, createSineStream<int16>(22050, 2, 0, false, true)), 22050, 2, true);
+		TS_ASSERT(!cache.find(key));
+
+		const Audio::DecodedSoundCache::Stats stats = cache.getStats();
+		TS_ASSERT_EQUALS(stats.tooLarge, 2u);
+		TS_ASSERT_EQUALS(stats.misses, 0u);
+		TS_ASSERT_EQUALS(stats.sounds, 0u);
+	}
+};
@@ -2,6 +2,10 @@
 
 #include "common/bitstream.h"
 #include "common/memstream.h"
+#include "common/str.h"
+#include "common/util.h"
+
+#include "test/system/benchmark.h"
 
 class BitStreamTestSuite : public CxxTest::TestSuite
 {
@@ -149,4 +153,223 @@ class BitStreamTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(bs.peekBits(5), 12u);
 		TS_ASSERT(!bs.eos());
 	}
+
+	void test_reservoir_get_bits() {
+		byte contents[] = { 'a', 'b' };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::BitStreamReservoir8MSB bs(ms);
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		TS_ASSERT_EQUALS(bs.getBits(3), 3u);
+		TS_ASSERT_EQUALS(bs.pos(), 3u);
+		TS_ASSERT_EQUALS(bs.getBits(8), 11u);
+		TS_ASSERT_EQUALS(bs.pos(), 11u);
+		TS_ASSERT(!bs.eos());
+		TS_ASSERT_EQUALS(bs.getBits(5), 2u);
+		TS_ASSERT(bs.eos());
+
+		bs.rewind();
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		TS_ASSERT(!bs.eos());
+		TS_ASSERT_EQUALS(bs.size(), 16u);
+	}
+
+	void test_reservoir_peek_bits_lsb() {
+		byte contents[] = { 'a', 'b' };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::BitStreamReservoir8LSB bs(ms);
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		TS_ASSERT_EQUALS(bs.peekBits(3), 1u);
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		bs.skip(3);
+		TS_ASSERT_EQUALS(bs.pos(), 3u);
+		TS_ASSERT_EQUALS(bs.peekBits(8), 76u);
+		TS_ASSERT_EQUALS(bs.pos(), 3u);
+		bs.skip(8);
+		TS_ASSERT_EQUALS(bs.pos(), 11u);
+		TS_ASSERT_EQUALS(bs.peekBits(5), 12u);
+		TS_ASSERT(!bs.eos());
+	}
+
+	void test_memory_peek_bits() {
+		byte contents[] = { 'a', 'b' };
+
+		Common::BitStreamMemoryStream ms(contents, sizeof(contents));
+
+		Common::BitStreamMemory8MSB bs(ms);
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		TS_ASSERT_EQUALS(bs.peekBits(3), 3u);
+		TS_ASSERT_EQUALS(bs.pos(), 0u);
+		bs.skip(3);
+		TS_ASSERT_EQUALS(bs.pos(), 3u);
+		TS_ASSERT_EQUALS(bs.peekBits(8), 11u);
+		TS_ASSERT_EQUALS(bs.pos(), 3u);
+		bs.skip(8);
+		TS_ASSERT_EQUALS(bs.pos(), 11u);
+		TS_ASSERT_EQUALS(bs.peekBits(5), 2u);
+		TS_ASSERT(!bs.eos());
+	}
+
+	void test_memory_align() {
+		byte contents[] = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0 };
+
+		Common::BitStreamMemoryStream ms(contents, sizeof(contents));
+
+		Common::BitStreamMemory16BEMSB bs(ms);
+		bs.skip(3);
+		bs.align();
+		TS_ASSERT_EQUALS(bs.pos(), 16u);
+		TS_ASSERT_EQUALS(bs.getBits(16), 0x5678u);
+		bs.align();
+		TS_ASSERT_EQUALS(bs.pos(), 32u);
+		TS_ASSERT_EQUALS(bs.getBits(32), 0x9ABCDEF0u);
+		TS_ASSERT(bs.eos());
+	}
+
+	void test_reservoir_layouts() {
+		// The reservoir bit streams need to hand out the very same bits as the classic ones
+		compareLayout<Common::BitStream8MSB    , Common::BitStreamReservoir8MSB    , Common::BitStreamMemory8MSB    >();
+		compareLayout<Common::BitStream8LSB    , Common::BitStreamReservoir8LSB    , Common::BitStreamMemory8LSB    >();
+		compareLayout<Common::BitStream16LEMSB , Common::BitStreamReservoir16LEMSB , Common::BitStreamMemory16LEMSB >();
+		compareLayout<Common::BitStream16LELSB , Common::BitStreamReservoir16LELSB , Common::BitStreamMemory16LELSB >();
+		compareLayout<Common::BitStream16BEMSB , Common::BitStreamReservoir16BEMSB , Common::BitStreamMemory16BEMSB >();
+		compareLayout<Common::BitStream16BELSB , Common::BitStreamReservoir16BELSB , Common::BitStreamMemory16BELSB >();
+		compareLayout<Common::BitStream32LEMSB , Common::BitStreamReservoir32LEMSB , Common::BitStreamMemory32LEMSB >();
+		compareLayout<Common::BitStream32LELSB , Common::BitStreamReservoir32LELSB , Common::BitStreamMemory32LELSB >();
+		compareLayout<Common::BitStream32BEMSB , Common::BitStreamReservoir32BEMSB , Common::BitStreamMemory32BEMSB >();
+		compareLayout<Common::BitStream32BELSB , Common::BitStreamReservoir32BELSB , Common::BitStreamMemory32BELSB >();
+	}
+
+	void test_benchmark() {
+		// Random data, read like a decoder would: mixed getBits() widths,
+		// and peek 12 bits then consume a few like a table-driven decoder
+		const uint32 kSize = 1024 * 1024;
+		byte *data = new byte[kSize];
+		uint32 seed = 1;
+		for (uint32 i = 0; i < kSize; i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = seed >> 16;
+		}
+
+		uint32 getClassic = 0, getReservoir = 0, getMemory = 0, peekClassic = 0, peekReservoir = 0, peekMemory = 0;
+		for (int run = 0; run < BenchmarkTimer::kRuns; run++) {
+			Common::MemoryReadStream classicStream(data, kSize);
+			Common::MemoryReadStream reservoirStream(data, kSize);
+			Common::BitStreamMemoryStream memoryStream(data, kSize);
+
+			Common::BitStream8MSB classic(classicStream);
+			Common::BitStreamReservoir8MSB reservoir(reservoirStream);
+			Common::BitStreamMemory8MSB memory(memoryStream);
+
+			const uint32 v = readBits(classic, getClassic, run);
+			TS_ASSERT_EQUALS(readBits(reservoir, getReservoir, run), v);
+			TS_ASSERT_EQUALS(readBits(memory, getMemory, run), v);
+
+			classic.rewind();
+			const uint32 w = peekAndSkip(classic, peekClassic, run);
+			reservoir.rewind();
+			TS_ASSERT_EQUALS(peekAndSkip(reservoir, peekReservoir, run), w);
+			memory.rewind();
+			TS_ASSERT_EQUALS(peekAndSkip(memory, peekMemory, run), w);
+		}
+
+		delete[] data;
+
+		TS_TRACE(Common::String::format("Reading %u KB, BitStream vs. BitStreamReservoir vs. BitStreamMemory: "
+		         "getBits() %u vs. %u vs. %u us, peekBits() and skip() %u vs. %u vs. %u us", kSize / 1024,
+		         getClassic, getReservoir, getMemory, peekClassic, peekReservoir, peekMemory).c_str());
+	}
+
+	private:
+	/** Read all bits with getBits() of 1 to 17 bits, keep the best time in microseconds and return a checksum. */
+	static uint32 readBits(Common::BitStream &bs, uint32 &best, int run) {
+		BenchmarkTimer timer;
+
+		uint32 sum = 0;
+		for (uint8 n = 1; bs.size() - bs.pos() >= 17; n = (n % 17) + 1)
+			sum = sum * 31 + bs.getBits(n);
+
+		BenchmarkTimer::keepBest(best, timer.micros(), run);
+		return sum;
+	}
+
+	/** Peek 12 bits and skip 1 to 12 of them until the end, keep the best time and return a checksum. */
+	static uint32 peekAndSkip(Common::BitStream &bs, uint32 &best, int run) {
+		BenchmarkTimer timer;
+
+		uint32 sum = 0;
+		while (bs.size() - bs.pos() >= 12) {
+			const uint32 v = bs.peekBits(12);
+			sum = sum * 31 + v;
+			bs.skip((v % 12) + 1);
+		}
+
+		BenchmarkTimer::keepBest(best, timer.micros(), run);
+		return sum;
+	}
+
+	template<class CLASSIC, class RESERVOIR, class MEMORY>
+	void compareLayout() {
+		byte contents[256];
+		for (uint32 i = 0; i < sizeof(contents); i++)
+			contents[i] = (i * 167 + 13) ^ (i >> 3);
+
+		Common::MemoryReadStream classicStream(contents, sizeof(contents));
+		Common::MemoryReadStream reservoirStream(contents, sizeof(contents));
+		Common::BitStreamMemoryStream memoryStream(contents, sizeof(contents));
+
+		CLASSIC   classic(classicStream);
+		RESERVOIR reservoir(reservoirStream);
+		MEMORY    memory(memoryStream);
+
+		TS_ASSERT_EQUALS(reservoir.size(), classic.size());
+		TS_ASSERT_EQUALS(memory.size(), classic.size());
+
+		// Mix reads of all sizes, peeks and skips, including ones larger than the reservoir
+		for (uint32 i = 0; (classic.size() - classic.pos()) >= 100; i++) {
+			const uint8 n = (i * 7) % 33;
+
+			switch (i % 4) {
+			case 0: {
+				const uint32 v = classic.getBits(n);
+				TS_ASSERT_EQUALS(reservoir.getBits(n), v);
+				TS_ASSERT_EQUALS(memory.getBits(n), v);
+				break;
+			}
+
+			case 1: {
+				const uint32 v = classic.peekBits(n);
+				TS_ASSERT_EQUALS(reservoir.peekBits(n), v);
+				TS_ASSERT_EQUALS(memory.peekBits(n), v);
+				break;
+			}
+
+			case 2: {
+				const uint32 v = classic.getBit();
+				TS_ASSERT_EQUALS(reservoir.getBit(), v);
+				TS_ASSERT_EQUALS(memory.getBit(), v);
+				break;
+			}
+
+			default:
+				classic.skip(n * 3);
+				reservoir.skip(n * 3);
+				memory.skip(n * 3);
+				break;
+			}
+
+			TS_ASSERT_EQUALS(reservoir.pos(), classic.pos());
+			TS_ASSERT_EQUALS(memory.pos(), classic.pos());
+		}
+
+		classic.align();
+		reservoir.align();
+		memory.align();
+
+		TS_ASSERT_EQUALS(reservoir.pos(), classic.pos());
+		TS_ASSERT_EQUALS(memory.pos(), classic.pos());
+	}
 };
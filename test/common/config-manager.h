@@ -0,0 +1,172 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/config-manager.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "test/system/benchmark.h"
+
+class ConfigManagerTestSuite : public CxxTest::TestSuite {
+	static void load(const char *text) {
+		Common::MemoryReadStream stream((const byte *)text, strlen(text));
+		ConfMan.loadFromStream(stream);
+	}
+
+	struct StringWriteStream : public Common::WriteStream {
+		Common::String text;
+
+		uint32 write(const void *dataPtr, uint32 dataSize) {
+			const char *data = (const char *)dataPtr;
+			text += Common::String(data, data + dataSize);
+			return dataSize;
+		}
+	};
+
+	struct CountingWriteStream : public Common::WriteStream {
+		uint32 written;
+
+		CountingWriteStream() : written(0) {}
+
+		uint32 write(const void *dataPtr, uint32 dataSize) {
+			written += dataSize;
+			return dataSize;
+		}
+	};
+
+	static Common::String save() {
+		StringWriteStream stream;
+		ConfMan.saveToStream(stream);
+		return stream.text;
+	}
+
+public:
+	void test_load_save() {
+		load("# Application settings\r\n"
+		     "[scummvm]\r\n"
+		     "  gfx_mode = 2x  \r\n"
+		     "\r\n"
+		     "[monkey]\n"
+		     "# The game id\n"
+		     "gameid=monkey\n"
+		     "description= The Secret of Monkey Island\n"
+		     "\n"
+		     "[keymapper]\r"
+		     "keymap_global_MENU=C+F5\r");
+
+		TS_ASSERT(!ConfMan.isDirty());
+		TS_ASSERT_EQUALS(ConfMan.get("gfx_mode", "scummvm"), "2x");
+		TS_ASSERT_EQUALS(ConfMan.get("description", "monkey"), "The Secret of Monkey Island");
+		TS_ASSERT(ConfMan.hasGameDomain("monkey"));
+
+		const Common::ConfigManager::Domain *monkey = ConfMan.getDomain("monkey");
+		TS_ASSERT(monkey->hasKVComment("gameid"));
+		TS_ASSERT(!monkey->hasKVComment("description"));
+		TS_ASSERT_EQUALS(monkey->getKVComment("gameid"), "# The game id\n");
+		TS_ASSERT_EQUALS(ConfMan.getDomain("scummvm")->getDomainComment(), "# Application settings\n");
+
+		Common::String text = save();
+		TS_ASSERT(text.hasPrefix("# Application settings\n[scummvm]\ngfx_mode=2x\n\n"));
+		TS_ASSERT(text.contains("# The game id\ngameid=monkey\n"));
+
+		// Loading what was saved yields the same file again
+		Common::MemoryReadStream stream((const byte *)text.c_str(), text.size());
+		ConfMan.loadFromStream(stream);
+		TS_ASSERT_EQUALS(save(), text);
+	}
+
+	void test_dirty_tracking() {
+		load("[scummvm]\n"
+		     "music_volume=192\n"
+		     "[monkey]\n"
+		     "gameid=monkey\n");
+
+		TS_ASSERT(!ConfMan.isDirty());
+
+		// Reading values leaves the configuration clean
+		TS_ASSERT_EQUALS(ConfMan.getInt("music_volume", "scummvm"), 192);
+		TS_ASSERT(!ConfMan.isDirty());
+
+		// So does reading them through non-const access
+		Common::ConfigManager::Domain *monkey = ConfMan.getDomain("monkey");
+		TS_ASSERT_EQUALS((*monkey)["gameid"], "monkey");
+		TS_ASSERT_EQUALS(monkey->getVal("gameid"), "monkey");
+		TS_ASSERT((*monkey)["missing"].empty());
+		TS_ASSERT(!ConfMan.isDirty());
+
+		// Or writing back what is already there
+		(*monkey)["gameid"] = "monkey";
+		TS_ASSERT(!ConfMan.isDirty());
+
+		// Setting a value to what it already is changes nothing
+		ConfMan.setInt("music_volume", 192, "scummvm");
+		TS_ASSERT(!ConfMan.isDirty());
+
+		// Neither do changes to domains which are never saved
+		ConfMan.set("dirty_test", "64", Common::ConfigManager::kTransientDomain);
+		ConfMan.registerDefault("dirty_test", 255);
+		TS_ASSERT(!ConfMan.isDirty());
+		ConfMan.getDomain(Common::ConfigManager::kTransientDomain)->erase("dirty_test");
+
+		// Writing through a reference is noticed
+		(*monkey)["gameid"] = "monkey2";
+		TS_ASSERT(ConfMan.isDirty());
+		TS_ASSERT(save().contains("gameid=monkey2\n"));
+
+		ConfMan.setInt("music_volume", 128, "scummvm");
+		TS_ASSERT(ConfMan.isDirty());
+		TS_ASSERT(save().contains("music_volume=128\n"));
+
+		load("[monkey]\n"
+		     "gameid=monkey\n");
+		ConfMan.removeGameDomain("monkey");
+		TS_ASSERT(ConfMan.isDirty());
+		TS_ASSERT(save().empty());
+	}
+
+	void test_benchmark() {
+		const int kDomains = 5000;
+
+		Common::String text;
+		for (int i = 0; i < kDomains; i++) {
+			text += Common::String::format("[game%d]\n", i);
+			text += Common::String::format("gameid=game%d\n", i);
+			text += Common::String::format("description=Game number %d (DOS/English)\n", i);
+			text += Common::String::format("path=/home/user/games/game%d\n", i);
+			text += "language=en\n";
+			text += "platform=pc\n";
+			text += "music_volume=192\n";
+			text += "sfx_volume=192\n";
+			text += "subtitles=true\n";
+			text += "\n";
+		}
+
+		Common::MemoryReadStream stream((const byte *)text.c_str(), text.size());
+		BenchmarkTimer timer;
+		ConfMan.loadFromStream(stream);
+		uint32 loadTime = timer.millis();
+
+		TS_ASSERT_EQUALS(ConfMan.getGameDomains().size(), (uint)kDomains);
+		TS_ASSERT_EQUALS(ConfMan.get("path", "game4999"), "/home/user/games/game4999");
+
+		// The first save serializes every domain, later ones only what changed
+		CountingWriteStream first;
+		timer.restart();
+		ConfMan.saveToStream(first);
+		uint32 coldSaveTime = timer.millis();
+
+		const int kFlushes = 100;
+		timer.restart();
+		for (int i = 0; i < kFlushes; i++) {
+			ConfMan.setInt("music_volume", i, Common::String::format("game%d", i * 37));
+			CountingWriteStream out;
+			ConfMan.saveToStream(out);
+		}
+		uint32 warmSaveTime = timer.millis();
+
+		TS_ASSERT_EQUALS(first.written, text.size());
+		TS_ASSERT(save().contains("music_volume=1\n"));
+
+		TS_TRACE(Common::String::format("Loaded %d domains in %u ms, first save took %u ms, %d saves of one changed domain took %u ms",
+		         kDomains, loadTime, coldSaveTime, kFlushes, warmSaveTime).c_str());
+	}
+};
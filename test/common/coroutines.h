@@ -0,0 +1,106 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/coroutines.h"
+
+/**
+ * Infinite waits never look at the clock, so the scheduler can be driven
+ * without a backend here.
+ */
+class CoroutineTestSuite : public CxxTest::TestSuite {
+	/** What the waiting process waits for, and how often it woke up. */
+	struct WaitState {
+		uint32 pids[2];
+		int count;
+		int woken;
+	};
+
+	static void waitForAny(CORO_PARAM, const void *param) {
+		WaitState *state = *(WaitState *const *)param;
+
+		CORO_BEGIN_CONTEXT;
+		CORO_END_CONTEXT(_ctx);
+
+		CORO_BEGIN_CODE(_ctx);
+
+		if (state->count == 1)
+			CORO_INVOKE_2(CoroScheduler.waitForSingleObject, state->pids[0], CORO_INFINITE);
+		else
+			CORO_INVOKE_4(CoroScheduler.waitForMultipleObjects, state->count, state->pids, false, CORO_INFINITE);
+		state->woken++;
+
+		CORO_END_CODE;
+	}
+
+	static void sleepFrames(CORO_PARAM, const void *param) {
+		CORO_BEGIN_CONTEXT;
+		CORO_END_CONTEXT(_ctx);
+
+		CORO_BEGIN_CODE(_ctx);
+		CORO_SLEEP(*(const int *)param);
+		CORO_END_CODE;
+	}
+
+public:
+	void setUp() {
+		CoroScheduler.reset();
+	}
+
+	void test_wait_for_event() {
+		WaitState state = { { CoroScheduler.createEvent(false, false), 0 }, 1, 0 };
+		WaitState *statePtr = &state;
+		CoroScheduler.createProcess(waitForAny, &statePtr, sizeof(statePtr));
+
+		CoroScheduler.schedule();
+		TS_ASSERT_EQUALS(CoroScheduler.getStats().blockedProcesses, 1u);
+
+		// Blocked processes are not run until the event is set
+		for (int i = 0; i < 3; i++) {
+			CoroScheduler.schedule();
+			TS_ASSERT_EQUALS(CoroScheduler.getStats().dispatches, 0u);
+		}
+		TS_ASSERT_EQUALS(state.woken, 0);
+
+		CoroScheduler.setEvent(state.pids[0]);
+		CoroScheduler.schedule();
+		TS_ASSERT_EQUALS(state.woken, 1);
+		TS_ASSERT_EQUALS(CoroScheduler.getStats().wakeups, 1u);
+		TS_ASSERT_EQUALS(CoroScheduler.getStats().liveProcesses, 0u);
+
+		CoroScheduler.closeEvent(state.pids[0]);
+	}
+
+	void test_wait_for_process() {
+		const int frames = 3;
+		WaitState state = { { CoroScheduler.createProcess(sleepFrames, &frames, sizeof(frames)), 0 }, 1, 0 };
+		WaitState *statePtr = &state;
+		CoroScheduler.createProcess(waitForAny, &statePtr, sizeof(statePtr));
+
+		int schedules = 0;
+		while (!state.woken && schedules < 10) {
+			CoroScheduler.schedule();
+			schedules++;
+		}
+
+		// The waiting process is woken up when the sleeping one ends
+		TS_ASSERT_EQUALS(state.woken, 1);
+		TS_ASSERT_LESS_THAN_EQUALS(schedules, frames + 2);
+		TS_ASSERT_EQUALS(CoroScheduler.getStats().liveProcesses, 0u);
+	}
+
+	void test_wait_for_multiple_with_unknown_pid() {
+		// Only the event can signal the wait; the other pid belongs to no
+		// process or event and has to be skipped when resetting events
+		WaitState state = { { CoroScheduler.createEvent(false, false), 0x7ffffff0 }, 2, 0 };
+		WaitState *statePtr = &state;
+		CoroScheduler.createProcess(waitForAny, &statePtr, sizeof(statePtr));
+
+		CoroScheduler.schedule();
+		TS_ASSERT_EQUALS(state.woken, 0);
+
+		CoroScheduler.setEvent(state.pids[0]);
+		CoroScheduler.schedule();
+		TS_ASSERT_EQUALS(state.woken, 1);
+
+		CoroScheduler.closeEvent(state.pids[0]);
+	}
+};
@@ -2,6 +2,10 @@
 #include "common/huffman.h"
 #include "common/bitstream.h"
 #include "common/memstream.h"
+#include "common/array.h"
+#include "common/str.h"
+
+#include "test/system/benchmark.h"
 
 /**
 * A test suite for the Huffman decoder in common/huffman.h
@@ -141,4 +145,255 @@ class HuffmanTestSuite : public CxxTest::TestSuite {
 		TS_ASSERT_EQUALS(h.getSymbol(bs), expected[5]);
 		TS_ASSERT_EQUALS(h.getSymbol(bs), expected[6]);
 	}
+
+	void test_get_long_codes() {
+
+		/*
+		 * Codes longer than the prefix lookup table have to be found
+		 * by walking the remaining bits. We use a unary code here, with
+		 * lengths from 1 to 12:
+		 *
+		 * 0=0
+		 * 1=10
+		 * 2=110
+		 * ...
+		 * 11=111111111110
+		 * 12=111111111111
+		 */
+
+		const uint32 codeCount = 13;
+		uint8  lengths[codeCount];
+		uint32 codes[codeCount];
+
+		for (uint32 i = 0; i < codeCount - 1; i++) {
+			lengths[i] = i + 1;
+			codes[i]   = (1 << (i + 1)) - 2;
+		}
+
+		lengths[codeCount - 1] = codeCount - 1;
+		codes[codeCount - 1]   = (1 << (codeCount - 1)) - 1;
+
+		Common::Huffman h(0, codeCount, codes, lengths, 0);
+
+		const uint32 expected[] = {12, 0, 11, 3, 9, 12, 1, 8, 7, 0, 0, 10, 2, 12, 5, 4, 6};
+		const uint32 count = ARRAYSIZE(expected);
+
+		Common::Array<byte> input;
+		uint32 bitCount = 0;
+		for (uint32 i = 0; i < count; i++)
+			writeCode(input, bitCount, codes[expected[i]], lengths[expected[i]], true);
+
+		// Walking the codes bit by bit
+		Common::MemoryReadStream ms(input.begin(), input.size());
+		Common::BitStream8MSB bs(ms);
+
+		for (uint32 i = 0; i < count; i++)
+			TS_ASSERT_EQUALS(h.getSymbol(bs), expected[i]);
+
+		TS_ASSERT_EQUALS(bs.pos(), bitCount);
+
+		// With the prefix table lookup
+		Common::BitStreamMemoryStream bms(input.begin(), input.size());
+		Common::BitStreamMemory8MSB bbs(bms);
+
+		for (uint32 i = 0; i < count; i++)
+			TS_ASSERT_EQUALS(h.getSymbol(bbs), expected[i]);
+
+		TS_ASSERT_EQUALS(bbs.pos(), bitCount);
+	}
+
+	void test_get_lsb2msb() {
+
+		/*
+		 * The same unary code, read from a LSB2MSB bit stream.
+		 * With such a stream, the first bit of a code is its lowest one:
+		 *
+		 * 0=0
+		 * 1=01
+		 * 2=011
+		 * ...
+		 */
+
+		const uint32 codeCount = 13;
+		uint8  lengths[codeCount];
+		uint32 codes[codeCount];
+
+		for (uint32 i = 0; i < codeCount - 1; i++) {
+			lengths[i] = i + 1;
+			codes[i]   = (1 << i) - 1;
+		}
+
+		lengths[codeCount - 1] = codeCount - 1;
+		codes[codeCount - 1]   = (1 << (codeCount - 1)) - 1;
+
+		Common::Huffman h(0, codeCount, codes, lengths, 0);
+
+		const uint32 expected[] = {3, 12, 0, 0, 11, 1, 7, 2, 12, 9, 4, 10, 5, 8, 6};
+		const uint32 count = ARRAYSIZE(expected);
+
+		Common::Array<byte> input;
+		uint32 bitCount = 0;
+		for (uint32 i = 0; i < count; i++)
+			writeCode(input, bitCount, codes[expected[i]], lengths[expected[i]], false);
+
+		Common::MemoryReadStream ms(input.begin(), input.size());
+		Common::BitStream8LSB bs(ms);
+
+		for (uint32 i = 0; i < count; i++)
+			TS_ASSERT_EQUALS(h.getSymbol(bs), expected[i]);
+
+		TS_ASSERT_EQUALS(bs.pos(), bitCount);
+
+		Common::BitStreamMemoryStream bms(input.begin(), input.size());
+		Common::BitStreamMemory8LSB bbs(bms);
+
+		for (uint32 i = 0; i < count; i++)
+			TS_ASSERT_EQUALS(h.getSymbol(bbs), expected[i]);
+
+		TS_ASSERT_EQUALS(bbs.pos(), bitCount);
+	}
+
+	void test_benchmark() {
+
+		/*
+		 * A complete canonical code shaped like the ones video codecs use:
+		 * 4 codes of 3 bits, 4 of 4, 8 of 6, 48 of 9 and 128 of 12 bits.
+		 * Most symbols are found with a single table lookup, the long ones
+		 * need the bit walk after it. We decode the same symbols with
+		 * Huffman::getSymbol() and with a bit by bit walk over the codes,
+		 * which is how getSymbol() worked before the prefix table, from
+		 * each kind of bit stream. BitStreamImpl can't peek cheaply, so
+		 * getSymbol() walks the codes there as well.
+		 */
+
+		const uint8 lengthCounts[][2] = { {3, 4}, {4, 4}, {6, 8}, {9, 48}, {12, 128} };
+
+		Common::Array<uint8>  lengths;
+		Common::Array<uint32> codes;
+
+		uint32 code = 0;
+		uint8 lastLength = lengthCounts[0][0];
+		for (uint i = 0; i < ARRAYSIZE(lengthCounts); i++) {
+			code <<= lengthCounts[i][0] - lastLength;
+			lastLength = lengthCounts[i][0];
+
+			for (uint j = 0; j < lengthCounts[i][1]; j++) {
+				lengths.push_back(lastLength);
+				codes.push_back(code++);
+			}
+		}
+
+		Common::Huffman h(0, codes.size(), codes.begin(), lengths.begin(), 0);
+
+		CodesByLength byLength;
+		byLength.resize(lastLength);
+		for (uint32 i = 0; i < codes.size(); i++) {
+			const Code c = { codes[i], i };
+			byLength[lengths[i] - 1].push_back(c);
+		}
+
+		// Random symbols, as often as their code lengths say: the code
+		// starting random bits is the one an encoder would have picked
+		const uint32 kSymbols = 200000;
+		Common::Array<uint32> symbols;
+		Common::Array<byte> input;
+		uint32 bitCount = 0;
+		uint32 seed = 1;
+		for (uint32 i = 0; i < kSymbols; i++) {
+			seed = seed * 1103515245 + 12345;
+			const uint32 bits = (seed >> 16) & ((1 << lastLength) - 1);
+
+			uint32 symbol = 0;
+			while ((bits >> (lastLength - lengths[symbol])) != codes[symbol])
+				symbol++;
+
+			symbols.push_back(symbol);
+			writeCode(input, bitCount, codes[symbol], lengths[symbol], true);
+		}
+
+		// Padding, so the table lookup never runs out of bits
+		input.push_back(0);
+
+		uint32 walkMemory = 0, tableMemory = 0, walkReservoir = 0, tableReservoir = 0, walkImpl = 0, tableImpl = 0;
+		for (int run = 0; run < BenchmarkTimer::kRuns; run++) {
+			BenchmarkTimer::keepBest(walkMemory,     decodeMemory(0,  byLength, input, symbols), run);
+			BenchmarkTimer::keepBest(tableMemory,    decodeMemory(&h, byLength, input, symbols), run);
+			BenchmarkTimer::keepBest(walkReservoir,  decodeStream<Common::BitStreamReservoir8MSB>(0,  byLength, input, symbols), run);
+			BenchmarkTimer::keepBest(tableReservoir, decodeStream<Common::BitStreamReservoir8MSB>(&h, byLength, input, symbols), run);
+			BenchmarkTimer::keepBest(walkImpl,       decodeStream<Common::BitStream8MSB>(0,  byLength, input, symbols), run);
+			BenchmarkTimer::keepBest(tableImpl,      decodeStream<Common::BitStream8MSB>(&h, byLength, input, symbols), run);
+		}
+
+		TS_TRACE(Common::String::format("Decoding %u symbols, bit walk vs. Huffman::getSymbol(): BitStreamMemory %u vs. %u us, "
+		         "BitStreamReservoir %u vs. %u us, BitStreamImpl %u vs. %u us", kSymbols,
+		         walkMemory, tableMemory, walkReservoir, tableReservoir, walkImpl, tableImpl).c_str());
+	}
+
+	private:
+	struct Code {
+		uint32 code;
+		uint32 symbol;
+	};
+
+	typedef Common::Array<Common::Array<Code> > CodesByLength;
+
+	/** Return the next symbol, walking the codes of each length bit by bit. */
+	static uint32 walkSymbol(Common::BitStream &bits, const CodesByLength &codes) {
+		uint32 code = 0;
+		for (uint32 i = 0; i < codes.size(); i++) {
+			bits.addBit(code, i);
+
+			for (uint32 j = 0; j < codes[i].size(); j++)
+				if (codes[i][j].code == code)
+					return codes[i][j].symbol;
+		}
+
+		return 0xFFFFFFFF;
+	}
+
+	/** Decode all symbols, with the Huffman decoder if given, and return the time it took in microseconds. */
+	static uint32 decode(const Common::Huffman *h, Common::BitStream &bits, const CodesByLength &codes,
+	                     const Common::Array<uint32> &symbols) {
+		bool match = true;
+
+		BenchmarkTimer timer;
+		for (uint32 i = 0; i < symbols.size(); i++) {
+			const uint32 symbol = h ? h->getSymbol(bits) : walkSymbol(bits, codes);
+			match = match && (symbol == symbols[i]);
+		}
+		const uint32 time = timer.micros();
+
+		TS_ASSERT(match);
+		return time;
+	}
+
+	static uint32 decodeMemory(const Common::Huffman *h, const CodesByLength &codes,
+	                           const Common::Array<byte> &input, const Common::Array<uint32> &symbols) {
+		Common::BitStreamMemoryStream ms(input.begin(), input.size());
+		Common::BitStreamMemory8MSB bs(ms);
+
+		return decode(h, bs, codes, symbols);
+	}
+
+	template<class BITSTREAM>
+	static uint32 decodeStream(const Common::Huffman *h, const CodesByLength &codes,
+	                           const Common::Array<byte> &input, const Common::Array<uint32> &symbols) {
+		Common::MemoryReadStream ms(input.begin(), input.size());
+		BITSTREAM bs(ms);
+
+		return decode(h, bs, codes, symbols);
+	}
+
+	/** Append a code, in the order the bit stream will read it, to a byte buffer. */
+	static void writeCode(Common::Array<byte> &data, uint32 &bitCount, uint32 code, uint8 length, bool msb) {
+		for (uint8 i = 0; i < length; i++, bitCount++) {
+			const uint32 bit = msb ? ((code >> (length - i - 1)) & 1) : ((code >> i) & 1);
+
+			if ((bitCount % 8) == 0)
+				data.push_back(0);
+
+			if (bit)
+				data.back() |= msb ? (0x80 >> (bitCount % 8)) : (1 << (bitCount % 8));
+		}
+	}
 };
@@ -0,0 +1,155 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memorypool.h"
+#include "common/array.h"
+#include "common/hashmap.h"
+#include "common/str.h"
+#include "common/hash-str.h"
+
+class MemoryPoolTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_arena_alloc() {
+		Common::Arena arena(256);
+
+		byte *a = (byte *)arena.allocate(10);
+		byte *b = (byte *)arena.allocate(20, 16);
+		TS_ASSERT(a != 0);
+		TS_ASSERT(b != 0);
+		TS_ASSERT_EQUALS((size_t)b & 15, (size_t)0);
+		TS_ASSERT(b >= a + 10);
+		memset(a, 0xAA, 10);
+		memset(b, 0xBB, 20);
+		TS_ASSERT_EQUALS(a[9], 0xAA);
+
+		// Bigger than a block
+		byte *c = (byte *)arena.allocate(1000);
+		TS_ASSERT(c != 0);
+		memset(c, 0xCC, 1000);
+		TS_ASSERT_EQUALS(b[19], 0xBB);
+
+		TS_ASSERT(arena.getBytesUsed() >= 1030);
+		TS_ASSERT_EQUALS(arena.getHighWaterMark(), arena.getBytesUsed());
+	}
+
+	void test_arena_reset() {
+		Common::Arena arena(256);
+
+		for (int i = 0; i < 20; ++i)
+			arena.allocate(100);
+		const size_t used = arena.getBytesUsed();
+		const size_t reserved = arena.getBytesReserved();
+
+		arena.reset();
+		TS_ASSERT_EQUALS(arena.getBytesUsed(), (size_t)0);
+		TS_ASSERT_EQUALS(arena.getHighWaterMark(), used);
+
+		// The blocks are reused for the next frame
+		for (int i = 0; i < 20; ++i)
+			arena.allocate(100);
+		TS_ASSERT_EQUALS(arena.getBytesReserved(), reserved);
+
+		arena.reset();
+		arena.freeUnusedBlocks();
+		TS_ASSERT_EQUALS(arena.getBytesReserved(), (size_t)0);
+	}
+
+	void test_arena_rewind() {
+		Common::Arena arena(128);
+
+		arena.allocate(50);
+		const size_t used = arena.getBytesUsed();
+		{
+			Common::ArenaScope scope(arena);
+			for (int i = 0; i < 10; ++i)
+				arena.allocate(60);
+			arena.allocate(500);
+			TS_ASSERT(arena.getBytesUsed() > used);
+		}
+		TS_ASSERT_EQUALS(arena.getBytesUsed(), used);
+		TS_ASSERT(arena.getHighWaterMark() > used);
+
+		arena.resetHighWaterMark();
+		TS_ASSERT_EQUALS(arena.getHighWaterMark(), used);
+	}
+
+	void test_size_class_pool() {
+		Common::SizeClassPool pool;
+
+		void *small = pool.allocate(5);
+		void *medium = pool.allocate(100);
+		void *large = pool.allocate(Common::SizeClassPool::getMaxPooledSize() + 1);
+		TS_ASSERT(small != 0);
+		TS_ASSERT(medium != 0);
+		TS_ASSERT(large != 0);
+		memset(small, 0, 5);
+		memset(medium, 0, 100);
+
+		const size_t inUse = pool.getBytesInUse();
+		TS_ASSERT(inUse >= 5 + 100 + Common::SizeClassPool::getMaxPooledSize() + 1);
+
+		pool.deallocate(medium, 100);
+		pool.deallocate(large, Common::SizeClassPool::getMaxPooledSize() + 1);
+		pool.deallocate(small, 5);
+		TS_ASSERT_EQUALS(pool.getBytesInUse(), (size_t)0);
+		TS_ASSERT_EQUALS(pool.getHighWaterMark(), inUse);
+
+		// Freed chunks are handed out again
+		void *again = pool.allocate(100);
+		TS_ASSERT_EQUALS(again, medium);
+		pool.deallocate(again, 100);
+	}
+
+	void test_array_allocator() {
+		Common::Arena arena;
+		{
+			Common::Array<int, Common::ArenaAllocator> array((Common::ArenaAllocator(arena)));
+			for (int i = 0; i < 100; ++i)
+				array.push_back(i);
+			TS_ASSERT_EQUALS(array.size(), (uint)100);
+			TS_ASSERT_EQUALS(array[57], 57);
+			TS_ASSERT(arena.getBytesUsed() >= 100 * sizeof(int));
+
+			Common::Array<int, Common::ArenaAllocator> copy(array);
+			TS_ASSERT(copy == array);
+			TS_ASSERT_EQUALS(&copy.getAllocator().getArena(), &arena);
+		}
+		arena.reset();
+
+		Common::SizeClassPool pool;
+		{
+			Common::Array<Common::String, Common::PoolAllocator> array((Common::PoolAllocator(pool)));
+			array.push_back("one");
+			array.push_back("two");
+			array.insert_at(1, "three");
+			TS_ASSERT_EQUALS(array[1], "three");
+			TS_ASSERT(pool.getBytesInUse() > 0);
+		}
+		TS_ASSERT_EQUALS(pool.getBytesInUse(), (size_t)0);
+	}
+
+	void test_hashmap_allocator() {
+		typedef Common::HashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo, Common::PoolAllocator> PoolMap;
+
+		Common::SizeClassPool pool;
+		{
+			PoolMap map((Common::PoolAllocator(pool)));
+			for (int i = 0; i < 100; ++i)
+				map[Common::String::format("key%d", i)] = i;
+			TS_ASSERT_EQUALS(map.size(), (uint)100);
+			TS_ASSERT_EQUALS(map["KEY42"], 42);
+
+			map.erase("key42");
+			TS_ASSERT(!map.contains("key42"));
+
+			PoolMap copy(map);
+			TS_ASSERT_EQUALS(copy.size(), (uint)99);
+			TS_ASSERT_EQUALS(copy["key7"], 7);
+
+			map.clear(true);
+			TS_ASSERT(map.empty());
+		}
+		TS_ASSERT_EQUALS(pool.getBytesInUse(), (size_t)0);
+		TS_ASSERT(pool.getHighWaterMark() > 0);
+	}
+};
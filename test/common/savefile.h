@@ -0,0 +1,161 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/fs.h"
+#include "common/savefile.h"
+#include "common/str.h"
+
+#include "backends/saves/default/default-saves.h"
+
+#include "test/system/null_osystem.h"
+
+/**
+ * Writes every savefile in the background, into the test directory of the
+ * build directory the tests run in.
+ */
+class BackgroundSaveFileManager : public DefaultSaveFileManager {
+protected:
+	virtual Common::String getSavePath() const { return "test"; }
+	virtual bool canSaveInBackground() const { return true; }
+};
+
+class SaveFileTestSuite : public CxxTest::TestSuite {
+	OSystem *_oldSystem;
+	NullOSystem *_system;
+
+	static Common::String readFile(const Common::String &name) {
+		Common::SeekableReadStream *stream = Common::FSNode("test").getChild(name).createReadStream();
+		if (!stream)
+			return "<missing>";
+		Common::String contents;
+		while (!stream->eos()) {
+			const char c = stream->readByte();
+			if (!stream->eos())
+				contents += c;
+		}
+		delete stream;
+		return contents;
+	}
+
+	static void writeFile(const Common::String &name, const char *contents) {
+		Common::WriteStream *stream = Common::FSNode("test").getChild(name).createWriteStream();
+		stream->writeString(contents);
+		delete stream;
+	}
+
+	static bool fileExists(const Common::String &name) {
+		return Common::FSNode("test").getChild(name).exists();
+	}
+
+	static void removeFile(const Common::String &name) {
+		remove(Common::FSNode("test").getChild(name).getPath().c_str());
+	}
+
+	/**
+	 * A name the file system accepts, while the temporary file the savefile
+	 * is written to first has a name too long for it.
+	 */
+	static Common::String unwritableName() {
+		Common::String name = "savefile-test-";
+		while (name.size() < 252)
+			name += 'x';
+		return name;
+	}
+
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		_system = new NullOSystem();
+		g_system = _system;
+	}
+
+	void tearDown() {
+		g_system = _oldSystem;
+		delete _system;
+		_system = 0;
+	}
+
+	void test_background_save() {
+#if defined(POSIX)
+		BackgroundSaveFileManager manager;
+
+		Common::OutSaveFile *out = manager.openForSaving("savefile-test-ok", false);
+		TS_ASSERT(out);
+		out->writeString("saved");
+		out->finalize();
+		TS_ASSERT(!out->err());
+		delete out;
+
+		// Compressed savefiles are written the same way
+		out = manager.openForSaving("savefile-test-compressed");
+		out->writeString("compressed");
+		delete out;
+
+		TS_ASSERT(manager.flushSavefiles());
+		TS_ASSERT_EQUALS(readFile("savefile-test-ok"), "saved");
+		TS_ASSERT(!fileExists("savefile-test-ok.tmp"));
+
+		Common::InSaveFile *in = manager.openForLoading("savefile-test-compressed");
+		TS_ASSERT(in);
+		if (in) {
+			TS_ASSERT_EQUALS(in->readLine(), "compressed");
+			delete in;
+		}
+
+		removeFile("savefile-test-ok");
+		removeFile("savefile-test-compressed");
+#endif
+	}
+
+	void test_failure_reported_by_err() {
+#if defined(POSIX)
+		const Common::String name = unwritableName();
+		writeFile(name, "previous");
+
+		BackgroundSaveFileManager manager;
+		Common::OutSaveFile *out = manager.openForSaving(name, false);
+		TS_ASSERT(out);
+		out->writeString("next");
+		TS_ASSERT(!out->err());
+		out->finalize();
+		TS_ASSERT(out->err());
+		delete out;
+
+		// The engine knows about it already, the previous savegame is kept
+		TS_ASSERT(manager.flushSavefiles());
+		TS_ASSERT_EQUALS(readFile(name), "previous");
+
+		removeFile(name);
+#endif
+	}
+
+	void test_failure_reported_by_flush() {
+#if defined(POSIX)
+		const Common::String name = unwritableName();
+		writeFile(name, "previous");
+
+		BackgroundSaveFileManager manager;
+		Common::OutSaveFile *out = manager.openForSaving(name, false);
+		TS_ASSERT(out);
+		out->writeString("next");
+		delete out;
+
+		// Saving another file meanwhile does not hide the failure
+		out = manager.openForSaving("savefile-test-ok", false);
+		out->writeString("saved");
+		delete out;
+
+		TS_ASSERT(!manager.flushSavefiles());
+		TS_ASSERT_EQUALS(manager.getError().getCode(), Common::kWritingFailed);
+		TS_ASSERT(manager.getErrorDesc().contains(name));
+		TS_ASSERT(!manager.getErrorDesc().contains("savefile-test-ok"));
+		TS_ASSERT_EQUALS(readFile(name), "previous");
+		TS_ASSERT_EQUALS(readFile("savefile-test-ok"), "saved");
+
+		// Each failure is reported once
+		TS_ASSERT(manager.flushSavefiles());
+
+		removeFile(name);
+		removeFile("savefile-test-ok");
+#endif
+	}
+};
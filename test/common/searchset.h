@@ -0,0 +1,216 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/str-array.h"
+
+/**
+ * A simple archive with a fixed list of members, each containing a single
+ * byte identifying the archive.
+ */
+class TestArchive : public Common::Archive {
+public:
+	TestArchive(byte id, const Common::StringArray &names) : _id(id), _names(names), _probes(0) {
+	}
+
+	/** Also serve a member without listing it, like a FSDirectory does for files in sub directories. */
+	void addUnlisted(const Common::String &name) {
+		_unlisted.push_back(name);
+	}
+
+	bool hasFile(const Common::String &name) const {
+		_probes++;
+
+		for (Common::StringArray::const_iterator it = _names.begin(); it != _names.end(); ++it)
+			if (it->equalsIgnoreCase(name))
+				return true;
+
+		for (Common::StringArray::const_iterator it = _unlisted.begin(); it != _unlisted.end(); ++it)
+			if (it->equalsIgnoreCase(name))
+				return true;
+
+		return false;
+	}
+
+	int listMembers(Common::ArchiveMemberList &list) const {
+		for (Common::StringArray::const_iterator it = _names.begin(); it != _names.end(); ++it)
+			list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(*it, this)));
+
+		return _names.size();
+	}
+
+	const Common::ArchiveMemberPtr getMember(const Common::String &name) const {
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(name, this));
+	}
+
+	Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const {
+		if (!hasFile(name))
+			return 0;
+
+		return new Common::MemoryReadStream(&_id, 1);
+	}
+
+	uint32 getProbes() const {
+		return _probes;
+	}
+
+private:
+	byte _id;
+	Common::StringArray _names;
+	Common::StringArray _unlisted;
+
+	mutable uint32 _probes;
+};
+
+class SearchSetTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_index_priority() {
+		Common::SearchSet set;
+		set.enableIndex(true);
+
+		TestArchive *low  = new TestArchive(1, makeNames("a.dat", "shared.dat"));
+		TestArchive *high = new TestArchive(2, makeNames("b.dat", "SHARED.DAT"));
+
+		set.add("low", low, 0);
+		set.add("high", high, 10);
+
+		TS_ASSERT(set.hasFile("a.dat"));
+		TS_ASSERT(set.hasFile("B.dat"));
+		TS_ASSERT(!set.hasFile("c.dat"));
+
+		// The member of the archive with the higher priority has to win
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+
+		set.setPriority("low", 20);
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 1);
+
+		set.remove("low");
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+		TS_ASSERT(!set.hasFile("a.dat"));
+
+		// shared.dat is found by an ordered search after removing "low",
+		// and added back to the index
+		Common::SearchSet::IndexStats stats = set.getIndexStats();
+		TS_ASSERT_EQUALS(stats.members, 2u);
+		TS_ASSERT_EQUALS(stats.hits, 4u);
+		TS_ASSERT_EQUALS(stats.misses, 3u);
+
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+		TS_ASSERT_EQUALS(set.getIndexStats().hits, 5u);
+	}
+
+	void test_index_incremental() {
+		Common::SearchSet set;
+		set.enableIndex(true);
+
+		TestArchive *first  = new TestArchive(1, makeNames("a.dat", "b.dat"));
+		TestArchive *second = new TestArchive(2, makeNames("c.dat", "d.dat"));
+		TestArchive *third  = new TestArchive(3, makeNames("e.dat", "a.dat"));
+
+		set.add("first", first, 10);
+		set.add("second", second, 0);
+		set.add("third", third, 5);
+
+		// Only the archive added is probed: for its own new members, and for
+		// the members of archives with a lower priority it might serve
+		TS_ASSERT_EQUALS(first->getProbes(), 2u);
+		TS_ASSERT_EQUALS(second->getProbes(), 2u);
+		TS_ASSERT_EQUALS(third->getProbes(), 2u + 1u);
+
+		TS_ASSERT_EQUALS(readId(set, "a.dat"), 1);
+		TS_ASSERT_EQUALS(readId(set, "d.dat"), 2);
+		TS_ASSERT_EQUALS(readId(set, "e.dat"), 3);
+		TS_ASSERT_EQUALS(set.getIndexStats().members, 5u);
+
+		set.remove("first");
+		TS_ASSERT_EQUALS(readId(set, "a.dat"), 3);
+		TS_ASSERT(!set.hasFile("b.dat"));
+	}
+
+	void test_index_unlisted_member() {
+		Common::SearchSet set;
+		set.enableIndex(true);
+
+		TestArchive *high = new TestArchive(1, makeNames("a.dat", "b.dat"));
+		TestArchive *low  = new TestArchive(2, makeNames("sub/x.dat", "c.dat"));
+		high->addUnlisted("sub/x.dat");
+
+		set.add("high", high, 10);
+		set.add("low", low, 0);
+
+		// The index doesn't know high serves sub/x.dat, but the first lookup
+		// checks the archives of higher priority
+		TS_ASSERT_EQUALS(readId(set, "sub/x.dat"), 1);
+		TS_ASSERT_EQUALS(readId(set, "sub/x.dat"), 1);
+
+		// Unlisted members are found and added by an ordered search
+		high->addUnlisted("sub/y.dat");
+		TS_ASSERT_EQUALS(readId(set, "sub/y.dat"), 1);
+		TS_ASSERT_EQUALS(readId(set, "sub/y.dat"), 1);
+
+		Common::SearchSet::IndexStats stats = set.getIndexStats();
+		TS_ASSERT_EQUALS(stats.hits, 3u);
+		TS_ASSERT_EQUALS(stats.misses, 1u);
+	}
+
+	void test_index_single_probe() {
+		Common::SearchSet set;
+		set.enableIndex(true);
+
+		TestArchive *first  = new TestArchive(1, makeNames("a.dat", "b.dat"));
+		TestArchive *second = new TestArchive(2, makeNames("c.dat", "d.dat"));
+
+		set.add("first", first, 10);
+		set.add("second", second, 0);
+
+		// Build the index
+		TS_ASSERT(set.hasFile("d.dat"));
+
+		const uint32 firstProbes  = first->getProbes();
+		const uint32 secondProbes = second->getProbes();
+
+		// With the index, the first archive doesn't need to be probed anymore
+		for (int i = 0; i < 10; i++)
+			TS_ASSERT_EQUALS(readId(set, "d.dat"), 2);
+
+		TS_ASSERT_EQUALS(first->getProbes(), firstProbes);
+		TS_ASSERT_EQUALS(second->getProbes(), secondProbes + 10);
+	}
+
+	void test_no_index() {
+		Common::SearchSet set;
+
+		set.add("low", new TestArchive(1, makeNames("a.dat", "shared.dat")), 0);
+		set.add("high", new TestArchive(2, makeNames("b.dat", "shared.dat")), 10);
+
+		TS_ASSERT(set.hasFile("a.dat"));
+		TS_ASSERT_EQUALS(readId(set, "shared.dat"), 2);
+
+		Common::SearchSet::IndexStats stats = set.getIndexStats();
+		TS_ASSERT_EQUALS(stats.members, 0u);
+		TS_ASSERT_EQUALS(stats.hits, 0u);
+		TS_ASSERT_EQUALS(stats.misses, 0u);
+	}
+
+	private:
+	static Common::StringArray makeNames(const char *a, const char *b) {
+		Common::StringArray names;
+
+		names.push_back(a);
+		names.push_back(b);
+
+		return names;
+	}
+
+	static int readId(Common::SearchSet &set, const char *name) {
+		Common::SeekableReadStream *stream = set.createReadStreamForMember(name);
+		if (!stream)
+			return -1;
+
+		int id = stream->readByte();
+		delete stream;
+
+		return id;
+	}
+};
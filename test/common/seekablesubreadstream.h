@@ -70,4 +70,63 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_read_stream() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+		// Copying through read(), and asking the parent for the data
+		for (int share = 0; share < 2; share++) {
+			Common::MemoryReadStream ms(contents, 10);
+
+			Common::SeekableSubReadStream ssrs(&ms, 2, 8);
+			if (share)
+				ssrs.shareParentData();
+
+			ssrs.seek(1);
+
+			Common::SeekableReadStream *s = ssrs.readStream(3);
+			TS_ASSERT_EQUALS(s->size(), 3);
+			TS_ASSERT_EQUALS(s->readByte(), 3);
+			TS_ASSERT_EQUALS(ssrs.pos(), 4);
+			TS_ASSERT(!ssrs.eos());
+			delete s;
+
+			// Reading past the end of the sub stream returns less data
+			s = ssrs.readStream(5);
+			TS_ASSERT_EQUALS(s->size(), 2);
+			TS_ASSERT_EQUALS(s->readByte(), 6);
+			TS_ASSERT_EQUALS(s->readByte(), 7);
+			TS_ASSERT_EQUALS(ssrs.pos(), 6);
+			TS_ASSERT(ssrs.eos());
+			delete s;
+		}
+	}
+
+	void test_read_stream_uses_read_override() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+
+		// Subclasses like Neverhood's mutexed stream rely on their read()
+		CountingSubReadStream ssrs(&ms, 2, 8);
+
+		Common::SeekableReadStream *s = ssrs.readStream(4);
+		TS_ASSERT_EQUALS(s->readByte(), 2);
+		TS_ASSERT_EQUALS(ssrs.reads, 1);
+		delete s;
+	}
+
+	private:
+	class CountingSubReadStream : public Common::SafeSeekableSubReadStream {
+	public:
+		int reads;
+
+		CountingSubReadStream(Common::SeekableReadStream *parentStream, uint32 begin, uint32 end)
+			: Common::SafeSeekableSubReadStream(parentStream, begin, end), reads(0) {
+		}
+
+		virtual uint32 read(void *dataPtr, uint32 dataSize) {
+			reads++;
+			return Common::SafeSeekableSubReadStream::read(dataPtr, dataSize);
+		}
+	};
 };
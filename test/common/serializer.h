@@ -1,8 +1,27 @@
 #include <cxxtest/TestSuite.h>
 
+#include "common/memstream.h"
 #include "common/serializer.h"
 #include "common/stream.h"
 
+#include "test/system/benchmark.h"
+
+/**
+ * A memory stream counting the calls made to it, to check that arrays are
+ * synced in bulk.
+ */
+class CallCountingWriteStream : public Common::MemoryWriteStream {
+public:
+	uint32 _calls;
+
+	CallCountingWriteStream(byte *buf, uint32 len) : Common::MemoryWriteStream(buf, len), _calls(0) {}
+
+	uint32 write(const void *dataPtr, uint32 dataSize) {
+		_calls++;
+		return Common::MemoryWriteStream::write(dataPtr, dataSize);
+	}
+};
+
 class SerializerTestSuite : public CxxTest::TestSuite {
 	Common::SeekableReadStream *_inStreamV1;
 	Common::SeekableReadStream *_inStreamV2;
@@ -108,4 +127,211 @@ public:
 	void test_read_v2_as_v2() {
 		readVersioned_v2(_inStreamV2, 2);
 	}
+
+	void test_sync_array() {
+		int32 values[300];
+		for (int i = 0; i < 300; ++i)
+			values[i] = i * 1000 - 100000;
+
+		// Syncing an array gives the same data as syncing each value
+		byte single[300 * 10], bulk[300 * 10];
+		Common::MemoryWriteStream singleStream(single, sizeof(single));
+		Common::MemoryWriteStream bulkStream(bulk, sizeof(bulk));
+		Common::Serializer singleSer(0, &singleStream);
+		Common::Serializer bulkSer(0, &bulkStream);
+
+		for (int i = 0; i < 300; ++i)
+			singleSer.syncAsSint32BE(values[i]);
+		for (int i = 0; i < 300; ++i)
+			singleSer.syncAsSint32LE(values[i]);
+		for (int i = 0; i < 300; ++i)
+			singleSer.syncAsUint16BE(values[i]);
+		bulkSer.syncArray<Common::Serializer::Sint32BE>(values, 300);
+		bulkSer.syncArray<Common::Serializer::Sint32LE>(values, 300);
+		bulkSer.syncArray<Common::Serializer::Uint16BE>(values, 300);
+
+		TS_ASSERT_EQUALS(bulkSer.bytesSynced(), (uint)(300 * 10));
+		TS_ASSERT_EQUALS(singleSer.bytesSynced(), bulkSer.bytesSynced());
+		TS_ASSERT(!memcmp(single, bulk, sizeof(bulk)));
+
+		// And loading it back
+		int32 loaded[300];
+		int16 loaded16[300];
+		Common::MemoryReadStream in(bulk, sizeof(bulk));
+		Common::Serializer loadSer(&in, 0);
+		loadSer.syncArray<Common::Serializer::Sint32BE>(loaded, 300);
+		TS_ASSERT(!memcmp(loaded, values, sizeof(loaded)));
+		loadSer.syncArray<Common::Serializer::Sint32LE>(loaded, 300);
+		TS_ASSERT(!memcmp(loaded, values, sizeof(loaded)));
+		loadSer.syncArray<Common::Serializer::Uint16BE>(loaded16, 300);
+		TS_ASSERT_EQUALS(loaded16[7], (int16)values[7]);
+		TS_ASSERT_EQUALS(loaded16[299], (int16)values[299]);
+
+		// Nothing is synced for other versions
+		loadSer.syncArray<Common::Serializer::Byte>(loaded16, 300, 1);
+		TS_ASSERT_EQUALS(loadSer.bytesSynced(), (uint)(300 * 10));
+	}
+
+	enum {
+		kStateValues = 1024 * 1024
+	};
+
+	// A synthetic 10 MB savestate
+	void syncState(Common::Serializer &ser, uint32 *a, int16 *b, int32 *c) {
+		ser.syncVersion(1);
+		ser.syncArray<Common::Serializer::Uint32LE>(a, kStateValues);
+		ser.syncArray<Common::Serializer::Sint16BE>(b, kStateValues);
+		ser.syncArray<Common::Serializer::Uint16LE>(c, 2 * kStateValues);
+	}
+
+	void test_dry_run() {
+		uint32 *a = new uint32[kStateValues];
+		int16 *b = new int16[kStateValues];
+		int32 *c = new int32[2 * kStateValues];
+		for (uint32 i = 0; i < kStateValues; ++i) {
+			a[i] = i * 2654435761U;
+			b[i] = (int16)(i ^ 0x5555);
+			c[2 * i] = i & 0xFFFF;
+			c[2 * i + 1] = (i * 7) & 0xFFFF;
+		}
+
+		// Find out the size of the savestate, ...
+		Common::Serializer dryRun(0, 0);
+		TS_ASSERT(dryRun.isSaving());
+		TS_ASSERT(dryRun.isDryRun());
+		syncState(dryRun, a, b, c);
+		const uint size = dryRun.bytesSynced();
+		TS_ASSERT_EQUALS(size, (uint)(4 + 10 * kStateValues));
+
+		// ... and save it into one buffer
+		byte *buf = new byte[size];
+		CallCountingWriteStream out(buf, size);
+		Common::Serializer saver(0, &out);
+		TS_ASSERT(!saver.isDryRun());
+		syncState(saver, a, b, c);
+		TS_ASSERT_EQUALS(out.pos(), (uint32)size);
+		TS_ASSERT(!out.err());
+		TS_ASSERT_LESS_THAN(out._calls, (uint32)(size / 1024));
+
+		uint32 *a2 = new uint32[kStateValues];
+		int16 *b2 = new int16[kStateValues];
+		int32 *c2 = new int32[2 * kStateValues];
+		Common::MemoryReadStream in(buf, size);
+		Common::Serializer loader(&in, 0);
+		syncState(loader, a2, b2, c2);
+		TS_ASSERT_EQUALS(loader.bytesSynced(), size);
+		TS_ASSERT(!memcmp(a, a2, kStateValues * sizeof(uint32)));
+		TS_ASSERT(!memcmp(b, b2, kStateValues * sizeof(int16)));
+		TS_ASSERT(!memcmp(c, c2, 2 * kStateValues * sizeof(int32)));
+
+		delete[] a;
+		delete[] b;
+		delete[] c;
+		delete[] a2;
+		delete[] b2;
+		delete[] c2;
+		delete[] buf;
+	}
+
+	void test_copy_dry_run() {
+		uint32 value = 1;
+		Common::Serializer dryRun(0, 0);
+		dryRun.syncAsUint32LE(value);
+
+		// The copy counts on its own, not into the original's stream
+		Common::Serializer copy(dryRun);
+		TS_ASSERT(copy.isDryRun());
+		copy.syncAsUint32LE(value);
+		TS_ASSERT_EQUALS(copy.bytesSynced(), 8u);
+		TS_ASSERT(!copy.err());
+
+		Common::Serializer assigned(0, 0);
+		assigned = copy;
+		TS_ASSERT(assigned.isDryRun());
+		assigned.syncAsUint16LE(value);
+		TS_ASSERT_EQUALS(assigned.bytesSynced(), 10u);
+		TS_ASSERT_EQUALS(copy.bytesSynced(), 8u);
+		TS_ASSERT_EQUALS(dryRun.bytesSynced(), 4u);
+
+		// Copies of other serializers share the streams
+		byte buf[4];
+		Common::MemoryWriteStream out(buf, sizeof(buf));
+		Common::Serializer saver(0, &out);
+		Common::Serializer saverCopy(saver);
+		TS_ASSERT(!saverCopy.isDryRun());
+		saverCopy.syncAsUint32BE(value);
+		TS_ASSERT_EQUALS(out.pos(), 4u);
+	}
+
+	// The synthetic savestate synced value by value, as before syncArray()
+	void syncStateSingle(Common::Serializer &ser, uint32 *a, int16 *b, int32 *c) {
+		ser.syncVersion(1);
+		for (uint32 i = 0; i < kStateValues; ++i)
+			ser.syncAsUint32LE(a[i]);
+		for (uint32 i = 0; i < kStateValues; ++i)
+			ser.syncAsSint16BE(b[i]);
+		for (uint32 i = 0; i < 2 * kStateValues; ++i)
+			ser.syncAsUint16LE(c[i]);
+	}
+
+	/** Save the state into a preallocated buffer and load it back, keeping the best times in ms. */
+	void timeSaveLoad(bool bulk, uint32 *a, int16 *b, int32 *c, byte *buf, uint size, uint32 &saveMillis, uint32 &loadMillis, int run) {
+		BenchmarkTimer timer;
+		Common::Serializer dryRun(0, 0);
+		if (bulk)
+			syncState(dryRun, a, b, c);
+		else
+			syncStateSingle(dryRun, a, b, c);
+		TS_ASSERT_EQUALS(dryRun.bytesSynced(), size);
+		Common::MemoryWriteStream out(buf, size);
+		Common::Serializer saver(0, &out);
+		if (bulk)
+			syncState(saver, a, b, c);
+		else
+			syncStateSingle(saver, a, b, c);
+		BenchmarkTimer::keepBest(saveMillis, timer.millis(), run);
+
+		timer.restart();
+		Common::MemoryReadStream in(buf, size);
+		Common::Serializer loader(&in, 0);
+		if (bulk)
+			syncState(loader, a, b, c);
+		else
+			syncStateSingle(loader, a, b, c);
+		BenchmarkTimer::keepBest(loadMillis, timer.millis(), run);
+		TS_ASSERT_EQUALS(loader.bytesSynced(), size);
+	}
+
+	void test_benchmark_state() {
+		uint32 *a = new uint32[kStateValues];
+		int16 *b = new int16[kStateValues];
+		int32 *c = new int32[2 * kStateValues];
+		for (uint32 i = 0; i < kStateValues; ++i) {
+			a[i] = i * 2654435761U;
+			b[i] = (int16)(i ^ 0x5555);
+			c[2 * i] = i & 0xFFFF;
+			c[2 * i + 1] = (i * 7) & 0xFFFF;
+		}
+		const uint size = 4 + 10 * kStateValues;
+		byte *buf = new byte[size];
+
+		uint32 singleSave = 0, singleLoad = 0, bulkSave = 0, bulkLoad = 0;
+		for (int run = 0; run < BenchmarkTimer::kRuns; run++) {
+			timeSaveLoad(false, a, b, c, buf, size, singleSave, singleLoad, run);
+			timeSaveLoad(true, a, b, c, buf, size, bulkSave, bulkLoad, run);
+		}
+
+		// Loading what was saved gives the same state
+		TS_ASSERT_EQUALS(a[12345], 12345 * 2654435761U);
+		TS_ASSERT_EQUALS(b[12345], (int16)(12345 ^ 0x5555));
+		TS_ASSERT_EQUALS(c[2 * 12345 + 1], (12345 * 7) & 0xFFFF);
+
+		TS_TRACE(Common::String::format("Saving and loading a %u byte state took %u and %u ms value by value, %u and %u ms with syncArray",
+		         size, singleSave, singleLoad, bulkSave, bulkLoad).c_str());
+
+		delete[] a;
+		delete[] b;
+		delete[] c;
+		delete[] buf;
+	}
 };
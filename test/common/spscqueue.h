@@ -0,0 +1,113 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/spscqueue.h"
+
+#if defined(POSIX) && defined(USE_PTHREADS)
+#include <pthread.h>
+#endif
+
+class SPSCQueueTestSuite : public CxxTest::TestSuite {
+	enum {
+		kThreadedItems = 200000
+	};
+
+	/** An item whose halves a torn copy would not match. */
+	struct Item {
+		uint32 value;
+		uint32 check;
+	};
+
+	typedef Common::SPSCQueue<Item, 16> ThreadedQueue;
+
+	static void *produce(void *queue) {
+		for (uint32 i = 0; i < kThreadedItems; ) {
+			Item item = { i, ~i };
+			if (((ThreadedQueue *)queue)->push(item))
+				i++;
+		}
+		return 0;
+	}
+
+public:
+	void test_push_pop() {
+		Common::SPSCQueue<int, 4> queue;
+		int value = -1;
+
+		TS_ASSERT(queue.empty());
+		TS_ASSERT(!queue.pop(value));
+		TS_ASSERT_EQUALS(value, -1);
+
+		TS_ASSERT(queue.push(1));
+		TS_ASSERT(queue.push(2));
+		TS_ASSERT(!queue.empty());
+
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 1);
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 2);
+		TS_ASSERT(queue.empty());
+	}
+
+	void test_full() {
+		Common::SPSCQueue<int, 4> queue;
+
+		for (int i = 0; i < 4; i++)
+			TS_ASSERT(queue.push(i));
+
+		// A full queue rejects items, and keeps what it has
+		TS_ASSERT(!queue.push(4));
+
+		int value;
+		TS_ASSERT(queue.pop(value));
+		TS_ASSERT_EQUALS(value, 0);
+		TS_ASSERT(queue.push(4));
+
+		for (int i = 1; i <= 4; i++) {
+			TS_ASSERT(queue.pop(value));
+			TS_ASSERT_EQUALS(value, i);
+		}
+		TS_ASSERT(queue.empty());
+	}
+
+	void test_wrap_around() {
+		Common::SPSCQueue<int, 8> queue;
+		int next = 0, expected = 0;
+
+		// Keep the queue partially filled while the positions wrap many times
+		for (int round = 0; round < 1000; round++) {
+			for (int i = 0; i < 5; i++)
+				TS_ASSERT(queue.push(next++));
+
+			int value;
+			for (int i = 0; i < 5; i++) {
+				TS_ASSERT(queue.pop(value));
+				TS_ASSERT_EQUALS(value, expected++);
+			}
+		}
+
+		TS_ASSERT(queue.empty());
+	}
+
+	void test_two_threads() {
+#if defined(POSIX) && defined(USE_PTHREADS)
+		// The queue is small, so that both ends wait for each other often
+		ThreadedQueue queue;
+		pthread_t producer;
+		TS_ASSERT_EQUALS(pthread_create(&producer, 0, &produce, &queue), 0);
+
+		uint32 expected = 0, errors = 0;
+		while (expected < kThreadedItems) {
+			Item item;
+			if (!queue.pop(item))
+				continue;
+			if (item.value != expected || item.check != ~expected)
+				errors++;
+			expected = item.value + 1;
+		}
+
+		pthread_join(producer, 0);
+		TS_ASSERT_EQUALS(errors, 0u);
+		TS_ASSERT(queue.empty());
+#endif
+	}
+};
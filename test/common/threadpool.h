@@ -0,0 +1,283 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/atomic.h"
+#include "common/threadpool.h"
+#include "backends/threads/threadpool.h"
+
+#if defined(POSIX) && defined(USE_PTHREADS)
+#include "backends/threads/posix/posix-threadpool.h"
+#endif
+
+class ThreadPoolTestSuite : public CxxTest::TestSuite {
+	struct Counter {
+		int calls;
+		Common::Array<int> hits;
+
+		Counter() : calls(0) {}
+
+		int next() { return ++calls; }
+		void bump() { calls += 10; }
+		void hit(uint i) { hits[i]++; }
+	};
+
+	/** A worker pool whose threads can't be started. */
+	class ThreadlessPool : public WorkerThreadPool {
+	public:
+		ThreadlessPool() : locks(0) { startWorkers(4); }
+		~ThreadlessPool() { stopWorkers(); }
+
+		int locks;
+
+	protected:
+		virtual bool createThread(uint index) { return false; }
+		virtual void joinThread(uint index) {}
+		virtual int getCurrentWorker() const { return -1; }
+		virtual void lock() { locks++; }
+		virtual bool tryLock() { locks++; return true; }
+		virtual void unlock() { locks--; }
+		virtual void waitForSignal() {}
+		virtual void signalAll() {}
+	};
+
+	/** A pool whose workers never run, so that submitted tasks stay queued. */
+	class StalledPool : public WorkerThreadPool {
+	public:
+		StalledPool() { startWorkers(2); }
+		~StalledPool() { stopWorkers(); }
+
+		void stop() { stopWorkers(); }
+
+	protected:
+		virtual bool createThread(uint index) { return true; }
+		virtual void joinThread(uint index) {}
+		virtual int getCurrentWorker() const { return -1; }
+		virtual void lock() {}
+		virtual bool tryLock() { return true; }
+		virtual void unlock() {}
+		virtual void waitForSignal() {}
+		virtual void signalAll() {}
+	};
+
+	/** Squares a number. */
+	struct SquareTask : public Common::ThreadTask {
+		uint value, result;
+
+		SquareTask(uint v) : value(v), result(0) {}
+		virtual void run() { result = value * value; }
+	};
+
+	/**
+	 * Sums up a range by splitting it in halves, which run as tasks of
+	 * their own, until they are small. The tasks wait for their children,
+	 * so that the workers have to run other tasks while waiting.
+	 */
+	struct SumTask : public Common::ThreadTask {
+		Common::ThreadPool &pool;
+		uint begin, end;
+		uint sum;
+
+		SumTask(Common::ThreadPool &p, uint b, uint e) : pool(p), begin(b), end(e), sum(0) {}
+
+		virtual void run() {
+			if (end - begin <= 16) {
+				for (uint i = begin; i < end; ++i)
+					sum += i;
+				return;
+			}
+
+			const uint middle = (begin + end) / 2;
+			SumTask left(pool, begin, middle), right(pool, middle, end);
+			pool.submit(&left);
+			pool.submit(&right);
+			pool.wait(&right);
+			pool.wait(&left);
+			sum = left.sum + right.sum;
+		}
+	};
+
+	/** Counts its runs, and the tasks of its kind which were deleted. */
+	struct CountingTask : public Common::ThreadTask {
+		int runs;
+
+		CountingTask() : runs(0) {}
+		~CountingTask() { Common::atomicAdd(&_deleted, 1); }
+		virtual void run() { runs++; }
+
+		static volatile int32 _deleted;
+	};
+
+public:
+	void test_async() {
+		Common::SerialThreadPool pool;
+		Counter counter;
+
+		TS_ASSERT_EQUALS(pool.getThreadCount(), 0u);
+
+		Common::Future<int> first = pool.async(new Common::Functor0Mem<int, Counter>(&counter, &Counter::next));
+		Common::Future<int> second = pool.async(new Common::Functor0Mem<int, Counter>(&counter, &Counter::next));
+
+		TS_ASSERT(first.isValid());
+		TS_ASSERT(first.isReady());
+		TS_ASSERT_EQUALS(first.get(), 1);
+		TS_ASSERT_EQUALS(second.get(), 2);
+
+		// Copies refer to the same task
+		Common::Future<int> copy = first;
+		TS_ASSERT_EQUALS(copy.get(), 1);
+		TS_ASSERT_EQUALS(counter.calls, 2);
+
+		Common::Future<int> empty;
+		TS_ASSERT(!empty.isValid());
+		TS_ASSERT(!empty.isReady());
+		empty.wait();
+
+		Common::Future<void> emptyVoid;
+		TS_ASSERT(!emptyVoid.isReady());
+		emptyVoid.wait();
+	}
+
+	void test_async_void() {
+		Common::SerialThreadPool pool;
+		Counter counter;
+
+		Common::Future<void> future = pool.async(new Common::Functor0Mem<void, Counter>(&counter, &Counter::bump));
+		future.get();
+		TS_ASSERT(future.isReady());
+		TS_ASSERT_EQUALS(counter.calls, 10);
+	}
+
+	void test_parallel_for() {
+		Common::SerialThreadPool pool;
+		Counter counter;
+		counter.hits.resize(20);
+		for (uint i = 0; i < counter.hits.size(); ++i)
+			counter.hits[i] = 0;
+
+		Common::Functor1Mem<uint, void, Counter> func(&counter, &Counter::hit);
+		pool.parallelFor(5, 15, func, 3);
+
+		for (uint i = 0; i < counter.hits.size(); ++i)
+			TS_ASSERT_EQUALS(counter.hits[i], (i >= 5 && i < 15) ? 1 : 0);
+
+		// An empty range doesn't call anything
+		pool.parallelFor(7, 7, func);
+		TS_ASSERT_EQUALS(counter.hits[7], 1);
+	}
+
+	void test_worker_pool_without_threads() {
+		ThreadlessPool pool;
+		TS_ASSERT_EQUALS(pool.getThreadCount(), 0u);
+
+		// Tasks run right away, with the pool unlocked
+		SquareTask task(7);
+		pool.submit(&task);
+		TS_ASSERT(pool.isFinished(&task));
+		TS_ASSERT_EQUALS(task.result, 49u);
+		pool.wait(&task);
+		TS_ASSERT_EQUALS(pool.locks, 0);
+
+		Counter counter;
+		Common::Future<int> future = pool.async(new Common::Functor0Mem<int, Counter>(&counter, &Counter::next));
+		TS_ASSERT(future.isReady());
+		TS_ASSERT_EQUALS(future.get(), 1);
+	}
+
+	void test_stop_runs_queued_tasks() {
+		StalledPool pool;
+		CountingTask::_deleted = 0;
+
+		CountingTask task;
+		CountingTask *detached = new CountingTask();
+		pool.submit(&task);
+		pool.submit(detached);
+		pool.detach(detached);
+		TS_ASSERT(!pool.isFinished(&task));
+
+		// Nobody would wait for the queued tasks forever
+		pool.stop();
+		TS_ASSERT(pool.isFinished(&task));
+		TS_ASSERT_EQUALS(task.runs, 1);
+		TS_ASSERT_EQUALS(Common::atomicLoad(&CountingTask::_deleted), 1);
+
+		// Without workers, tasks run right away
+		pool.submit(&task);
+		TS_ASSERT_EQUALS(task.runs, 2);
+	}
+
+	void test_try_submit_and_detach() {
+		Common::SerialThreadPool pool;
+		CountingTask::_deleted = 0;
+
+		// Tasks can be queued again once they finished
+		CountingTask *task = new CountingTask();
+		TS_ASSERT(pool.trySubmit(task));
+		TS_ASSERT(pool.trySubmit(task));
+		TS_ASSERT_EQUALS(task->runs, 2);
+
+		pool.detach(task);
+		TS_ASSERT_EQUALS(Common::atomicLoad(&CountingTask::_deleted), 1);
+
+#if defined(POSIX) && defined(USE_PTHREADS)
+		{
+			PosixThreadPool posixPool;
+
+			// Detached tasks are deleted once they ran, even those still
+			// queued when the pool goes away
+			for (int i = 0; i < 100; ++i) {
+				task = new CountingTask();
+				posixPool.trySubmit(task);
+				posixPool.detach(task);
+			}
+		}
+		TS_ASSERT_EQUALS(Common::atomicLoad(&CountingTask::_deleted), 101);
+#endif
+	}
+
+#if defined(POSIX) && defined(USE_PTHREADS)
+	void test_posix_pool_tasks() {
+		PosixThreadPool pool;
+		TS_ASSERT_LESS_THAN(0u, pool.getThreadCount());
+
+		Common::Array<SquareTask *> tasks;
+		for (uint i = 0; i < 1000; ++i) {
+			tasks.push_back(new SquareTask(i));
+			pool.submit(tasks.back());
+		}
+
+		// Wait in reverse, so that most tasks have finished when waited for
+		for (uint i = tasks.size(); i-- > 0; ) {
+			pool.wait(tasks[i]);
+			TS_ASSERT(pool.isFinished(tasks[i]));
+			TS_ASSERT_EQUALS(tasks[i]->result, i * i);
+			delete tasks[i];
+		}
+	}
+
+	void test_posix_pool_nested_tasks() {
+		PosixThreadPool pool;
+
+		// Many more tasks waiting for others than there are threads
+		SumTask sum(pool, 0, 4096);
+		pool.submit(&sum);
+		pool.wait(&sum);
+		TS_ASSERT_EQUALS(sum.sum, 4096u * 4095u / 2);
+	}
+
+	void test_posix_pool_parallel_for() {
+		PosixThreadPool pool;
+		Counter counter;
+		counter.hits.resize(10000);
+		for (uint i = 0; i < counter.hits.size(); ++i)
+			counter.hits[i] = 0;
+
+		// Each index is only touched by one thread
+		Common::Functor1Mem<uint, void, Counter> func(&counter, &Counter::hit);
+		pool.parallelFor(0, counter.hits.size(), func);
+
+		for (uint i = 0; i < counter.hits.size(); ++i)
+			TS_ASSERT_EQUALS(counter.hits[i], 1);
+	}
+#endif
+};
+
+volatile int32 ThreadPoolTestSuite::CountingTask::_deleted = 0;
@@ -0,0 +1,198 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/timer/default/default-timer.h"
+
+#include "test/system/null_osystem.h"
+
+class TimerTestSuite : public CxxTest::TestSuite {
+	struct Call {
+		int timer;
+		uint32 millis;
+	};
+
+	static NullOSystem *_system;
+	static DefaultTimerManager *_timers;
+	static Common::Array<Call> _calls;
+
+	/** Records the call, distinct instances make distinct callbacks. */
+	template<int N>
+	static void callback(void *refCon) {
+		Call call;
+		call.timer = N;
+		call.millis = _system->_millis;
+		_calls.push_back(call);
+	}
+
+	template<int N>
+	static void removeOther(void *refCon) {
+		callback<N>(refCon);
+		_timers->removeTimerProc((Common::TimerManager::TimerProc)refCon);
+	}
+
+	template<int N>
+	static void removeSelf(void *refCon) {
+		callback<N>(refCon);
+		_timers->removeTimerProc(&removeSelf<N>);
+	}
+
+	static void runUntil(uint32 millis) {
+		while (_system->_millis < millis) {
+			_system->_millis++;
+			_timers->handler();
+		}
+	}
+
+	static uint countCalls(int timer) {
+		uint count = 0;
+		for (uint i = 0; i < _calls.size(); ++i)
+			count += (_calls[i].timer == timer);
+		return count;
+	}
+
+	OSystem *_oldSystem;
+
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		_system = new NullOSystem();
+		g_system = _system;
+		_timers = new DefaultTimerManager();
+		_calls.clear();
+	}
+
+	void tearDown() {
+		delete _timers;
+		_timers = 0;
+		g_system = _oldSystem;
+		delete _system;
+		_system = 0;
+	}
+
+	void test_heap_order() {
+		// Intervals in ms, two of them equal to check the tie break
+		static const int intervals[] = { 7, 3, 5, 3, 11, 2, 13 };
+		_timers->installTimerProc(&callback<0>, intervals[0] * 1000, 0, "t0");
+		_timers->installTimerProc(&callback<1>, intervals[1] * 1000, 0, "t1");
+		_timers->installTimerProc(&callback<2>, intervals[2] * 1000, 0, "t2");
+		_timers->installTimerProc(&callback<3>, intervals[3] * 1000, 0, "t3");
+		_timers->installTimerProc(&callback<4>, intervals[4] * 1000, 0, "t4");
+		_timers->installTimerProc(&callback<5>, intervals[5] * 1000, 0, "t5");
+		_timers->installTimerProc(&callback<6>, intervals[6] * 1000, 0, "t6");
+
+		// Timers fire once their time has passed, so each handler call
+		// catches up on all of them in the order they were due
+		_system->_millis = 100;
+		_timers->handler();
+
+		uint32 lastDue = 0;
+		int lastTimer = -1;
+		uint calls[ARRAYSIZE(intervals)] = { 0 };
+		for (uint i = 0; i < _calls.size(); ++i) {
+			const int timer = _calls[i].timer;
+			const uint32 due = ++calls[timer] * intervals[timer];
+			TS_ASSERT_LESS_THAN(due, 100u);
+			TS_ASSERT_LESS_THAN_EQUALS(lastDue, due);
+			// Timer 1 was installed first and stays ahead of timer 3
+			if (due == lastDue && intervals[timer] == intervals[lastTimer])
+				TS_ASSERT_LESS_THAN(lastTimer, timer);
+			lastDue = due;
+			lastTimer = timer;
+		}
+
+		for (uint i = 0; i < ARRAYSIZE(intervals); ++i)
+			TS_ASSERT_EQUALS(calls[i], (uint)(99 / intervals[i]));
+
+		// And stepping through the time calls each one when it is due
+		_calls.clear();
+		runUntil(200);
+		for (uint i = 0; i < _calls.size(); ++i) {
+			const int interval = intervals[_calls[i].timer];
+			TS_ASSERT_EQUALS((_calls[i].millis - 1) % interval, 0u);
+		}
+		for (uint i = 0; i < ARRAYSIZE(intervals); ++i)
+			TS_ASSERT_EQUALS(countCalls(i), (uint)(199 / intervals[i] - 99 / intervals[i]));
+	}
+
+	void test_remove_in_callback() {
+		_timers->installTimerProc(&removeOther<0>, 5000, (void *)&callback<1>, "remover");
+		_timers->installTimerProc(&callback<1>, 5000, 0, "removed");
+		_timers->installTimerProc(&removeSelf<2>, 2000, 0, "self");
+		_timers->installTimerProc(&callback<3>, 1000, 0, "other");
+
+		runUntil(30);
+
+		// Both were due in the same handler call, the remover came first
+		TS_ASSERT_EQUALS(countCalls(1), 0u);
+		TS_ASSERT_EQUALS(countCalls(2), 1u);
+		TS_ASSERT_EQUALS(countCalls(3), 29u);
+
+		// The removed names are free again
+		_timers->removeTimerProc(&removeOther<0>);
+		TS_ASSERT(_timers->installTimerProc(&callback<1>, 1000, 0, "self"));
+		TS_ASSERT(_timers->installTimerProc(&removeSelf<2>, 1000, 0, "removed"));
+		_calls.clear();
+		runUntil(40);
+		// Due at 31 to 39 ms, a timer fires once its time has passed
+		TS_ASSERT_EQUALS(countCalls(1), 9u);
+		TS_ASSERT_EQUALS(countCalls(2), 1u);
+
+		Common::Array<Common::TimerManager::TimerStats> stats;
+		_timers->getTimerStats(stats);
+		TS_ASSERT_EQUALS(stats.size(), 2u);
+	}
+
+	void test_stats() {
+		_timers->installTimerProc(&callback<0>, 10000, 0, "stats");
+
+		// Due at 10 ms, called at 15 ms
+		_system->_millis = 15;
+		_timers->handler();
+		// Due at 20 ms, called at 21 ms, 6 ms after the previous call
+		_system->_millis = 21;
+		_timers->handler();
+		// Due at 30 ms, called at 50 ms, 29 ms after the previous call. The
+		// call due at 40 ms follows right after it.
+		_system->_millis = 50;
+		_timers->handler();
+
+		Common::Array<Common::TimerManager::TimerStats> stats;
+		_timers->getTimerStats(stats);
+		TS_ASSERT_EQUALS(stats.size(), 1u);
+		TS_ASSERT_EQUALS(stats[0].id, "stats");
+		TS_ASSERT_EQUALS(stats[0].interval, 10000);
+		TS_ASSERT_EQUALS(stats[0].calls, 4u);
+		TS_ASSERT_EQUALS(stats[0].totalLateness, 5000u + 1000u + 20000u + 10000u);
+		TS_ASSERT_EQUALS(stats[0].maxLateness, 20000u);
+		// Buckets by powers of two of milliseconds: 0, 1, 2-3, 4-7, 8-15, 16-31
+		TS_ASSERT_EQUALS(stats[0].lateness[1], 1u);
+		TS_ASSERT_EQUALS(stats[0].lateness[2], 0u);
+		TS_ASSERT_EQUALS(stats[0].lateness[3], 1u);
+		TS_ASSERT_EQUALS(stats[0].lateness[4], 1u);
+		TS_ASSERT_EQUALS(stats[0].lateness[5], 1u);
+		// 4, 19 and 10 ms from the interval
+		TS_ASSERT_EQUALS(stats[0].maxJitter, 19000u);
+		TS_ASSERT_EQUALS(stats[0].jitter[3], 1u);
+		TS_ASSERT_EQUALS(stats[0].jitter[4], 1u);
+		TS_ASSERT_EQUALS(stats[0].jitter[5], 1u);
+
+		_timers->resetTimerStats();
+		_timers->getTimerStats(stats);
+		TS_ASSERT_EQUALS(stats.size(), 1u);
+		TS_ASSERT_EQUALS(stats[0].id, "stats");
+		TS_ASSERT_EQUALS(stats[0].calls, 0u);
+		TS_ASSERT_EQUALS(stats[0].totalLateness, 0u);
+		TS_ASSERT_EQUALS(stats[0].maxJitter, 0u);
+
+		// The first call after a reset has no previous one to compare to
+		_system->_millis = 60;
+		_timers->handler();
+		_timers->getTimerStats(stats);
+		TS_ASSERT_EQUALS(stats[0].calls, 1u);
+		TS_ASSERT_EQUALS(stats[0].maxLateness, 10000u);
+		TS_ASSERT_EQUALS(stats[0].maxJitter, 0u);
+	}
+};
+
+NullOSystem *TimerTestSuite::_system = 0;
+DefaultTimerManager *TimerTestSuite::_timers = 0;
+Common::Array<TimerTestSuite::Call> TimerTestSuite::_calls;
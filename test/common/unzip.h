@@ -0,0 +1,290 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/memstream.h"
+#include "common/threadpool.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+/**
+ * A test suite for the ZIP archive support in common/unzip.h.
+ * The ZIP files are assembled in memory, with one stored and, if zlib is
+ * available, one deflated member.
+ */
+class UnzipTestSuite : public CxxTest::TestSuite {
+	public:
+	void test_stored_member() {
+		Common::ZipArchive *zip = makeTestArchive();
+		TS_ASSERT(zip);
+
+		TS_ASSERT(zip->hasFile("stored.txt"));
+		TS_ASSERT(zip->hasFile("STORED.TXT"));
+		TS_ASSERT(!zip->hasFile("missing.txt"));
+
+		// Member streams share the handle of the archive
+		Common::ArchiveMemberPtr member = zip->getMember("stored.txt");
+		TS_ASSERT(member);
+		TS_ASSERT(!member->createsPrivateStreams());
+
+		Common::SeekableReadStream *first  = zip->createReadStreamForMember("stored.txt");
+		Common::SeekableReadStream *second = zip->createReadStreamForMember("stored.txt");
+		TS_ASSERT(first);
+		TS_ASSERT(second);
+
+		// Both streams can be read independently
+		TS_ASSERT_EQUALS(first->size(), (int32)strlen(kStoredText));
+		TS_ASSERT_EQUALS(first->readByte(), kStoredText[0]);
+		TS_ASSERT_EQUALS(second->readByte(), kStoredText[0]);
+		TS_ASSERT_EQUALS(first->readByte(), kStoredText[1]);
+
+		// And they survive the archive
+		delete zip;
+
+		first->seek(-4, SEEK_END);
+		TS_ASSERT_EQUALS(first->readByte(), kStoredText[strlen(kStoredText) - 4]);
+
+		delete first;
+		delete second;
+	}
+
+	void test_directory_checksum() {
+		Common::ZipArchive *zip = makeTestArchive();
+		Common::ZipArchive *same = makeTestArchive();
+		Common::ZipArchive *changed = makeTestArchive("This member has been modified since.");
+		TS_ASSERT(zip && same && changed);
+
+		TS_ASSERT_EQUALS(zip->getDirectoryChecksum(), same->getDirectoryChecksum());
+		TS_ASSERT_DIFFERS(zip->getDirectoryChecksum(), changed->getDirectoryChecksum());
+
+		// Computing it leaves the members readable
+		Common::SeekableReadStream *stream = zip->createReadStreamForMember("stored.txt");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->readByte(), kStoredText[0]);
+
+		delete stream;
+		delete zip;
+		delete same;
+		delete changed;
+	}
+
+#ifdef USE_ZLIB
+	void test_deflated_member() {
+		Common::ZipArchive *zip = makeTestArchive();
+		TS_ASSERT(zip);
+
+		checkDeflated(zip->createReadStreamForMember("deflated.txt"));
+
+		// And now inflated on the fly
+		zip->setStreamingThreshold(16);
+		checkDeflated(zip->createReadStreamForMember("deflated.txt"));
+
+		delete zip;
+	}
+
+	void test_prefetch() {
+		Common::ZipArchive *zip = makeTestArchive();
+		TS_ASSERT(zip);
+
+		Common::StringArray names;
+		names.push_back("deflated.txt");
+		names.push_back("stored.txt");
+		names.push_back("missing.txt");
+
+		TS_ASSERT_EQUALS(zip->prefetch(names), 2u);
+
+		checkDeflated(zip->createReadStreamForMember("deflated.txt"));
+		checkDeflated(zip->createReadStreamForMember("deflated.txt"));
+		checkStored(zip->createReadStreamForMember("stored.txt"), false);
+
+		delete zip;
+	}
+
+	void test_prefetch_on_pool() {
+		Common::SerialThreadPool pool;
+		Common::ZipArchive *zip = makeTestArchive(kStoredText, true);
+		TS_ASSERT(zip);
+
+		Common::StringArray names;
+		names.push_back("deflated.txt");
+		names.push_back("stored.txt");
+
+		TS_ASSERT_EQUALS(zip->prefetch(names, &pool), 2u);
+
+		// A member failing its CRC check is read normally instead
+		checkDeflated(zip->createReadStreamForMember("deflated.txt"));
+		checkStored(zip->createReadStreamForMember("stored.txt"), true);
+
+		// Members never picked up are freed with the archive
+		TS_ASSERT_EQUALS(zip->prefetch(names, &pool), 2u);
+		delete zip;
+	}
+
+	void test_stored_member_crc() {
+		Common::ZipArchive *zip = makeTestArchive();
+		Common::ZipArchive *broken = makeTestArchive(kStoredText, true);
+		TS_ASSERT(zip && broken);
+
+		checkStored(zip->createReadStreamForMember("stored.txt"), false);
+		checkStored(broken->createReadStreamForMember("stored.txt"), true);
+
+		// Only a completely read member can be verified
+		Common::SeekableReadStream *stream = broken->createReadStreamForMember("stored.txt");
+		TS_ASSERT(stream);
+		stream->skip(4);
+		stream->readByte();
+		TS_ASSERT(!stream->err());
+
+		// Reading it again from the start, here as a view, completes the check
+		stream->seek(0);
+		Common::SeekableReadStream *rest = stream->readStream(stream->size());
+		TS_ASSERT(rest);
+		TS_ASSERT(stream->err());
+
+		delete rest;
+		delete stream;
+		delete zip;
+		delete broken;
+	}
+#endif
+
+	private:
+	static const char *const kStoredText;
+
+	static Common::String deflatedText() {
+		Common::String text;
+		for (int i = 0; i < 64; i++)
+			text += Common::String::format("Line %d of a rather repetitive text. ", i);
+
+		return text;
+	}
+
+	void checkDeflated(Common::SeekableReadStream *stream) {
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		const Common::String text = deflatedText();
+		TS_ASSERT_EQUALS(stream->size(), (int32)text.size());
+
+		Common::Array<char> data;
+		data.resize(text.size() + 1);
+		TS_ASSERT_EQUALS(stream->read(data.begin(), text.size()), text.size());
+		data[text.size()] = 0;
+		TS_ASSERT_EQUALS(Common::String(data.begin()), text);
+
+		stream->seek(5);
+		TS_ASSERT_EQUALS(stream->readByte(), text[5]);
+
+		delete stream;
+	}
+
+	void checkStored(Common::SeekableReadStream *stream, bool broken) {
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		const uint32 size = strlen(kStoredText);
+
+		Common::Array<char> data;
+		data.resize(size + 1);
+		TS_ASSERT_EQUALS(stream->read(data.begin(), size), size);
+		data[size] = 0;
+		TS_ASSERT_EQUALS(Common::String(data.begin()), kStoredText);
+
+		TS_ASSERT_EQUALS(stream->err(), broken);
+
+		delete stream;
+	}
+
+	static uint32 crc32(const byte *data, uint32 size) {
+		uint32 crc = 0xFFFFFFFF;
+
+		while (size-- > 0) {
+			crc ^= *data++;
+			for (int i = 0; i < 8; i++)
+				crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+		}
+
+		return ~crc;
+	}
+
+	static void writeEntry(Common::MemoryWriteStreamDynamic &zip, Common::MemoryWriteStreamDynamic &dir,
+	                       const char *name, uint16 method, const Common::String &data, const byte *compressed, uint32 compressedSize,
+	                       bool brokenCrc = false) {
+
+		const uint32 offset = zip.pos();
+		const uint32 crc    = crc32((const byte *)data.c_str(), data.size()) ^ (brokenCrc ? 1 : 0);
+
+		zip.writeUint32LE(0x04034B50);
+		zip.writeUint16LE(20);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(method);
+		zip.writeUint32LE(0);
+		zip.writeUint32LE(crc);
+		zip.writeUint32LE(compressedSize);
+		zip.writeUint32LE(data.size());
+		zip.writeUint16LE(strlen(name));
+		zip.writeUint16LE(0);
+		zip.write(name, strlen(name));
+		zip.write(compressed, compressedSize);
+
+		dir.writeUint32LE(0x02014B50);
+		dir.writeUint16LE(20);
+		dir.writeUint16LE(20);
+		dir.writeUint16LE(0);
+		dir.writeUint16LE(method);
+		dir.writeUint32LE(0);
+		dir.writeUint32LE(crc);
+		dir.writeUint32LE(compressedSize);
+		dir.writeUint32LE(data.size());
+		dir.writeUint16LE(strlen(name));
+		dir.writeUint16LE(0);
+		dir.writeUint16LE(0);
+		dir.writeUint16LE(0);
+		dir.writeUint16LE(0);
+		dir.writeUint32LE(0);
+		dir.writeUint32LE(offset);
+		dir.write(name, strlen(name));
+	}
+
+	static Common::ZipArchive *makeTestArchive(const char *storedText = kStoredText, bool brokenCrc = false) {
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+		Common::MemoryWriteStreamDynamic dir(DisposeAfterUse::YES);
+
+		uint16 count = 0;
+
+		writeEntry(zip, dir, "stored.txt", 0, storedText, (const byte *)storedText, strlen(storedText), brokenCrc);
+		count++;
+
+#ifdef USE_ZLIB
+		// Compress with gzip and strip the header and trailer to get raw deflate data
+		const Common::String text = deflatedText();
+
+		Common::MemoryWriteStreamDynamic *gzipData = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(gzipData);
+		gzip->write(text.c_str(), text.size());
+		gzip->finalize();
+
+		writeEntry(zip, dir, "deflated.txt", 8, text, gzipData->getData() + 10, gzipData->size() - 18);
+		count++;
+
+		delete gzip;
+#endif
+
+		const uint32 dirOffset = zip.pos();
+		zip.write(dir.getData(), dir.size());
+
+		zip.writeUint32LE(0x06054B50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(count);
+		zip.writeUint16LE(count);
+		zip.writeUint32LE(dir.size());
+		zip.writeUint32LE(dirOffset);
+		zip.writeUint16LE(0);
+
+		return Common::makeZipArchive(new Common::MemoryReadStream(zip.getData(), zip.size(), DisposeAfterUse::YES));
+	}
+};
+
+const char *const UnzipTestSuite::kStoredText = "This member is stored without compression.";
@@ -0,0 +1,263 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/xmlparser.h"
+
+/**
+ * A parser accepting the layout of the GUI themes, as described in
+ * gui/ThemeParser.h. It only counts the keys and properties it sees.
+ */
+class ThemeLayoutParser : public Common::XMLParser {
+public:
+	int keys;
+	int properties;
+	Common::String lastColor;
+
+	ThemeLayoutParser() : keys(0), properties(0) {}
+
+protected:
+	CUSTOM_XML_PARSER(ThemeLayoutParser) {
+		XML_KEY(render_info)
+			XML_PROP(resolution, false)
+			XML_KEY(palette)
+				XML_KEY(color)
+					XML_PROP(name, true)
+					XML_PROP(rgb, true)
+				KEY_END()
+			KEY_END()
+
+			XML_KEY(fonts)
+				XML_KEY(font)
+					XML_PROP(id, true)
+					XML_PROP(file, true)
+					XML_PROP(resolution, false)
+					XML_PROP(scalable_file, false)
+					XML_PROP(point_size, false)
+				KEY_END()
+
+				XML_KEY(text_color)
+					XML_PROP(id, true);
+					XML_PROP(color, true);
+				KEY_END()
+			KEY_END()
+
+			XML_KEY(bitmaps)
+				XML_KEY(bitmap)
+					XML_PROP(filename, true)
+					XML_PROP(resolution, false)
+				KEY_END()
+			KEY_END()
+
+			XML_KEY(cursor)
+				XML_PROP(file, true)
+				XML_PROP(hotspot, true)
+				XML_PROP(resolution, false)
+			KEY_END()
+
+			XML_KEY(defaults)
+				XML_PROP(stroke, false)
+				XML_PROP(shadow, false)
+				XML_PROP(bevel, false)
+				XML_PROP(factor, false)
+				XML_PROP(fg_color, false)
+				XML_PROP(bg_color, false)
+				XML_PROP(gradient_start, false)
+				XML_PROP(gradient_end, false)
+				XML_PROP(bevel_color, false)
+				XML_PROP(gradient_factor, false)
+				XML_PROP(fill, false)
+			KEY_END()
+
+			XML_KEY(drawdata)
+				XML_PROP(id, true)
+				XML_PROP(cache, false)
+				XML_PROP(resolution, false)
+
+				XML_KEY(defaults)
+					XML_PROP(stroke, false)
+					XML_PROP(shadow, false)
+					XML_PROP(bevel, false)
+					XML_PROP(factor, false)
+					XML_PROP(fg_color, false)
+					XML_PROP(bg_color, false)
+					XML_PROP(gradient_start, false)
+					XML_PROP(gradient_end, false)
+					XML_PROP(bevel_color, false)
+					XML_PROP(gradient_factor, false)
+					XML_PROP(fill, false)
+				KEY_END()
+
+				XML_KEY(drawstep)
+					XML_PROP(func, true)
+					XML_PROP(stroke, false)
+					XML_PROP(shadow, false)
+					XML_PROP(bevel, false)
+					XML_PROP(factor, false)
+					XML_PROP(fg_color, false)
+					XML_PROP(bg_color, false)
+					XML_PROP(gradient_start, false)
+					XML_PROP(gradient_end, false)
+					XML_PROP(gradient_factor, false)
+					XML_PROP(bevel_color, false)
+					XML_PROP(fill, false)
+					XML_PROP(radius, false)
+					XML_PROP(width, false)
+					XML_PROP(height, false)
+					XML_PROP(xpos, false)
+					XML_PROP(ypos, false)
+					XML_PROP(padding, false)
+					XML_PROP(orientation, false)
+					XML_PROP(file, false)
+				KEY_END()
+
+				XML_KEY(text)
+					XML_PROP(font, true)
+					XML_PROP(text_color, true)
+					XML_PROP(vertical_align, true)
+					XML_PROP(horizontal_align, true)
+				KEY_END()
+			KEY_END()
+
+		KEY_END() // render_info end
+
+		XML_KEY(layout_info)
+			XML_PROP(resolution, false)
+			XML_KEY(globals)
+				XML_PROP(resolution, false)
+				XML_KEY(def)
+					XML_PROP(var, true)
+					XML_PROP(value, true)
+					XML_PROP(resolution, false)
+				KEY_END()
+
+				XML_KEY(widget)
+					XML_PROP(name, true)
+					XML_PROP(size, false)
+					XML_PROP(pos, false)
+					XML_PROP(padding, false)
+					XML_PROP(resolution, false)
+					XML_PROP(textalign, false)
+				KEY_END()
+			KEY_END()
+
+			XML_KEY(dialog)
+				XML_PROP(name, true)
+				XML_PROP(overlays, true)
+				XML_PROP(shading, false)
+				XML_PROP(enabled, false)
+				XML_PROP(resolution, false)
+				XML_PROP(inset, false)
+				XML_KEY(layout)
+					XML_PROP(type, true)
+					XML_PROP(center, false)
+					XML_PROP(padding, false)
+					XML_PROP(spacing, false)
+
+					XML_KEY(import)
+						XML_PROP(layout, true)
+					KEY_END()
+
+					XML_KEY(widget)
+						XML_PROP(name, true)
+						XML_PROP(width, false)
+						XML_PROP(height, false)
+						XML_PROP(type, false)
+						XML_PROP(enabled, false)
+						XML_PROP(textalign, false)
+					KEY_END()
+
+					XML_KEY(space)
+						XML_PROP(size, false)
+					KEY_END()
+
+					XML_KEY_RECURSIVE(layout)
+				KEY_END()
+			KEY_END()
+		KEY_END()
+
+	} PARSER_END()
+
+	bool count(ParserNode *node) {
+		keys++;
+		properties += node->values.size();
+		return true;
+	}
+
+	bool parserCallback_render_info(ParserNode *node) { return count(node); }
+	bool parserCallback_palette(ParserNode *node) { return count(node); }
+	bool parserCallback_fonts(ParserNode *node) { return count(node); }
+	bool parserCallback_font(ParserNode *node) { return count(node); }
+	bool parserCallback_text_color(ParserNode *node) { return count(node); }
+	bool parserCallback_bitmaps(ParserNode *node) { return count(node); }
+	bool parserCallback_bitmap(ParserNode *node) { return count(node); }
+	bool parserCallback_cursor(ParserNode *node) { return count(node); }
+	bool parserCallback_defaults(ParserNode *node) { return count(node); }
+	bool parserCallback_drawdata(ParserNode *node) { return count(node); }
+	bool parserCallback_drawstep(ParserNode *node) { return count(node); }
+	bool parserCallback_text(ParserNode *node) { return count(node); }
+	bool parserCallback_layout_info(ParserNode *node) { return count(node); }
+	bool parserCallback_globals(ParserNode *node) { return count(node); }
+	bool parserCallback_def(ParserNode *node) { return count(node); }
+	bool parserCallback_dialog(ParserNode *node) { return count(node); }
+	bool parserCallback_layout(ParserNode *node) { return count(node); }
+	bool parserCallback_import(ParserNode *node) { return count(node); }
+	bool parserCallback_widget(ParserNode *node) { return count(node); }
+	bool parserCallback_space(ParserNode *node) { return count(node); }
+
+	bool parserCallback_color(ParserNode *node) {
+		lastColor = node->values["name"] + "=" + node->values["rgb"];
+		return count(node);
+	}
+};
+
+class XMLParserTestSuite : public CxxTest::TestSuite {
+	static bool parse(ThemeLayoutParser &parser, const char *text) {
+		parser.close();
+		parser.loadBuffer((const byte *)text, strlen(text));
+		return parser.parse();
+	}
+
+public:
+	void test_parse() {
+		ThemeLayoutParser parser;
+
+		TS_ASSERT(parse(parser,
+			"<?xml version = '1.0'?>\n"
+			"<!-- A comment -->\n"
+			"<render_info resolution = '-320xY'>\n"
+			"\t<palette>\n"
+			"\t\t<color name = \"black\" rgb = '0, 0, 0' />\n"
+			"\t\t<color name = 'white'\n"
+			"\t\t\t\trgb = '255, 255, 255'\n"
+			"\t\t/>\n"
+			"\t</palette>\n"
+			"</render_info>\n"));
+
+		TS_ASSERT_EQUALS(parser.keys, 4);
+		TS_ASSERT_EQUALS(parser.properties, 5);
+		TS_ASSERT_EQUALS(parser.lastColor, "white=255, 255, 255");
+	}
+
+	void test_case_insensitive_keys() {
+		ThemeLayoutParser parser;
+
+		// Key and property names are matched case-insensitively, but
+		// closing keys have to match the opening ones exactly
+		TS_ASSERT(parse(parser,
+			"<?xml version = '1.0'?>"
+			"<Render_Info><Palette><COLOR NAME = 'red' rgb = '255, 0, 0'/></Palette></Render_Info>"));
+		TS_ASSERT_EQUALS(parser.keys, 3);
+		TS_ASSERT_EQUALS(parser.lastColor, "red=255, 0, 0");
+	}
+
+	void test_builtin_theme() {
+		// The built-in theme, with the same layout as the bundled ones
+		static const char *const theme =
+#include "gui/themes/default.inc"
+			;
+
+		ThemeLayoutParser parser;
+		TS_ASSERT(parse(parser, theme));
+		TS_ASSERT_LESS_THAN(500, parser.keys);
+		TS_ASSERT_LESS_THAN(parser.keys, parser.properties);
+	}
+};
@@ -0,0 +1,92 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/zlib.h"
+
+#ifdef USE_ZLIB
+
+/**
+ * A memory stream counting the bytes read from it, to measure how much
+ * compressed data a GZipReadStream has to process.
+ */
+class CountingReadStream : public Common::MemoryReadStream {
+public:
+	uint32 _bytesRead;
+
+	CountingReadStream(const byte *data, uint32 size) : Common::MemoryReadStream(data, size, DisposeAfterUse::YES), _bytesRead(0) {}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 n = Common::MemoryReadStream::read(dataPtr, dataSize);
+		_bytesRead += n;
+		return n;
+	}
+};
+
+#endif
+
+class ZlibTestSuite : public CxxTest::TestSuite {
+	public:
+#ifdef USE_ZLIB
+	enum {
+		kSaveSize = 4 * 1024 * 1024,
+		kNumSeeks = 200,
+		kReadSize = 64
+	};
+
+	static byte getSaveByte(uint32 pos) {
+		uint32 x = pos * 2654435761U;
+		return 'a' + ((x >> 13) ^ (pos >> 5)) % 16;
+	}
+
+	void test_random_seek() {
+		// The GZipWriteStream takes ownership of the memory stream, but not
+		// of the compressed data.
+		Common::MemoryWriteStreamDynamic *compressed = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *save = Common::wrapCompressedWriteStream(compressed);
+
+		byte buf[4096];
+		for (uint32 pos = 0; pos < kSaveSize; pos += sizeof(buf)) {
+			for (uint32 i = 0; i < sizeof(buf); ++i)
+				buf[i] = getSaveByte(pos + i);
+			save->write(buf, sizeof(buf));
+		}
+		save->finalize();
+
+		CountingReadStream *counter = new CountingReadStream(compressed->getData(), compressed->size());
+		delete save;
+
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(counter);
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), (int32)kSaveSize);
+
+		// Read through once, which builds up the seek index
+		for (uint32 pos = 0; pos < kSaveSize; pos += sizeof(buf))
+			stream->read(buf, sizeof(buf));
+		TS_ASSERT(!stream->err());
+
+		const uint32 linearRead = counter->_bytesRead;
+		counter->_bytesRead = 0;
+
+		uint32 seed = 12345;
+		for (int i = 0; i < kNumSeeks; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const uint32 pos = (seed >> 8) % (kSaveSize - kReadSize);
+
+			TS_ASSERT(stream->seek(pos));
+			TS_ASSERT_EQUALS(stream->pos(), (int32)pos);
+			TS_ASSERT_EQUALS(stream->read(buf, kReadSize), (uint32)kReadSize);
+
+			bool match = true;
+			for (uint32 j = 0; j < kReadSize; ++j)
+				match = match && (buf[j] == getSaveByte(pos + j));
+			TS_ASSERT(match);
+		}
+
+		// Without an index every backward seek restarts at the beginning,
+		// which amounts to reading the whole file dozens of times.
+		TS_ASSERT_LESS_THAN(counter->_bytesRead, linearRead * (kNumSeeks / 10));
+
+		delete stream;
+	}
+#endif
+};
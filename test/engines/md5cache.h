@@ -0,0 +1,88 @@
+#include <cxxtest/TestSuite.h>
+
+#include "engines/advancedDetector.h"
+
+#include "common/fs.h"
+#include "common/str.h"
+#include "common/stream.h"
+
+#include "backends/saves/default/default-saves.h"
+
+#include "test/system/null_osystem.h"
+
+/** Keeps the savefiles, and so the MD5 cache, in the test directory of the build directory. */
+class MD5CacheSaveFileManager : public DefaultSaveFileManager {
+protected:
+	virtual Common::String getSavePath() const { return "test"; }
+	virtual bool canSaveInBackground() const { return false; }
+};
+
+/** A NullOSystem with a savefile manager, for the MD5 cache to be written. */
+class MD5CacheOSystem : public NullOSystem {
+public:
+	MD5CacheOSystem() {
+		_savefileManager = new MD5CacheSaveFileManager();
+	}
+};
+
+class ADMD5CacheTestSuite : public CxxTest::TestSuite {
+	OSystem *_oldSystem;
+	MD5CacheOSystem *_system;
+
+	static Common::FSNode testFile(const Common::String &name) {
+		return Common::FSNode("test").getChild(name);
+	}
+
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		_system = new MD5CacheOSystem();
+		g_system = _system;
+		ADMD5Cache::destroy();
+	}
+
+	void tearDown() {
+		ADMD5Cache::destroy();
+		remove(testFile("detection.md5cache").getPath().c_str());
+		remove(testFile("md5cache-test.dat").getPath().c_str());
+
+		g_system = _oldSystem;
+		delete _system;
+		_system = 0;
+	}
+
+	void test_empty_md5() {
+#if defined(POSIX)
+		const Common::FSNode file = testFile("md5cache-test.dat");
+		Common::WriteStream *stream = file.createWriteStream();
+		stream->writeString("data fork");
+		delete stream;
+
+		// A file without a resource fork gets an empty MD5 for it
+		ADFileProperties noFork;
+		noFork.size = -1;
+		ADFileProperties dataFork;
+		dataFork.size = 9;
+		dataFork.md5 = "0123456789abcdef0123456789abcdef";
+
+		ADMD5Cache::instance().store(file, true, 5000, noFork);
+		ADMD5Cache::instance().store(file, false, 5000, dataFork);
+		ADMD5Cache::instance().flush();
+
+		// Read the cache back from disk
+		ADMD5Cache::destroy();
+
+		ADFileProperties props;
+		TS_ASSERT(ADMD5Cache::instance().lookup(file, true, 5000, props));
+		TS_ASSERT_EQUALS(props.size, -1);
+		TS_ASSERT_EQUALS(props.md5, "");
+
+		TS_ASSERT(ADMD5Cache::instance().lookup(file, false, 5000, props));
+		TS_ASSERT_EQUALS(props.size, 9);
+		TS_ASSERT_EQUALS(props.md5, dataFork.md5);
+
+		TS_ASSERT_EQUALS(ADMD5Cache::instance().getHits(), 2u);
+		TS_ASSERT_EQUALS(ADMD5Cache::instance().getMisses(), 0u);
+#endif
+	}
+};
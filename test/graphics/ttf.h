@@ -0,0 +1,130 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#include "graphics/font.h"
+#include "graphics/surface.h"
+
+#ifdef USE_FREETYPE2
+#include "graphics/fonts/ttf.h"
+
+#include "backends/fs/stdiostream.h"
+#endif
+
+class TTFFontTestSuite : public CxxTest::TestSuite {
+#ifdef USE_FREETYPE2
+	enum {
+		kWidth = 400,
+		kHeight = 60
+	};
+
+	static Graphics::Font *loadFont(const char *name, int size) {
+		Common::SeekableReadStream *file = StdioStream::makeFromPath(Common::String(SCUMMVM_SRCDIR "/gui/themes/fonts/") + name, false);
+		if (!file)
+			return 0;
+		Graphics::Font *font = Graphics::loadTTFFont(*file, size);
+		delete file;
+		return font;
+	}
+
+	static void fillBackground(Graphics::Surface &surface) {
+		for (int y = 0; y < surface.h; ++y) {
+			for (int x = 0; x < surface.w; ++x) {
+				const uint32 color = surface.format.RGBToColor((x * 37) & 0xFF, (y * 59) & 0xFF, ((x + y) * 11) & 0xFF);
+				if (surface.format.bytesPerPixel == 2)
+					*(uint16 *)surface.getBasePtr(x, y) = color;
+				else
+					*(uint32 *)surface.getBasePtr(x, y) = color;
+			}
+		}
+	}
+
+	/**
+	 * Draws a string glyph by glyph, at the positions drawString uses and
+	 * clipped to the same characters.
+	 */
+	static void drawByChar(const Graphics::Font &font, Graphics::Surface *dst, const Common::String &str, int x, int y, int w, uint32 color) {
+		const int leftX = x, rightX = x + w;
+		uint32 last = 0;
+		for (uint i = 0; i < str.size(); ++i) {
+			const uint32 cur = (byte)str[i];
+			x += font.getKerningOffset(last, cur);
+			last = cur;
+			const int charWidth = font.getCharWidth(cur);
+			if (x + charWidth > rightX)
+				break;
+			if (x + charWidth >= leftX)
+				font.drawChar(dst, cur, x, y, color);
+			x += charWidth;
+		}
+	}
+
+	static bool surfaceEquals(const Graphics::Surface &a, const Graphics::Surface &b) {
+		for (int y = 0; y < a.h; ++y) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+		return true;
+	}
+
+	void checkFont(const char *name, int size, const Graphics::PixelFormat &format) {
+		Graphics::Font *font = loadFont(name, size);
+		TS_ASSERT(font);
+		if (!font)
+			return;
+
+		static const char *const strings[] = {
+			"AVAWAY Tofu Type", "ffi fj rn LT", "The quick brown fox jumps over the lazy dog."
+		};
+		// Left and top clipping, and drawing a cached run a second time
+		static const int positions[][2] = { { 4, 20 }, { -7, -5 }, { 4, 20 } };
+
+		const uint32 color = format.RGBToColor(240, 240, 200);
+
+		Graphics::Surface background, runs, chars;
+		background.create(kWidth, kHeight, format);
+		fillBackground(background);
+
+		for (uint i = 0; i < ARRAYSIZE(strings); ++i) {
+			for (uint j = 0; j < ARRAYSIZE(positions); ++j) {
+				const int x = positions[j][0], y = positions[j][1];
+				const Common::String message = Common::String::format("%s %dpt, %d bit, \"%s\" at %d, %d",
+				                                                      name, size, format.bytesPerPixel * 8, strings[i], x, y);
+
+				runs.copyFrom(background);
+				font->drawString(&runs, strings[i], x, y, kWidth - x, color, Graphics::kTextAlignLeft, 0, false);
+
+				chars.copyFrom(background);
+				drawByChar(*font, &chars, strings[i], x, y, kWidth - x, color);
+
+				TSM_ASSERT(message.c_str(), !surfaceEquals(runs, background));
+				TSM_ASSERT(message.c_str(), surfaceEquals(runs, chars));
+			}
+		}
+
+		background.free();
+		runs.free();
+		chars.free();
+		delete font;
+	}
+#endif
+
+public:
+	void test_runs_match_chars_16bit() {
+#ifdef USE_FREETYPE2
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		checkFont("FreeSans.ttf", 12, format);
+		checkFont("FreeSans.ttf", 31, format);
+		checkFont("FreeMonoBold.ttf", 17, format);
+#endif
+	}
+
+	void test_runs_match_chars_32bit() {
+#ifdef USE_FREETYPE2
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		checkFont("FreeSans.ttf", 12, format);
+		checkFont("FreeSansBold.ttf", 31, format);
+		checkFont("FreeMonoBold.ttf", 17, format);
+#endif
+	}
+};
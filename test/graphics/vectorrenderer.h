@@ -0,0 +1,232 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/VectorRendererSpec.h"
+
+class VectorRendererTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 200,
+		kHeight = 120
+	};
+
+	/** A step drawn into the test area, with the extra data to draw it with. */
+	struct TestStep {
+		const char *name;
+		Graphics::DrawStep step;
+		uint32 extra;
+	};
+
+	static Graphics::DrawStep makeStep(Graphics::DrawingFunctionCallback call, uint8 fillMode) {
+		Graphics::DrawStep step = Graphics::DrawStep();
+		step.xAlign = Graphics::DrawStep::kVectorAlignManual;
+		step.yAlign = Graphics::DrawStep::kVectorAlignManual;
+		step.factor = 1;
+		step.autoWidth = true;
+		step.autoHeight = true;
+		step.fillMode = fillMode;
+		step.scale = (1 << 16);
+		step.radius = 0xFF;
+		step.drawingCall = call;
+
+		step.fgColor.r = 250; step.fgColor.g = 10; step.fgColor.b = 10; step.fgColor.set = true;
+		step.bgColor.set = true; // black, as beveled squares require
+		step.bevelColor.r = 10; step.bevelColor.g = 250; step.bevelColor.b = 10; step.bevelColor.set = true;
+		step.gradColor1.r = 10; step.gradColor1.g = 10; step.gradColor1.b = 250; step.gradColor1.set = true;
+		step.gradColor2.r = 250; step.gradColor2.g = 250; step.gradColor2.b = 10; step.gradColor2.set = true;
+		return step;
+	}
+
+	static Common::Array<TestStep> makeSteps() {
+		typedef Graphics::VectorRenderer VR;
+		Common::Array<TestStep> steps;
+		TestStep t;
+		t.extra = 0;
+
+		t.name = "square with shadow";
+		t.step = makeStep(&VR::drawCallback_SQUARE, VR::kFillForeground);
+		t.step.shadow = 3;
+		steps.push_back(t);
+
+		t.name = "stroked square";
+		t.step = makeStep(&VR::drawCallback_SQUARE, VR::kFillDisabled);
+		t.step.stroke = 2;
+		steps.push_back(t);
+
+		// Antialiased gradients query the backend, so use a plain fill
+		t.name = "rounded square with shadow";
+		t.step = makeStep(&VR::drawCallback_ROUNDSQ, VR::kFillBackground);
+		t.step.radius = 6;
+		t.step.shadow = 3;
+		t.step.stroke = 1;
+		t.step.bevel = 1;
+		steps.push_back(t);
+
+		t.name = "rounded square with big shadow";
+		t.step = makeStep(&VR::drawCallback_ROUNDSQ, VR::kFillBackground);
+		t.step.radius = 4;
+		t.step.shadow = 5;
+		steps.push_back(t);
+
+		t.name = "circle with shadow";
+		t.step = makeStep(&VR::drawCallback_CIRCLE, VR::kFillForeground);
+		t.step.radius = 10;
+		t.step.shadow = 2;
+		steps.push_back(t);
+
+		t.name = "stroked circle";
+		t.step = makeStep(&VR::drawCallback_CIRCLE, VR::kFillBackground);
+		t.step.stroke = 2;
+		steps.push_back(t);
+
+		t.name = "line";
+		t.step = makeStep(&VR::drawCallback_LINE, VR::kFillDisabled);
+		t.step.autoWidth = false;
+		t.step.w = 30;
+		t.step.stroke = 3;
+		steps.push_back(t);
+
+		t.name = "cross";
+		t.step = makeStep(&VR::drawCallback_CROSS, VR::kFillDisabled);
+		t.step.autoWidth = t.step.autoHeight = false;
+		t.step.w = 20;
+		t.step.h = 20;
+		t.step.stroke = 2;
+		steps.push_back(t);
+
+		// Filled beveled squares query the backend, so only the bevel is drawn
+		t.name = "beveled square";
+		t.step = makeStep(&VR::drawCallback_BEVELSQ, VR::kFillDisabled);
+		t.step.bevel = 2;
+		steps.push_back(t);
+
+		t.name = "active tab";
+		t.step = makeStep(&VR::drawCallback_TAB, VR::kFillBackground);
+		t.step.radius = 4;
+		t.step.stroke = 1;
+		t.extra = (5 << 16) | 7;
+		steps.push_back(t);
+
+		t.name = "beveled tab";
+		t.step = makeStep(&VR::drawCallback_TAB, VR::kFillBackground);
+		t.step.radius = 0;
+		t.step.bevel = 2;
+		steps.push_back(t);
+		t.extra = 0;
+
+		t.name = "triangle";
+		t.step = makeStep(&VR::drawCallback_TRIANGLE, VR::kFillForeground);
+		t.step.autoWidth = t.step.autoHeight = false;
+		t.step.xAlign = t.step.yAlign = Graphics::DrawStep::kVectorAlignCenter;
+		t.step.w = 16;
+		t.step.h = 16;
+		t.step.extraData = Graphics::VectorRenderer::kTriangleDown;
+		steps.push_back(t);
+
+		return steps;
+	}
+
+	static void fillBackground(Graphics::Surface &surface) {
+		for (int y = 0; y < surface.h; ++y) {
+			for (int x = 0; x < surface.w; ++x) {
+				const uint32 color = surface.format.RGBToColor((x * 37) & 0xFF, (y * 59) & 0xFF, ((x + y) * 11) & 0xFF);
+				if (surface.format.bytesPerPixel == 2)
+					*(uint16 *)surface.getBasePtr(x, y) = color;
+				else
+					*(uint32 *)surface.getBasePtr(x, y) = color;
+			}
+		}
+	}
+
+	static bool pixelEquals(const Graphics::Surface &a, const Graphics::Surface &b, int x, int y) {
+		return !memcmp(a.getBasePtr(x, y), b.getBasePtr(x, y), a.format.bytesPerPixel);
+	}
+
+	static bool rectEquals(const Graphics::Surface &a, const Graphics::Surface &b) {
+		for (int y = 0; y < a.h; ++y) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Draws each step directly, and the way ThemeEngine's render cache does:
+	 * a result rendered onto an identical background is copied back over
+	 * the drawn area only. Both have to give the same pixels, which holds
+	 * as long as no step changes pixels outside the area the renderer
+	 * reports.
+	 */
+	void checkRenderer(Graphics::VectorRenderer *renderer, const Graphics::PixelFormat &format, const char *rendererName) {
+		const Common::Rect area(40, 30, 140, 80);
+		const Common::Array<TestStep> steps = makeSteps();
+
+		Graphics::Surface background, direct, cached;
+		background.create(kWidth, kHeight, format);
+		fillBackground(background);
+
+		for (uint i = 0; i < steps.size(); ++i) {
+			const TestStep &t = steps[i];
+			Common::String name = Common::String::format("%s, %s", rendererName, t.name);
+
+			direct.copyFrom(background);
+			renderer->setSurface(&direct);
+			renderer->drawStep(area, t.step, t.extra);
+
+			Common::Rect drawn = renderer->stepGetDrawnArea(t.step, area, t.extra);
+			drawn.clip(kWidth, kHeight);
+
+			bool changed = false, outside = false;
+			for (int y = 0; y < kHeight; ++y) {
+				for (int x = 0; x < kWidth; ++x) {
+					if (pixelEquals(direct, background, x, y))
+						continue;
+					changed = true;
+					if (!drawn.contains(x, y))
+						outside = true;
+				}
+			}
+			TSM_ASSERT(name.c_str(), changed);
+			TSM_ASSERT(name.c_str(), !outside);
+
+			// Render onto a scratch copy and keep only the drawn area
+			Graphics::Surface scratch;
+			scratch.copyFrom(background);
+			renderer->setSurface(&scratch);
+			renderer->drawStep(area, t.step, t.extra);
+			Graphics::Surface result;
+			result.copyFrom(scratch.getSubArea(drawn));
+
+			cached.copyFrom(background);
+			TSM_ASSERT(name.c_str(), rectEquals(cached.getSubArea(drawn), background.getSubArea(drawn)));
+			cached.copyRectToSurface(result, drawn.left, drawn.top, Common::Rect(result.w, result.h));
+			TSM_ASSERT(name.c_str(), rectEquals(cached, direct));
+
+			scratch.free();
+			result.free();
+		}
+
+		background.free();
+		direct.free();
+		cached.free();
+	}
+
+public:
+	void test_cached_matches_direct_16bit() {
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		Graphics::VectorRendererSpec<uint16> spec(format);
+		checkRenderer(&spec, format, "16 bit");
+#ifndef DISABLE_FANCY_THEMES
+		Graphics::VectorRendererAA<uint16> aa(format);
+		checkRenderer(&aa, format, "16 bit antialiased");
+#endif
+	}
+
+	void test_cached_matches_direct_32bit() {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		Graphics::VectorRendererSpec<uint32> spec(format);
+		checkRenderer(&spec, format, "32 bit");
+#ifndef DISABLE_FANCY_THEMES
+		Graphics::VectorRendererAA<uint32> aa(format);
+		checkRenderer(&aa, format, "32 bit antialiased");
+#endif
+	}
+};
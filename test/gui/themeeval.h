@@ -0,0 +1,90 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "gui/ThemeEval.h"
+
+class ThemeEvalTestSuite : public CxxTest::TestSuite {
+public:
+	void test_cache_round_trip() {
+		// A theme cache as written by ThemeEval::saveToCache(), in big endian
+		static const byte cache[] = {
+			0x00, 0x00, 0x00, 0x02,                     // variables
+			'G', 'l', 'o', 'b', 'a', 'l', 's', '.', 'B', 'u', 't', 't', 'o', 'n', '.', 'W', 'i', 'd', 't', 'h', '\n',
+			0x00, 0x00, 0x01, 0x2c,                     // 300
+			'D', 'i', 'a', 'l', 'o', 'g', '.', 'T', 'e', 's', 't', '.', 'E', 'n', 'a', 'b', 'l', 'e', 'd', '\n',
+			0x00, 0x00, 0x00, 0x01,                     // 1
+			0x00, 0x00, 0x00, 0x01,                     // layouts
+			'D', 'i', 'a', 'l', 'o', 'g', '.', 'T', 'e', 's', 't', '\n',
+			0x00, 0x00, 0x10, 0x00, 0x20,               // main layout at (16, 32)
+			0x00, 0x10, 0x00, 0x20, 0x01, 0x40, 0x00, 0xc8, // x, y, w, h
+			0xff, 0xff, 0xff, 0xff,                     // default width and height
+			0x00, 0x04, 0x00, 0x04, 0x00, 0x02, 0x00, 0x02, // padding
+			0x00, 0x00, 0x00,                           // not centered, no alignment
+			0x00, 0x01,                                 // children
+			0x01, 0x01, 0x04,                           // vertical layout, spacing 4
+			0x00, 0x14, 0x00, 0x22, 0x01, 0x18, 0x00, 0xc4,
+			0xff, 0xff, 0xff, 0xff,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00,
+			0x00, 0x01,
+			0x02, 'B', 'u', 't', 't', 'o', 'n', '\n',   // widget
+			0x00, 0x14, 0x00, 0x22, 0x01, 0x2c, 0x00, 0x14,
+			0x01, 0x2c, 0x00, 0x14,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x03,                           // right aligned
+			0x00, 0x00
+		};
+
+		GUI::ThemeEval eval;
+		Common::MemoryReadStream in(cache, sizeof(cache));
+		TS_ASSERT(eval.loadFromCache(in));
+		TS_ASSERT_EQUALS(in.pos(), (int32)sizeof(cache));
+		checkTestDialog(eval);
+
+		// Writing it again gives the same data, except for the order of the
+		// variables, and reading that back the same layout
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+		eval.saveToCache(out);
+		TS_ASSERT_EQUALS(out.size(), sizeof(cache));
+		TS_ASSERT(!memcmp(out.getData(), cache, 4));
+		const uint32 layouts = 4 + 21 + 4 + 20 + 4;
+		TS_ASSERT(!memcmp(out.getData() + layouts, cache + layouts, sizeof(cache) - layouts));
+
+		GUI::ThemeEval reloaded;
+		Common::MemoryReadStream in2(out.getData(), out.size());
+		TS_ASSERT(reloaded.loadFromCache(in2));
+		checkTestDialog(reloaded);
+	}
+
+	void test_cache_truncated() {
+		GUI::ThemeEval eval;
+		eval.setVar("Globals.Button.Width", 300);
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+		eval.saveToCache(out);
+
+		// A cache cut short is rejected
+		GUI::ThemeEval truncated;
+		Common::MemoryReadStream in(out.getData(), out.size() - 3);
+		TS_ASSERT(!truncated.loadFromCache(in));
+		TS_ASSERT(!truncated.hasVar("Globals.Button.Width"));
+	}
+
+private:
+	void checkTestDialog(GUI::ThemeEval &eval) {
+		TS_ASSERT_EQUALS(eval.getVar("Globals.Button.Width"), 300);
+		TS_ASSERT_EQUALS(eval.getVar("Dialog.Test.Enabled"), 1);
+
+		int16 x = 0, y = 0;
+		uint16 w = 0, h = 0;
+		TS_ASSERT(eval.getWidgetData("Dialog.Test.Button", x, y, w, h));
+		TS_ASSERT_EQUALS(x, 20);
+		TS_ASSERT_EQUALS(y, 34);
+		TS_ASSERT_EQUALS(w, 300);
+		TS_ASSERT_EQUALS(h, 20);
+		TS_ASSERT_EQUALS(eval.getWidgetTextHAlign("Dialog.Test.Button"), Graphics::kTextAlignRight);
+
+		TS_ASSERT(eval.getWidgetData("Dialog.Test", x, y, w, h));
+		TS_ASSERT_EQUALS(x, 16);
+		TS_ASSERT_EQUALS(w, 320);
+	}
+};
@@ -5,12 +5,12 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h $(srcdir)/test/gui/*.h $(srcdir)/test/engines/*.h
+TEST_LIBS    := engines/libengines.a gui/libgui.a graphics/libgraphics.a audio/libaudio.a backends/libbackends.a common/libcommon.a
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
-TEST_CFLAGS  := -I$(srcdir)/test/cxxtest
+TEST_CFLAGS  := -I$(srcdir)/test/cxxtest -DSCUMMVM_SRCDIR=\"$(srcdir)\"
 TEST_LDFLAGS := $(LIBS)
 TEST_CXXFLAGS := $(filter-out -Wglobal-constructors,$(CXXFLAGS))
 
@@ -0,0 +1,49 @@
+#ifndef TEST_SYSTEM_BENCHMARK_H
+#define TEST_SYSTEM_BENCHMARK_H
+
+#include "common/scummsys.h"
+#include "common/util.h"
+
+// The benchmarks run without an OSystem, so they can't use getMillis()
+#undef clock
+#include <time.h>
+
+/**
+ * Measures the processor time taken by the benchmarks in the tests. The
+ * tests only trace these times and never assert on them, as they depend
+ * on the machine and on whatever else runs on it.
+ */
+class BenchmarkTimer {
+public:
+	/** The number of runs a benchmark takes the best time of. */
+	static const int kRuns = 3;
+
+	BenchmarkTimer() : _start(clock()) {}
+
+	/** Start measuring anew. */
+	void restart() { _start = clock(); }
+
+	/** Return the time since the start, in milliseconds. */
+	uint32 millis() const { return (uint32)(seconds() * 1000.0); }
+
+	/** Return the time since the start, in microseconds. */
+	uint32 micros() const { return (uint32)(seconds() * 1000000.0); }
+
+	/** Return the time since the start in nanoseconds, divided by count. */
+	uint32 nanosPer(uint32 count) const { return (uint32)(seconds() * 1000000000.0 / count); }
+
+	/**
+	 * Keep the best time of the runs of a benchmark so far. The shortest
+	 * run is the one least disturbed by the rest of the machine.
+	 */
+	static void keepBest(uint32 &best, uint32 time, int run) {
+		best = (run == 0) ? time : MIN(best, time);
+	}
+
+private:
+	double seconds() const { return (double)(clock() - _start) / CLOCKS_PER_SEC; }
+
+	clock_t _start;
+};
+
+#endif
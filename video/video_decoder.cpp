@@ -27,6 +27,7 @@
 
 #include "common/rational.h"
 #include "common/file.h"
+#include "common/profiler.h"
 #include "common/system.h"
 
 #include "graphics/palette.h"
@@ -170,6 +171,8 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 }
 
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
+	PROFILE_SCOPE("video.decode_frame");
+
 	_needsUpdate = false;
 
 	readNextPacket();